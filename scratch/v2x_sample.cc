@@ -44,6 +44,8 @@
 #include "ns3/config-store.h"
 #include <ns3/buildings-module.h>
 #include <cfloat>
+#include <fstream>
+#include <unistd.h>
 #include <sstream>
 #include <string>
 
@@ -96,6 +98,20 @@ PrintStatus (uint32_t sPeriod)
   Simulator::Schedule (Seconds (sPeriod),&PrintStatus, sPeriod);
 }
 
+// Resident memory of the process in bytes, 0 if /proc is not available
+uint64_t
+GetResidentMemory ()
+{
+  std::ifstream statm ("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(statm >> size >> resident))
+    {
+      return 0;
+    }
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
 
 int
 main (int argc, char *argv[])
@@ -128,6 +144,9 @@ main (int argc, char *argv[])
   bool enableFullDuplex = false;
   uint32_t changeProb = 100;
   uint32_t vehiclePercent = 10;
+  bool v2xBroadcast = false;       // All the vehicles share a single broadcast destination
+  double mobilityWindow = 0;       // Parse the SUMO trace this many seconds ahead, 0 to parse it at install time
+  bool binaryMobility = false;     // Load the SUMO trace from its binary version, written on first use
 
   // Command line arguments
   CommandLine cmd;
@@ -155,6 +174,9 @@ main (int argc, char *argv[])
   cmd.AddValue ("enableFullDuplex", "Enable Full Duplex", enableFullDuplex);
   cmd.AddValue ("changeProb", "Probability of Change Resource", changeProb);
   cmd.AddValue ("vehiclePercent", "percentages of simulated vehicles", vehiclePercent);
+  cmd.AddValue ("v2xBroadcast", "Use a single broadcast destination instead of one group per transmitter", v2xBroadcast);
+  cmd.AddValue ("mobilityWindow", "Seconds the SUMO trace is parsed ahead of the simulation time (0: whole trace at install)", mobilityWindow);
+  cmd.AddValue ("binaryMobility", "Load the SUMO trace from <trace>.bin, converted from the ns-2 trace if missing", binaryMobility);
   cmd.Parse (argc, argv);
 
   if (enableNsLogs)
@@ -317,16 +339,38 @@ main (int argc, char *argv[])
   // Load scenario from SUMO output
   std::string scenario_file = "/home/taeju/git-projects/ns3-lte-v2x/sumo_scenarios/highway_" + std::to_string(vehiclePercent) + "p_vehicle.tcl";
   Ns2MobilityHelper acosta = Ns2MobilityHelper(scenario_file);
+  acosta.SetStreamingWindow (Seconds (mobilityWindow));
   NodeContainer ueResponders;
   ueResponders.Create(numGroups);
   ueAllNodes.Add (ueResponders);
-  acosta.Install(ueResponders.Begin(), ueResponders.End());
+  if (binaryMobility)
+    {
+      std::string binary_file = scenario_file + ".bin";
+      if (!std::ifstream (binary_file.c_str ()).good ())
+        {
+          acosta.WriteBinaryTrace (binary_file);
+        }
+      Ns2BinaryMobilityHelper binaryAcosta = Ns2BinaryMobilityHelper (binary_file);
+      binaryAcosta.Install (ueResponders.Begin (), ueResponders.End ());
+    }
+  else
+    {
+      acosta.Install(ueResponders.Begin(), ueResponders.End());
+    }
 
   // Install LTE devices to all UEs and deploy them in the sectors.
   NS_LOG_INFO ("Installing UE's network devices and Deploying...");
   lteHelper->SetAttribute ("UseSidelink", BooleanValue (true));
   //NetDeviceContainer ueRespondersDevs = topoHelper->DropUEsUniformlyPerSector (ueResponders);
+  uint64_t memoryBeforeUes = GetResidentMemory ();
   NetDeviceContainer ueRespondersDevs = lteHelper->InstallUeDevice (ueResponders);
+  uint64_t memoryAfterUes = GetResidentMemory ();
+  if (memoryAfterUes > memoryBeforeUes && ueResponders.GetN () != 0)
+    {
+      std::cout << "Memory per UE device: "
+                << (memoryAfterUes - memoryBeforeUes) / ueResponders.GetN ()
+                << " bytes (" << ueResponders.GetN () << " UEs)" << std::endl;
+    }
   NetDeviceContainer ueDevs;
   ueDevs.Add (ueRespondersDevs);
 
@@ -380,7 +424,12 @@ main (int argc, char *argv[])
   double ulEarfcn = enbDevs.Get (0)->GetObject<LteEnbNetDevice> ()->GetUlEarfcn ();
   double ulBandwidth = enbDevs.Get (0)->GetObject<LteEnbNetDevice> ()->GetUlBandwidth ();
   std::vector < NetDeviceContainer > createdgroups;
-  if (numReceivers > 0)
+  if (v2xBroadcast)
+    {
+      //no group: every vehicle transmits to the broadcast destination
+      std::cout << "V2X broadcast destination shared by " << ueRespondersDevs.GetN () << " UEs" << std::endl;
+    }
+  else if (numReceivers > 0)
     {
       //groupcast
       createdgroups = proseHelper->AssociateForGroupcast (ueTxPower, ulEarfcn, ulBandwidth, ueRespondersDevs, -112, numGroups, numReceivers, LteSidelinkHelper::SLRSRP_TX_PW);
@@ -425,8 +474,11 @@ main (int argc, char *argv[])
       std::cout << mIt->first << " " << mIt->second << std::endl;
       groupsPerUe [mIt->second]++;
     }
-  std::cout << "Average number of receivers per transmitter = " << (totalRxs / numGroups) << std::endl;
-  std::cout << "Average number of transmitters per receiver = " << (totalTxPerUe / txPerUeMap.size ()) << std::endl;
+  if (!createdgroups.empty ())
+    {
+      std::cout << "Average number of receivers per transmitter = " << (totalRxs / numGroups) << std::endl;
+      std::cout << "Average number of transmitters per receiver = " << (totalTxPerUe / txPerUeMap.size ()) << std::endl;
+    }
   std::cout << "Associated Groups per Rx UE" << std::endl;
   for (mIt = groupsPerUe.begin (); mIt != groupsPerUe.end (); mIt++)
     {
@@ -516,6 +568,44 @@ main (int argc, char *argv[])
       clientRespondersAddress = Ipv4AddressGenerator::NextAddress (Ipv4Mask ("255.0.0.0"));
     } // end for each group in created groups
 
+  if (v2xBroadcast)
+    {
+      //one bidirectional bearer per UE towards the shared destination
+      proseHelper->ActivateV2xBroadcastBearer (Seconds (1.0), ueRespondersDevs, clientRespondersAddress, groupL2Address);
+      std::cout << "Created broadcast L2Address=" << groupL2Address << " IPAddress=";
+      clientRespondersAddress.Print (std::cout);
+      std::cout << std::endl;
+
+      // Install Application in all the Responders' UEs
+      for (uint32_t i = 0; i < ueRespondersDevs.GetN (); i++)
+        {
+          activeTxUes.Add (ueRespondersDevs.Get (i));
+        }
+      if (onoff)
+        {
+          std::cout << "Responder's OnOff App. bitrate " << dataRateBitsPerSec << std::endl;
+          OnOffHelper clientOnOffHelper ("ns3::UdpSocketFactory",
+                                         Address ( InetSocketAddress (clientRespondersAddress, applicationPort)));
+          clientOnOffHelper.SetAttribute ("PacketSize", UintegerValue (pktSize));
+          clientOnOffHelper.SetAttribute ("DataRate", DataRateValue (dataRateBitsPerSec));
+          clientOnOffHelper.SetAttribute ("OnTime", PointerValue (onRv));
+          clientOnOffHelper.SetAttribute ("OffTime", PointerValue (offRv));
+
+          clientRespondersApps.Add (clientOnOffHelper.Install (ueResponders));
+        }
+      else
+        {
+          // UDP application
+          UdpEchoClientHelper echoClientHelper (clientRespondersAddress, applicationPort);
+          echoClientHelper.SetAttribute ("MaxPackets", UintegerValue (responderMaxPack));
+          echoClientHelper.SetAttribute ("Interval", TimeValue (Seconds (responderPktIntvl)));
+          echoClientHelper.SetAttribute ("PacketSize", UintegerValue (responderPktSize));
+
+          clientRespondersApps.Add (echoClientHelper.Install (ueResponders));
+        }
+      groupL2Addresses.push_back (groupL2Address);
+    }
+
   clientRespondersApps.Start (Seconds (respondersStart));
   clientRespondersApps.Stop (Seconds (simTime));
 
@@ -602,6 +692,9 @@ main (int argc, char *argv[])
   Simulator::Stop (MilliSeconds (simTime * 1000 + 40));
   Simulator::Run ();
 
+  std::cout << "Sidelink payload bytes shared instead of copied: "
+            << LteSpectrumSignalParametersSlFrame::GetSharedPayloadBytes () << std::endl;
+
   Simulator::Destroy ();
 
   NS_LOG_INFO ("Done.");
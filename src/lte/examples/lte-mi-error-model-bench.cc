@@ -0,0 +1,88 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program benchmarks the computation of the mean mutual information
+// per bit of a TB by LteMiErrorModel::Mib, on a SpectrumValue and on a
+// contiguous array of SINRs, for allocations of 6, 25, 50 and 100 RBs
+// Sample usage:  ./waf --run 'lte-mi-error-model-bench --n=1000000'
+
+#include "ns3/core-module.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/lte-mi-error-model.h"
+#include "ns3/lte-spectrum-value-helper.h"
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+
+  CommandLine cmd;
+  cmd.AddValue ("n", "Number of computations per allocation and modulation", n);
+  cmd.Parse (argc, argv);
+
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  const uint8_t nRbs[] = {6, 25, 50, 100};
+  // one MCS per modulation: QPSK, 16-QAM and 64-QAM
+  const uint8_t mcs[] = {5, 14, 24};
+
+  std::cout << "RBs\tMCS\tSpectrumValue (ns)\tarray (ns)\tspeedup" << std::endl;
+  for (uint32_t i = 0; i < sizeof (nRbs) / sizeof (nRbs[0]); i++)
+    {
+      // SINRs from -10 dB to 30 dB, which cover the three MI maps
+      SpectrumValue sinr (LteSpectrumValueHelper::GetSpectrumModel (100, nRbs[i]));
+      std::vector<int> map;
+      for (uint32_t rb = 0; rb < nRbs[i]; rb++)
+        {
+          sinr[rb] = std::pow (10, random->GetValue (-10, 30) / 10);
+          map.push_back (rb);
+        }
+      const double *sinrArray = &(*sinr.ConstValuesBegin ());
+
+      for (uint32_t j = 0; j < sizeof (mcs) / sizeof (mcs[0]); j++)
+        {
+          double mibSpectrumValue = LteMiErrorModel::Mib (sinr, map, mcs[j]);
+          double mibArray = LteMiErrorModel::Mib (sinrArray, &map[0], map.size (), mcs[j]);
+          NS_ABORT_MSG_IF (mibSpectrumValue != mibArray, "Different MI for " << (uint16_t) nRbs[i] << " RBs and MCS "
+                           << (uint16_t) mcs[j] << ": " << mibSpectrumValue << " and " << mibArray);
+
+          // the sums keep the computations from being optimized out
+          double sumSpectrumValue = 0;
+          double sumArray = 0;
+          SystemWallClockMs clock;
+          clock.Start ();
+          for (uint32_t k = 0; k < n; k++)
+            {
+              sumSpectrumValue += LteMiErrorModel::Mib (sinr, map, mcs[j]);
+            }
+          double spectrumValueNs = clock.End () * 1e6 / n;
+          clock.Start ();
+          for (uint32_t k = 0; k < n; k++)
+            {
+              sumArray += LteMiErrorModel::Mib (sinrArray, &map[0], map.size (), mcs[j]);
+            }
+          double arrayNs = clock.End () * 1e6 / n;
+          NS_ABORT_MSG_IF (sumSpectrumValue != sumArray, "Different MI sums");
+
+          std::cout << (uint16_t) nRbs[i] << "\t" << (uint16_t) mcs[j] << "\t" << spectrumValueNs << "\t"
+                    << arrayNs << "\t" << spectrumValueNs / arrayNs << std::endl;
+        }
+    }
+  return 0;
+}
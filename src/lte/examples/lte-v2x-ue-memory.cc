@@ -0,0 +1,120 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program reports the resident memory taken by the V2V UEs: first per
+// UE device installed by the LteHelper, then per LteSpectrumPhy alone, which
+// holds the Mode-4 sensing window of the UE.
+// The memory is read from /proc/self/statm, thus on Linux only.
+// Sample usage:  ./waf --run 'lte-v2x-ue-memory --nUes=5000'
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/lte-module.h"
+#include "ns3/point-to-point-epc-helper.h"
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LteV2xUeMemory");
+
+// Resident memory of the process in bytes, 0 if /proc is not available
+uint64_t
+GetResidentMemory ()
+{
+  std::ifstream statm ("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(statm >> size >> resident))
+    {
+      return 0;
+    }
+  return resident * sysconf (_SC_PAGESIZE);
+}
+
+void
+PrintMemory (std::string what, uint64_t before, uint64_t after, uint32_t n)
+{
+  if (after > before && n != 0)
+    {
+      std::cout << "Memory per " << what << ": " << (after - before) / n
+                << " bytes (" << n << " objects)" << std::endl;
+    }
+  else
+    {
+      std::cout << "Memory per " << what << ": not available" << std::endl;
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nUes = 5000;
+
+  CommandLine cmd;
+  cmd.AddValue ("nUes", "Number of UEs", nUes);
+  cmd.Parse (argc, argv);
+
+  // the UE devices installed out of coverage, as in V2V mode
+  Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetEpcHelper (epcHelper);
+  lteHelper->DisableEnbPhy (true);
+  lteHelper->SetV2VMode (true);
+  lteHelper->SetRbPerSubChannel (10);
+  lteHelper->SetAttribute ("UseSidelink", BooleanValue (true));
+  lteHelper->Initialize ();
+
+  NodeContainer ueNodes;
+  ueNodes.Create (nUes);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "DeltaX", DoubleValue (5.0),
+                                 "DeltaY", DoubleValue (5.0),
+                                 "GridWidth", UintegerValue (100));
+  mobility.Install (ueNodes);
+
+  uint64_t memoryBeforeUes = GetResidentMemory ();
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  uint64_t memoryAfterUes = GetResidentMemory ();
+  PrintMemory ("UE device", memoryBeforeUes, memoryAfterUes, ueDevs.GetN ());
+
+  // the PHYs alone, after the UE devices so as not to reuse their memory
+  Ptr<const SpectrumValue> noisePsd = LteSpectrumValueHelper::CreateNoisePowerSpectralDensity (23330, 50, 9.0);
+  std::vector<Ptr<LteSpectrumPhy> > phys;
+  phys.reserve (nUes);
+  uint64_t memoryBeforePhys = GetResidentMemory ();
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      Ptr<LteSpectrumPhy> phy = CreateObject<LteSpectrumPhy> ();
+      phy->SetRbPerSubChannel (10);
+      phy->SetNoisePowerSpectralDensity (noisePsd);
+      phys.push_back (phy);
+    }
+  uint64_t memoryAfterPhys = GetResidentMemory ();
+  PrintMemory ("LteSpectrumPhy", memoryBeforePhys, memoryAfterPhys, nUes);
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      phys[i]->Dispose ();
+    }
+  phys.clear ();
+
+  Simulator::Destroy ();
+  return 0;
+}
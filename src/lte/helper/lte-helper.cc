@@ -96,6 +96,7 @@ LteHelper::DoInitialize (void)
   m_phyStats = CreateObject<PhyStatsCalculator> ();
   m_phyTxStats = CreateObject<PhyTxStatsCalculator> ();
   m_phyRxStats = CreateObject<PhyRxStatsCalculator> ();
+  m_slV2xMetrics = CreateObject<SlV2xMetricsCalculator> ();
   m_macStats = CreateObject<MacStatsCalculator> ();
   Object::DoInitialize ();
 
@@ -580,7 +581,7 @@ LteHelper::InstallUeDevice (NodeContainer c)
       Ptr<NetDevice> device;
       if(m_v2v)
       {
-        device = InstallSingleVueDevice (node, c, nodeIdx);
+        device = InstallSingleVueDevice (node, nodeIdx);
       }
       else
       {
@@ -852,7 +853,7 @@ LteHelper::InstallSingleEnbDevice (Ptr<Node> n)
 }
 
 Ptr<NetDevice>
-LteHelper::InstallSingleVueDevice (Ptr<Node> n, NodeContainer c, uint32_t nodeIdx)
+LteHelper::InstallSingleVueDevice (Ptr<Node> n, uint32_t nodeIdx)
 {
   NS_LOG_FUNCTION (this);
 
@@ -892,6 +893,7 @@ LteHelper::InstallSingleVueDevice (Ptr<Node> n, NodeContainer c, uint32_t nodeId
     phy->SetSlSpectrumPhy(slPhy);
     slPhy->SetAttribute("CtrlFullDuplexEnabled", BooleanValue (true));
     slPhy->SetAttribute("HalfDuplexPhy", PointerValue(slPhy)); // pointer to sl spectrumphy
+    slPhy->SetAttribute ("SlBandwidth", UintegerValue (it->second->GetSlBandwidth ()));
     slPhy->SetRbPerSubChannel (m_rbPerSubChannel);
     slPhy->SetEnableFullDuplex (m_enableFullDuplex);
     slPhy->SetTJAlgo(isTJAlgo);
@@ -916,7 +918,6 @@ LteHelper::InstallSingleVueDevice (Ptr<Node> n, NodeContainer c, uint32_t nodeId
 
     Ptr<MobilityModel> mm = n->GetObject<MobilityModel> ();
     slPhy->SetMobility(mm);
-    slPhy->SetNodeList(c);
 
     Ptr<AntennaModel> antenna = (m_ueAntennaModelFactory.Create ())->GetObject<AntennaModel> ();
     slPhy->SetAntenna (antenna);
@@ -1965,6 +1966,19 @@ LteHelper::EnableSlPscchRxPhyTraces (void)
                    MakeBoundCallback (&PhyRxStatsCalculator::SlPscchReceptionCallback, m_phyRxStats));
 }
 
+void
+LteHelper::EnableSlV2xMetrics (void)
+{
+  Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/ComponentCarrierMapUe/*/LteUePhy/SlSpectrumPhy/SlPscchReception",
+                                 MakeCallback (&SlV2xMetricsCalculator::SlPscchReception, m_slV2xMetrics));
+}
+
+Ptr<SlV2xMetricsCalculator>
+LteHelper::GetSlV2xMetrics (void)
+{
+  return m_slV2xMetrics;
+}
+
 
 void
 LteHelper::EnableMacTraces (void)
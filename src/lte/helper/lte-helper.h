@@ -35,6 +35,7 @@
 #include <ns3/phy-stats-calculator.h>
 #include <ns3/phy-tx-stats-calculator.h>
 #include <ns3/phy-rx-stats-calculator.h>
+#include <ns3/sl-v2x-metrics-calculator.h>
 #include <ns3/mac-stats-calculator.h>
 #include <ns3/radio-bearer-stats-calculator.h>
 #include <ns3/radio-bearer-stats-connector.h>
@@ -788,6 +789,17 @@ public:
    */
   void EnableSlPsschMacTraces (void);
 
+  /**
+   * Enable the aggregation of the Sidelink PSCCH receptions into PRR,
+   * inter-packet gap and failure cause statistics per time window.
+   */
+  void EnableSlV2xMetrics (void);
+
+  /**
+   * \return The aggregator of the Sidelink PSCCH receptions
+   */
+  Ptr<SlV2xMetricsCalculator> GetSlV2xMetrics (void);
+
   /**
    * Deploys the Sidelink configuration to the eNodeBs
    *
@@ -856,7 +868,7 @@ private:
    * \return Pointer to the created device
    */
   Ptr<NetDevice> InstallSingleUeDevice (Ptr<Node> n);
-  Ptr<NetDevice> InstallSingleVueDevice (Ptr<Node> n, NodeContainer c, uint32_t nodeIdx);
+  Ptr<NetDevice> InstallSingleVueDevice (Ptr<Node> n, uint32_t nodeIdx);
 
   /**
    * The actual function to trigger a manual handover.
@@ -947,6 +959,8 @@ private:
   Ptr<PhyTxStatsCalculator> m_phyTxStats;
   /// Container of PHY layer statistics related to reception.
   Ptr<PhyRxStatsCalculator> m_phyRxStats;
+  /// Aggregator of the Sidelink PSCCH receptions.
+  Ptr<SlV2xMetricsCalculator> m_slV2xMetrics;
   /// Container of MAC layer statistics.
   Ptr<MacStatsCalculator> m_macStats;
   /// Container of RLC layer statistics.
@@ -42,6 +42,9 @@
 #include <ns3/angles.h>
 #include <ns3/random-variable-stream.h>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <map>
 
 
 namespace ns3 {
@@ -52,9 +55,11 @@ NS_LOG_COMPONENT_DEFINE ("LteSidelinkHelper");
 NS_OBJECT_ENSURE_REGISTERED (LteSidelinkHelper);
 
 LteSidelinkHelper::LteSidelinkHelper ()
+  : m_maxAssociationDistance (0)
 {
   NS_LOG_FUNCTION (this);
   m_uniformRandomVariable = CreateObject<UniformRandomVariable> ();
+  m_rsrpCalculator = CreateObject<SidelinkRsrpCalculator> ();
 }
 
 LteSidelinkHelper::~LteSidelinkHelper (void)
@@ -69,7 +74,13 @@ TypeId LteSidelinkHelper::GetTypeId (void)
     TypeId ("ns3::LteSidelinkHelper")
     .SetParent<Object> ()
     .AddConstructor<LteSidelinkHelper> ()
-
+    .AddAttribute ("MaxAssociationDistance",
+                   "Maximum distance (m) between a transmitter and a receiver of a group. "
+                   "The UEs farther away are not considered by the association methods, "
+                   "and their RSRP is not computed. 0 disables the limit.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&LteSidelinkHelper::m_maxAssociationDistance),
+                   MakeDoubleChecker<double> (0.0))
   ;
   return tid;
 }
@@ -78,6 +89,8 @@ void
 LteSidelinkHelper::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_rsrpCalculator->Dispose ();
+  m_rsrpCalculator = 0;
   Object::DoDispose ();
 }
 
@@ -104,65 +117,251 @@ LteSidelinkHelper::RemoveNetDevice (NetDeviceContainer container, Ptr<NetDevice>
   return newContainer;
 }
 
+namespace {
+
+/**
+ * Set of UE indices supporting the random selection and the removal of an
+ * index in constant time. The removal moves the last index of the set into
+ * the position of the removed one.
+ */
+class SlUeIndexSet
+{
+public:
+  /**
+   * Create the set of all the indices lower than the given number of UEs
+   * \param nUes The number of UEs
+   */
+  SlUeIndexSet (uint32_t nUes)
+    : m_indices (nUes),
+      m_positions (nUes)
+  {
+    for (uint32_t i = 0; i < nUes; i++)
+      {
+        m_indices[i] = i;
+        m_positions[i] = i;
+      }
+  }
+
+  /// \return The number of indices in the set
+  uint32_t GetN () const
+  {
+    return m_indices.size ();
+  }
+
+  /**
+   * \param i The position in the set
+   * \return The index at the given position
+   */
+  uint32_t Get (uint32_t i) const
+  {
+    return m_indices[i];
+  }
+
+  /**
+   * Remove an index from the set, if present
+   * \param index The index to remove
+   */
+  void Remove (uint32_t index)
+  {
+    uint32_t pos = m_positions[index];
+    if (pos == NOT_IN_SET)
+      {
+        return;
+      }
+    m_indices[pos] = m_indices.back ();
+    m_positions[m_indices[pos]] = pos;
+    m_indices.pop_back ();
+    m_positions[index] = NOT_IN_SET;
+  }
+
+private:
+  static const uint32_t NOT_IN_SET = 0xFFFFFFFF; ///< position of the indices not in the set
+  std::vector<uint32_t> m_indices; ///< indices in the set
+  std::vector<uint32_t> m_positions; ///< position of each index in m_indices
+};
+
+/**
+ * Per-index view of the UEs being associated: the uplink spectrum PHY
+ * and the position of each UE, and, when a maximum association distance
+ * is set, a grid of square cells whose side is this distance. The UEs in
+ * range of a transmitter are then in the 3x3 cells around it, and only
+ * these UEs are considered as candidate receivers.
+ */
+class SlUeAssociationIndex
+{
+public:
+  /**
+   * \param ues The UEs to associate
+   * \param maxDistance The maximum distance between a transmitter and a receiver, 0 for no limit
+   */
+  SlUeAssociationIndex (NetDeviceContainer ues, double maxDistance)
+    : m_maxDistance (maxDistance)
+  {
+    uint32_t nUes = ues.GetN ();
+    m_phys.reserve (nUes);
+    m_positions.reserve (nUes);
+    for (uint32_t i = 0; i < nUes; i++)
+      {
+        Ptr<SpectrumPhy> phy = ues.Get (i)->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
+        m_phys.push_back (phy);
+        m_positions.push_back (phy->GetMobility ()->GetPosition ());
+        if (m_maxDistance > 0)
+          {
+            m_cells[GetCell (m_positions[i])].push_back (i);
+          }
+      }
+  }
+
+  /**
+   * \param i The UE index
+   * \return The uplink spectrum PHY of the UE
+   */
+  Ptr<SpectrumPhy> GetPhy (uint32_t i) const
+  {
+    return m_phys[i];
+  }
+
+  /**
+   * \param i The UE index
+   * \return The position of the UE when the association started
+   */
+  const Vector& GetPosition (uint32_t i) const
+  {
+    return m_positions[i];
+  }
+
+  /**
+   * \param a A position
+   * \param b Another position
+   * \return True if no maximum distance is set or the positions are within the maximum distance
+   */
+  bool InRange (const Vector &a, const Vector &b) const
+  {
+    return m_maxDistance <= 0 || CalculateDistance (a, b) <= m_maxDistance;
+  }
+
+  /**
+   * Get the candidate receivers of a transmitter: the eligible UEs, other
+   * than the transmitter, within the maximum distance of the transmitter
+   * \param tx The index of the transmitter
+   * \param eligible The UEs which can be selected
+   * \param candidates The indices of the candidate receivers, in increasing order
+   */
+  void GetCandidateReceivers (uint32_t tx, const std::vector<bool> &eligible, std::vector<uint32_t> &candidates) const
+  {
+    candidates.clear ();
+    if (m_maxDistance <= 0)
+      {
+        for (uint32_t i = 0; i < eligible.size (); i++)
+          {
+            if (eligible[i] && i != tx)
+              {
+                candidates.push_back (i);
+              }
+          }
+        return;
+      }
+    Cell cell = GetCell (m_positions[tx]);
+    for (int64_t x = cell.first - 1; x <= cell.first + 1; x++)
+      {
+        for (int64_t y = cell.second - 1; y <= cell.second + 1; y++)
+          {
+            std::map<Cell, std::vector<uint32_t> >::const_iterator it = m_cells.find (Cell (x, y));
+            if (it == m_cells.end ())
+              {
+                continue;
+              }
+            for (std::vector<uint32_t>::const_iterator rxIt = it->second.begin (); rxIt != it->second.end (); rxIt++)
+              {
+                if (eligible[*rxIt] && *rxIt != tx && InRange (m_positions[tx], m_positions[*rxIt]))
+                  {
+                    candidates.push_back (*rxIt);
+                  }
+              }
+          }
+      }
+    std::sort (candidates.begin (), candidates.end ());
+  }
+
+private:
+  /// Grid cell coordinates
+  typedef std::pair<int64_t, int64_t> Cell;
+
+  /**
+   * \param pos A position
+   * \return The grid cell of the position
+   */
+  Cell GetCell (const Vector &pos) const
+  {
+    return Cell ((int64_t) std::floor (pos.x / m_maxDistance), (int64_t) std::floor (pos.y / m_maxDistance));
+  }
+
+  double m_maxDistance; ///< maximum association distance, 0 for no limit
+  std::vector<Ptr<SpectrumPhy> > m_phys; ///< uplink spectrum PHY per UE
+  std::vector<Vector> m_positions; ///< position per UE
+  std::map<Cell, std::vector<uint32_t> > m_cells; ///< UE indices per grid cell
+};
+
+} // unnamed namespace
+
+double
+LteSidelinkHelper::CalcRsrp (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy, SrsrpMethod_t compMethod)
+{
+  if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
+    {
+      return m_rsrpCalculator->CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, rxPhy);
+    }
+  return SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, rxPhy);
+}
 
 std::vector < NetDeviceContainer >
 LteSidelinkHelper::AssociateForGroupcast (double txPower, double ulEarfcn, double ulBandwidth, NetDeviceContainer ues, double rsrpThreshold, int nGroups, int nReceivers, SrsrpMethod_t compMethod)
 {
   std::vector < NetDeviceContainer > groups; //groups created
 
-  NetDeviceContainer remainingUes; //list of UEs not assigned to groups
-  remainingUes.Add (ues);
+  SlUeAssociationIndex index (ues, m_maxAssociationDistance);
+  std::vector<bool> remainingUes (ues.GetN (), true); //UEs not assigned to groups
 
   // Start association of groupcast links, set NUM_GROUPS_ASSOCIATED = 0.
   int32_t numGroupsAssociated = 0;
 
-  NetDeviceContainer candidateTx; //list of UEs not assigned to groups that can be selected for transmission
-  candidateTx.Add (ues);
+  SlUeIndexSet candidateTx (ues.GetN ()); //UEs not assigned to groups that can be selected for transmission
 
   Ptr<Object> uplinkPathlossModel = m_lteHelper->GetUplinkPathlossModel ();
   Ptr<PropagationLossModel> lossModel = uplinkPathlossModel->GetObject<PropagationLossModel> ();
   NS_ASSERT_MSG (lossModel != 0, " " << uplinkPathlossModel << " is not a PropagationLossModel");
 
+  std::vector<uint32_t> candidateRx;
+  std::vector<uint32_t> selectedRx;
   while (numGroupsAssociated < nGroups && candidateTx.GetN () > 0)
     {
       //Transmitter UE is randomly selected from the total number of UEs.
-      uint32_t iTx = m_uniformRandomVariable->GetValue (0, candidateTx.GetN ());
-      Ptr<NetDevice> tx = candidateTx.Get (iTx);
-      NS_LOG_DEBUG (" Candidate Tx= " << tx->GetNode ()->GetId ());
-      candidateTx = RemoveNetDevice (candidateTx, tx);
+      uint32_t tx = candidateTx.Get (m_uniformRandomVariable->GetValue (0, candidateTx.GetN ()));
+      NS_LOG_DEBUG (" Candidate Tx= " << ues.Get (tx)->GetNode ()->GetId ());
+      candidateTx.Remove (tx);
       //build list of candidate receivers
-      NetDeviceContainer candidateRx = RemoveNetDevice (remainingUes, tx);
-      NetDeviceContainer selectedRx;
+      index.GetCandidateReceivers (tx, remainingUes, candidateRx);
+      selectedRx.clear ();
 
       //Start selecting the receiver for the transmitter, set NUM_RECEIVERS_ASSOCIATED = 0.
       int32_t numReceiversAssociated = 0;
 
       //Receiver UE is randomly selected from the remaining UEs (i.e., not already part of a group).
-      while (numReceiversAssociated < nReceivers && candidateRx.GetN () > 0)
+      while (numReceiversAssociated < nReceivers && candidateRx.size () > 0)
         {
-          uint32_t iRx = m_uniformRandomVariable->GetValue (0, candidateRx.GetN ());
-          Ptr<NetDevice> rx = candidateRx.Get (iRx);
-          candidateRx = RemoveNetDevice (candidateRx, rx);
-          double rsrpRx = 0;
+          uint32_t iRx = m_uniformRandomVariable->GetValue (0, candidateRx.size ());
+          uint32_t rx = candidateRx[iRx];
+          candidateRx[iRx] = candidateRx.back ();
+          candidateRx.pop_back ();
 
-          Ptr<SpectrumPhy> txPhy = tx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-          Ptr<SpectrumPhy> rxPhy = rx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-
-          if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
-            {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, rxPhy);
-            }
-          else
-            {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, rxPhy);
-            }
+          double rsrpRx = CalcRsrp (lossModel, txPower, ulEarfcn, ulBandwidth, index.GetPhy (tx), index.GetPhy (rx), compMethod);
           //If receiver UE is not within RSRP* of X dBm of the transmitter UE then randomly reselect the receiver UE among the UEs that are
           //within the RSRP of X dBm of the transmitter UE and are not part of a group already.
-          NS_LOG_DEBUG ("\tCandidate Rx= " << rx->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
+          NS_LOG_DEBUG ("\tCandidate Rx= " << ues.Get (rx)->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
           if (rsrpRx >= rsrpThreshold)
             {
               //good receiver
-              selectedRx.Add (rx);
+              selectedRx.push_back (rx);
               numReceiversAssociated++;
               NS_LOG_DEBUG ("\tAdding Rx to group");
             }
@@ -172,16 +371,14 @@ LteSidelinkHelper::AssociateForGroupcast (double txPower, double ulEarfcn, doubl
           NS_LOG_DEBUG (" Group successfully created");
           //found all the receivers, update lists
           //remove receivers from candidate Tx and remaining nodes
-          remainingUes = RemoveNetDevice (remainingUes, tx); //remove selected Tx
-          uint32_t nDevices = selectedRx.GetN ();
-          for (uint32_t i = 0; i < nDevices; ++i)
+          remainingUes[tx] = false; //remove selected Tx
+          NetDeviceContainer newGroup (ues.Get (tx));
+          for (uint32_t i = 0; i < selectedRx.size (); ++i)
             {
-              Ptr<NetDevice> p = selectedRx.Get (i);
-              candidateTx = RemoveNetDevice (candidateTx, p);
-              remainingUes = RemoveNetDevice (remainingUes, p);
+              candidateTx.Remove (selectedRx[i]);
+              remainingUes[selectedRx[i]] = false;
+              newGroup.Add (ues.Get (selectedRx[i]));
             }
-          NetDeviceContainer newGroup (tx);
-          newGroup.Add (selectedRx);
           groups.push_back (newGroup);
           numGroupsAssociated++;
         }
@@ -201,85 +398,52 @@ LteSidelinkHelper::AssociateForBroadcast (double txPower, double ulEarfcn, doubl
 {
   std::vector < NetDeviceContainer > groups; //groups created
 
-  NetDeviceContainer remainingUes; //list of UEs not assigned to groups
-  remainingUes.Add (ues);
+  SlUeAssociationIndex index (ues, m_maxAssociationDistance);
+  std::vector<bool> remainingUes (ues.GetN (), true); //UEs not assigned to groups
 
   // Start the selection of the transmitters
-  NetDeviceContainer candidateTx; //list of UEs that can be selected for transmission
-  candidateTx.Add (ues);
-  NetDeviceContainer selectedTx;
-  uint32_t numTransmittersSelected = 0;
+  std::vector<uint32_t> selectedTx = SelectTransmitters (ues, nTransmitters);
+  for (uint32_t i = 0; i < selectedTx.size (); i++)
+    {
+      remainingUes[selectedTx[i]] = false;
+    }
 
   Ptr<Object> uplinkPathlossModel = m_lteHelper->GetUplinkPathlossModel ();
   Ptr<PropagationLossModel> lossModel = uplinkPathlossModel->GetObject<PropagationLossModel> ();
   NS_ASSERT_MSG (lossModel != 0, " " << uplinkPathlossModel << " is not a PropagationLossModel");
 
-  while (numTransmittersSelected < nTransmitters)
-    {
-      //Transmitter UE is randomly selected from the total number of UEs.
-      uint32_t iTx = m_uniformRandomVariable->GetValue (0, candidateTx.GetN ());
-      Ptr<NetDevice> tx = candidateTx.Get (iTx);
-      NS_LOG_DEBUG (" Candidate Tx= " << tx->GetNode ()->GetId ());
-      selectedTx.Add (tx);
-      candidateTx = RemoveNetDevice (candidateTx, tx);
-      remainingUes = RemoveNetDevice (remainingUes, tx);
-      numTransmittersSelected++;
-    }
-
   //For each remaining UE, associate to all transmitters where RSRP is greater than X dBm
-  for (uint32_t i = 0; i < numTransmittersSelected; i++)
+  std::vector<uint32_t> candidateRx;
+  for (uint32_t i = 0; i < selectedTx.size (); i++)
     {
-      Ptr<NetDevice> tx = selectedTx.Get (i);
+      uint32_t tx = selectedTx[i];
       //prepare group for this transmitter
-      NetDeviceContainer newGroup (tx);
-      uint32_t nRxDevices = remainingUes.GetN ();
+      NetDeviceContainer newGroup (ues.Get (tx));
+      index.GetCandidateReceivers (tx, remainingUes, candidateRx);
       double rsrpRx = 0;
 
-      for (uint32_t j = 0; j < nRxDevices; ++j)
+      for (uint32_t j = 0; j < candidateRx.size (); ++j)
         {
-          Ptr<NetDevice> rx = remainingUes.Get (j);
-
-          Ptr<SpectrumPhy> txPhy = tx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-          Ptr<SpectrumPhy> rxPhy = rx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-
-          if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
-            {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, rxPhy);
-            }
-          else
-            {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, rxPhy);
-            }
+          uint32_t rx = candidateRx[j];
+          rsrpRx = CalcRsrp (lossModel, txPower, ulEarfcn, ulBandwidth, index.GetPhy (tx), index.GetPhy (rx), compMethod);
           //If receiver UE is not within RSRP* of X dBm of the transmitter UE then randomly reselect the receiver UE among the UEs
           //that are within the RSRP of X dBm of the transmitter UE and are not part of a group already.
-          NS_LOG_DEBUG ("\tCandidate Rx= " << rx->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
+          NS_LOG_DEBUG ("\tCandidate Rx= " << ues.Get (rx)->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
           if (rsrpRx >= rsrpThreshold)
             {
               //good receiver
               NS_LOG_DEBUG ("\tAdding Rx to group");
-              newGroup.Add (rx);
+              newGroup.Add (ues.Get (rx));
             }
         }
 
       //Initializing link to other transmitters to be able to receive SLSSs from other transmitters
-      for (uint32_t k = 0; k < numTransmittersSelected; k++)
+      for (uint32_t k = 0; k < selectedTx.size (); k++)
         {
-          if (k != i)
+          if (k != i && index.InRange (index.GetPosition (tx), index.GetPosition (selectedTx[k])))
             {
-              Ptr<NetDevice> othertx = selectedTx.Get (k);
-
-              Ptr<SpectrumPhy> txPhy = tx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-              Ptr<SpectrumPhy> otherTxPhy = othertx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-
-              if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
-                {
-                  rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, otherTxPhy);
-                }
-              else
-                {
-                  rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, otherTxPhy);
-                }
-              NS_LOG_DEBUG ("\tOther Tx= " << othertx->GetNode ()->GetId () << " Rsrp=" << rsrpRx);
+              rsrpRx = CalcRsrp (lossModel, txPower, ulEarfcn, ulBandwidth, index.GetPhy (tx), index.GetPhy (selectedTx[k]), compMethod);
+              NS_LOG_DEBUG ("\tOther Tx= " << ues.Get (selectedTx[k])->GetNode ()->GetId () << " Rsrp=" << rsrpRx);
             }
         }
 
@@ -294,65 +458,24 @@ LteSidelinkHelper::AssociateForBroadcastWithTxEnabledToReceive (double txPower,
 {
   std::vector < NetDeviceContainer > groups; //groups created
 
-  NetDeviceContainer remainingUes; //list of UEs not assigned to groups
-  remainingUes.Add (ues);
+  SlUeAssociationIndex index (ues, m_maxAssociationDistance);
+  std::vector<bool> remainingUes (ues.GetN (), true); //the transmitters also receive
 
   // Start the selection of the transmitters
-  NetDeviceContainer candidateTx; //list of UEs that can be selected for transmission
-  candidateTx.Add (ues);
-  NetDeviceContainer selectedTx;
-  uint32_t numTransmittersSelected = 0;
-
-  Ptr<Object> uplinkPathlossModel = m_lteHelper->GetUplinkPathlossModel ();
-  Ptr<PropagationLossModel> lossModel = uplinkPathlossModel->GetObject<PropagationLossModel> ();
-  NS_ASSERT_MSG (lossModel != 0, " " << uplinkPathlossModel << " is not a PropagationLossModel");
+  std::vector<uint32_t> selectedTx = SelectTransmitters (ues, nTransmitters);
 
-  while (numTransmittersSelected < nTransmitters)
+  //For each UE, associate to all the other transmitters
+  std::vector<uint32_t> candidateRx;
+  for (uint32_t i = 0; i < selectedTx.size (); i++)
     {
-      //Transmitter UE is randomly selected from the total number of UEs.
-      uint32_t iTx = m_uniformRandomVariable->GetValue (0, candidateTx.GetN ());
-      Ptr<NetDevice> tx = candidateTx.Get (iTx);
-      NS_LOG_DEBUG (" Candidate Tx= " << tx->GetNode ()->GetId ());
-      selectedTx.Add (tx);
-      candidateTx = RemoveNetDevice (candidateTx, tx);
-      numTransmittersSelected++;
-    }
-
-  //For each remaining UE, associate to all transmitters where RSRP is greater than X dBm
-  for (uint32_t i = 0; i < numTransmittersSelected; i++)
-    {
-      Ptr<NetDevice> tx = selectedTx.Get (i);
+      uint32_t tx = selectedTx[i];
       //prepare group for this transmitter
-      NetDeviceContainer newGroup (tx);
-      uint32_t nRxDevices = remainingUes.GetN ();
-      //double rsrpRx = 0;
-
-      for (uint32_t j = 0; j < nRxDevices; ++j)
+      NetDeviceContainer newGroup (ues.Get (tx));
+      //No loopback link possible due to half-duplex
+      index.GetCandidateReceivers (tx, remainingUes, candidateRx);
+      for (uint32_t j = 0; j < candidateRx.size (); ++j)
         {
-          Ptr<NetDevice> rx = remainingUes.Get (j);
-          if (rx->GetNode ()->GetId () != tx->GetNode ()->GetId ()) //No loopback link possible due to half-duplex
-            {
-              Ptr<SpectrumPhy> txPhy = tx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-              Ptr<SpectrumPhy> rxPhy = rx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-              //if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
-              //  {
-
-              //    rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, rxPhy);
-              //  }
-              //else
-              //  {
-              //    rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, rxPhy);
-              //  }
-              //If receiver UE is not within RSRP* of X dBm of the transmitter UE then randomly reselect the receiver UE among the UEs that are within the RSRP of X dBm of the transmitter UE and are not part of a group already.
-              //NS_LOG_DEBUG ("\tCandidate Rx= " << rx->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
-              //if (rsrpRx >= rsrpThreshold)
-              //  {
-                  //good receiver
-              //    NS_LOG_DEBUG ("\tAdding Rx to group");
-              //    newGroup.Add (rx);
-              //  }
-              newGroup.Add (rx);
-            }
+          newGroup.Add (ues.Get (candidateRx[j]));
         }
       groups.push_back (newGroup);
     }
@@ -365,72 +488,56 @@ LteSidelinkHelper::AssociateForBroadcastWithWrapAround (double txPower, double u
 {
   std::vector < NetDeviceContainer > groups; //groups created
 
-  NetDeviceContainer remainingUes; //list of UEs not assigned to groups
-  remainingUes.Add (ues);
-
-  // Start the selection of the transmitters
-  NetDeviceContainer candidateTx; //list of UEs that can be selected for transmission
-  candidateTx.Add (ues);
-  NetDeviceContainer selectedTx;
-  uint32_t numTransmittersSelected = 0;
+  //the distance is checked on the wrapped positions, not with the grid
+  SlUeAssociationIndex index (ues, 0);
+  std::vector<uint32_t> selectedTx = SelectTransmitters (ues, nTransmitters);
+  std::vector<bool> remainingUes (ues.GetN (), true); //UEs not assigned to groups
+  for (uint32_t i = 0; i < selectedTx.size (); i++)
+    {
+      remainingUes[selectedTx[i]] = false;
+    }
 
   Ptr<Object> uplinkPathlossModel = m_lteHelper->GetUplinkPathlossModel ();
   Ptr<PropagationLossModel> lossModel = uplinkPathlossModel->GetObject<PropagationLossModel> ();
   NS_ASSERT_MSG (lossModel != 0, " " << uplinkPathlossModel << " is not a PropagationLossModel");
 
-  while (numTransmittersSelected < nTransmitters)
-    {
-      //Transmitter UE is randomly selected from the total number of UEs.
-      uint32_t iTx = m_uniformRandomVariable->GetValue (0, candidateTx.GetN ());
-      Ptr<NetDevice> tx = candidateTx.Get (iTx);
-      NS_LOG_DEBUG (" Candidate Tx= " << tx->GetNode ()->GetId ());
-      selectedTx.Add (tx);
-      candidateTx = RemoveNetDevice (candidateTx, tx);
-      remainingUes = RemoveNetDevice (remainingUes, tx);
-      numTransmittersSelected++;
-    }
-
   //For each remaining UE, associate to all transmitters where RSRP is greater than X dBm
-  for (uint32_t i = 0; i < numTransmittersSelected; i++)
+  std::vector<uint32_t> candidateRx;
+  for (uint32_t i = 0; i < selectedTx.size (); i++)
     {
-      Ptr<NetDevice> tx = selectedTx.Get (i);
+      uint32_t tx = selectedTx[i];
       //prepare group for this transmitter
-      NetDeviceContainer newGroup (tx);
-      uint32_t nRxDevices = remainingUes.GetN ();
+      NetDeviceContainer newGroup (ues.Get (tx));
+      index.GetCandidateReceivers (tx, remainingUes, candidateRx);
       double rsrpRx = 0;
 
-      for (uint32_t j = 0; j < nRxDevices; ++j)
+      for (uint32_t j = 0; j < candidateRx.size (); ++j)
         {
-          Ptr<NetDevice> rx = remainingUes.Get (j);
+          uint32_t rx = candidateRx[j];
+          Ptr<MobilityModel> rxMobility = index.GetPhy (rx)->GetMobility ();
           //With wrap around, the closest location may be in one of the extended hexagon
           //store position
-          Vector rxPos = rx->GetNode ()->GetObject<MobilityModel> ()->GetPosition ();
-          Vector closestPos = topologyHelper->GetClosestPositionInWrapAround (tx->GetNode ()->GetObject<MobilityModel> ()->GetPosition (), rxPos);
-          //assign temporary position to compute RSRP
-          rx->GetNode ()->GetObject<MobilityModel> ()->SetPosition (closestPos);
-
-          Ptr<SpectrumPhy> txPhy = tx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-          Ptr<SpectrumPhy> rxPhy = rx->GetObject<LteUeNetDevice> ()->GetPhy ()->GetUlSpectrumPhy ();
-
-          if (compMethod == LteSidelinkHelper::SLRSRP_PSBCH)
-            {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpPsbch (lossModel, txPower, ulEarfcn, ulBandwidth, txPhy, rxPhy);
-            }
-          else
+          Vector rxPos = rxMobility->GetPosition ();
+          Vector closestPos = topologyHelper->GetClosestPositionInWrapAround (index.GetPhy (tx)->GetMobility ()->GetPosition (), rxPos);
+          if (m_maxAssociationDistance > 0 && CalculateDistance (index.GetPhy (tx)->GetMobility ()->GetPosition (), closestPos) > m_maxAssociationDistance)
             {
-              rsrpRx = SidelinkRsrpCalculator::CalcSlRsrpTxPw (lossModel, txPower, txPhy, rxPhy);
+              continue;
             }
+          //assign temporary position to compute RSRP
+          rxMobility->SetPosition (closestPos);
+
+          rsrpRx = CalcRsrp (lossModel, txPower, ulEarfcn, ulBandwidth, index.GetPhy (tx), index.GetPhy (rx), compMethod);
           //If receiver UE is not within RSRP* of X dBm of the transmitter UE then randomly reselect the receiver UE among the UEs that are within the RSRP of X dBm of the transmitter UE and are not part of a group already.
-          NS_LOG_DEBUG ("\tCandidate Rx= " << rx->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
+          NS_LOG_DEBUG ("\tCandidate Rx= " << ues.Get (rx)->GetNode ()->GetId () << " Rsrp=" << rsrpRx << " required=" << rsrpThreshold);
           if (rsrpRx >= rsrpThreshold)
             {
               //good receiver
               NS_LOG_DEBUG ("\tAdding Rx to group");
-              newGroup.Add (rx);
+              newGroup.Add (ues.Get (rx));
             }
 
           //restore position
-          rx->GetNode ()->GetObject<MobilityModel> ()->SetPosition (rxPos);
+          rxMobility->SetPosition (rxPos);
         }
       groups.push_back (newGroup);
     }
@@ -438,6 +545,22 @@ LteSidelinkHelper::AssociateForBroadcastWithWrapAround (double txPower, double u
   return groups;
 }
 
+std::vector<uint32_t>
+LteSidelinkHelper::SelectTransmitters (NetDeviceContainer ues, uint32_t nTransmitters)
+{
+  NS_ABORT_MSG_IF (nTransmitters > ues.GetN (), "Cannot select " << nTransmitters << " transmitters among " << ues.GetN () << " UEs");
+  SlUeIndexSet candidateTx (ues.GetN ()); //UEs that can be selected for transmission
+  std::vector<uint32_t> selectedTx;
+  while (selectedTx.size () < nTransmitters)
+    {
+      //Transmitter UE is randomly selected from the total number of UEs.
+      uint32_t tx = candidateTx.Get (m_uniformRandomVariable->GetValue (0, candidateTx.GetN ()));
+      NS_LOG_DEBUG (" Candidate Tx= " << ues.Get (tx)->GetNode ()->GetId ());
+      selectedTx.push_back (tx);
+      candidateTx.Remove (tx);
+    }
+  return selectedTx;
+}
 
 
 void
@@ -491,6 +614,14 @@ LteSidelinkHelper::DoActivateSidelinkBearer (NetDeviceContainer ues, Ptr<LteSlTf
   m_lteHelper->ActivateSidelinkBearer (ues, tft);
 }
 
+void
+LteSidelinkHelper::ActivateV2xBroadcastBearer (Time activationTime, NetDeviceContainer ues, Ipv4Address groupAddress, uint32_t groupL2Address)
+{
+  NS_LOG_FUNCTION (this << activationTime << ues.GetN () << groupAddress << groupL2Address);
+  Ptr<LteSlTft> tft = Create<LteSlTft> (LteSlTft::BIDIRECTIONAL, groupAddress, groupL2Address);
+  ActivateSidelinkBearer (activationTime, ues, tft);
+}
+
 int64_t
 LteSidelinkHelper::AssignStreams (int64_t stream)
 {
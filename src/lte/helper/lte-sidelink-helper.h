@@ -179,6 +179,20 @@ public:
    */
   void DoActivateSidelinkBearer (NetDeviceContainer ues, Ptr<LteSlTft> tft);
 
+  /**
+   * Schedule the activation of a V2X broadcast bearer. All the UEs share
+   * a single destination: each of them transmits to and receives from
+   * this destination, instead of one group being created per transmitter
+   * (see AssociateForBroadcastWithTxEnabledToReceive). A UE creates the
+   * receiving radio bearer of a source when it first hears it, so the
+   * setup and the memory grow linearly with the number of UEs.
+   * \param activationTime The time to setup the sidelink bearer
+   * \param ues The list of UEs where the bearer must be activated
+   * \param groupAddress The multicast IP address of the broadcast destination
+   * \param groupL2Address The layer 2 ID of the broadcast destination
+   */
+  void ActivateV2xBroadcastBearer (Time activationTime, NetDeviceContainer ues, Ipv4Address groupAddress, uint32_t groupL2Address);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -190,8 +204,31 @@ public:
   int64_t AssignStreams (int64_t stream);
 
 private:
+  /**
+   * Compute the Sidelink RSRP between a transmitter and a receiver
+   * \param lossModel The propagation loss model
+   * \param txPower The transmit power used by the UEs
+   * \param ulEarfcn The uplink frequency band
+   * \param ulBandwidth The uplink bandwidth
+   * \param txPhy The spectrum PHY of the transmitter
+   * \param rxPhy The spectrum PHY of the receiver
+   * \param compMethod The method to compute the SRSRP value
+   * \return The RSRP
+   */
+  double CalcRsrp (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy, SrsrpMethod_t compMethod);
+
+  /**
+   * Randomly select the transmitters among the UEs
+   * \param ues The list of UEs deployed
+   * \param nTransmitters The number of transmitters to select
+   * \return The indices of the transmitters in the list of UEs, in selection order
+   */
+  std::vector<uint32_t> SelectTransmitters (NetDeviceContainer ues, uint32_t nTransmitters);
+
   Ptr<LteHelper> m_lteHelper;
   Ptr<UniformRandomVariable> m_uniformRandomVariable; ///< Provides uniform random variables
+  double m_maxAssociationDistance; ///< Maximum distance between a transmitter and a receiver of a group, 0 for no limit
+  Ptr<SidelinkRsrpCalculator> m_rsrpCalculator; ///< Computes the RSRP of the associations
 };
 
 
@@ -23,6 +23,8 @@
 
 #include <ns3/log.h>
 #include <ns3/config.h>
+#include <ns3/simulator.h>
+#include <ns3/uinteger.h>
 #include <ns3/lte-enb-rrc.h>
 #include <ns3/lte-ue-rrc.h>
 #include <ns3/lte-enb-net-device.h>
@@ -44,7 +46,7 @@ LteStatsCalculator::LteStatsCalculator ()
 
 LteStatsCalculator::~LteStatsCalculator ()
 {
-  // Nothing to do here
+  CloseOutputStreams ();
 }
 
 
@@ -55,10 +57,101 @@ LteStatsCalculator::GetTypeId (void)
     .SetParent<Object> ()
     .SetGroupName("Lte")
     .AddConstructor<LteStatsCalculator> ()
+    .AddAttribute ("OutputBufferSize",
+                   "Size in bytes of the buffer of each output file. "
+                   "If 0, the default buffer of the standard library is used.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&LteStatsCalculator::m_outputBufferSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlushInterval",
+                   "Interval between two writes of the buffered output to the files. "
+                   "If 0, the output is only written when the buffer is full and "
+                   "when the simulator is destroyed.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&LteStatsCalculator::m_flushInterval),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
 
+void
+LteStatsCalculator::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  CloseOutputStreams ();
+  Object::DoDispose ();
+}
+
+std::ostream*
+LteStatsCalculator::GetOutputStream (std::string filename, bool truncate, bool binary)
+{
+  if (m_flushInterval > Time (0) && Simulator::Now () - m_lastFlush >= m_flushInterval)
+    {
+      FlushOutputStreams ();
+    }
+
+  std::map<std::string, OutputSink>::iterator it = m_outputSinks.find (filename);
+  if (it != m_outputSinks.end ())
+    {
+      return it->second.stream;
+    }
+
+  NS_LOG_FUNCTION (this << filename << truncate);
+  OutputSink &sink = m_outputSinks[filename];
+  sink.stream = new std::ofstream ();
+  if (m_outputBufferSize > 0)
+    {
+      // the buffer must be set before the file is opened
+      sink.buffer.resize (m_outputBufferSize);
+      sink.stream->rdbuf ()->pubsetbuf (&sink.buffer[0], sink.buffer.size ());
+    }
+  std::ios_base::openmode mode = truncate ? std::ios_base::out : std::ios_base::app;
+  if (binary)
+    {
+      mode |= std::ios_base::binary;
+    }
+  sink.stream->open (filename.c_str (), mode);
+  if (!sink.stream->is_open ())
+    {
+      delete sink.stream;
+      m_outputSinks.erase (filename);
+      return 0;
+    }
+
+  if (!m_closeEvent.IsRunning ())
+    {
+      m_closeEvent = Simulator::ScheduleDestroy (&LteStatsCalculator::CloseOutputStreams, this);
+    }
+  return sink.stream;
+}
+
+void
+LteStatsCalculator::FlushOutputStreams ()
+{
+  NS_LOG_FUNCTION (this);
+  for (std::map<std::string, OutputSink>::iterator it = m_outputSinks.begin (); it != m_outputSinks.end (); ++it)
+    {
+      it->second.stream->flush ();
+    }
+  m_lastFlush = Simulator::Now ();
+}
+
+void
+LteStatsCalculator::CloseOutputStreams ()
+{
+  if (m_outputSinks.empty ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  m_closeEvent.Cancel ();
+  for (std::map<std::string, OutputSink>::iterator it = m_outputSinks.begin (); it != m_outputSinks.end (); ++it)
+    {
+      it->second.stream->close ();
+      delete it->second.stream;
+    }
+  m_outputSinks.clear ();
+}
 
 void
 LteStatsCalculator::SetUlOutputFilename (std::string outputFilename)
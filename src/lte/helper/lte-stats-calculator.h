@@ -24,7 +24,11 @@
 
 #include "ns3/object.h"
 #include "ns3/string.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 #include <map>
+#include <vector>
+#include <fstream>
 
 namespace ns3 {
 
@@ -149,7 +153,34 @@ public:
    */
   uint16_t GetCellIdPath (std::string path);
 
+  /**
+   * Write the buffered output of all the open output files to disk
+   */
+  void FlushOutputStreams (void);
+
+  /**
+   * Flush and close all the open output files
+   */
+  void CloseOutputStreams (void);
+
 protected:
+  virtual void DoDispose (void);
+
+  /**
+   * Get the persistent output stream of a file. The file is opened on
+   * the first call, with a buffer of OutputBufferSize bytes, and stays
+   * open until the end of the simulation. The buffered output is written
+   * when the buffer is full, on the first write after each FlushInterval
+   * (so that no event keeps the simulation running) and when the
+   * simulator is destroyed.
+   *
+   * @param filename Name of the file
+   * @param truncate True to truncate the file when it is opened, false to append to it
+   * @param binary True to open the file in binary mode
+   * @return the output stream, or 0 if the file cannot be opened
+   */
+  std::ostream* GetOutputStream (std::string filename, bool truncate, bool binary = false);
+
 
   /**
    * Retrieves IMSI from Enb RLC path in the attribute system
@@ -212,6 +243,38 @@ protected:
   static uint64_t FindImsiForUe (std::string path, uint16_t rnti);
 
 private:
+  /// Persistent output file and its buffer
+  struct OutputSink
+  {
+    std::ofstream *stream; ///< output file stream
+    std::vector<char> buffer; ///< buffer of the file stream
+  };
+
+  /**
+   * Open output files by file name
+   */
+  std::map<std::string, OutputSink> m_outputSinks;
+
+  /**
+   * Size in bytes of the buffer of each output file
+   */
+  uint32_t m_outputBufferSize;
+
+  /**
+   * Interval between two flushes of the output files
+   */
+  Time m_flushInterval;
+
+  /**
+   * Time of the last flush of the output files
+   */
+  Time m_lastFlush;
+
+  /**
+   * Event closing the output files when the simulator is destroyed
+   */
+  EventId m_closeEvent;
+
   /**
    * List of IMSI by path in the attribute system
    */
@@ -23,6 +23,7 @@
 
 #include "phy-rx-stats-calculator.h"
 #include "ns3/string.h"
+#include "ns3/enum.h"
 #include <ns3/simulator.h>
 #include <ns3/log.h>
 
@@ -36,7 +37,9 @@ PhyRxStatsCalculator::PhyRxStatsCalculator ()
   : m_dlRxFirstWrite (true),
     m_ulRxFirstWrite (true),
     m_slRxFirstWrite (true),
-    m_slPscchRxFirstWrite (true)
+    m_slPscchRxFirstWrite (true),
+    m_slPscchRxFormat (SlPscchRxStatsFormat::TEXT),
+    m_slPscchRxLastTimestamp (0)
 {
   NS_LOG_FUNCTION (this);
 
@@ -74,6 +77,13 @@ PhyRxStatsCalculator::GetTypeId (void)
                    StringValue ("SlPscchRxPhyStats.txt"),
                    MakeStringAccessor (&PhyRxStatsCalculator::SetSlPscchRxOutputFilename),
                    MakeStringChecker ())
+    .AddAttribute ("SlPscchRxOutputFormat",
+                   "Format of the Sidelink PSCCH results: tab separated text, or "
+                   "fixed-width binary records readable with SlPscchRxStatsReader.",
+                   EnumValue (SlPscchRxStatsFormat::TEXT),
+                   MakeEnumAccessor (&PhyRxStatsCalculator::m_slPscchRxFormat),
+                   MakeEnumChecker (SlPscchRxStatsFormat::TEXT, "Text",
+                                    SlPscchRxStatsFormat::BINARY, "Binary"))
   ;
   return tid;
 }
@@ -132,27 +142,18 @@ PhyRxStatsCalculator::DlPhyReception (PhyReceptionStatParameters params)
   NS_LOG_FUNCTION (this << params.m_cellId << params.m_imsi << params.m_timestamp << params.m_rnti << params.m_layer << params.m_mcs << params.m_size << params.m_rv << params.m_ndi << params.m_correctness);
   NS_LOG_INFO ("Write DL Rx Phy Stats in " << GetDlRxOutputFilename ().c_str ());
 
-  std::ofstream outFile;
-  if ( m_dlRxFirstWrite == true )
+  std::ostream *stream = GetOutputStream (GetDlRxOutputFilename (), m_dlRxFirstWrite);
+  if (stream == 0)
     {
-      outFile.open (GetDlRxOutputFilename ().c_str ());
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetDlRxOutputFilename ().c_str ());
-          return;
-        }
-      m_dlRxFirstWrite = false;
-      outFile << "% time\tcellId\tIMSI\tRNTI\ttxMode\tlayer\tmcs\tsize\trv\tndi\tcorrect\tavrgSinrPerRb\tccId";
-      outFile << std::endl;
+      NS_LOG_ERROR ("Can't open file " << GetDlRxOutputFilename ().c_str ());
+      return;
     }
-  else
+  std::ostream &outFile = *stream;
+  if (m_dlRxFirstWrite == true)
     {
-      outFile.open (GetDlRxOutputFilename ().c_str (),  std::ios_base::app);
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetDlRxOutputFilename ().c_str ());
-          return;
-        }
+      m_dlRxFirstWrite = false;
+      outFile << "% time\tcellId\tIMSI\tRNTI\ttxMode\tlayer\tmcs\tsize\trv\tndi\tcorrect\tavrgSinrPerRb\tccId";
+      outFile << "\n";
     }
 
 //   outFile << Simulator::Now ().GetNanoSeconds () / (double) 1e9 << "\t";
@@ -168,8 +169,7 @@ PhyRxStatsCalculator::DlPhyReception (PhyReceptionStatParameters params)
   outFile << (uint32_t) params.m_ndi << "\t";
   outFile << (uint32_t) params.m_correctness << "\t";
   outFile << (double) params.m_sinrPerRb << "\t";
-  outFile << (uint32_t) params.m_ccId << std::endl;
-  outFile.close ();
+  outFile << (uint32_t) params.m_ccId << "\n";
 }
 
 void
@@ -178,27 +178,18 @@ PhyRxStatsCalculator::UlPhyReception (PhyReceptionStatParameters params)
   NS_LOG_FUNCTION (this << params.m_cellId << params.m_imsi << params.m_timestamp << params.m_rnti << params.m_layer << params.m_mcs << params.m_size << params.m_rv << params.m_ndi << params.m_correctness);
   NS_LOG_INFO ("Write UL Rx Phy Stats in " << GetUlRxOutputFilename ().c_str ());
 
-  std::ofstream outFile;
-  if ( m_ulRxFirstWrite == true )
+  std::ostream *stream = GetOutputStream (GetUlRxOutputFilename (), m_ulRxFirstWrite);
+  if (stream == 0)
     {
-      outFile.open (GetUlRxOutputFilename ().c_str ());
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetUlRxOutputFilename ().c_str ());
-          return;
-        }
-      m_ulRxFirstWrite = false;
-      outFile << "% time\tcellId\tIMSI\tRNTI\tlayer\tmcs\tsize\trv\tndi\tcorrect\tavrgSinrPerRb\tccId";
-      outFile << std::endl;
+      NS_LOG_ERROR ("Can't open file " << GetUlRxOutputFilename ().c_str ());
+      return;
     }
-  else
+  std::ostream &outFile = *stream;
+  if (m_ulRxFirstWrite == true)
     {
-      outFile.open (GetUlRxOutputFilename ().c_str (),  std::ios_base::app);
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetUlRxOutputFilename ().c_str ());
-          return;
-        }
+      m_ulRxFirstWrite = false;
+      outFile << "% time\tcellId\tIMSI\tRNTI\tlayer\tmcs\tsize\trv\tndi\tcorrect\tavrgSinrPerRb\tccId";
+      outFile << "\n";
     }
 
 //   outFile << Simulator::Now ().GetNanoSeconds () / (double) 1e9 << "\t";
@@ -213,8 +204,7 @@ PhyRxStatsCalculator::UlPhyReception (PhyReceptionStatParameters params)
   outFile << (uint32_t) params.m_ndi << "\t";
   outFile << (uint32_t) params.m_correctness << "\t";
   outFile << (double) params.m_sinrPerRb << "\t";
-  outFile << (uint32_t) params.m_ccId <<std::endl;
-  outFile.close ();
+  outFile << (uint32_t) params.m_ccId << "\n";
 }
 
 void
@@ -223,27 +213,18 @@ PhyRxStatsCalculator::SlPhyReception (PhyReceptionStatParameters params)
   NS_LOG_FUNCTION (this << params.m_cellId << params.m_imsi << params.m_timestamp << params.m_rnti << params.m_layer << params.m_mcs << params.m_size << params.m_rv << params.m_ndi << params.m_correctness);
   NS_LOG_INFO ("Write SL Rx Phy Stats in " << GetSlRxOutputFilename ().c_str ());
 
-  std::ofstream outFile;
+  std::ostream *stream = GetOutputStream (GetSlRxOutputFilename (), m_slRxFirstWrite);
+  if (stream == 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << GetSlRxOutputFilename ().c_str ());
+      return;
+    }
+  std::ostream &outFile = *stream;
   if (m_slRxFirstWrite == true)
     {
-      outFile.open (GetSlRxOutputFilename ().c_str ());
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetSlRxOutputFilename ().c_str ());
-          return;
-        }
       m_slRxFirstWrite = false;
       outFile << "% time\tcellId\tIMSI\tRNTI\tlayer\tmcs\tsize\trv\tndi\tcorrect\tavrgSinrPerRb";
-      outFile << std::endl;
-    }
-  else
-    {
-      outFile.open (GetSlRxOutputFilename ().c_str (),  std::ios_base::app);
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetSlRxOutputFilename ().c_str ());
-          return;
-        }
+      outFile << "\n";
     }
 
   outFile << params.m_timestamp << "\t";
@@ -256,8 +237,7 @@ PhyRxStatsCalculator::SlPhyReception (PhyReceptionStatParameters params)
   outFile << (uint32_t) params.m_rv << "\t";
   outFile << (uint32_t) params.m_ndi << "\t";
   outFile << (uint32_t) params.m_correctness << "\t";
-  outFile << (double) params.m_sinrPerRb <<std::endl;
-  outFile.close ();
+  outFile << (double) params.m_sinrPerRb << "\n";
 }
 
 void
@@ -266,64 +246,35 @@ PhyRxStatsCalculator::SlPscchReception (SlPhyReceptionStatParameters params)
   NS_LOG_FUNCTION (this << params.m_timestamp << params.m_cellId << params.m_imsi << params.m_rnti << (uint16_t)params.m_mcs << params.m_size << params.m_resPscch << (uint16_t)params.m_rbLen << (uint16_t)params.m_rbStart<< (uint16_t)params.m_iTrp << (uint16_t)params.m_hopping << (uint16_t)params.m_groupDstId << (uint16_t)params.m_correctness);
   NS_LOG_INFO ("Write SL Rx PSCCH Stats in " << GetSlPscchRxOutputFilename ().c_str ());
 
-  std::ofstream outFile;
+  bool binary = (m_slPscchRxFormat == SlPscchRxStatsFormat::BINARY);
+  std::ostream *stream = GetOutputStream (GetSlPscchRxOutputFilename (), m_slPscchRxFirstWrite, binary);
+  if (stream == 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << GetSlPscchRxOutputFilename ().c_str ());
+      return;
+    }
+  std::ostream &outFile = *stream;
   if (m_slPscchRxFirstWrite == true)
     {
-      outFile.open (GetSlPscchRxOutputFilename ().c_str ());
-      if (!outFile.is_open ())
+      m_slPscchRxFirstWrite = false;
+      if (binary)
         {
-          NS_LOG_ERROR ("Can't open file " << GetSlPscchRxOutputFilename ().c_str ());
-          return;
+          SlPscchRxStatsFormat::WriteBinaryHeader (outFile);
         }
-      m_slPscchRxFirstWrite = false;
       //outFile << "% time\tcellId\tIMSI\tRNTI\tmcs\tsize\tresPscch\trbLen\trbStart\tiTrp\thopping\tgroupDstId\tcorrect";
       //outFile << "time\tTJAlgo\tTXID\tRXID\tWeak\tCflict\tNeiBor\tItervl\tisTx\tRxType\t";
       //outFile << "time\tTXID\tRXID\tRxPosX\tRxPosY\tCorrect\tNeighbour";
-      //outFile << std::endl;
+      //outFile << "\n";
+    }
+
+  if (binary)
+    {
+      SlPscchRxStatsFormat::WriteBinaryRecord (outFile, params, m_slPscchRxLastTimestamp);
     }
   else
     {
-      outFile.open (GetSlPscchRxOutputFilename ().c_str (),  std::ios_base::app);
-      if (!outFile.is_open ())
-        {
-          NS_LOG_ERROR ("Can't open file " << GetSlPscchRxOutputFilename ().c_str ());
-          return;
-        }
+      SlPscchRxStatsFormat::WriteTextRecord (outFile, params);
     }
-
-  /*
-  outFile << params.m_timestamp << "\t";
-  outFile << (uint32_t) params.m_cellId << "\t";
-  outFile << params.m_imsi << "\t";
-  outFile << params.m_rnti << "\t";
-  outFile << (uint32_t) params.m_mcs << "\t";
-  outFile << params.m_size << "\t";
-  outFile << params.m_resPscch << "\t";
-  outFile << (uint32_t) params.m_rbLen << "\t";
-  outFile << (uint32_t) params.m_rbStart << "\t";
-  outFile << (uint32_t) params.m_iTrp << "\t";
-  outFile << (uint32_t) params.m_hopping << "\t";
-  outFile << (uint32_t) params.m_groupDstId << "\t";
-  outFile << (uint32_t) params.m_correctness <<std::endl;*/
-
-  outFile << params.m_timestamp << "\t";
-  outFile << (uint32_t) params.m_frl << "\t";
-  outFile << params.m_TJAlgo << "\t";
-  //outFile << params.m_nextTxTime << "\t";
-  outFile << params.m_rnti << "\t";
-  outFile << params.m_imsi << "\t";
-  //outFile << params.m_txPosX << "\t";
-  //outFile << params.m_txPosY << "\t";
-  //outFile << params.m_rxPosX << "\t";
-  //outFile << params.m_rxPosY << "\t";
-  outFile << (uint32_t) params.m_weakSignal << "\t";
-  outFile << params.m_conflict << "\t";
-  //outFile << params.m_neighbor << "\t";
-  outFile << params.m_msgInterval << "\t";
-  outFile << params.m_consecutiveMiss << "\t";
-  outFile << (uint32_t) params.m_isTx << "\t";
-  outFile << params.m_rxType <<std::endl;
-  outFile.close ();
 }
 
 void
@@ -30,6 +30,7 @@
 #include <string>
 #include <fstream>
 #include <ns3/lte-common.h>
+#include <ns3/sl-pscch-rx-stats-format.h>
 
 namespace ns3 {
 
@@ -219,6 +220,17 @@ private:
    */
   bool m_slPscchRxFirstWrite;
 
+  /**
+   * Output format of the Sidelink PSCCH RX PHY statistics
+   */
+  SlPscchRxStatsFormat::Format m_slPscchRxFormat;
+
+  /**
+   * Timestamp of the last binary Sidelink PSCCH RX PHY record, the
+   * reference of the time delta of the next one
+   */
+  int64_t m_slPscchRxLastTimestamp;
+
 };
 
 } // namespace ns3
@@ -41,6 +41,7 @@
 #include <ns3/abort.h>
 #include <ns3/angles.h>
 #include <cfloat>
+#include <map>
 
 namespace ns3 {
 
@@ -90,22 +91,23 @@ void
 SidelinkRsrpCalculator::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
+  m_referenceRePowers.clear ();
   Object::DoDispose ();
 }
 
 
 double
-SidelinkRsrpCalculator::CalcSlRsrpPsbch (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
+SidelinkRsrpCalculator::GetReferenceRePower (double txPower, double ulEarfcn, double ulBandwidth)
 {
+  NS_LOG_FUNCTION (this << txPower << ulEarfcn << ulBandwidth);
+  // the PSD of the PSBCH only depends on the frequency, bandwidth and power
+  PsbchConfig_t key = std::make_pair (std::make_pair (ulEarfcn, ulBandwidth), txPower);
+  std::map<PsbchConfig_t, double>::const_iterator it = m_referenceRePowers.find (key);
+  if (it != m_referenceRePowers.end ())
+    {
+      return it->second;
+    }
 
-  NS_ASSERT_MSG (lossModel != 0, "No PropagationLossModel provided");
-
-  /*
-    36.214: Sidelink Reference Signal Received Power (S-RSRP) is defined as the linear average over the
-    power contributions (in [W]) of the resource elements that carry demodulation reference signals
-    associated with PSBCH, within the central 6 PRBs of the applicable subframes.
-  */
-  //This method returned very low values of RSRP
   std::vector <int> rbMask;
   int indexLowerRb = 0;
   int indexUpperRb = 0;
@@ -126,94 +128,77 @@ SidelinkRsrpCalculator::CalcSlRsrpPsbch (Ptr<PropagationLossModel> lossModel, do
   LteSpectrumValueHelper psdHelper;
   Ptr<SpectrumValue> psd = psdHelper.CreateUlTxPowerSpectralDensity (ulEarfcn, ulBandwidth, txPower, rbMask);
 
-  double rsrp = DoCalcRsrp (lossModel, psd, txPhy, rxPhy);
-
-  NS_LOG_INFO ("S-RSRP=" << rsrp);
-
-  return rsrp;
+  // average power among the active RBs
+  double sum = 0.0;
+  uint8_t rbNum = 0;
+  Values::const_iterator vit;
+  for (vit = psd->ConstValuesBegin (); vit != psd->ConstValuesEnd (); vit++)
+    {
+      //The non active RB will be set to -inf
+      //We count only the active
+      if ((*vit))
+        {
+          // convert PSD [W/Hz] to linear power [W] for the single RE
+          // we consider only one RE for the RS since the channel is
+          // flat within the same RB
+          double powerTxW = ((*vit) * 180000.0) / 12.0;
+          sum += powerTxW;
+          rbNum++;
+        }
+    }
+  double rePower = (rbNum > 0) ? (sum / rbNum) : DBL_MAX;
+  NS_LOG_LOGIC ("Reference RE power for EARFCN " << ulEarfcn << ", bandwidth " << ulBandwidth << ", power " << txPower << " dBm = " << rePower << " W");
+  m_referenceRePowers[key] = rePower;
+  return rePower;
 }
 
 double
-SidelinkRsrpCalculator::CalcSlRsrpTxPw (Ptr<PropagationLossModel> lossModel, double txPower, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
+SidelinkRsrpCalculator::CalcSlRsrpPsbch (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
 {
 
   NS_ASSERT_MSG (lossModel != 0, "No PropagationLossModel provided");
 
   /*
-    36.843: RSRP is calculated for transmit power of 23dBm by the transmitter UE and is the received power at the receiver UE calculated
-    after accounting for large scale path loss and shadowing. Additionally note that wrap around is used for path loss calculations except
-    for the case of partial -coverage.
+    36.214: Sidelink Reference Signal Received Power (S-RSRP) is defined as the linear average over the
+    power contributions (in [W]) of the resource elements that carry demodulation reference signals
+    associated with PSBCH, within the central 6 PRBs of the applicable subframes.
   */
-  double rsrp = DoCalcRsrp (lossModel, txPower, txPhy, rxPhy);
+  //This method returned very low values of RSRP
+  double rePower = GetReferenceRePower (txPower, ulEarfcn, ulBandwidth);
+  double rsrp = DBL_MAX;
+  if (rePower != DBL_MAX)
+    {
+      // the path gain applies to every RB, so it applies to their average
+      double pathGainLinear = std::pow (10.0, (-CalcPathLossDb (lossModel, txPhy, rxPhy)) / 10.0);
+      rsrp = rePower * pathGainLinear;
+    }
 
-  NS_LOG_INFO ("RSRP=" << rsrp);
+  NS_LOG_INFO ("RSRP linear=" << rsrp << " (" << 10 * std::log10 (rsrp) + 30 << "dBm)");
+  NS_LOG_INFO ("S-RSRP=" << 10 * std::log10 (rsrp) + 30);
 
-  return rsrp;
+  return 10 * std::log10 (rsrp) + 30;
 }
 
-//called by CalcSlRsrpPsbch function
 double
-SidelinkRsrpCalculator::DoCalcRsrp (Ptr<PropagationLossModel> propagationLoss, Ptr<SpectrumValue> psd, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
+SidelinkRsrpCalculator::CalcSlRsrpTxPw (Ptr<PropagationLossModel> lossModel, double txPower, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
 {
-  Ptr<MobilityModel> txMobility = txPhy->GetMobility ();
-  Ptr<MobilityModel> rxMobility = rxPhy->GetMobility ();
 
-  double pathLossDb = 0;
-  if (txPhy->GetRxAntenna () != 0)
-    {
-      Angles txAngles (rxMobility->GetPosition (), txMobility->GetPosition ());
-      double txAntennaGain = txPhy->GetRxAntenna ()->GetGainDb (txAngles);
-      NS_LOG_DEBUG ("txAntennaGain = " << txAntennaGain << " dB");
-      pathLossDb -= txAntennaGain;
-    }
-  Ptr<AntennaModel> rxAntenna = rxPhy->GetRxAntenna ();
-  if (rxAntenna != 0)
-    {
-      Angles rxAngles (txMobility->GetPosition (), rxMobility->GetPosition ());
-      double rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-      NS_LOG_DEBUG ("rxAntennaGain = " << rxAntennaGain << " dB");
-      pathLossDb -= rxAntennaGain;
-    }
-  if (propagationLoss)
-    {
-      double propagationGainDb = propagationLoss->CalcRxPower (0, txMobility, rxMobility);
-      NS_LOG_DEBUG ("propagationGainDb = " << propagationGainDb << " dB");
-      pathLossDb -= propagationGainDb;
-    }
-  NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");
-
-  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-  Ptr<SpectrumValue> rxPsd = Copy<SpectrumValue> (psd);
-  *rxPsd *= pathGainLinear;
+  NS_ASSERT_MSG (lossModel != 0, "No PropagationLossModel provided");
 
-  // RSRP evaluated as averaged received power among RBs
-  double sum = 0.0;
-  uint8_t rbNum = 0;
-  Values::const_iterator it;
-  for (it = (*rxPsd).ValuesBegin (); it != (*rxPsd).ValuesEnd (); it++)
-    {
-      //The non active RB will be set to -inf
-      //We count only the active
-      if ((*it))
-        {
-          // convert PSD [W/Hz] to linear power [W] for the single RE
-          // we consider only one RE for the RS since the channel is
-          // flat within the same RB
-          double powerTxW = ((*it) * 180000.0) / 12.0;
-          sum += powerTxW;
-          rbNum++;
-        }
-    }
-  double rsrp = (rbNum > 0) ? (sum / rbNum) : DBL_MAX;
+  /*
+    36.843: RSRP is calculated for transmit power of 23dBm by the transmitter UE and is the received power at the receiver UE calculated
+    after accounting for large scale path loss and shadowing. Additionally note that wrap around is used for path loss calculations except
+    for the case of partial -coverage.
+  */
+  double rsrp = txPower - CalcPathLossDb (lossModel, txPhy, rxPhy);
 
-  NS_LOG_INFO ("RSRP linear=" << rsrp << " (" << 10 * std::log10 (rsrp) + 30 << "dBm)");
+  NS_LOG_INFO ("RSRP=" << rsrp);
 
-  return 10 * std::log10 (rsrp) + 30;
+  return rsrp;
 }
 
-//used by CalcSlRsrpTxPw function
 double
-SidelinkRsrpCalculator::DoCalcRsrp (Ptr<PropagationLossModel> propagationLoss, double txPower, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
+SidelinkRsrpCalculator::CalcPathLossDb (Ptr<PropagationLossModel> propagationLoss, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy)
 {
   Ptr<MobilityModel> txMobility = txPhy->GetMobility ();
   Ptr<MobilityModel> rxMobility = rxPhy->GetMobility ();
@@ -242,11 +227,7 @@ SidelinkRsrpCalculator::DoCalcRsrp (Ptr<PropagationLossModel> propagationLoss, d
     }
   NS_LOG_DEBUG ("total pathLoss = " << pathLossDb << " dB");
 
-  double rsrp = txPower - pathLossDb;
-
-  NS_LOG_INFO ("RSRP=" << rsrp << " dBm");
-
-  return rsrp;
+  return pathLossDb;
 }
 
 } // namespace ns3
@@ -42,6 +42,7 @@
 #include <ns3/double.h>
 #include <ns3/pointer.h>
 #include <ns3/random-variable-stream.h>
+#include <map>
 
 
 namespace ns3 {
@@ -84,7 +85,7 @@ public:
    *
    * \return RSRP value in dBm
    */
-  static double CalcSlRsrpPsbch (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy);
+  double CalcSlRsrpPsbch (Ptr<PropagationLossModel> lossModel, double txPower, double ulEarfcn, double ulBandwidth, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy);
   /**
    * Computes the S-RSRP between a transmitter UE and a receiver UE as defined in TR 36.843.
    * \param lossModel The loss model to use in the calculation
@@ -98,28 +99,32 @@ public:
 
 private:
   /**
-   * Compute the RSRP between the given nodes for the given propagation loss model (used by CalcSidelinkRsrp function)
+   * Compute the path loss between the given nodes for the given propagation loss model, including the antenna gains
    * This code is derived from the multi-model-spectrum-channel class. It can be used for both uplink and downlink
    * \param propagationLoss The loss model
-   * \param psd The power spectral density of the transmitter
    * \param txPhy The transmitter
    * \param rxPhy The receiver
    *
-   * \return The RSRP in dBm
+   * \return The path loss in dB
    */
-  static double DoCalcRsrp (Ptr<PropagationLossModel> propagationLoss, Ptr<SpectrumValue> psd, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy);
+  static double CalcPathLossDb (Ptr<PropagationLossModel> propagationLoss, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy);
 
   /**
-   * Compute the RSRP between the given nodes for the given propagation loss model (used by CalcSidelinkRsrpEval function)
-   * This code is derived from the multi-model-spectrum-channel class. It can be used for both uplink and downlink
-   * \param propagationLoss The loss model
-   * \param txPower The transmit power
-   * \param txPhy The transmitter
-   * \param rxPhy The receiver
+   * Get the average power of the resource elements carrying the PSBCH reference signals, at the transmitter.
+   * The value is computed from the transmit PSD once per uplink frequency, bandwidth and transmit power,
+   * and cached for the following calls.
+   * \param txPower Transmit power for the reference signal
+   * \param ulEarfcn Uplink frequency
+   * \param ulBandwidth Uplink bandwidth
    *
-   * \return The RSRP in dBm
+   * \return The average power of a resource element in W
    */
-  static double DoCalcRsrp (Ptr<PropagationLossModel> propagationLoss, double txPower, Ptr<SpectrumPhy> txPhy, Ptr<SpectrumPhy> rxPhy);
+  double GetReferenceRePower (double txPower, double ulEarfcn, double ulBandwidth);
+
+  /// Uplink frequency, bandwidth and transmit power of a PSBCH transmission
+  typedef std::pair<std::pair<double, double>, double> PsbchConfig_t;
+
+  std::map<PsbchConfig_t, double> m_referenceRePowers; ///< average power of a reference resource element per PSBCH configuration, in W
 
 };
 
@@ -0,0 +1,550 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sl-pscch-rx-stats-format.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/abort.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SlPscchRxStatsFormat");
+
+/// Magic string at the beginning of the binary files
+static const char SL_PSCCH_RX_STATS_MAGIC[8] = { 'S', 'L', 'P', 'S', 'C', 'C', 'H', '3' };
+
+/// Size of the column name in the schema header
+static const uint32_t SL_PSCCH_RX_STATS_NAME_SIZE = 16;
+
+/// Largest size of a binary record
+static const uint32_t SL_PSCCH_RX_STATS_MAX_RECORD_SIZE = 16;
+
+/// Width in bits of the values of the extended columns in an extension record
+static const uint8_t SL_PSCCH_RX_STATS_EXTENDED_WIDTH = 32;
+
+/// Index of the columns of the binary record
+enum SlPscchRxStatsColumn
+{
+  COL_TIME,
+  COL_FRL,
+  COL_TJ_ALGO,
+  COL_RNTI,
+  COL_IMSI,
+  COL_WEAK_SIGNAL,
+  COL_CONFLICT,
+  COL_MSG_INTERVAL,
+  COL_CONSECUTIVE_MISS,
+  COL_IS_TX,
+  COL_RX_TYPE,
+  COL_N
+};
+
+/**
+ * Store the width lowest bytes of a value, least significant byte first
+ * \param buffer The destination
+ * \param value The value
+ * \param width The number of bytes
+ */
+static void
+StoreLittleEndian (uint8_t *buffer, uint64_t value, uint8_t width)
+{
+  for (uint8_t i = 0; i < width; i++)
+    {
+      buffer[i] = (value >> (8 * i)) & 0xff;
+    }
+}
+
+/**
+ * \param buffer The source
+ * \param width The number of bytes
+ * \return The value stored least significant byte first
+ */
+static uint64_t
+LoadLittleEndian (const uint8_t *buffer, uint8_t width)
+{
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < width; i++)
+    {
+      value |= static_cast<uint64_t> (buffer[i]) << (8 * i);
+    }
+  return value;
+}
+
+/**
+ * \param width A number of bits, at most 64
+ * \return The largest value of width bits
+ */
+static uint64_t
+MaxValue (uint8_t width)
+{
+  return width < 64 ? (static_cast<uint64_t> (1) << width) - 1 : ~static_cast<uint64_t> (0);
+}
+
+/**
+ * Store a bit field in a zero initialized record
+ * \param record The record
+ * \param offset The offset in bits of the field
+ * \param width The width in bits of the field
+ * \param value The value, that fits in the field
+ */
+static void
+StoreBits (uint8_t *record, uint16_t offset, uint8_t width, uint64_t value)
+{
+  while (width > 0)
+    {
+      uint8_t shift = offset % 8;
+      uint8_t n = std::min<uint8_t> (8 - shift, width);
+      record[offset / 8] |= (value & MaxValue (n)) << shift;
+      value >>= n;
+      offset += n;
+      width -= n;
+    }
+}
+
+/**
+ * \param record The record
+ * \param offset The offset in bits of the field
+ * \param width The width in bits of the field
+ * \return The value of the bit field
+ */
+static uint64_t
+LoadBits (const uint8_t *record, uint16_t offset, uint8_t width)
+{
+  uint64_t value = 0;
+  uint8_t done = 0;
+  while (done < width)
+    {
+      uint8_t shift = offset % 8;
+      uint8_t n = std::min<uint8_t> (8 - shift, width - done);
+      value |= static_cast<uint64_t> ((record[offset / 8] >> shift) & MaxValue (n)) << done;
+      offset += n;
+      done += n;
+    }
+  return value;
+}
+
+const std::vector<SlPscchRxStatsFormat::Column>&
+SlPscchRxStatsFormat::GetColumns (void)
+{
+  static std::vector<Column> columns;
+  if (columns.empty ())
+    {
+      // same order as the text format
+      const Column layout[COL_N] = {
+        { "time", 'd', 16, 0 },
+        { "frl", 'u', 8, 0 },
+        { "TJAlgo", 'u', 1, 0 },
+        { "rnti", 'u', 16, 0 },
+        { "imsi", 'x', 16, 0 },
+        { "weakSignal", 'u', 1, 0 },
+        { "conflict", 'u', 1, 0 },
+        { "msgInterval", 'x', 16, 0 },
+        { "consecutiveMiss", 'x', 16, 0 },
+        { "isTx", 'u', 1, 0 },
+        { "rxType", 'u', 3, 0 }
+      };
+      uint16_t offset = 0;
+      uint32_t nExtended = 0;
+      for (uint32_t i = 0; i < COL_N; i++)
+        {
+          Column column = layout[i];
+          column.offset = offset;
+          offset += column.width;
+          nExtended += (column.type == 'x');
+          columns.push_back (column);
+        }
+      // a time record stores the absolute time after the delta
+      NS_ASSERT (columns[COL_TIME].width + 64 <= 8 * SL_PSCCH_RX_STATS_MAX_RECORD_SIZE);
+      NS_ASSERT (offset <= 8 * SL_PSCCH_RX_STATS_MAX_RECORD_SIZE);
+      NS_ASSERT (nExtended * SL_PSCCH_RX_STATS_EXTENDED_WIDTH <= 8 * SL_PSCCH_RX_STATS_MAX_RECORD_SIZE);
+    }
+  return columns;
+}
+
+uint32_t
+SlPscchRxStatsFormat::GetRecordSize (void)
+{
+  const Column &last = GetColumns ().back ();
+  uint32_t bits = std::max<uint32_t> (last.offset + last.width, GetColumns ()[COL_TIME].width + 64);
+  uint32_t extensionBits = 0;
+  for (std::vector<Column>::const_iterator it = GetColumns ().begin (); it != GetColumns ().end (); ++it)
+    {
+      extensionBits += (it->type == 'x') ? SL_PSCCH_RX_STATS_EXTENDED_WIDTH : 0;
+    }
+  bits = std::max (bits, extensionBits);
+  return (bits + 7) / 8;
+}
+
+/**
+ * \param record A reception record
+ * \return True if an extended column has all its bits set, i.e., an
+ *         extension record follows
+ */
+static bool
+HasExtension (const uint8_t *record)
+{
+  const std::vector<SlPscchRxStatsFormat::Column> &columns = SlPscchRxStatsFormat::GetColumns ();
+  for (uint32_t i = 0; i < COL_N; i++)
+    {
+      if (columns[i].type == 'x' && LoadBits (record, columns[i].offset, columns[i].width) == MaxValue (columns[i].width))
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+uint32_t
+SlPscchRxStatsFormat::GetHeaderSize (void)
+{
+  uint32_t size = sizeof (SL_PSCCH_RX_STATS_MAGIC) + 3 * sizeof (uint32_t)
+    + GetColumns ().size () * (SL_PSCCH_RX_STATS_NAME_SIZE + 4);
+  return (size + 7) / 8 * 8;
+}
+
+void
+SlPscchRxStatsFormat::WriteBinaryHeader (std::ostream &os)
+{
+  std::vector<uint8_t> header (GetHeaderSize (), 0);
+  uint8_t *p = &header[0];
+  std::memcpy (p, SL_PSCCH_RX_STATS_MAGIC, sizeof (SL_PSCCH_RX_STATS_MAGIC));
+  p += sizeof (SL_PSCCH_RX_STATS_MAGIC);
+  StoreLittleEndian (p, GetHeaderSize (), 4);
+  StoreLittleEndian (p + 4, GetRecordSize (), 4);
+  StoreLittleEndian (p + 8, GetColumns ().size (), 4);
+  p += 12;
+  for (std::vector<Column>::const_iterator it = GetColumns ().begin (); it != GetColumns ().end (); ++it)
+    {
+      std::strncpy (reinterpret_cast<char *> (p), it->name, SL_PSCCH_RX_STATS_NAME_SIZE);
+      p[SL_PSCCH_RX_STATS_NAME_SIZE] = it->type;
+      p[SL_PSCCH_RX_STATS_NAME_SIZE + 1] = it->width;
+      StoreLittleEndian (p + SL_PSCCH_RX_STATS_NAME_SIZE + 2, it->offset, 2);
+      p += SL_PSCCH_RX_STATS_NAME_SIZE + 4;
+    }
+  os.write (reinterpret_cast<const char *> (&header[0]), header.size ());
+}
+
+void
+SlPscchRxStatsFormat::WriteBinaryRecord (std::ostream &os, const SlPhyReceptionStatParameters &params,
+                                         int64_t &lastTimestamp)
+{
+  const std::vector<Column> &columns = GetColumns ();
+  uint32_t recordSize = GetRecordSize ();
+  uint8_t record[SL_PSCCH_RX_STATS_MAX_RECORD_SIZE];
+  const Column &time = columns[COL_TIME];
+  uint64_t escape = MaxValue (time.width);
+
+  if (params.m_timestamp < lastTimestamp
+      || static_cast<uint64_t> (params.m_timestamp - lastTimestamp) >= escape)
+    {
+      std::memset (record, 0, recordSize);
+      StoreBits (record, time.offset, time.width, escape);
+      StoreBits (record, time.offset + time.width, 64, static_cast<uint64_t> (params.m_timestamp));
+      os.write (reinterpret_cast<const char *> (record), recordSize);
+      lastTimestamp = params.m_timestamp;
+    }
+
+  uint64_t values[COL_N];
+  values[COL_TIME] = params.m_timestamp - lastTimestamp;
+  values[COL_FRL] = params.m_frl;
+  values[COL_TJ_ALGO] = params.m_TJAlgo;
+  values[COL_RNTI] = params.m_rnti;
+  values[COL_IMSI] = params.m_imsi;
+  values[COL_WEAK_SIGNAL] = params.m_weakSignal;
+  values[COL_CONFLICT] = params.m_conflict;
+  values[COL_MSG_INTERVAL] = params.m_msgInterval;
+  values[COL_CONSECUTIVE_MISS] = params.m_consecutiveMiss;
+  values[COL_IS_TX] = params.m_isTx;
+  values[COL_RX_TYPE] = params.m_rxType;
+  lastTimestamp = params.m_timestamp;
+
+  std::memset (record, 0, recordSize);
+  bool extended = false;
+  for (uint32_t i = 0; i < COL_N; i++)
+    {
+      uint64_t max = MaxValue (columns[i].width);
+      uint64_t value = values[i];
+      if (columns[i].type == 'x' && value >= max)
+        {
+          // the value is in the extension record
+          extended = true;
+          value = max;
+        }
+      NS_ABORT_MSG_IF (value > max, "Value " << value << " of column " << columns[i].name
+                       << " does not fit in the binary format, use the text format");
+      StoreBits (record, columns[i].offset, columns[i].width, value);
+    }
+  os.write (reinterpret_cast<const char *> (record), recordSize);
+
+  if (extended)
+    {
+      std::memset (record, 0, recordSize);
+      uint16_t offset = 0;
+      for (uint32_t i = 0; i < COL_N; i++)
+        {
+          if (columns[i].type == 'x')
+            {
+              NS_ABORT_MSG_IF (values[i] > MaxValue (SL_PSCCH_RX_STATS_EXTENDED_WIDTH), "Value " << values[i]
+                               << " of column " << columns[i].name << " does not fit in the binary format, use the text format");
+              StoreBits (record, offset, SL_PSCCH_RX_STATS_EXTENDED_WIDTH, values[i]);
+              offset += SL_PSCCH_RX_STATS_EXTENDED_WIDTH;
+            }
+        }
+      os.write (reinterpret_cast<const char *> (record), recordSize);
+    }
+}
+
+void
+SlPscchRxStatsFormat::WriteTextRecord (std::ostream &os, const SlPhyReceptionStatParameters &params)
+{
+  os << params.m_timestamp << "\t";
+  os << (uint32_t) params.m_frl << "\t";
+  os << params.m_TJAlgo << "\t";
+  os << params.m_rnti << "\t";
+  os << params.m_imsi << "\t";
+  os << (uint32_t) params.m_weakSignal << "\t";
+  os << params.m_conflict << "\t";
+  os << params.m_msgInterval << "\t";
+  os << params.m_consecutiveMiss << "\t";
+  os << (uint32_t) params.m_isTx << "\t";
+  os << params.m_rxType << "\n";
+}
+
+
+SlPscchRxStatsReader::SlPscchRxStatsReader ()
+  : m_data (0),
+    m_size (0),
+    m_nSlots (0),
+    m_nRecords (0),
+    m_nextSlot (0),
+    m_lastTimestamp (0)
+{
+}
+
+SlPscchRxStatsReader::~SlPscchRxStatsReader ()
+{
+  Close ();
+}
+
+void
+SlPscchRxStatsReader::Close (void)
+{
+  if (m_data != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+    }
+  m_data = 0;
+  m_size = 0;
+  m_nSlots = 0;
+  m_nRecords = 0;
+  Rewind ();
+}
+
+bool
+SlPscchRxStatsReader::Open (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  Close ();
+
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << filename);
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < (off_t) SlPscchRxStatsFormat::GetHeaderSize ())
+    {
+      NS_LOG_ERROR ("File " << filename << " is too short");
+      close (fd);
+      return false;
+    }
+  void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_ERROR ("Can't map file " << filename);
+      return false;
+    }
+  m_data = static_cast<const uint8_t *> (data);
+  m_size = st.st_size;
+  madvise (data, m_size, MADV_SEQUENTIAL);
+
+  // check the schema against the layout of this build
+  const uint8_t *p = m_data;
+  if (std::memcmp (p, SL_PSCCH_RX_STATS_MAGIC, sizeof (SL_PSCCH_RX_STATS_MAGIC)) != 0)
+    {
+      NS_LOG_ERROR ("File " << filename << " is not a binary PSCCH statistics file");
+      Close ();
+      return false;
+    }
+  p += sizeof (SL_PSCCH_RX_STATS_MAGIC);
+  uint32_t headerSize = LoadLittleEndian (p, 4);
+  uint32_t recordSize = LoadLittleEndian (p + 4, 4);
+  uint32_t nColumns = LoadLittleEndian (p + 8, 4);
+  const std::vector<SlPscchRxStatsFormat::Column> &columns = SlPscchRxStatsFormat::GetColumns ();
+  if (headerSize != SlPscchRxStatsFormat::GetHeaderSize ()
+      || recordSize != SlPscchRxStatsFormat::GetRecordSize ()
+      || nColumns != columns.size ())
+    {
+      NS_LOG_ERROR ("Unsupported record layout in " << filename);
+      Close ();
+      return false;
+    }
+  p += 12;
+  for (uint32_t i = 0; i < nColumns; i++)
+    {
+      if (std::strncmp (reinterpret_cast<const char *> (p), columns[i].name, SL_PSCCH_RX_STATS_NAME_SIZE) != 0
+          || p[SL_PSCCH_RX_STATS_NAME_SIZE] != columns[i].type
+          || p[SL_PSCCH_RX_STATS_NAME_SIZE + 1] != columns[i].width
+          || LoadLittleEndian (p + SL_PSCCH_RX_STATS_NAME_SIZE + 2, 2) != columns[i].offset)
+        {
+          NS_LOG_ERROR ("Unsupported column " << i << " in " << filename);
+          Close ();
+          return false;
+        }
+      p += SL_PSCCH_RX_STATS_NAME_SIZE + 4;
+    }
+
+  m_nSlots = (m_size - headerSize) / recordSize;
+  if ((m_size - headerSize) % recordSize != 0)
+    {
+      NS_LOG_WARN ("Ignoring the truncated last record of " << filename);
+    }
+  // the time and extension records hold no reception
+  const SlPscchRxStatsFormat::Column &time = columns[COL_TIME];
+  uint64_t escape = MaxValue (time.width);
+  m_nRecords = 0;
+  for (uint64_t i = 0; i < m_nSlots; i++)
+    {
+      const uint8_t *record = m_data + headerSize + i * recordSize;
+      if (LoadBits (record, time.offset, time.width) == escape)
+        {
+          continue;
+        }
+      if (HasExtension (record))
+        {
+          if (i + 1 == m_nSlots)
+            {
+              NS_LOG_WARN ("Ignoring the last record of " << filename << ", its extension is truncated");
+              m_nSlots = i;
+              break;
+            }
+          i++;
+        }
+      m_nRecords++;
+    }
+  return true;
+}
+
+uint64_t
+SlPscchRxStatsReader::GetNRecords (void) const
+{
+  return m_nRecords;
+}
+
+void
+SlPscchRxStatsReader::Rewind (void)
+{
+  m_nextSlot = 0;
+  m_lastTimestamp = 0;
+}
+
+bool
+SlPscchRxStatsReader::ReadNext (SlPhyReceptionStatParameters &params)
+{
+  const std::vector<SlPscchRxStatsFormat::Column> &columns = SlPscchRxStatsFormat::GetColumns ();
+  const SlPscchRxStatsFormat::Column &time = columns[COL_TIME];
+  uint64_t escape = MaxValue (time.width);
+  uint32_t recordSize = SlPscchRxStatsFormat::GetRecordSize ();
+  while (m_nextSlot < m_nSlots)
+    {
+      const uint8_t *record = m_data + SlPscchRxStatsFormat::GetHeaderSize () + m_nextSlot * recordSize;
+      m_nextSlot++;
+      uint64_t values[COL_N];
+      for (uint32_t i = 0; i < COL_N; i++)
+        {
+          values[i] = LoadBits (record, columns[i].offset, columns[i].width);
+        }
+      if (values[COL_TIME] == escape)
+        {
+          m_lastTimestamp = static_cast<int64_t> (LoadBits (record, time.offset + time.width, 64));
+          continue;
+        }
+      m_lastTimestamp += values[COL_TIME];
+      if (HasExtension (record))
+        {
+          const uint8_t *extension = record + recordSize;
+          m_nextSlot++;
+          uint16_t offset = 0;
+          for (uint32_t i = 0; i < COL_N; i++)
+            {
+              if (columns[i].type == 'x')
+                {
+                  values[i] = LoadBits (extension, offset, SL_PSCCH_RX_STATS_EXTENDED_WIDTH);
+                  offset += SL_PSCCH_RX_STATS_EXTENDED_WIDTH;
+                }
+            }
+        }
+
+      std::memset (&params, 0, sizeof (params));
+      params.m_timestamp = m_lastTimestamp;
+      params.m_frl = values[COL_FRL];
+      params.m_TJAlgo = values[COL_TJ_ALGO];
+      params.m_rnti = values[COL_RNTI];
+      params.m_imsi = values[COL_IMSI];
+      params.m_weakSignal = values[COL_WEAK_SIGNAL];
+      params.m_conflict = values[COL_CONFLICT];
+      params.m_msgInterval = values[COL_MSG_INTERVAL];
+      params.m_consecutiveMiss = values[COL_CONSECUTIVE_MISS];
+      params.m_isTx = values[COL_IS_TX];
+      params.m_rxType = values[COL_RX_TYPE];
+      return true;
+    }
+  return false;
+}
+
+bool
+SlPscchRxStatsReader::ConvertToText (std::string binaryFilename, std::string textFilename)
+{
+  NS_LOG_FUNCTION (binaryFilename << textFilename);
+  SlPscchRxStatsReader reader;
+  if (!reader.Open (binaryFilename))
+    {
+      return false;
+    }
+  std::ofstream outFile (textFilename.c_str ());
+  if (!outFile.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open file " << textFilename);
+      return false;
+    }
+  SlPhyReceptionStatParameters params;
+  while (reader.ReadNext (params))
+    {
+      SlPscchRxStatsFormat::WriteTextRecord (outFile, params);
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,175 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SL_PSCCH_RX_STATS_FORMAT_H_
+#define SL_PSCCH_RX_STATS_FORMAT_H_
+
+#include <ns3/lte-common.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Output formats of the Sidelink PSCCH reception statistics
+ * (SlPscchRxPhyStats).
+ *
+ * The text format is one tab separated line per reception. The binary
+ * format stores the same columns as fixed-width records of bit fields,
+ * after a schema header:
+ *
+ *   - magic "SLPSCCH3" (8 bytes)
+ *   - header size, record size in bytes and number of columns
+ *     (3 x uint32_t)
+ *   - per column: name (16 bytes, zero padded), type (1 byte), width in
+ *     bits (1 byte) and bit offset in the record (uint16_t)
+ *   - zero padding up to the header size, a multiple of 8 bytes
+ *
+ * All the integers are little-endian and a record is a little-endian bit
+ * string: bit b is bit b % 8 of byte b / 8, and the fields follow each
+ * other without padding. The column types are:
+ *
+ *   - 'u': unsigned integer; the writer aborts if a value does not fit
+ *   - 'x': unsigned integer. A field with all its bits set means that the
+ *     record is followed by an extension record, that holds no reception:
+ *     the values of all the 'x' columns of the record, as 32-bit fields in
+ *     column order. The IMSI and the counters are thus never truncated.
+ *   - 'd': time delta in ms from the previous record, the first record
+ *     being relative to 0. A delta with all its bits set marks a time
+ *     record, that holds no reception: the 64 bits after the delta carry
+ *     the absolute time, as a signed integer, of the next records.
+ *
+ * The records start at the header size, so a file can be memory mapped
+ * and decoded sequentially.
+ */
+class SlPscchRxStatsFormat
+{
+public:
+  /// Output format selector
+  enum Format
+  {
+    TEXT,
+    BINARY
+  };
+
+  /// Column of the binary record
+  struct Column
+  {
+    const char *name; ///< column name, as in the text format
+    char type; ///< 'u', 'x' or 'd', see the format description
+    uint8_t width; ///< width in bits
+    uint16_t offset; ///< offset in bits in the record
+  };
+
+  /// \return The columns of the binary record, in text format order
+  static const std::vector<Column>& GetColumns (void);
+
+  /// \return The size in bytes of a binary record
+  static uint32_t GetRecordSize (void);
+
+  /// \return The size in bytes of the binary header
+  static uint32_t GetHeaderSize (void);
+
+  /**
+   * Write the schema header of the binary format
+   * \param os The output stream
+   */
+  static void WriteBinaryHeader (std::ostream &os);
+
+  /**
+   * Write one reception as a binary record, preceded by a time record if
+   * its timestamp is not within the range of the time delta
+   * \param os The output stream
+   * \param params The reception
+   * \param lastTimestamp The timestamp of the previous record, 0 before
+   *        the first one; updated with the timestamp of the reception
+   */
+  static void WriteBinaryRecord (std::ostream &os, const SlPhyReceptionStatParameters &params,
+                                 int64_t &lastTimestamp);
+
+  /**
+   * Write one reception as a line of the text format
+   * \param os The output stream
+   * \param params The reception
+   */
+  static void WriteTextRecord (std::ostream &os, const SlPhyReceptionStatParameters &params);
+};
+
+/**
+ * \ingroup lte
+ *
+ * Reader of the binary Sidelink PSCCH reception statistics. The file is
+ * memory mapped, its schema header is checked against the record layout
+ * of this build and the records are decoded in order.
+ */
+class SlPscchRxStatsReader
+{
+public:
+  SlPscchRxStatsReader ();
+  ~SlPscchRxStatsReader ();
+
+  /**
+   * Map a binary statistics file
+   * \param filename The name of the file
+   * \return False if the file cannot be read or its schema does not match
+   */
+  bool Open (std::string filename);
+
+  /// \return The number of receptions in the file
+  uint64_t GetNRecords (void) const;
+
+  /**
+   * Decode the next reception
+   * \param params The reception; the fields that are not part of the
+   *        format are set to zero
+   * \return False if all the receptions have been read
+   */
+  bool ReadNext (SlPhyReceptionStatParameters &params);
+
+  /// Restart the decoding from the first reception
+  void Rewind (void);
+
+  /**
+   * Convert a binary statistics file to the text format
+   * \param binaryFilename The name of the binary file
+   * \param textFilename The name of the text file to write
+   * \return False if the binary file cannot be read or the text file written
+   */
+  static bool ConvertToText (std::string binaryFilename, std::string textFilename);
+
+private:
+  /// Disabled copy constructor, the mapping is owned by one reader
+  SlPscchRxStatsReader (const SlPscchRxStatsReader &);
+  /// Disabled assignment operator, the mapping is owned by one reader
+  SlPscchRxStatsReader& operator= (const SlPscchRxStatsReader &);
+
+  /// Unmap the file, if any
+  void Close (void);
+
+  const uint8_t *m_data; ///< mapped content of the file
+  uint64_t m_size; ///< size of the mapping
+  uint64_t m_nSlots; ///< number of complete records, time records included
+  uint64_t m_nRecords; ///< number of receptions
+  uint64_t m_nextSlot; ///< index of the next record to decode
+  int64_t m_lastTimestamp; ///< timestamp of the last decoded record
+};
+
+} // namespace ns3
+
+#endif /* SL_PSCCH_RX_STATS_FORMAT_H_ */
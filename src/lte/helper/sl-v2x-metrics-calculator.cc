@@ -0,0 +1,304 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sl-v2x-metrics-calculator.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include <ns3/simulator.h>
+#include <ns3/log.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SlV2xMetricsCalculator");
+
+NS_OBJECT_ENSURE_REGISTERED (SlV2xMetricsCalculator);
+
+SlV2xMetricsCalculator::SlV2xMetricsCalculator ()
+  : m_windowActive (false),
+    m_windowIndex (0),
+    m_windowRx (0),
+    m_windowOk (0),
+    m_prrFirstWrite (true),
+    m_ipgFirstWrite (true),
+    m_failureFirstWrite (true)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SlV2xMetricsCalculator::~SlV2xMetricsCalculator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+SlV2xMetricsCalculator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SlV2xMetricsCalculator")
+    .SetParent<LteStatsCalculator> ()
+    .SetGroupName("Lte")
+    .AddConstructor<SlV2xMetricsCalculator> ()
+    .AddAttribute ("PrrOutputFilename",
+                   "Name of the file where the PRR per distance will be saved.",
+                   StringValue ("SlV2xPrrStats.txt"),
+                   MakeStringAccessor (&SlV2xMetricsCalculator::m_prrOutputFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("InterPacketGapOutputFilename",
+                   "Name of the file where the inter-packet gap histogram will be saved.",
+                   StringValue ("SlV2xIpgStats.txt"),
+                   MakeStringAccessor (&SlV2xMetricsCalculator::m_ipgOutputFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("FailureOutputFilename",
+                   "Name of the file where the causes of the failed receptions will be saved.",
+                   StringValue ("SlV2xFailureStats.txt"),
+                   MakeStringAccessor (&SlV2xMetricsCalculator::m_failureOutputFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("WindowDuration",
+                   "Duration of the time window over which the receptions are aggregated.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SlV2xMetricsCalculator::m_windowDuration),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("DistanceBinWidth",
+                   "Width (m) of the distance bins of the PRR.",
+                   DoubleValue (10.0),
+                   MakeDoubleAccessor (&SlV2xMetricsCalculator::m_distanceBinWidth),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("MaxDistance",
+                   "Upper bound (m) of the last distance bin of the PRR. "
+                   "Receptions from farther transmitters are counted in the last bin.",
+                   DoubleValue (150.0),
+                   MakeDoubleAccessor (&SlV2xMetricsCalculator::m_maxDistance),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("InterPacketGapBinWidth",
+                   "Width of the bins of the inter-packet gap histogram.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&SlV2xMetricsCalculator::m_ipgBinWidth),
+                   MakeTimeChecker (MilliSeconds (1)))
+    .AddAttribute ("MaxInterPacketGap",
+                   "Upper bound of the inter-packet gap histogram. "
+                   "Longer gaps are counted in an additional last bin.",
+                   TimeValue (Seconds (1)),
+                   MakeTimeAccessor (&SlV2xMetricsCalculator::m_maxIpg),
+                   MakeTimeChecker (MilliSeconds (1)))
+  ;
+  return tid;
+}
+
+void
+SlV2xMetricsCalculator::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_finishEvent.IsRunning ())
+    {
+      // the simulator has not been destroyed yet
+      WriteWindow ();
+      m_finishEvent.Cancel ();
+    }
+  LteStatsCalculator::DoDispose ();
+}
+
+void
+SlV2xMetricsCalculator::ResetWindow (void)
+{
+  uint32_t nDistanceBins = (uint32_t) std::ceil (m_maxDistance / m_distanceBinWidth);
+  uint32_t nIpgBins = (uint32_t) ((m_maxIpg.GetMilliSeconds () + m_ipgBinWidth.GetMilliSeconds () - 1) / m_ipgBinWidth.GetMilliSeconds ()) + 1;
+  m_nRx.assign (nDistanceBins, 0);
+  m_nOk.assign (nDistanceBins, 0);
+  m_ipgCount.assign (nIpgBins, 0);
+  m_failures.assign (N_FAILURE_CAUSES, 0);
+  m_windowRx = 0;
+  m_windowOk = 0;
+}
+
+void
+SlV2xMetricsCalculator::SlPscchReception (SlPhyReceptionStatParameters params)
+{
+  NS_LOG_FUNCTION (this << params.m_timestamp << params.m_rnti << (uint16_t)params.m_correctness << params.m_rxType);
+
+  if (!m_finishEvent.IsRunning ())
+    {
+      // scheduled before any output file is opened, so that the last
+      // window is written before the files are closed
+      m_finishEvent = Simulator::ScheduleDestroy (&SlV2xMetricsCalculator::Finish, this);
+    }
+
+  int64_t windowIndex = params.m_timestamp / m_windowDuration.GetMilliSeconds ();
+  if (m_windowActive && windowIndex != m_windowIndex)
+    {
+      WriteWindow ();
+    }
+  if (!m_windowActive)
+    {
+      ResetWindow ();
+      m_windowActive = true;
+      m_windowIndex = windowIndex;
+    }
+
+  double deltaX = params.m_rxPosX - params.m_txPosX;
+  double deltaY = params.m_rxPosY - params.m_txPosY;
+  double distance = std::sqrt (deltaX * deltaX + deltaY * deltaY);
+  uint32_t distanceBin = std::min<uint32_t> ((uint32_t) (distance / m_distanceBinWidth), m_nRx.size () - 1);
+
+  m_windowRx++;
+  m_nRx[distanceBin]++;
+  if (params.m_correctness)
+    {
+      m_windowOk++;
+      m_nOk[distanceBin]++;
+      // the interval is 0 for the first reception from a transmitter
+      if (params.m_msgInterval > 0)
+        {
+          uint32_t ipgBin = m_ipgCount.size () - 1;
+          if (params.m_msgInterval < m_maxIpg.GetMilliSeconds ())
+            {
+              ipgBin = params.m_msgInterval / m_ipgBinWidth.GetMilliSeconds ();
+            }
+          m_ipgCount[ipgBin]++;
+        }
+    }
+  else
+    {
+      switch (params.m_rxType)
+        {
+        case 1:
+          m_failures[WEAK_SIGNAL]++;
+          break;
+        case 2:
+          m_failures[COLLISION]++;
+          break;
+        case 3:
+          m_failures[INTERFERENCE]++;
+          break;
+        case 4:
+          m_failures[HALF_DUPLEX]++;
+          break;
+        default:
+          m_failures[OTHER]++;
+          break;
+        }
+    }
+}
+
+void
+SlV2xMetricsCalculator::WriteWindow (void)
+{
+  if (!m_windowActive)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << m_windowIndex);
+  m_windowActive = false;
+
+  int64_t windowMs = m_windowDuration.GetMilliSeconds ();
+  int64_t start = m_windowIndex * windowMs;
+  int64_t end = start + windowMs;
+
+  std::ostream *stream = GetOutputStream (m_prrOutputFilename, m_prrFirstWrite);
+  if (stream == 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << m_prrOutputFilename.c_str ());
+    }
+  else
+    {
+      std::ostream &outFile = *stream;
+      if (m_prrFirstWrite == true)
+        {
+          m_prrFirstWrite = false;
+          outFile << "% start\tend\tdistLow\tdistHigh\tnRx\tnOk\tprr";
+          outFile << "\n";
+        }
+      for (uint32_t bin = 0; bin < m_nRx.size (); bin++)
+        {
+          outFile << start << "\t";
+          outFile << end << "\t";
+          outFile << bin * m_distanceBinWidth << "\t";
+          outFile << std::min ((bin + 1) * m_distanceBinWidth, m_maxDistance) << "\t";
+          outFile << m_nRx[bin] << "\t";
+          outFile << m_nOk[bin] << "\t";
+          outFile << (m_nRx[bin] > 0 ? (double) m_nOk[bin] / m_nRx[bin] : 0.0) << "\n";
+        }
+    }
+
+  stream = GetOutputStream (m_ipgOutputFilename, m_ipgFirstWrite);
+  if (stream == 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << m_ipgOutputFilename.c_str ());
+    }
+  else
+    {
+      std::ostream &outFile = *stream;
+      if (m_ipgFirstWrite == true)
+        {
+          m_ipgFirstWrite = false;
+          outFile << "% start\tend\tipgLow\tipgHigh\tcount";
+          outFile << "\n";
+        }
+      int64_t ipgWidthMs = m_ipgBinWidth.GetMilliSeconds ();
+      int64_t maxIpgMs = m_maxIpg.GetMilliSeconds ();
+      for (uint32_t bin = 0; bin < m_ipgCount.size (); bin++)
+        {
+          outFile << start << "\t";
+          outFile << end << "\t";
+          if (bin + 1 < m_ipgCount.size ())
+            {
+              outFile << bin * ipgWidthMs << "\t";
+              outFile << std::min<int64_t> ((bin + 1) * ipgWidthMs, maxIpgMs) << "\t";
+            }
+          else
+            {
+              outFile << maxIpgMs << "\t";
+              outFile << "inf" << "\t";
+            }
+          outFile << m_ipgCount[bin] << "\n";
+        }
+    }
+
+  stream = GetOutputStream (m_failureOutputFilename, m_failureFirstWrite);
+  if (stream == 0)
+    {
+      NS_LOG_ERROR ("Can't open file " << m_failureOutputFilename.c_str ());
+    }
+  else
+    {
+      std::ostream &outFile = *stream;
+      if (m_failureFirstWrite == true)
+        {
+          m_failureFirstWrite = false;
+          outFile << "% start\tend\tnRx\tnOk\tweakSignal\tcollision\tinterference\thalfDuplex\tother";
+          outFile << "\n";
+        }
+      outFile << start << "\t";
+      outFile << end << "\t";
+      outFile << m_windowRx << "\t";
+      outFile << m_windowOk << "\t";
+      outFile << m_failures[WEAK_SIGNAL] << "\t";
+      outFile << m_failures[COLLISION] << "\t";
+      outFile << m_failures[INTERFERENCE] << "\t";
+      outFile << m_failures[HALF_DUPLEX] << "\t";
+      outFile << m_failures[OTHER] << "\n";
+    }
+}
+
+void
+SlV2xMetricsCalculator::Finish (void)
+{
+  NS_LOG_FUNCTION (this);
+  WriteWindow ();
+  CloseOutputStreams ();
+}
+
+} // namespace ns3
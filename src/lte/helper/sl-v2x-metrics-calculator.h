@@ -0,0 +1,137 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SL_V2X_METRICS_CALCULATOR_H_
+#define SL_V2X_METRICS_CALCULATOR_H_
+
+#include "ns3/lte-stats-calculator.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include <ns3/lte-common.h>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Aggregates the Sidelink PSCCH receptions (SlPscchReception trace) in
+ * the simulation and writes only the aggregates, once per time window:
+ *
+ *   - PRR per distance bin: number of receptions, number of successful
+ *     receptions and their ratio
+ *   - histogram of the inter-packet gap, i.e., the time between two
+ *     successful receptions from the same transmitter
+ *   - breakdown of the failed receptions by cause: weak signal,
+ *     collision, interference, half duplex
+ *
+ * The failure cause is taken from the reception type reported by
+ * LteSpectrumPhy: 1 weak signal, 2 collision with an overlapping PSCCH,
+ * 3 decoding failure under interference without PSCCH overlap (SINR /
+ * BLER), 4 half duplex.
+ * The PHY reports only the receptions from the transmitters closer than
+ * 150 m, so the distance bins should not extend beyond that range.
+ *
+ * A window is written when the first reception of a later window is
+ * notified, and the last window when the simulator is destroyed; windows
+ * without receptions are not written.
+ */
+class SlV2xMetricsCalculator : public LteStatsCalculator
+{
+public:
+  /**
+   * Constructor
+   */
+  SlV2xMetricsCalculator ();
+
+  /**
+   * Destructor
+   */
+  virtual ~SlV2xMetricsCalculator ();
+
+  // Inherited from ns3::Object
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Notifies the calculator that a Sidelink PSCCH reception has occurred.
+   * \param params The trace information regarding the reception
+   */
+  void SlPscchReception (SlPhyReceptionStatParameters params);
+
+  /**
+   * Write the aggregates of the current window, if any
+   */
+  void WriteWindow (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// Causes of reception failure
+  enum FailureCause
+  {
+    WEAK_SIGNAL = 0,
+    COLLISION,
+    INTERFERENCE,
+    HALF_DUPLEX,
+    OTHER,
+    N_FAILURE_CAUSES
+  };
+
+  /**
+   * Allocate the bins of the current window
+   */
+  void ResetWindow (void);
+
+  /**
+   * Write the last window and close the output files
+   */
+  void Finish (void);
+
+  std::string m_prrOutputFilename; ///< name of the file of the PRR per distance
+  std::string m_ipgOutputFilename; ///< name of the file of the inter-packet gap histogram
+  std::string m_failureOutputFilename; ///< name of the file of the failure causes
+
+  Time m_windowDuration; ///< duration of a window
+  double m_distanceBinWidth; ///< width of a distance bin (m)
+  double m_maxDistance; ///< upper bound of the last distance bin (m)
+  Time m_ipgBinWidth; ///< width of an inter-packet gap bin
+  Time m_maxIpg; ///< upper bound of the inter-packet gap histogram
+
+  bool m_windowActive; ///< true if receptions were notified in the current window
+  int64_t m_windowIndex; ///< index of the current window
+  std::vector<uint64_t> m_nRx; ///< receptions per distance bin
+  std::vector<uint64_t> m_nOk; ///< successful receptions per distance bin
+  std::vector<uint64_t> m_ipgCount; ///< inter-packet gaps per bin, the last bin counts the gaps above MaxInterPacketGap
+  std::vector<uint64_t> m_failures; ///< failed receptions per cause
+  uint64_t m_windowRx; ///< receptions in the current window
+  uint64_t m_windowOk; ///< successful receptions in the current window
+
+  bool m_prrFirstWrite; ///< true if the PRR file has not been opened yet
+  bool m_ipgFirstWrite; ///< true if the inter-packet gap file has not been opened yet
+  bool m_failureFirstWrite; ///< true if the failure cause file has not been opened yet
+
+  EventId m_finishEvent; ///< writes the last window when the simulator is destroyed
+};
+
+} // namespace ns3
+
+#endif /* SL_V2X_METRICS_CALCULATOR_H_ */
@@ -415,6 +415,54 @@ LteMiErrorModel::Mib (const SpectrumValue& sinr, const std::vector<int>& map, ui
   return MI;
 }
 
+double
+LteMiErrorModel::Mib (const double *sinr, const int *rbs, uint32_t nRbs, uint8_t mcs)
+{
+  NS_LOG_FUNCTION (sinr << rbs << nRbs << (uint32_t) mcs);
+
+  // the modulation is the same for all the RBs of the TB, so the MI map is
+  // selected once instead of for each RB
+  const double *miMap;
+  const double *miAxis;
+  uint16_t miMapSize;
+  if (mcs <= MI_QPSK_MAX_ID) // QPSK
+    {
+      miMap = MI_map_qpsk;
+      miAxis = MI_map_qpsk_axis;
+      miMapSize = MI_MAP_QPSK_SIZE;
+    }
+  else if (mcs <= MI_16QAM_MAX_ID) // 16-QAM
+    {
+      miMap = MI_map_16qam;
+      miAxis = MI_map_16qam_axis;
+      miMapSize = MI_MAP_16QAM_SIZE;
+    }
+  else // 64-QAM
+    {
+      miMap = MI_map_64qam;
+      miAxis = MI_map_64qam_axis;
+      miMapSize = MI_MAP_64QAM_SIZE;
+    }
+  const double axisMin = miAxis[0];
+  const double axisMax = miAxis[miMapSize - 1];
+  // the values of the axis are uniformly spaced
+  const double scalingCoeff = (miMapSize - 1) / (axisMax - axisMin);
+  const double maxIndex = miMapSize - 1;
+
+  // without branches nor bounds checks in the loop: the index is clamped
+  // to the map, and the MI replaced by 1 above the last value of the axis
+  double miSum = 0.0;
+  for (uint32_t i = 0; i < nRbs; i++)
+    {
+      double sinrLin = sinr[rbs[i]];
+      double sinrIndexDouble = std::min (std::max ((sinrLin - axisMin) * scalingCoeff + 1, 0.0), maxIndex);
+      double mi = miMap[(uint32_t) sinrIndexDouble];
+      miSum += sinrLin > axisMax ? 1 : mi;
+    }
+  double mib = miSum / nRbs;
+  NS_LOG_LOGIC (" MI = " << mib);
+  return mib;
+}
 
 double 
 LteMiErrorModel::MappingMiBler (double mib, uint8_t ecrId, uint16_t cbSize)
@@ -558,7 +606,7 @@ LteMiErrorModel::GetTbDecodificationStats (const SpectrumValue& sinr, const std:
 {
   NS_LOG_FUNCTION (sinr << &map << (uint32_t) size << (uint32_t) mcs);
 
-  double tbMi = Mib(sinr, map, mcs);
+  double tbMi = Mib (&(*sinr.ConstValuesBegin ()), map.empty () ? 0 : &map[0], map.size (), mcs);
   double MI = 0.0;
   double Reff = 0.0;
   NS_ASSERT (mcs < 29);
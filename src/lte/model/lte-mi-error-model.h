@@ -91,6 +91,20 @@ public:
    * \return the mmib
    */
   static double Mib (const SpectrumValue& sinr, const std::vector<int>& map, uint8_t mcs);
+  /**
+   * \brief find the mmib (mean mutual information per bit) of the specified TB
+   *
+   * Same as the Mib above, on a contiguous array of SINRs. The MI map
+   * of the modulation is selected once for all the RBs, and the loop on
+   * the RBs has neither branches nor bounds checks.
+   *
+   * \param sinr the perceived sinrs in the whole bandwidth, one per RB
+   * \param rbs the indices of the active RBs for the TB
+   * \param nRbs the number of active RBs, at least 1
+   * \param mcs the MCS of the TB
+   * \return the mmib
+   */
+  static double Mib (const double *sinr, const int *rbs, uint32_t nRbs, uint8_t mcs);
   /** 
    * \brief map the mmib (mean mutual information per bit) for different MCS
    * \param mib mean mutual information per bit of a code-block
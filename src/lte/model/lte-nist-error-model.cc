@@ -351,6 +351,139 @@ static const double PsbchAwgnSisoBlerCurveYaxis[43] = {
   1,0.9979,0.9969,0.9958,0.995,0.9912,0.9912,0.9846,0.9766,0.9661,0.9587,0.9409,0.9217,0.8995,0.8787,0.8373,0.7927,0.744,0.6976,0.6348,0.5662,0.5032,0.4392,0.3677,0.3068,0.2522,0.2011,0.1504,0.1254,0.0878,0.0635,0.0436,0.032,0.0211,0.0146,0.008,0.0063,0.0046,0.0033,0.0017,0.001,0.0004,0
 };
 
+/**
+ * Number of points of the dense BLER tables per step of the BLER curves,
+ * i.e. a grid of 0.02 dB for the curves sampled every 0.2 dB
+ */
+static const uint16_t DENSE_POINTS_PER_STEP = 10;
+
+/**
+ * BLER curves resampled on a dense grid of SINR in dB.
+ *
+ * The curves are interpolated linearly in the linear SINR between their
+ * points, which needs two std::pow per lookup. The dense table stores
+ * this interpolation on a grid DENSE_POINTS_PER_STEP times finer, which
+ * contains the points of the curves, so that a lookup is a linear
+ * interpolation in dB between two consecutive values of the table.
+ */
+class LteNistDenseBlerTable
+{
+public:
+  /**
+   * \brief Resample the BLER curves
+   * \param xtable The x-axis table
+   * \param ytable The y-axis table
+   * \param nRows The number of rows of the tables
+   * \param ysize The number of columns of the table containing y-axis values
+   */
+  LteNistDenseBlerTable (const double (*xtable)[XTABLE_SIZE], const double *ytable, uint16_t nRows, uint16_t ysize)
+  {
+    m_rows.resize (nRows);
+    for (uint16_t r = 0; r < nRows; r++)
+      {
+        Row &row = m_rows[r];
+        double step = xtable[r][2] / DENSE_POINTS_PER_STEP;
+        uint32_t nCols = std::floor ((xtable[r][1] - xtable[r][0]) / xtable[r][2] + 0.5) + 1;
+        NS_ASSERT (nCols <= ysize);
+        row.minDb = xtable[r][0];
+        row.maxDb = xtable[r][1];
+        row.invStep = 1 / step;
+        row.offset = m_values.size ();
+        row.lastIndex = (nCols - 1) * DENSE_POINTS_PER_STEP;
+        for (uint32_t i = 0; i < nCols - 1; i++)
+          {
+            double bler1 = ytable[r * ysize + i];
+            double bler2 = ytable[r * ysize + i + 1];
+            double sinr1 = std::pow (10, (xtable[r][0] + i * xtable[r][2]) / 10);
+            double sinr2 = std::pow (10, (xtable[r][0] + (i + 1) * xtable[r][2]) / 10);
+            for (uint16_t j = 0; j < DENSE_POINTS_PER_STEP; j++)
+              {
+                double sinr = std::pow (10, (xtable[r][0] + i * xtable[r][2] + j * step) / 10);
+                m_values.push_back (j == 0 ? bler1 : bler1 + (bler2 - bler1) * (sinr - sinr1) / (sinr2 - sinr1));
+              }
+          }
+        // the last point is repeated so that a lookup can always read the next value
+        m_values.push_back (ytable[r * ysize + nCols - 1]);
+        m_values.push_back (ytable[r * ysize + nCols - 1]);
+      }
+  }
+
+  /**
+   * \param row The row index
+   * \param sinrDb The SINR in dB
+   * \return The BLER
+   */
+  double GetBler (uint16_t row, double sinrDb) const
+  {
+    const Row &r = m_rows[row];
+    double pos = (sinrDb - r.minDb) * r.invStep;
+    pos = std::min (std::max (pos, 0.0), (double) r.lastIndex);
+    uint32_t index = pos;
+    double frac = pos - index;
+    const float *v = &m_values[r.offset + index];
+    double bler = v[0] + frac * (v[1] - v[0]);
+    bler = sinrDb < r.minDb ? 1 : bler;
+    bler = sinrDb > r.maxDb ? 0 : bler;
+    return bler;
+  }
+
+  /**
+   * \brief Lookup the BLER of several SINRs in one pass
+   * \param rows The row indices
+   * \param sinrDb The SINRs in dB
+   * \param bler The BLERs
+   * \param n The number of lookups
+   */
+  void GetBler (const uint16_t *rows, const double *sinrDb, double *bler, uint32_t n) const
+  {
+    for (uint32_t i = 0; i < n; i++)
+      {
+        bler[i] = GetBler (rows[i], sinrDb[i]);
+      }
+  }
+
+private:
+  /// Dense BLER curve of an MCS and HARQ transmission
+  struct Row
+  {
+    double minDb; ///< SINR of the first point, in dB
+    double maxDb; ///< SINR of the last point, in dB
+    double invStep; ///< inverse of the step of the dense grid, in 1/dB
+    uint32_t offset; ///< index of the first point in the values
+    uint32_t lastIndex; ///< index of the last point, relative to the offset
+  };
+
+  std::vector<Row> m_rows; ///< rows of the table
+  std::vector<float> m_values; ///< BLER values of all the rows
+};
+
+/**
+ * \brief Get the dense BLER table of BLER curves, which is built on first use
+ * \param xtable The x-axis table
+ * \return The dense BLER table
+ */
+static const LteNistDenseBlerTable &
+GetDenseBlerTable (const double (*xtable)[XTABLE_SIZE])
+{
+  if (xtable == PuschAwgnSisoBlerCurveXaxis)
+    {
+      static const LteNistDenseBlerTable table (PuschAwgnSisoBlerCurveXaxis, PuschAwgnSisoBlerCurveYaxis, 116, PUSCH_AWGN_SIZE);
+      return table;
+    }
+  if (xtable == PsdchAwgnSisoBlerCurveXaxis)
+    {
+      static const LteNistDenseBlerTable table (PsdchAwgnSisoBlerCurveXaxis, PsdchAwgnSisoBlerCurveYaxis, 4, PSDCH_AWGN_SIZE);
+      return table;
+    }
+  if (xtable == PscchAwgnSisoBlerCurveXaxis)
+    {
+      static const LteNistDenseBlerTable table (PscchAwgnSisoBlerCurveXaxis, PscchAwgnSisoBlerCurveYaxis, 1, PSCCH_AWGN_SIZE);
+      return table;
+    }
+  NS_ASSERT (xtable == PsbchAwgnSisoBlerCurveXaxis);
+  static const LteNistDenseBlerTable table (PsbchAwgnSisoBlerCurveXaxis, PsbchAwgnSisoBlerCurveYaxis, 1, PSBCH_AWGN_SIZE);
+  return table;
+}
 
 int16_t
 LteNistErrorModel::GetRowIndex (uint16_t mcs, uint8_t harq)
@@ -374,41 +507,32 @@ LteNistErrorModel::GetColIndex (double val, double min, double max, double step)
 }
 
 double
-LteNistErrorModel::GetBlerValue (const double (*xtable)[XTABLE_SIZE], const double (*ytable), const uint16_t ysize, uint16_t mcs, uint8_t harq, double sinr)
+LteNistErrorModel::GetBlerValue (const double (*xtable)[XTABLE_SIZE], uint16_t mcs, uint8_t harq, double sinr)
 {
   NS_LOG_FUNCTION (mcs << (uint16_t) harq << sinr);
   double sinrDb = 10 * std::log10 (sinr);
   int16_t rIndex = GetRowIndex (mcs, harq);
-  double bler = 1;
-
   NS_LOG_DEBUG ("sinrDb=" << sinrDb << " min=" << xtable[rIndex][0] << " max=" << xtable[rIndex][1]);
-  if (sinrDb < xtable[rIndex][0])
-    {
-      bler = 1;
-    }
-  else if (sinrDb  > xtable[rIndex][1])
+  return GetDenseBlerTable (xtable).GetBler (rIndex, sinrDb);
+}
+
+void
+LteNistErrorModel::GetBlerValues (const double (*xtable)[XTABLE_SIZE], const std::vector<uint16_t> &rows, const std::vector<double> &sinr, std::vector<double> &bler)
+{
+  NS_LOG_FUNCTION (sinr.size ());
+  NS_ASSERT (rows.size () == sinr.size ());
+  bler.resize (sinr.size ());
+  if (sinr.empty ())
     {
-      bler = 0;
+      return;
     }
-  else
+  //convert all the SINRs first, then lookup the table, so that each loop is simple enough to be vectorized
+  std::vector<double> sinrDb (sinr.size ());
+  for (uint32_t i = 0; i < sinr.size (); i++)
     {
-      int16_t index1 = std::floor ((sinrDb - xtable[rIndex][0]) / xtable[rIndex][2]);
-      int16_t index2 = std::ceil ((sinrDb - xtable[rIndex][0]) / xtable[rIndex][2]);
-      if (index1 != index2)
-        {
-          //interpolate
-          double sinr1 = std::pow (10, (xtable[rIndex][0] + index1 * xtable[rIndex][2]) / 10);
-          double sinr2 = std::pow (10, (xtable[rIndex][0] + index2 * xtable[rIndex][2]) / 10);
-          double bler1 = ytable[rIndex * ysize + index1];
-          double bler2 = ytable[rIndex * ysize + index2];
-          bler = bler1 + (bler2 - bler1) * (sinr - sinr1) / (sinr2 - sinr1);
-        }
-      else
-        {
-          bler = ytable[rIndex * ysize + index1];
-        }
+      sinrDb[i] = 10 * std::log10 (sinr[i]);
     }
-  return bler;
+  GetDenseBlerTable (xtable).GetBler (&rows[0], &sinrDb[0], &bler[0], sinr.size ());
 }
 
 double
@@ -470,8 +594,8 @@ LteNistErrorModel::GetBler (const double (*xtable)[XTABLE_SIZE], const double (*
   if (harq > 0 && prevSinr != newSinr)
     {
       //must combine previous and new transmission
-      double prevBler = GetBlerValue (xtable, ytable, ysize, mcs, harq, prevSinr);
-      double newBler = GetBlerValue (xtable, ytable, ysize, mcs, harq, newSinr);
+      double prevBler = GetBlerValue (xtable, mcs, harq, prevSinr);
+      double newBler = GetBlerValue (xtable, mcs, harq, newSinr);
       //compute effective BLER
       if (prevBler == 1 && newBler == 1)
         {
@@ -498,7 +622,7 @@ LteNistErrorModel::GetBler (const double (*xtable)[XTABLE_SIZE], const double (*
   else
     {
       //first transmission or the SINR did not change
-      tbStat.tbler = GetBlerValue (xtable, ytable, ysize, mcs, harq, newSinr);
+      tbStat.tbler = GetBlerValue (xtable, mcs, harq, newSinr);
       tbStat.sinr = newSinr;
     }
   NS_LOG_INFO ("bler=" << tbStat.tbler << ", sinr=" << tbStat.sinr);
@@ -698,4 +822,67 @@ LteNistErrorModel::GetPsbchBler (LteFadingModel fadingChannel, LteTxMode txmode,
 }
 
 
+void
+LteNistErrorModel::GetPscchBler (LteFadingModel fadingChannel, LteTxMode txmode, const std::vector<double> &sinr, std::vector<double> &bler)
+{
+  //Find the table to use
+  const double (*xtable)[XTABLE_SIZE];
+
+  switch (fadingChannel)
+    {
+    case AWGN:
+      switch (txmode)
+        {
+        case SISO:
+          xtable = PscchAwgnSisoBlerCurveXaxis;
+          break;
+        default:
+          NS_FATAL_ERROR ("Transmit mode " << txmode << " not supported in AWGN channel");
+        }
+      break;
+    default:
+      NS_FATAL_ERROR ("Fading channel " << fadingChannel << " not supported");
+    }
+
+  std::vector<uint16_t> rows (sinr.size (), 0);
+  GetBlerValues (xtable, rows, sinr, bler);
+}
+
+void
+LteNistErrorModel::GetPsschBler (LteFadingModel fadingChannel, LteTxMode txmode, const std::vector<uint16_t> &mcs, const std::vector<double> &sinr, std::vector<double> &bler)
+{
+  NS_ASSERT (mcs.size () == sinr.size ());
+
+  //Find the table to use
+  const double (*xtable)[XTABLE_SIZE];
+
+  switch (fadingChannel)
+    {
+    case AWGN:
+      switch (txmode)
+        {
+        case SISO:
+          xtable = PuschAwgnSisoBlerCurveXaxis;
+          break;
+        default:
+          NS_FATAL_ERROR ("Transmit mode " << txmode << " not supported in AWGN channel");
+        }
+      break;
+    default:
+      NS_FATAL_ERROR ("Fading channel " << fadingChannel << " not supported");
+    }
+
+  std::vector<uint16_t> rows (mcs.size ());
+  for (uint32_t i = 0; i < mcs.size (); i++)
+    {
+      //Check mcs values
+      if (mcs[i] > 20)
+        {
+          NS_FATAL_ERROR ("PSSCH modulation cannot exceed 20");
+        }
+      rows[i] = GetRowIndex (mcs[i], 0);
+    }
+  GetBlerValues (xtable, rows, sinr, bler);
+}
+
 } // namespace ns3
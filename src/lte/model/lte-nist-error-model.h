@@ -36,6 +36,7 @@
 #ifndef LTE_NIST_ERROR_MODEL_H
 #define LTE_NIST_ERROR_MODEL_H
 #include <stdint.h>
+#include <vector>
 #include <ns3/lte-harq-phy.h>
 
 namespace ns3 {
@@ -60,6 +61,13 @@ struct TbErrorStats_t
   * i.e., Pssch, Psdch, Pscch Psbch and LTE Pusch obtained by using and extending
   * (for Sidelink physical channels) MATLAB LTE toolbox.
   * For more details please refer to; http://nvlpubs.nist.gov/nistpubs/ir/2016/NIST.IR.8157.pdf
+  *
+  * The BLER curves are interpolated linearly in the linear SINR between
+  * their points. On first use, each curve is resampled with this
+  * interpolation on a grid of SINR ten times finer (0.02 dB), so that a
+  * lookup only interpolates linearly in dB between two values of the
+  * grid. The BLER returned differ from the interpolation of the curves by
+  * less than 1e-4.
   */
 class LteNistErrorModel
 {
@@ -148,6 +156,31 @@ public:
    */
   static TbErrorStats_t GetPsbchBler (LteFadingModel fadingChannel, LteTxMode txmode, double sinr);
 
+  /**
+   * \brief Lookup the BLER of several PSCCH receptions in one pass
+   *
+   * Same as the BLER returned by GetPscchBler for each SINR.
+   * \param fadingChannel The channel to use
+   * \param txmode The Transmission mode used
+   * \param sinr The mean sinr of each TB
+   * \param bler The BLER of each TB, resized to the number of SINRs
+   */
+  static void GetPscchBler (LteFadingModel fadingChannel, LteTxMode txmode, const std::vector<double> &sinr, std::vector<double> &bler);
+
+  /**
+   * \brief Lookup the BLER of several PSSCH first transmissions in one pass
+   *
+   * Same as the BLER returned by GetPsschBler for each TB, without HARQ
+   * history. Retransmissions, which combine the SINR of the previous
+   * transmission, use GetPsschBler.
+   * \param fadingChannel The channel to use
+   * \param txmode The Transmission mode used
+   * \param mcs The MCS of each TB
+   * \param sinr The mean sinr of each TB
+   * \param bler The BLER of each TB, resized to the number of SINRs
+   */
+  static void GetPsschBler (LteFadingModel fadingChannel, LteTxMode txmode, const std::vector<uint16_t> &mcs, const std::vector<double> &sinr, std::vector<double> &bler);
+
 
   //TODO: as error models for other physical channels are added, add new functions. The signature should be the same
 
@@ -172,15 +205,26 @@ private:
 
   /**
    * \brief Get BLER value function
+   *
+   * The BLER is read from the dense table built from the x-axis table and
+   * its y-axis table.
+   *
    * \param *xtable Pointer to the x-axis table
-   * \param *ytable Pointer to the y-axis table
-   * \param ysize The number of columns of the table containing y-axis values (BLER)
    * \param mcs The MCS
    * \param harq The HARQ index
    * \param sinr The SINR
    * \return The BLER value
    */
-  static double GetBlerValue (const double (*xtable)[XTABLE_SIZE], const double *ytable, const uint16_t ysize, uint16_t mcs, uint8_t harq, double sinr);
+  static double GetBlerValue (const double (*xtable)[XTABLE_SIZE], uint16_t mcs, uint8_t harq, double sinr);
+
+  /**
+   * \brief Get the BLER values of several lookups in one pass
+   * \param *xtable Pointer to the x-axis table
+   * \param rows The row index of each lookup
+   * \param sinr The SINR of each lookup
+   * \param bler The BLER of each lookup, resized to the number of SINRs
+   */
+  static void GetBlerValues (const double (*xtable)[XTABLE_SIZE], const std::vector<uint16_t> &rows, const std::vector<double> &sinr, std::vector<double> &bler);
 
   /**
    * \brief Get BLER value function
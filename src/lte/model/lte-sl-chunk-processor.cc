@@ -36,6 +36,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("LteSlChunkProcessor");
 
 LteSlChunkProcessor::LteSlChunkProcessor ()
+  : m_nChunkValues (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -59,15 +60,18 @@ LteSlChunkProcessor::Start (bool init)
 
   if (init)
     {
-      m_chunkValues.clear ();
+      m_nChunkValues = 0;
     }
 
-  // Creates a new storage 
-  LteSlChunkValue newValue;
-  newValue.m_sumValues = 0;
+  // Creates a new storage, or reuses the one of a previous reception
+  if (m_nChunkValues == m_chunkValues.size ())
+    {
+      m_chunkValues.push_back (LteSlChunkValue ());
+    }
+  LteSlChunkValue &newValue = m_chunkValues[m_nChunkValues++];
+  newValue.m_sumValues.clear ();
+  newValue.m_model = 0;
   newValue.m_totDuration = MicroSeconds (0);
-
-  m_chunkValues.push_back (newValue);
 }
 
 
@@ -75,12 +79,30 @@ void
 LteSlChunkProcessor::EvaluateChunk (uint32_t index, const SpectrumValue& sinr, Time duration)
 {
   NS_LOG_FUNCTION (this << index << sinr << duration);
-  if (m_chunkValues[index].m_sumValues == 0)
+  EvaluateChunk (index, &(*sinr.ConstValuesBegin ()), sinr.GetSpectrumModel (), duration);
+}
+
+void
+LteSlChunkProcessor::EvaluateChunk (uint32_t index, const double *values, Ptr<const SpectrumModel> model, Time duration)
+{
+  NS_LOG_FUNCTION (this << index << duration);
+  NS_ASSERT (index < m_nChunkValues);
+  LteSlChunkValue &chunkValue = m_chunkValues[index];
+  size_t nValues = model->GetNumBands ();
+  if (chunkValue.m_model == 0)
+    {
+      chunkValue.m_model = model;
+      // keeps the capacity of the previous receptions
+      chunkValue.m_sumValues.assign (nValues, 0.0);
+    }
+  NS_ASSERT (chunkValue.m_sumValues.size () == nValues);
+  double seconds = duration.GetSeconds ();
+  double *sum = &chunkValue.m_sumValues[0];
+  for (size_t k = 0; k < nValues; ++k)
     {
-      m_chunkValues[index].m_sumValues = Create<SpectrumValue> (sinr.GetSpectrumModel ());
+      sum[k] += values[k] * seconds;
     }
-  *(m_chunkValues[index].m_sumValues) += sinr * duration.GetSeconds ();
-  m_chunkValues[index].m_totDuration += duration;
+  chunkValue.m_totDuration += duration;
 }
 
 void
@@ -88,13 +110,20 @@ LteSlChunkProcessor::End ()
 {
   NS_LOG_FUNCTION (this);
 
-  if (m_chunkValues[0].m_totDuration.GetSeconds () > 0)
+  if (m_nChunkValues > 0 && m_chunkValues[0].m_totDuration.GetSeconds () > 0)
     {
       std::vector<SpectrumValue> values;
-      std::vector<LteSlChunkValue>::iterator itValues;
-      for (itValues = m_chunkValues.begin() ; itValues != m_chunkValues.end () ; itValues++)
+      values.reserve (m_nChunkValues);
+      for (uint32_t index = 0; index < m_nChunkValues; index++)
         {
-          values.push_back (*((*itValues).m_sumValues) / (*itValues).m_totDuration.GetSeconds ());
+          const LteSlChunkValue &chunkValue = m_chunkValues[index];
+          values.push_back (SpectrumValue (chunkValue.m_model));
+          double seconds = chunkValue.m_totDuration.GetSeconds ();
+          Values::iterator out = values.back ().ValuesBegin ();
+          for (size_t k = 0; k < chunkValue.m_sumValues.size (); ++k, ++out)
+            {
+              *out = chunkValue.m_sumValues[k] / seconds;
+            }
         }
 
       std::vector<LteSlChunkProcessorCallback>::iterator it;
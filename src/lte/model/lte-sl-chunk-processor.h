@@ -32,10 +32,12 @@
 #include <ns3/ptr.h>
 #include <ns3/nstime.h>
 #include <ns3/object.h>
+#include <vector>
 
 namespace ns3 {
 
 class SpectrumValue;
+class SpectrumModel;
 
 /// Chunk processor callback typedef
 typedef Callback< void, std::vector<SpectrumValue> > LteSlChunkProcessorCallback;
@@ -54,7 +56,8 @@ public:
   /** Stores the received spectral power and duration of the received signals */
   struct LteSlChunkValue
   {
-    Ptr<SpectrumValue> m_sumValues; //!< received spectral density
+    std::vector<double> m_sumValues; //!< received spectral density, weighted by the duration in seconds
+    Ptr<const SpectrumModel> m_model; //!< spectrum model of the received spectral density
     Time m_totDuration; //!< duration of the signal received
   };
 
@@ -87,6 +90,19 @@ public:
     */
   virtual void EvaluateChunk (uint32_t index, const SpectrumValue& sinr, Time duration);
 
+  /**
+    * \brief Collect the values of a chunk and its duration
+    *
+    * Same as EvaluateChunk (uint32_t, const SpectrumValue&, Time), but
+    * the values are read from a buffer owned by the caller, which is only
+    * valid during the call.
+    * \param index The index of the message received
+    * \param values The values of the chunk, one per band of the model
+    * \param model The spectrum model of the values
+    * \param duration The duration of the chunk
+    */
+  virtual void EvaluateChunk (uint32_t index, const double *values, Ptr<const SpectrumModel> model, Time duration);
+
   /**
     * \brief Finish calculation and inform interested objects about calculated value
     *
@@ -97,7 +113,13 @@ public:
   virtual void End ();
 
 private:
-  std::vector<LteSlChunkValue> m_chunkValues; ///< Vector to hold LteSlChunkValue of Signals received on Sidelink
+  /**
+   * Vector to hold LteSlChunkValue of Signals received on Sidelink. Its
+   * elements are reused from one reception to the next, so that their
+   * storage is only allocated for the first receptions.
+   */
+  std::vector<LteSlChunkValue> m_chunkValues;
+  uint32_t m_nChunkValues; ///< number of signals of the current reception
 
   std::vector<LteSlChunkProcessorCallback> m_lteSlChunkProcessorCallbacks; ///< chunk processor callback
 };
@@ -90,7 +90,7 @@ LteSlInterference::StartRx (Ptr<const SpectrumValue> rxPsd)
     }
 
   // In Sidelink, each packet must be monitor separately
-  m_rxSignal.push_back (rxPsd->Copy ());
+  m_rxSignal.push_back (rxPsd);
   m_lastChangeTime = Now ();
   
   // trigger the initialization of each chunk processor 
@@ -200,31 +200,45 @@ LteSlInterference::ConditionallyEvaluateChunk ()
   NS_LOG_DEBUG (this << " now "  << Now () << " last " << m_lastChangeTime);
   if (m_receiving && (Now () > m_lastChangeTime))
     {
+      Ptr<const SpectrumModel> model = m_noise->GetSpectrumModel ();
+      const size_t nBands = m_interf.size ();
+      const double *allSignals = &(*m_allSignals->ConstValuesBegin ());
+      const double *noise = &(*m_noise->ConstValuesBegin ());
+      double *interf = &m_interf[0];
+      double *sinr = &m_sinr[0];
+      double *snr = &m_snr[0];
+      Time duration = Now () - m_lastChangeTime;
+
       //compute values for each signal being received
       for (uint32_t index = 0 ; index < m_rxSignal.size() ; ++index)
         {
           NS_LOG_LOGIC (this << " signal = " << *(m_rxSignal[index]) << " allSignals = " << *m_allSignals << " noise = " << *m_noise);
-          
-          SpectrumValue interf =  (*m_allSignals) - (*(m_rxSignal[index])) + (*m_noise);
-          
-          SpectrumValue sinr = (*(m_rxSignal[index])) / interf;
-          SpectrumValue snr = (*(m_rxSignal[index])) / (*m_noise);
-          Time duration = Now () - m_lastChangeTime;
+          NS_ASSERT (m_rxSignal[index]->GetSpectrumModel () == model);
+
+          const double *signal = &(*m_rxSignal[index]->ConstValuesBegin ());
+          for (size_t k = 0; k < nBands; ++k)
+            {
+              double interfPlusNoise = allSignals[k] - signal[k] + noise[k];
+              interf[k] = interfPlusNoise;
+              sinr[k] = signal[k] / interfPlusNoise;
+              snr[k] = signal[k] / noise[k];
+            }
+
           for (std::list<Ptr<LteSlChunkProcessor> >::const_iterator it = m_sinrChunkProcessorList.begin (); it != m_sinrChunkProcessorList.end (); ++it)
             {
-              (*it)->EvaluateChunk (index, sinr, duration);
+              (*it)->EvaluateChunk (index, sinr, model, duration);
             }
           for (std::list<Ptr<LteSlChunkProcessor> >::const_iterator it = m_snrChunkProcessorList.begin (); it != m_snrChunkProcessorList.end (); ++it)
             {
-              (*it)->EvaluateChunk (index, snr, duration);
+              (*it)->EvaluateChunk (index, snr, model, duration);
             }
           for (std::list<Ptr<LteSlChunkProcessor> >::const_iterator it = m_interfChunkProcessorList.begin (); it != m_interfChunkProcessorList.end (); ++it)
             {
-              (*it)->EvaluateChunk (index, interf, duration);
+              (*it)->EvaluateChunk (index, interf, model, duration);
             }
           for (std::list<Ptr<LteSlChunkProcessor> >::const_iterator it = m_rsPowerChunkProcessorList.begin (); it != m_rsPowerChunkProcessorList.end (); ++it)
             {
-              (*it)->EvaluateChunk (index, *(m_rxSignal[index]), duration);
+              (*it)->EvaluateChunk (index, signal, model, duration);
             }
         }
       m_lastChangeTime = Now ();
@@ -240,6 +254,10 @@ LteSlInterference::SetNoisePowerSpectralDensity (Ptr<const SpectrumValue> noiseP
   // reset m_allSignals (will reset if already set previously)
   // this is needed since this method can potentially change the SpectrumModel
   m_allSignals = Create<SpectrumValue> (noisePsd->GetSpectrumModel ());
+  size_t nBands = noisePsd->GetSpectrumModel ()->GetNumBands ();
+  m_interf.assign (nBands, 0.0);
+  m_sinr.assign (nBands, 0.0);
+  m_snr.assign (nBands, 0.0);
   if (m_receiving == true)
     {
       // abort rx
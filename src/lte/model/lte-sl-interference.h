@@ -30,6 +30,7 @@
 #include <ns3/spectrum-value.h>
 
 #include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -139,10 +140,12 @@ private:
 
   bool m_receiving; ///< are we receiving?
 
-  std::vector <Ptr<SpectrumValue> > m_rxSignal; /**< stores the power spectral density of
-                                                 * the signal whose RX is being
-                                                 * attempted
-                                                 */
+  std::vector <Ptr<const SpectrumValue> > m_rxSignal; /**< stores the power spectral density of
+                                                       * the signal whose RX is being
+                                                       * attempted; as for the signals added
+                                                       * with AddSignal, the PSD must not be
+                                                       * modified while it is referenced here
+                                                       */
 
   Ptr<SpectrumValue> m_allSignals; /**< stores the spectral
                                     * power density of the sum of incoming signals;
@@ -154,6 +157,16 @@ private:
   Time m_lastChangeTime;     /**< the time of the last change in
                                 m_TotalPower */
 
+  /**
+   * Scratch buffers of the interference plus noise, SINR and SNR of the
+   * chunk being evaluated, one value per band. They are sized with the
+   * noise PSD and reused for every signal and chunk, and are only lent
+   * to the chunk processors during LteSlChunkProcessor::EvaluateChunk.
+   */
+  std::vector<double> m_interf;
+  std::vector<double> m_sinr; ///< SINR scratch buffer, see m_interf
+  std::vector<double> m_snr; ///< SNR scratch buffer, see m_interf
+
   uint32_t m_lastSignalId; ///< the last signal ID
   uint32_t m_lastSignalIdBeforeReset; ///< the last signal ID before reset
 
@@ -0,0 +1,337 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lte-sl-resource-selector.h"
+#include <ns3/log.h>
+#include <ns3/double.h>
+#include <ns3/random-variable-stream.h>
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LteSlResourceSelector");
+
+NS_OBJECT_ENSURE_REGISTERED (LteSlResourceSelector);
+
+/// Orders the candidates by metric, then by subchannel and subframe
+static bool
+CompareCandidates (const SlCandidateResource &a, const SlCandidateResource &b)
+{
+  if (a.metric != b.metric)
+    {
+      return a.metric < b.metric;
+    }
+  if (a.subChannel != b.subChannel)
+    {
+      return a.subChannel < b.subChannel;
+    }
+  return a.subframe < b.subframe;
+}
+
+TypeId
+LteSlResourceSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LteSlResourceSelector")
+    .SetParent<Object> ()
+    .SetGroupName ("Lte")
+    .AddAttribute ("InitialRsrpThreshold",
+                   "Initial PSSCH-RSRP threshold (dBm) used to exclude the resources in use.",
+                   DoubleValue (-1000.0),
+                   MakeDoubleAccessor (&LteSlResourceSelector::m_initialRsrpThreshold),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("RsrpThresholdStep",
+                   "Increment (dB) of the PSSCH-RSRP threshold when not enough resources are left.",
+                   DoubleValue (30.0),
+                   MakeDoubleAccessor (&LteSlResourceSelector::m_rsrpThresholdStep),
+                   MakeDoubleChecker<double> (0.0, std::numeric_limits<double>::max ()))
+    .AddAttribute ("CandidateRatio",
+                   "Ratio of the resources of the selection window that must remain candidates.",
+                   DoubleValue (0.2),
+                   MakeDoubleAccessor (&LteSlResourceSelector::m_candidateRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+LteSlResourceSelector::LteSlResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LteSlResourceSelector::~LteSlResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LteSlResourceSelector::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rv = 0;
+  Object::DoDispose ();
+}
+
+void
+LteSlResourceSelector::SetRandomVariable (Ptr<UniformRandomVariable> rv)
+{
+  NS_LOG_FUNCTION (this << rv);
+  m_rv = rv;
+}
+
+bool
+LteSlResourceSelector::SelectJumpResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                           const std::vector<double> &decodingRatio,
+                                           SlCandidateResource &chosen)
+{
+  NS_LOG_FUNCTION (this << nSubChannels << scPeriod);
+  return false;
+}
+
+uint32_t
+LteSlResourceSelector::GetMinCandidates (uint32_t nResources) const
+{
+  return (uint32_t)(nResources * m_candidateRatio);
+}
+
+double
+LteSlResourceSelector::FilterByRsrp (const std::vector<double> &avrgRsrp, std::vector<bool> &candidates) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (avrgRsrp.size () == candidates.size ());
+
+  std::vector<double> rsrp;
+  rsrp.reserve (avrgRsrp.size ());
+  for (uint32_t idx = 0; idx < avrgRsrp.size (); idx++)
+    {
+      if (candidates[idx])
+        {
+          rsrp.push_back (avrgRsrp[idx]);
+        }
+    }
+
+  // more than minCandidates resources must be strictly below the threshold,
+  // i.e., the threshold must be above the (minCandidates + 1)-th lowest RSRP
+  uint32_t minCandidates = GetMinCandidates (avrgRsrp.size ());
+  if (rsrp.size () <= minCandidates)
+    {
+      NS_LOG_WARN ("Only " << rsrp.size () << " sensed resources, keeping all of them");
+      return std::numeric_limits<double>::infinity ();
+    }
+  std::nth_element (rsrp.begin (), rsrp.begin () + minCandidates, rsrp.end ());
+  double orderStatistic = rsrp[minCandidates];
+
+  double threshold = m_initialRsrpThreshold;
+  while (threshold <= orderStatistic)
+    {
+      threshold += m_rsrpThresholdStep;
+    }
+
+  for (uint32_t idx = 0; idx < avrgRsrp.size (); idx++)
+    {
+      if (candidates[idx] && !(avrgRsrp[idx] < threshold))
+        {
+          candidates[idx] = false;
+        }
+    }
+  NS_LOG_DEBUG ("RSRP threshold = " << threshold << " dBm");
+  return threshold;
+}
+
+SlCandidateResource
+LteSlResourceSelector::ChooseAmongBest (std::vector<SlCandidateResource> &candidates, uint32_t k) const
+{
+  NS_LOG_FUNCTION (this << candidates.size () << k);
+  NS_ASSERT (!candidates.empty ());
+  k = std::max<uint32_t> (1, std::min<uint32_t> (k, candidates.size ()));
+  if (k < candidates.size ())
+    {
+      // only the k best candidates are ordered, the random draw then picks
+      // the same resource as after a full sort of the candidate array
+      std::partial_sort (candidates.begin (), candidates.begin () + k, candidates.end (), CompareCandidates);
+    }
+  else
+    {
+      std::sort (candidates.begin (), candidates.end (), CompareCandidates);
+    }
+  return candidates[m_rv->GetInteger (0, k - 1)];
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LteSl3gppResourceSelector);
+
+TypeId
+LteSl3gppResourceSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LteSl3gppResourceSelector")
+    .SetParent<LteSlResourceSelector> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<LteSl3gppResourceSelector> ()
+  ;
+  return tid;
+}
+
+LteSl3gppResourceSelector::LteSl3gppResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LteSl3gppResourceSelector::~LteSl3gppResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+LteSl3gppResourceSelector::SelectResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                           const std::vector<double> &avrgRsrp,
+                                           const std::vector<double> &avrgRssi,
+                                           const std::vector<bool> &sensed,
+                                           SlCandidateResource &chosen)
+{
+  NS_LOG_FUNCTION (this << nSubChannels << scPeriod);
+  std::vector<bool> candidates (sensed);
+  FilterByRsrp (avrgRsrp, candidates);
+
+  std::vector<SlCandidateResource> packed;
+  packed.reserve (candidates.size ());
+  for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
+    {
+      for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
+        {
+          uint32_t idx = idx_sc * scPeriod + idx_sf;
+          if (candidates[idx])
+            {
+              SlCandidateResource resource;
+              resource.subChannel = idx_sc;
+              resource.subframe = idx_sf;
+              resource.metric = avrgRssi[idx];
+              packed.push_back (resource);
+            }
+        }
+    }
+  NS_LOG_INFO ("second candidate size = " << packed.size ());
+  if (packed.empty ())
+    {
+      return false;
+    }
+  chosen = ChooseAmongBest (packed, GetMinCandidates (nSubChannels * scPeriod));
+  return true;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LteSlTjResourceSelector);
+
+TypeId
+LteSlTjResourceSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LteSlTjResourceSelector")
+    .SetParent<LteSlResourceSelector> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<LteSlTjResourceSelector> ()
+    .AddAttribute ("JumpRatio",
+                   "Ratio of the resources with the highest decoding ratio considered for a jump.",
+                   DoubleValue (0.8),
+                   MakeDoubleAccessor (&LteSlTjResourceSelector::m_jumpRatio),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+  ;
+  return tid;
+}
+
+LteSlTjResourceSelector::LteSlTjResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LteSlTjResourceSelector::~LteSlTjResourceSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+LteSlTjResourceSelector::SelectResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                         const std::vector<double> &avrgRsrp,
+                                         const std::vector<double> &avrgRssi,
+                                         const std::vector<bool> &sensed,
+                                         SlCandidateResource &chosen)
+{
+  NS_LOG_FUNCTION (this << nSubChannels << scPeriod);
+  std::vector<bool> candidates (sensed);
+  FilterByRsrp (avrgRsrp, candidates);
+
+  std::vector<uint32_t> subFrameCandidateCount (scPeriod, 0);
+  uint32_t maxCandidateCount = 0;
+  for (uint32_t idx = 0; idx < candidates.size (); idx++)
+    {
+      if (candidates[idx])
+        {
+          uint32_t count = ++subFrameCandidateCount[idx % scPeriod];
+          maxCandidateCount = std::max (maxCandidateCount, count);
+        }
+    }
+
+  std::vector<SlCandidateResource> packed;
+  for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
+    {
+      for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
+        {
+          uint32_t idx = idx_sc * scPeriod + idx_sf;
+          if (candidates[idx] && subFrameCandidateCount[idx_sf] == maxCandidateCount)
+            {
+              SlCandidateResource resource;
+              resource.subChannel = idx_sc;
+              resource.subframe = idx_sf;
+              resource.metric = avrgRssi[idx];
+              packed.push_back (resource);
+            }
+        }
+    }
+  NS_LOG_INFO ("second candidate size = " << packed.size ());
+  if (packed.empty ())
+    {
+      return false;
+    }
+  chosen = packed[m_rv->GetInteger (0, packed.size () - 1)];
+  return true;
+}
+
+bool
+LteSlTjResourceSelector::SelectJumpResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                             const std::vector<double> &decodingRatio,
+                                             SlCandidateResource &chosen)
+{
+  NS_LOG_FUNCTION (this << nSubChannels << scPeriod);
+  std::vector<SlCandidateResource> packed;
+  packed.reserve (nSubChannels * scPeriod);
+  for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
+    {
+      for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
+        {
+          SlCandidateResource resource;
+          resource.subChannel = idx_sc;
+          resource.subframe = idx_sf;
+          resource.metric = -decodingRatio[idx_sc * scPeriod + idx_sf];
+          packed.push_back (resource);
+        }
+    }
+  if (packed.empty ())
+    {
+      return false;
+    }
+  chosen = ChooseAmongBest (packed, (uint32_t)(packed.size () * m_jumpRatio) + 1);
+  return true;
+}
+
+} // namespace ns3
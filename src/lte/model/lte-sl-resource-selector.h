@@ -0,0 +1,228 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_SL_RESOURCE_SELECTOR_H
+#define LTE_SL_RESOURCE_SELECTOR_H
+
+#include <ns3/object.h>
+#include <ns3/ptr.h>
+#include <vector>
+
+namespace ns3 {
+
+class UniformRandomVariable;
+
+/**
+ * \ingroup lte
+ *
+ * A single-subframe resource of the Mode-4 selection window
+ */
+struct SlCandidateResource
+{
+  uint32_t subChannel; ///< subchannel index
+  uint32_t subframe; ///< subframe index within the SC period
+  double metric; ///< ranking metric, lower is better
+};
+
+/**
+ * \ingroup lte
+ *
+ * Base class of the sensing based Mode-4 resource selection policies.
+ *
+ * The MAC passes the sensing results averaged over the sensing window,
+ * one entry per resource of the selection window stored row major by
+ * subchannel (index = subChannel * scPeriod + subframe). The base class
+ * provides the steps shared by the policies: the RSRP threshold
+ * filtering and the random choice among the best ranked candidates,
+ * which only partitions the packed candidate array (nth_element) instead
+ * of sorting it.
+ */
+class LteSlResourceSelector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  LteSlResourceSelector ();
+  virtual ~LteSlResourceSelector ();
+
+  /**
+   * \brief Set the random variable used to choose among the candidates
+   *
+   * \param rv The random variable, shared with the MAC so that stream
+   *           assignment is unchanged
+   */
+  void SetRandomVariable (Ptr<UniformRandomVariable> rv);
+
+  /**
+   * \brief Select the resource of a new SPS reservation
+   *
+   * \param nSubChannels The number of subchannels of the pool
+   * \param scPeriod The length of the selection window in subframes
+   * \param avrgRsrp The average PSSCH-RSRP (dBm) per resource
+   * \param avrgRssi The average S-RSSI (dBm) per resource
+   * \param sensed False for the resources excluded because the UE could not sense them
+   * \param chosen The selected resource
+   * \return False if no resource could be selected
+   */
+  virtual bool SelectResource (uint32_t nSubChannels, uint32_t scPeriod,
+                               const std::vector<double> &avrgRsrp,
+                               const std::vector<double> &avrgRssi,
+                               const std::vector<bool> &sensed,
+                               SlCandidateResource &chosen) = 0;
+
+  /**
+   * \brief Select the resource to jump to on reselection
+   *
+   * Called by the MAC at every reselection of a UE running the TJ
+   * algorithm. The default policy never jumps: the resource is kept.
+   *
+   * \param nSubChannels The number of subchannels of the pool
+   * \param scPeriod The length of the selection window in subframes
+   * \param decodingRatio The ratio of decoded transmissions per resource
+   * \param chosen On input the current resource, on output the selected resource
+   * \return False if the current resource is kept
+   */
+  virtual bool SelectJumpResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                   const std::vector<double> &decodingRatio,
+                                   SlCandidateResource &chosen);
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * \brief Exclude the resources whose average PSSCH-RSRP is above the threshold
+   *
+   * The threshold starts at the initial value and is raised by the
+   * threshold step until more than the candidate ratio of the resources
+   * remain. The threshold is computed from the order statistic of the
+   * RSRP values instead of re-scanning the grid at every step.
+   *
+   * \param avrgRsrp The average PSSCH-RSRP (dBm) per resource
+   * \param candidates On input the sensed resources, on output the remaining candidates
+   * \return The RSRP threshold (dBm)
+   */
+  double FilterByRsrp (const std::vector<double> &avrgRsrp, std::vector<bool> &candidates) const;
+
+  /**
+   * \brief Choose uniformly at random one of the k candidates with the lowest metric
+   *
+   * Ties are broken by subchannel and subframe index. The k best
+   * candidates are sorted, so that a given random draw picks the same
+   * resource as with a full sort of the array. The order of the
+   * candidate array is modified.
+   *
+   * The exchange sort this replaces left tied candidates in an order
+   * that depended on its swaps, so when candidates tie around the k-th
+   * rank (e.g. the resources of an empty window, or the many resources
+   * with a zero decoding ratio of a TJ jump) the set drawn from may
+   * differ from the one of the original MAC.
+   *
+   * \param candidates The packed candidate array (must not be empty)
+   * \param k The number of best candidates among which to choose
+   * \return The chosen resource
+   */
+  SlCandidateResource ChooseAmongBest (std::vector<SlCandidateResource> &candidates, uint32_t k) const;
+
+  /**
+   * \param nResources The total number of resources of the selection window
+   * \return The number of resources to keep after the RSRP filtering
+   */
+  uint32_t GetMinCandidates (uint32_t nResources) const;
+
+  Ptr<UniformRandomVariable> m_rv; ///< random variable used to choose among the candidates
+  double m_initialRsrpThreshold; ///< initial PSSCH-RSRP threshold (dBm)
+  double m_rsrpThresholdStep; ///< PSSCH-RSRP threshold increment (dB)
+  double m_candidateRatio; ///< minimum ratio of candidate resources
+};
+
+/**
+ * \ingroup lte
+ *
+ * Resource selection following 3GPP TS 36.213 14.1.1.6: after the RSRP
+ * threshold filtering, the candidate ratio of the resources with the
+ * lowest S-RSSI is kept and one of them is chosen at random.
+ */
+class LteSl3gppResourceSelector : public LteSlResourceSelector
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  LteSl3gppResourceSelector ();
+  virtual ~LteSl3gppResourceSelector ();
+
+  // inherited from LteSlResourceSelector
+  virtual bool SelectResource (uint32_t nSubChannels, uint32_t scPeriod,
+                               const std::vector<double> &avrgRsrp,
+                               const std::vector<double> &avrgRssi,
+                               const std::vector<bool> &sensed,
+                               SlCandidateResource &chosen);
+};
+
+/**
+ * \ingroup lte
+ *
+ * TJ resource selection: after the RSRP threshold filtering, one of the
+ * candidates located in the subframes with the largest number of
+ * candidate subchannels is chosen at random. On reselection the UE may
+ * jump to one of the resources where transmissions were most often
+ * decoded.
+ */
+class LteSlTjResourceSelector : public LteSlResourceSelector
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  LteSlTjResourceSelector ();
+  virtual ~LteSlTjResourceSelector ();
+
+  // inherited from LteSlResourceSelector
+  virtual bool SelectResource (uint32_t nSubChannels, uint32_t scPeriod,
+                               const std::vector<double> &avrgRsrp,
+                               const std::vector<double> &avrgRssi,
+                               const std::vector<bool> &sensed,
+                               SlCandidateResource &chosen);
+
+  /**
+   * \brief Select the resource to jump to on reselection
+   *
+   * One of the jump ratio of the resources with the highest decoding
+   * ratio is chosen at random.
+   *
+   * \copydetails LteSlResourceSelector::SelectJumpResource
+   */
+  virtual bool SelectJumpResource (uint32_t nSubChannels, uint32_t scPeriod,
+                                   const std::vector<double> &decodingRatio,
+                                   SlCandidateResource &chosen);
+
+private:
+  double m_jumpRatio; ///< ratio of the resources considered for a jump
+};
+
+} // namespace ns3
+
+#endif /* LTE_SL_RESOURCE_SELECTOR_H */
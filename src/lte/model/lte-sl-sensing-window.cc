@@ -0,0 +1,243 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lte-sl-sensing-window.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+#include <ns3/abort.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LteSlSensingWindow");
+
+const double LteSlSensingWindow::EMPTY_POWER_DBM = -1000.0;
+
+LteSlSensingWindow::LteSlSensingWindow ()
+  : m_nSubChannels (0),
+    m_length (0),
+    m_expiredUntilMs (-1)
+{
+}
+
+void
+LteSlSensingWindow::Resize (uint32_t nSubChannels, uint32_t length)
+{
+  NS_LOG_FUNCTION (this << nSubChannels << length);
+  NS_ASSERT_MSG (length > 0, "The sensing window must contain at least one subframe");
+  m_nSubChannels = nSubChannels;
+  m_length = length;
+  m_rssi.assign (m_nSubChannels * m_length, Quantize (EMPTY_POWER_DBM));
+  m_rsrp.assign (m_nSubChannels * m_length, Quantize (EMPTY_POWER_DBM));
+  m_decoded.assign (m_nSubChannels * m_length, false);
+  for (std::vector<AveragingSums>::iterator it = m_sums.begin (); it != m_sums.end (); it++)
+    {
+      BuildSums (*it);
+    }
+}
+
+void
+LteSlSensingWindow::Clear ()
+{
+  NS_LOG_FUNCTION (this);
+  std::fill (m_rssi.begin (), m_rssi.end (), Quantize (EMPTY_POWER_DBM));
+  std::fill (m_rsrp.begin (), m_rsrp.end (), Quantize (EMPTY_POWER_DBM));
+  std::fill (m_decoded.begin (), m_decoded.end (), false);
+  for (std::vector<AveragingSums>::iterator it = m_sums.begin (); it != m_sums.end (); it++)
+    {
+      BuildSums (*it);
+    }
+}
+
+void
+LteSlSensingWindow::Record (uint32_t subChannel, uint32_t slot, double rssi, double rsrp, bool decoded)
+{
+  NS_LOG_FUNCTION (this << subChannel << slot << rssi << rsrp << decoded);
+  NS_ASSERT_MSG (subChannel < m_nSubChannels && slot < m_length,
+                 "Invalid sensing window entry " << subChannel << "/" << slot);
+  uint32_t idx = subChannel * m_length + slot;
+  int64_t qRssi = Quantize (rssi);
+  int64_t qRsrp = Quantize (rsrp);
+  NS_ASSERT_MSG (qRssi >= std::numeric_limits<int32_t>::min () && qRssi <= std::numeric_limits<int32_t>::max ()
+                 && qRsrp >= std::numeric_limits<int32_t>::min () && qRsrp <= std::numeric_limits<int32_t>::max (),
+                 "Sensing sample out of range " << rssi << "/" << rsrp);
+  int64_t slotTime = GetSlotTime (slot);
+  for (std::vector<AveragingSums>::iterator it = m_sums.begin (); it != m_sums.end (); it++)
+    {
+      uint32_t sumIdx = subChannel * it->period + GetPhase (*it, slotTime);
+      it->rssiSum[sumIdx] += qRssi - m_rssi[idx];
+      it->rsrpSum[sumIdx] += qRsrp - m_rsrp[idx];
+    }
+  m_rssi[idx] = qRssi;
+  m_rsrp[idx] = qRsrp;
+  m_decoded[idx] = decoded;
+}
+
+void
+LteSlSensingWindow::Expire (int64_t timeMs)
+{
+  NS_LOG_FUNCTION (this << timeMs);
+  uint32_t slot = GetSlot (timeMs);
+  int64_t qEmpty = Quantize (EMPTY_POWER_DBM);
+  for (std::vector<AveragingSums>::iterator it = m_sums.begin (); it != m_sums.end (); it++)
+    {
+      uint32_t oldPhase = GetPhase (*it, timeMs - m_length);
+      uint32_t newPhase = GetPhase (*it, timeMs);
+      for (uint32_t subChannel = 0; subChannel < m_nSubChannels; subChannel++)
+        {
+          uint32_t idx = subChannel * m_length + slot;
+          it->rssiSum[subChannel * it->period + oldPhase] -= m_rssi[idx];
+          it->rsrpSum[subChannel * it->period + oldPhase] -= m_rsrp[idx];
+          it->rssiSum[subChannel * it->period + newPhase] += qEmpty;
+          it->rsrpSum[subChannel * it->period + newPhase] += qEmpty;
+        }
+    }
+  for (uint32_t idx = slot; idx < m_rssi.size (); idx += m_length)
+    {
+      m_rssi[idx] = qEmpty;
+      m_rsrp[idx] = qEmpty;
+      m_decoded[idx] = false;
+    }
+}
+
+void
+LteSlSensingWindow::ExpireUntil (int64_t timeMs)
+{
+  if (timeMs <= m_expiredUntilMs || m_length == 0)
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this << timeMs << m_expiredUntilMs);
+  if (timeMs - m_expiredUntilMs >= static_cast<int64_t> (m_length))
+    {
+      // the whole window expires
+      m_expiredUntilMs = timeMs;
+      Clear ();
+      return;
+    }
+  for (int64_t t = m_expiredUntilMs + 1; t <= timeMs; t++)
+    {
+      Expire (t);
+    }
+  m_expiredUntilMs = timeMs;
+}
+
+void
+LteSlSensingWindow::AddAveragingPeriod (uint32_t period)
+{
+  for (std::vector<AveragingSums>::const_iterator it = m_sums.begin (); it != m_sums.end (); it++)
+    {
+      if (it->period == period)
+        {
+          return;
+        }
+    }
+  NS_LOG_FUNCTION (this << period);
+  NS_ASSERT_MSG (period > 0, "The averaging period must contain at least one subframe");
+  AveragingSums sums;
+  sums.period = period;
+  BuildSums (sums);
+  m_sums.push_back (sums);
+}
+
+double
+LteSlSensingWindow::GetRssiSum (uint32_t subChannel, uint32_t subframe, uint32_t period) const
+{
+  return Dequantize (GetResourceSum (GetSums (period).rssiSum, m_rssi, subChannel, subframe, period));
+}
+
+double
+LteSlSensingWindow::GetRsrpSum (uint32_t subChannel, uint32_t subframe, uint32_t period) const
+{
+  return Dequantize (GetResourceSum (GetSums (period).rsrpSum, m_rsrp, subChannel, subframe, period));
+}
+
+int64_t
+LteSlSensingWindow::GetResourceSum (const std::vector<int64_t> &sums, const std::vector<int32_t> &samples,
+                                    uint32_t subChannel, uint32_t subframe, uint32_t period) const
+{
+  NS_ASSERT_MSG (subChannel < m_nSubChannels && subframe < period,
+                 "Invalid resource " << subChannel << "/" << subframe);
+  int64_t now = m_expiredUntilMs;
+  int64_t sum = sums[subChannel * period + ((now + subframe) % period + period) % period];
+  // the slot of the current subframe holds the subframe at now, while
+  // the MAC walks it as the subframe one window before now
+  int64_t length = m_length;
+  int64_t current = samples[subChannel * m_length + ((now % length) + length) % length];
+  if (subframe == 0)
+    {
+      sum -= current;
+    }
+  if (subframe == (period - m_length % period) % period)
+    {
+      sum += current;
+    }
+  return sum;
+}
+
+int64_t
+LteSlSensingWindow::GetSlotTime (uint32_t slot) const
+{
+  int64_t length = m_length;
+  return m_expiredUntilMs - ((m_expiredUntilMs - slot) % length + length) % length;
+}
+
+uint32_t
+LteSlSensingWindow::GetPhase (const AveragingSums &sums, int64_t timeMs)
+{
+  int64_t period = sums.period;
+  return ((timeMs % period) + period) % period;
+}
+
+void
+LteSlSensingWindow::BuildSums (AveragingSums &sums) const
+{
+  NS_LOG_FUNCTION (this << sums.period);
+  sums.rssiSum.assign (m_nSubChannels * sums.period, 0);
+  sums.rsrpSum.assign (m_nSubChannels * sums.period, 0);
+  for (uint32_t slot = 0; slot < m_length; slot++)
+    {
+      uint32_t phase = GetPhase (sums, GetSlotTime (slot));
+      for (uint32_t subChannel = 0; subChannel < m_nSubChannels; subChannel++)
+        {
+          uint32_t idx = subChannel * m_length + slot;
+          sums.rssiSum[subChannel * sums.period + phase] += m_rssi[idx];
+          sums.rsrpSum[subChannel * sums.period + phase] += m_rsrp[idx];
+        }
+    }
+}
+
+const LteSlSensingWindow::AveragingSums&
+LteSlSensingWindow::GetSums (uint32_t period) const
+{
+  std::vector<AveragingSums>::const_iterator it = m_sums.begin ();
+  while (it != m_sums.end () && it->period != period)
+    {
+      it++;
+    }
+  NS_ABORT_MSG_IF (it == m_sums.end (), "No sums kept for the averaging period " << period);
+  return *it;
+}
+
+int64_t
+LteSlSensingWindow::Quantize (double power)
+{
+  return static_cast<int64_t> (std::floor (power * 1048576.0 + 0.5));
+}
+
+} // namespace ns3
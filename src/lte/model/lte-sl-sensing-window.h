@@ -0,0 +1,252 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_SL_SENSING_WINDOW_H
+#define LTE_SL_SENSING_WINDOW_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Ring buffer holding the Mode-4 sensing history of a sidelink receiver.
+ *
+ * For every subchannel and every subframe of the sensing window the
+ * buffer stores the measured S-RSSI, the PSSCH-RSRP and whether the
+ * transmission was decoded. Samples are stored in a flat
+ * structure-of-arrays layout (one contiguous array per metric, row
+ * major by subchannel), and a subframe maps to its slot as
+ * (time in ms) % window length. The PHY writes the samples and the MAC
+ * reads them through a const reference, so no copy is made when a UE
+ * performs resource (re)selection.
+ *
+ * For every averaging period registered (the SC periods of the pools),
+ * the window also keeps the sums of the S-RSSI and PSSCH-RSRP of its
+ * slots per (subchannel, phase), the phase being the time of the
+ * subframe a slot holds modulo the period. The sums are updated when a
+ * sample is recorded or a slot expires, so the MAC reads the
+ * per-resource sums of a (re)selection in O(1) instead of walking the
+ * whole window. Samples are stored as 32-bit integers on a 2^-20 dB
+ * grid, covering +/-2048 dB, and summed as 64-bit integers: the sums
+ * never drift and are exactly equal to the sums of a full walk of the
+ * window. The window is most of the memory taken by a UE, hence the
+ * 32-bit samples and the packed decoding flags.
+ */
+class LteSlSensingWindow
+{
+public:
+  /// Power value (dBm) of a slot for which nothing was sensed
+  static const double EMPTY_POWER_DBM;
+
+  LteSlSensingWindow ();
+
+  /**
+   * \brief Allocate the window and mark all slots as empty
+   *
+   * \param nSubChannels The number of subchannels of the sidelink pool
+   * \param length The length of the sensing window in subframes
+   */
+  void Resize (uint32_t nSubChannels, uint32_t length);
+
+  /// Mark all the slots of the window as empty
+  void Clear ();
+
+  /**
+   * \brief Store the measurements of a received transmission
+   *
+   * \param subChannel The subchannel index
+   * \param slot The slot index, see GetSlot
+   * \param rssi The S-RSSI in dBm
+   * \param rsrp The PSSCH-RSRP in dBm
+   * \param decoded True if the transmission was successfully decoded
+   */
+  void Record (uint32_t subChannel, uint32_t slot, double rssi, double rsrp, bool decoded);
+
+  /**
+   * \brief Expire the slots of all the subframes up to the given time
+   *
+   * Expires the slots of the subframes following the last subframe
+   * expired through this method, up to and including the subframe at
+   * timeMs. A UE which did not move its window for some subframes thus
+   * catches up lazily, and at most one full window is expired.
+   *
+   * \param timeMs The absolute time in milliseconds of the last subframe to expire
+   */
+  void ExpireUntil (int64_t timeMs);
+
+  /**
+   * \brief Keep the sums of the samples for an averaging period
+   *
+   * The sums are built from the stored samples the first time a period
+   * is added, and are then kept up to date. Adding a period again does
+   * nothing.
+   *
+   * \param period The averaging period in subframes
+   */
+  void AddAveragingPeriod (uint32_t period);
+
+  /**
+   * \brief Get the sum of the S-RSSI of the subframes of a resource
+   *
+   * The window covers the length subframes preceding the last subframe
+   * expired through ExpireUntil (now), walked by the MAC from now - 1
+   * backwards. The resource gathers the subframes t of the window such
+   * that (t - now) modulo the period equals subframe.
+   *
+   * \param subChannel The subchannel index
+   * \param subframe The subframe of the resource, from 0 to period - 1
+   * \param period The averaging period, see AddAveragingPeriod
+   * \return The sum of the S-RSSI (dBm) of the subframes of the resource
+   */
+  double GetRssiSum (uint32_t subChannel, uint32_t subframe, uint32_t period) const;
+
+  /**
+   * \brief Get the sum of the PSSCH-RSRP of the subframes of a resource
+   *
+   * \param subChannel The subchannel index
+   * \param subframe The subframe of the resource, from 0 to period - 1
+   * \param period The averaging period, see AddAveragingPeriod
+   * \return The sum of the PSSCH-RSRP (dBm) of the subframes of the resource
+   * \see GetRssiSum
+   */
+  double GetRsrpSum (uint32_t subChannel, uint32_t subframe, uint32_t period) const;
+
+  /**
+   * \param timeMs The absolute time in milliseconds
+   * \return The slot of the ring buffer associated to the subframe
+   */
+  uint32_t GetSlot (int64_t timeMs) const
+  {
+    return timeMs % m_length;
+  }
+
+  /// \return The number of subchannels
+  uint32_t GetNSubChannels () const
+  {
+    return m_nSubChannels;
+  }
+
+  /// \return The length of the window in subframes
+  uint32_t GetLength () const
+  {
+    return m_length;
+  }
+
+  /// \return The S-RSSI (dBm) stored for the given subchannel and slot
+  double GetRssi (uint32_t subChannel, uint32_t slot) const
+  {
+    return Dequantize (m_rssi[subChannel * m_length + slot]);
+  }
+
+  /// \return The PSSCH-RSRP (dBm) stored for the given subchannel and slot
+  double GetRsrp (uint32_t subChannel, uint32_t slot) const
+  {
+    return Dequantize (m_rsrp[subChannel * m_length + slot]);
+  }
+
+  /**
+   * \param power The power in dBm
+   * \return The power in units of the 2^-20 dB grid of the samples
+   */
+  static int64_t Quantize (double power);
+
+  /**
+   * \param q The power in units of the 2^-20 dB grid of the samples
+   * \return The power in dBm
+   */
+  static double Dequantize (int64_t q)
+  {
+    return static_cast<double> (q) / 1048576.0;
+  }
+
+  /// \return True if a transmission was decoded in the given subchannel and slot
+  bool IsDecoded (uint32_t subChannel, uint32_t slot) const
+  {
+    return m_decoded[subChannel * m_length + slot];
+  }
+
+private:
+  /// The sums of the samples for an averaging period
+  struct AveragingSums
+  {
+    uint32_t period; ///< averaging period in subframes
+    std::vector<int64_t> rssiSum; ///< S-RSSI sums indexed by subchannel * period + phase
+    std::vector<int64_t> rsrpSum; ///< PSSCH-RSRP sums indexed by subchannel * period + phase
+  };
+
+  /**
+   * \brief Mark a slot of every subchannel as empty
+   *
+   * The slot held the subframe one window before timeMs, and holds the
+   * subframe at timeMs once expired.
+   *
+   * \param timeMs The absolute time in milliseconds of the subframe expired
+   */
+  void Expire (int64_t timeMs);
+
+  /**
+   * \param slot The slot index
+   * \return The time in milliseconds of the subframe held by the slot,
+   *         within the window ending at the last subframe expired
+   */
+  int64_t GetSlotTime (uint32_t slot) const;
+
+  /**
+   * \param sums The sums of an averaging period
+   * \param timeMs The absolute time in milliseconds
+   * \return The phase of the subframe at timeMs in the period
+   */
+  static uint32_t GetPhase (const AveragingSums &sums, int64_t timeMs);
+
+  /**
+   * \brief Build the sums of an averaging period from the stored samples
+   *
+   * \param sums The sums of the averaging period
+   */
+  void BuildSums (AveragingSums &sums) const;
+
+  /**
+   * \param period The averaging period
+   * \return The sums of the period, aborting if the period was not added
+   */
+  const AveragingSums& GetSums (uint32_t period) const;
+
+  /**
+   * \param sums The S-RSSI or PSSCH-RSRP sums of an averaging period
+   * \param samples The S-RSSI or PSSCH-RSRP samples
+   * \param subChannel The subchannel index
+   * \param subframe The subframe of the resource
+   * \param period The averaging period
+   * \return The sum of the samples of the resource, see GetRssiSum
+   */
+  int64_t GetResourceSum (const std::vector<int64_t> &sums, const std::vector<int32_t> &samples,
+                          uint32_t subChannel, uint32_t subframe, uint32_t period) const;
+
+  uint32_t m_nSubChannels; ///< number of subchannels
+  uint32_t m_length; ///< window length in subframes
+  std::vector<int32_t> m_rssi; ///< S-RSSI samples (2^-20 dB)
+  std::vector<int32_t> m_rsrp; ///< PSSCH-RSRP samples (2^-20 dB)
+  std::vector<bool> m_decoded; ///< decoding flags
+  int64_t m_expiredUntilMs; ///< time (ms) of the last subframe expired by ExpireUntil
+  std::vector<AveragingSums> m_sums; ///< sums of the samples per averaging period
+};
+
+} // namespace ns3
+
+#endif /* LTE_SL_SENSING_WINDOW_H */
@@ -0,0 +1,67 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lte-sl-sps-reservation.h"
+#include <ns3/log.h>
+#include <ns3/assert.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LteSlSpsReservation");
+
+LteSlSpsReservation::LteSlSpsReservation ()
+  : m_offset (0),
+    m_subChannel (0),
+    m_counter (0)
+{
+}
+
+void
+LteSlSpsReservation::Reserve (uint32_t offset, uint8_t subChannel, uint32_t counter)
+{
+  NS_LOG_FUNCTION (this << offset << (uint16_t) subChannel << counter);
+  m_offset = offset;
+  m_subChannel = subChannel;
+  m_counter = counter;
+}
+
+LteSlSpsReservation::Transmission
+LteSlSpsReservation::Pop (SidelinkCommResourcePool::SubframeInfo scPeriod)
+{
+  NS_LOG_FUNCTION (this << scPeriod.frameNo << scPeriod.subframeNo);
+  NS_ASSERT_MSG (m_counter > 0, "No transmission left in the reservation");
+  m_counter--;
+  Transmission tx;
+  tx.scPeriod = scPeriod;
+  tx.subframe = GetSubframe (scPeriod, m_offset);
+  return tx;
+}
+
+SidelinkCommResourcePool::SubframeInfo
+LteSlSpsReservation::GetSubframe (SidelinkCommResourcePool::SubframeInfo scPeriod, uint32_t offset)
+{
+  SidelinkCommResourcePool::SubframeInfo subframe;
+  subframe.frameNo = scPeriod.frameNo + offset / 10;
+  subframe.subframeNo = scPeriod.subframeNo + offset % 10;
+  if (subframe.subframeNo >= 11)
+    {
+      subframe.frameNo++;
+      subframe.subframeNo -= 10;
+    }
+  return subframe;
+}
+
+} // namespace ns3
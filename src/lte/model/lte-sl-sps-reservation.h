@@ -0,0 +1,103 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_SL_SPS_RESERVATION_H
+#define LTE_SL_SPS_RESERVATION_H
+
+#include <stdint.h>
+#include <ns3/lte-sl-pool.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup lte
+ *
+ * Semi-persistent scheduling (SPS) reservation of a Mode-4 transmitter.
+ *
+ * On (re)selection the UE reserves a subframe of the SC period and a
+ * subchannel for a number of SC periods, given by the reselection
+ * counter. The reservation keeps the resource and the counter, and gives
+ * the MAC the subframe of the transmission of each SC period in which it
+ * transmits.
+ *
+ * The counter is only decremented in the SC periods in which the UE
+ * transmits: the SC periods without data do not consume the reservation.
+ */
+class LteSlSpsReservation
+{
+public:
+  /// A reserved transmission
+  struct Transmission
+  {
+    SidelinkCommResourcePool::SubframeInfo scPeriod; ///< Start of the SC period of the transmission
+    SidelinkCommResourcePool::SubframeInfo subframe; ///< Subframe of the transmission
+  };
+
+  LteSlSpsReservation ();
+
+  /**
+   * \brief Reserve a resource
+   *
+   * Replaces the transmissions left, if any.
+   *
+   * \param offset The subframe of the resource, relative to the start of the SC period
+   * \param subChannel The subchannel of the resource
+   * \param counter The number of transmissions, i.e. the reselection counter
+   */
+  void Reserve (uint32_t offset, uint8_t subChannel, uint32_t counter);
+
+  /**
+   * \brief Take the transmission of an SC period
+   *
+   * \param scPeriod The start of the current SC period
+   * \return The transmission of the SC period, which decrements the reselection counter
+   */
+  Transmission Pop (SidelinkCommResourcePool::SubframeInfo scPeriod);
+
+  /// \return The number of transmissions left, i.e. the reselection counter
+  uint32_t GetCounter () const
+  {
+    return m_counter;
+  }
+
+  /// \return The subframe of the resource, relative to the start of the SC period
+  uint32_t GetOffset () const
+  {
+    return m_offset;
+  }
+
+  /// \return The subchannel of the resource
+  uint8_t GetSubChannel () const
+  {
+    return m_subChannel;
+  }
+
+  /**
+   * \param scPeriod The start of an SC period
+   * \param offset A subframe offset relative to the start of the SC period
+   * \return The subframe at the offset
+   */
+  static SidelinkCommResourcePool::SubframeInfo GetSubframe (SidelinkCommResourcePool::SubframeInfo scPeriod, uint32_t offset);
+
+private:
+  uint32_t m_offset; ///< reserved subframe relative to the start of the SC period
+  uint8_t m_subChannel; ///< reserved subchannel
+  uint32_t m_counter; ///< transmissions left
+};
+
+} // namespace ns3
+
+#endif /* LTE_SL_SPS_RESERVATION_H */
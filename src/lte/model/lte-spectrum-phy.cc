@@ -39,6 +39,7 @@
 #include <ns3/lte-radio-bearer-tag.h>
 #include <ns3/boolean.h>
 #include <ns3/double.h>
+#include <ns3/uinteger.h>
 #include <ns3/config.h>
 #include <ns3/node.h>
 #include "ns3/enum.h"
@@ -91,6 +92,56 @@ static const double EffectiveCodingRate[29] = {
   0.92
 };
 
+/**
+ * \param psd The PSD of a Sidelink signal
+ * \return The RBs on which the PSD is not zero
+ */
+static SlRbBitmap_t
+GetRbBitmap (const SpectrumValue& psd)
+{
+  NS_ABORT_MSG_IF (psd.GetSpectrumModel ()->GetNumBands () > SlRbBitmap_t ().size (), "Too many RBs for the Sidelink RB bitmap");
+  SlRbBitmap_t rbBitmap;
+  int i = 0;
+  for (Values::const_iterator it = psd.ConstValuesBegin (); it != psd.ConstValuesEnd (); it++, i++)
+    {
+      if (*it != 0)
+        {
+          rbBitmap.set (i);
+        }
+    }
+  return rbBitmap;
+}
+
+/**
+ * \param map The indexes of the RBs
+ * \return The RB bitmap with these RBs set
+ */
+static SlRbBitmap_t
+GetRbBitmap (const std::vector<int>& map)
+{
+  SlRbBitmap_t rbBitmap;
+  for (std::vector<int>::const_iterator it = map.begin (); it != map.end (); it++)
+    {
+      rbBitmap.set (*it);
+    }
+  return rbBitmap;
+}
+
+/**
+ * \param rbBitmap An RB bitmap
+ * \return The index of the first RB set, or the size of the bitmap if none
+ */
+static uint32_t
+GetFirstRb (const SlRbBitmap_t& rbBitmap)
+{
+  uint32_t i = 0;
+  while (i < rbBitmap.size () && !rbBitmap.test (i))
+    {
+      i++;
+    }
+  return i;
+}
+
 
 
   
@@ -276,11 +327,6 @@ LteSpectrumPhy::LteSpectrumPhy ()
     }
   
   m_slRxRbStartIdx = 0;
-  for (uint32_t i = 0; i < 1000; i++)
-    {
-      m_msgLastReception.push_back(0);
-      m_consecutiveMiss.push_back(0);
-    }
   isTx = false;
   m_nextTxTime = 0;
   m_enableFullDuplex = false;
@@ -431,6 +477,16 @@ LteSpectrumPhy::GetTypeId (void)
                    PointerValue (),
                    MakePointerAccessor (&LteSpectrumPhy::m_halfDuplexPhy),
                    MakePointerChecker <LteSpectrumPhy> ())
+    .AddAttribute ("SensingWindowLength",
+                   "Length in subframes of the Mode-4 sensing window.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&LteSpectrumPhy::m_sensingWindowLength),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("SlBandwidth",
+                   "Sidelink bandwidth in RBs, used to derive the number of subchannels of the sensing window.",
+                   UintegerValue (50),
+                   MakeUintegerAccessor (&LteSpectrumPhy::m_slBandwidth),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("CtrlFullDuplexEnabled",
                    "Activate/Deactivate the full duplex in the PSCCH [by default is disable].",
                    BooleanValue (false),
@@ -478,13 +534,6 @@ LteSpectrumPhy::SetDevice (Ptr<NetDevice> d)
   m_device = d;
 }
 
-void
-LteSpectrumPhy::SetNodeList (NodeContainer c)
-{
-  NS_LOG_FUNCTION (this);
-  m_nodeList = c;
-}
-
 void
 LteSpectrumPhy::SetMobility (Ptr<MobilityModel> m)
 {
@@ -524,51 +573,8 @@ void
 LteSpectrumPhy::InitRssiRsrpMap ()
 {
   NS_LOG_FUNCTION (this);
-  uint32_t nSubChannel = std::ceil(50 / m_RbPerSubChannel);
-
-  NS_ASSERT (m_rssiMap.size()==0);
-  for (uint32_t subChannel = 0; subChannel < nSubChannel; subChannel++)
-    {
-      std::vector<double> temp;
-      m_rssiMap.push_back(temp);
-      for (int subFrame = 0; subFrame < 1000; subFrame++)
-        {
-          m_rssiMap[subChannel].push_back(-1000.0);
-        }
-    }
-
-  NS_ASSERT (m_rsrpMap.size()==0);
-  for (uint32_t subChannel = 0; subChannel < nSubChannel; subChannel++)
-    {
-      std::vector<double> temp;
-      m_rsrpMap.push_back(temp);
-      for (int subFrame = 0; subFrame < 1000; subFrame++)
-        {
-          m_rsrpMap[subChannel].push_back(-1000.0);
-        }
-    }
-
-  NS_ASSERT (m_decodingMap.size()==0);
-  for (uint32_t subChannel = 0; subChannel < nSubChannel; subChannel++)
-    {
-      std::vector<bool> temp;
-      m_decodingMap.push_back(temp);
-      for (int subFrame = 0; subFrame < 1000; subFrame++)
-        {
-          m_decodingMap[subChannel].push_back(false);
-        }
-    }
-  
-  /*NS_ASSERT (m_feedbackMap.size()==0);
-  for (uint32_t subChannel = 0; subChannel < nSubChannel; subChannel++)
-    {
-      std::vector<uint32_t> temp;
-      m_feedbackMap.push_back(temp);
-      for (int subFrame = 0; subFrame < 1000; subFrame++)
-        {
-          m_feedbackMap[subChannel].push_back(0);
-        }
-    }*/
+  NS_ASSERT (m_sensingWindow.GetLength () == 0);
+  m_sensingWindow.Resize (m_slBandwidth / m_RbPerSubChannel, m_sensingWindowLength);
 }
 
 Ptr<SpectrumChannel> 
@@ -866,10 +872,19 @@ LteSpectrumPhy::StartTxSlDataFrame (Ptr<PacketBurst> pb, std::list<Ptr<LteContro
       txParams->txAntenna = m_antenna;
       txParams->psd = m_txPsd;
       txParams->nodeId = GetDevice()->GetNode()->GetId();
+      if (m_mobility)
+        {
+          txParams->txPosition = m_mobility->GetPosition ();
+        }
       txParams->groupId = groupId;
       txParams->slssId = m_slssId;
-      txParams->packetBurst = pb;
-      txParams->ctrlMsgList = ctrlMsgList;
+      // the receivers share the payload, which is no longer modified
+      Ptr<LteSlSignalPayload> payload = Create<LteSlSignalPayload> ();
+      payload->packetBurst = pb;
+      payload->ctrlMsgList = ctrlMsgList;
+      txParams->payload = payload;
+      // computed once here instead of by each receiver
+      txParams->rbBitmap = GetRbBitmap (*m_txPsd);
       m_ulDataSlCheck = true;
 
       //NS_LOG_DEBUG("StartTx on Spectrum Channel");
@@ -1073,7 +1088,7 @@ LteSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> spectrumRxParams)
       m_interferenceSl->AddSignal (rxPsd, duration);
       m_interferenceData->AddSignal (rxPsd, duration); //to compute UL/SL interference
       m_slStartRx (m_halfDuplexPhy);
-      if (m_ctrlFullDuplexEnabled && lteSlRxParams->ctrlMsgList.size () > 0)
+      if (m_ctrlFullDuplexEnabled && lteSlRxParams->payload->ctrlMsgList.size () > 0)
         {
           StartRxSlData (lteSlRxParams);
         }
@@ -1206,10 +1221,12 @@ LteSpectrumPhy::StartRxSlData (Ptr<LteSpectrumSignalParametersSlFrame> params)
 
               //SLSSs (PSBCH) should be received by all UEs
               //Checking if it is a SLSS, and if it is: measure S-RSRP and receive MIB-SL
-              if (params->ctrlMsgList.size () >0)
+              const std::list<Ptr<LteControlMessage> >& ctrlMsgList = params->payload->ctrlMsgList;
+              std::list<Ptr<LteControlMessage> >::const_iterator mibIt = ctrlMsgList.end ();
+              if (ctrlMsgList.size () >0)
                 {
-                  std::list<Ptr<LteControlMessage> >::iterator ctrlIt;
-                  for (ctrlIt=params->ctrlMsgList.begin() ; ctrlIt != params->ctrlMsgList.end(); ctrlIt++)
+                  std::list<Ptr<LteControlMessage> >::const_iterator ctrlIt;
+                  for (ctrlIt=ctrlMsgList.begin() ; ctrlIt != ctrlMsgList.end(); ctrlIt++)
                     {
                       //Detection of a SLSS and callback for measurement of S-RSRP
                       if ((*ctrlIt)->GetMessageType () == LteControlMessage::MIB_SL)
@@ -1246,23 +1263,18 @@ LteSpectrumPhy::StartRxSlData (Ptr<LteSpectrumSignalParametersSlFrame> params)
                           ChangeState (RX_DATA);
                           m_interferenceSl->StartRx (params->psd);
                           SlRxPacketInfo_t packetInfo;
-                          packetInfo.m_rxPacketBurst = params->packetBurst;
+                          packetInfo.m_rxPacketBurst = params->payload->packetBurst;
                           packetInfo.m_rxControlMessage = *ctrlIt;
-                          //convert the PSD to RB map so we know which RBs were used to transmit the control message
+                          packetInfo.m_txNodeId = params->nodeId;
+                          packetInfo.m_txPosition = params->txPosition;
+                          //the RBs used to transmit the control message
                           //will be used later to compute error rate
-                          std::vector <int> rbMap;
-                          int i = 0;
-                          for (Values::const_iterator it=params->psd->ConstValuesBegin (); it != params->psd->ConstValuesEnd () ; it++, i++)
-                            {
-                              if (*it != 0)
-                                {
-                                  NS_LOG_INFO ("SL MIB-SL arriving on RB " << i);
-                                  rbMap.push_back (i);
-                                }
-                            }
-                          packetInfo.rbBitmap = rbMap;
+                          packetInfo.rbBitmap = params->rbBitmap;
+                          NS_LOG_INFO ("SL MIB-SL arriving on " << packetInfo.rbBitmap.count () << " RBs");
                           m_rxPacketInfo.push_back (packetInfo);
-                          params->ctrlMsgList.erase(ctrlIt);
+                          // the payload is shared with the other receivers: skip
+                          // the MIB-SL below instead of removing it
+                          mibIt = ctrlIt;
                           break;
                         }
                     }
@@ -1296,39 +1308,35 @@ LteSpectrumPhy::StartRxSlData (Ptr<LteSpectrumSignalParametersSlFrame> params)
                   ChangeState (RX_DATA);
                   m_interferenceSl->StartRx (params->psd);
                   SlRxPacketInfo_t packetInfo;
-                  packetInfo.m_rxPacketBurst = params->packetBurst;
-                  if (params->ctrlMsgList.size () >0)
+                  packetInfo.m_rxPacketBurst = params->payload->packetBurst;
+                  packetInfo.m_txNodeId = params->nodeId;
+                  packetInfo.m_txPosition = params->txPosition;
+                  uint32_t nCtrlMsgs = ctrlMsgList.size () - (mibIt != ctrlMsgList.end () ? 1 : 0);
+                  if (nCtrlMsgs >0)
                     {
-                      NS_ASSERT (params->ctrlMsgList.size () == 1);
-                      packetInfo.m_rxControlMessage = *(params->ctrlMsgList.begin());
+                      NS_ASSERT (nCtrlMsgs == 1);
+                      std::list<Ptr<LteControlMessage> >::const_iterator ctrlIt = ctrlMsgList.begin ();
+                      if (ctrlIt == mibIt)
+                        {
+                          ctrlIt++;
+                        }
+                      packetInfo.m_rxControlMessage = *ctrlIt;
                     }
-                  //convert the PSD to RB map so we know which RBs were used to transmit the control message
+                  //the RBs used to transmit the control message
                   //will be used later to compute error rate
-                  std::vector <int> rbMap;
-                  int i = 0;
-                  int used_rb_cnt = 0;
-                  for (Values::const_iterator it=params->psd->ConstValuesBegin (); it != params->psd->ConstValuesEnd () ; it++, i++)
+                  packetInfo.rbBitmap = params->rbBitmap;
+                  if (packetInfo.rbBitmap.any ())
                     {
-                      if (*it != 0)
-                        {
-                          if (used_rb_cnt == 0)
-                            {
-                              m_slRxRbStartIdx = i;
-                            }
-                          NS_LOG_INFO ("SL Message arriving on RB " << i);
-                          rbMap.push_back (i);
-                          used_rb_cnt++;
-                        }
+                      m_slRxRbStartIdx = GetFirstRb (packetInfo.rbBitmap);
                     }
-                  NS_LOG_INFO ("SL Message arriving on "<<used_rb_cnt<<" RBs");
-                  packetInfo.rbBitmap = rbMap;
+                  NS_LOG_INFO ("SL Message arriving on "<< packetInfo.rbBitmap.count () <<" RBs");
                   m_rxPacketInfo.push_back (packetInfo);
-                  if (params->packetBurst)
+                  if (params->payload->packetBurst)
                     {
-                      m_phyRxStartTrace (params->packetBurst);
-                      NS_LOG_INFO ("RX Burst containing " << params->packetBurst->GetNPackets() << " packets");
+                      m_phyRxStartTrace (params->payload->packetBurst);
+                      NS_LOG_INFO ("RX Burst containing " << params->payload->packetBurst->GetNPackets() << " packets");
                     }
-                  NS_LOG_INFO ("Insert Sidelink ctrl msgs " << params->ctrlMsgList.size ());
+                  NS_LOG_INFO ("Insert Sidelink ctrl msgs " << nCtrlMsgs);
                   NS_LOG_LOGIC ("numSimultaneousRxEvents = " << m_rxPacketInfo.size ());
                 }
               else
@@ -1577,7 +1585,7 @@ LteSpectrumPhy::AddExpectedTb (uint16_t  rnti, uint8_t l1dst, uint8_t ndi, uint1
       m_expectedSlTbs.erase (it);
     }
   // insert new entry
-  SltbInfo_t tbInfo = {ndi, size, mcs, map, rv, 0.0, false, false};
+  SltbInfo_t tbInfo = {ndi, size, mcs, GetRbBitmap (map), rv, 0.0, false, false};
   m_expectedSlTbs.insert (std::pair<SlTbId_t, SltbInfo_t> (tbId,tbInfo));
 
   // if it is for new data, reset the HARQ process
@@ -1605,7 +1613,7 @@ LteSpectrumPhy::AddExpectedTb (uint16_t  rnti, uint8_t resPsdch, uint8_t ndi, st
       m_expectedDiscTbs.erase (it);
     }
   // insert new entry
-  SlDisctbInfo_t tbInfo = {ndi, resPsdch, map, rv, 0.0, false, false};
+  SlDisctbInfo_t tbInfo = {ndi, resPsdch, GetRbBitmap (map), rv, 0.0, false, false};
 
   m_expectedDiscTbs.insert (std::pair<SlDiscTbId_t, SlDisctbInfo_t> (tbId,tbInfo));
 
@@ -1865,26 +1873,14 @@ LteSpectrumPhy::EndRxSlData ()
         }
     }
 
-  std::set<int> collidedRbBitmap;
+  SlRbBitmap_t collidedRbBitmap;
   if (m_dropRbOnCollisionEnabled)
     {
       NS_LOG_DEBUG (this << " PSSCH DropOnCollisionEnabled: Identifying RB Collisions");
-      std::set<int> collidedRbBitmapTemp;
+      SlRbBitmap_t collidedRbBitmapTemp;
       for (expectedSlTbs_t::iterator itTb = m_expectedSlTbs.begin (); itTb != m_expectedSlTbs.end (); itTb++ )
         {
-          for (std::vector<int>::iterator rbIt =  (*itTb).second.rbBitmap.begin (); rbIt != (*itTb).second.rbBitmap.end (); rbIt++)
-            {
-              if (collidedRbBitmapTemp.find (*rbIt) != collidedRbBitmapTemp.end ())
-                {
-                  //collision, update the bitmap
-                  collidedRbBitmap.insert (*rbIt);
-                }
-              else
-                {
-                  //store resources used by the packet to detect collision
-                  collidedRbBitmapTemp.insert (*rbIt);
-                }
-            }
+          UpdateSlCollidedRbs ((*itTb).second.rbBitmap, collidedRbBitmapTemp, collidedRbBitmap);
         }
 
     }
@@ -1915,16 +1911,12 @@ LteSpectrumPhy::EndRxSlData ()
               if (m_dropRbOnCollisionEnabled)
                 {
                   NS_LOG_DEBUG (this << " PSSCH DropOnCollisionEnabled: Labeling Corrupted TB");
-                  //Check if any of the RBs have been decoded
-                  for (std::vector<int>::iterator rbIt =  (*itTb).second.rbBitmap.begin (); rbIt != (*itTb).second.rbBitmap.end (); rbIt++)
+                  //Check if any of the RBs have collided
+                  if (((*itTb).second.rbBitmap & collidedRbBitmap).any ())
                     {
-                      if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                        {
-                          NS_LOG_DEBUG (*rbIt << " collided, labeled as corrupted!");
-                          rbCollided = true;
-                          (*itTb).second.corrupt = true;
-                          break;
-                        }
+                      NS_LOG_DEBUG ("RB collided, labeled as corrupted!");
+                      rbCollided = true;
+                      (*itTb).second.corrupt = true;
                     }
                 }
               TbErrorStats_t tbStats = LteNistErrorModel::GetPsschBler (m_fadingModel,LteNistErrorModel::SISO, (*itTb).second.mcs, GetMeanSinr (m_slSinrPerceived[(*itSinr).second] * m_slRxGain, (*itTb).second.rbBitmap),  harqInfoList);
@@ -1943,7 +1935,7 @@ LteSpectrumPhy::EndRxSlData ()
                 }
 
               NS_LOG_DEBUG ("From RNTI " << (*itTb).first.m_rnti << " TB size " << (*itTb).second.size << " MCS " << (uint32_t)(*itTb).second.mcs);
-              NS_LOG_DEBUG ("RB bitmap size " << (*itTb).second.rbBitmap.size () << " TBLER " << tbStats.tbler
+              NS_LOG_DEBUG ("RB bitmap size " << (*itTb).second.rbBitmap.count () << " TBLER " << tbStats.tbler
                                               << " corrupted " << (*itTb).second.corrupt << " prevDecoded"
                                               << m_slHarqPhyModule->IsPrevDecoded ((*itTb).first.m_rnti, (*itTb).first.m_l1dst));
 
@@ -1953,16 +1945,12 @@ LteSpectrumPhy::EndRxSlData ()
               if (m_dropRbOnCollisionEnabled)
                 {
                   NS_LOG_DEBUG (this << " PSSCH DropOnCollisionEnabled: Labeling Corrupted TB");
-                  //Check if any of the RBs have been decoded
-                  for (std::vector<int>::iterator rbIt =  (*itTb).second.rbBitmap.begin (); rbIt != (*itTb).second.rbBitmap.end (); rbIt++)
+                  //Check if any of the RBs have collided
+                  if (((*itTb).second.rbBitmap & collidedRbBitmap).any ())
                     {
-                      if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                        {
-                          NS_LOG_DEBUG (*rbIt << " collided, labeled as corrupted!");
-                          rbCollided = true;
-                          (*itTb).second.corrupt = true;
-                          break;
-                        }
+                      NS_LOG_DEBUG ("RB collided, labeled as corrupted!");
+                      rbCollided = true;
+                      (*itTb).second.corrupt = true;
                     }
                 }
 
@@ -2022,7 +2010,9 @@ LteSpectrumPhy::EndRxSlData ()
 
                       if (!m_ltePhyRxDataEndOkCallback.IsNull ())
                         {
-                          m_ltePhyRxDataEndOkCallback (*j);
+                          // the upper layers remove headers and tags: the
+                          // packet of the shared payload is copied on delivery
+                          m_ltePhyRxDataEndOkCallback ((*j)->Copy ());
                         }
                     }
                   else
@@ -2052,9 +2042,9 @@ LteSpectrumPhy::EndRxSlData ()
   bool ctrlMessageFound = false;
   std::multiset<SlCtrlPacketInfo_t> sortedControlMessages;
   //container to store the RB indices of the collided TBs
-  collidedRbBitmap.clear ();
+  collidedRbBitmap.reset ();
   //container to store the RB indices of the decoded TBs
-  std::set<int> rbDecodedBitmap;
+  SlRbBitmap_t rbDecodedBitmap;
 
   for (uint32_t i = 0; i < m_rxPacketInfo.size (); i++)
     {
@@ -2075,25 +2065,12 @@ LteSpectrumPhy::EndRxSlData ()
     {
       NS_LOG_DEBUG (this << "Ctrl DropOnCollisionEnabled");
       //Add new loop to make one pass and identify which RB have collisions
-      std::set<int> collidedRbBitmapTemp;
+      SlRbBitmap_t collidedRbBitmapTemp;
 
       for (std::multiset<SlCtrlPacketInfo_t>::iterator it = sortedControlMessages.begin (); it != sortedControlMessages.end (); it++ )
         {
           int i = (*it).index;
-          for (std::vector<int>::iterator rbIt =  m_rxPacketInfo[i].rbBitmap.begin (); rbIt != m_rxPacketInfo[i].rbBitmap.end (); rbIt++)
-            {
-              if (collidedRbBitmapTemp.find (*rbIt) != collidedRbBitmapTemp.end ())
-                {
-                  //collision, update the bitmap
-                  collidedRbBitmap.insert (*rbIt);
-                  break;
-                }
-              else
-                {
-                  //store resources used by the packet to detect collision
-                  collidedRbBitmapTemp.insert ((*rbIt));
-                }
-            }
+          UpdateSlCtrlCollidedRbs (m_rxPacketInfo[i].rbBitmap, collidedRbBitmapTemp, collidedRbBitmap);
         }
     }
 
@@ -2112,28 +2089,25 @@ LteSpectrumPhy::EndRxSlData ()
       NS_LOG_DEBUG("meanSinr = " << (*it).sinr);
       if (m_slCtrlErrorModelEnabled)
         {
-          for (std::vector<int>::iterator rbIt =  m_rxPacketInfo[i].rbBitmap.begin ();  rbIt != m_rxPacketInfo[i].rbBitmap.end (); rbIt++)
+          //if m_dropRbOnCollisionEnabled == false, collidedRbBitmap will remain empty
+          //and we move to the second "if" to check if the TB with similar RBs has already
+          //been decoded. If m_dropRbOnCollisionEnabled == true, all the collided TBs
+          //are marked corrupt in the first "if" condition. The first RB of the TB
+          //that has either collided or been decoded decides
+          SlCtrlRbStatus_t rbStatus = GetSlCtrlRbStatus (m_rxPacketInfo[i].rbBitmap, collidedRbBitmap, rbDecodedBitmap);
+          if (rbStatus == SL_CTRL_RB_COLLIDED)
             {
-              //if m_dropRbOnCollisionEnabled == false, collidedRbBitmap will remain empty
-              //and we move to the second "if" to check if the TB with similar RBs has already
-              //been decoded. If m_dropRbOnCollisionEnabled == true, all the collided TBs
-              //are marked corrupt and this for loop will break in the first "if" condition
-              if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                {
-                  corrupt = true;
-                  NS_LOG_DEBUG (this << " RB " << *rbIt << " has collided");
-                  break;
-                }
-              if (rbDecodedBitmap.find (*rbIt) != rbDecodedBitmap.end ())
-                {
-                  NS_LOG_INFO (*rbIt << " TB with the similar RB has already been decoded. Avoid to decode it again!");
-                  corrupt = true;
-                  secondOverlap = true;
-                  first = false;
-                  conflict = true;
-                  break;
-                }
-             }
+              corrupt = true;
+              NS_LOG_DEBUG (this << " RB has collided");
+            }
+          else if (rbStatus == SL_CTRL_RB_DECODED)
+            {
+              NS_LOG_INFO ("TB with the similar RB has already been decoded. Avoid to decode it again!");
+              corrupt = true;
+              secondOverlap = true;
+              first = false;
+              conflict = true;
+            }
           //NS_LOG_DEBUG("begin RB= " << m_rxPacketInfo[i].rbBitmap[0] << ", end RB= " << m_rxPacketInfo[i].rbBitmap[m_rxPacketInfo[i].rbBitmap.size()-1]);
           if (!corrupt)
             {
@@ -2180,14 +2154,10 @@ LteSpectrumPhy::EndRxSlData ()
           //On the other hand, if m_dropRbOnCollisionEnabled == false, all the TBs are considered as not corrupted.
           if (m_dropRbOnCollisionEnabled)
             {
-              for (std::vector<int>::iterator rbIt =  m_rxPacketInfo[i].rbBitmap.begin ();  rbIt != m_rxPacketInfo[i].rbBitmap.end (); rbIt++)
+              if ((m_rxPacketInfo[i].rbBitmap & collidedRbBitmap).any ())
                 {
-                  if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                    {
-                      corrupt = true;
-                      NS_LOG_DEBUG (this << " RB " << *rbIt << " has collided");
-                      break;
-                    }
+                  corrupt = true;
+                  NS_LOG_DEBUG (this << " RB " << GetFirstRb (m_rxPacketInfo[i].rbBitmap & collidedRbBitmap) << " has collided");
                 }
             }
         }
@@ -2202,7 +2172,7 @@ LteSpectrumPhy::EndRxSlData ()
           m_isDecoded = true;
           rxControlMessageOkList.push_back (m_rxPacketInfo[i].m_rxControlMessage);
           //Store the indices of the decoded RBs
-          rbDecodedBitmap.insert ( m_rxPacketInfo[i].rbBitmap.begin (), m_rxPacketInfo[i].rbBitmap.end ());
+          rbDecodedBitmap |= m_rxPacketInfo[i].rbBitmap;
         }
 
       if (m_rxPacketInfo[i].m_rxControlMessage->GetMessageType () == LteControlMessage::SCI)
@@ -2245,8 +2215,8 @@ LteSpectrumPhy::EndRxSlData ()
           params.m_TJAlgo = m_TJAlgo;
           params.m_rxPosX = m_mobility->GetPosition ().x;
           params.m_rxPosY = m_mobility->GetPosition ().y;
-          params.m_txPosX = m_nodeList.Get(params.m_rnti-1) -> GetObject<MobilityModel> () -> GetPosition ().x;
-          params.m_txPosY = m_nodeList.Get(params.m_rnti-1) -> GetObject<MobilityModel> () -> GetPosition ().y;
+          params.m_txPosX = m_rxPacketInfo[i].m_txPosition.x;
+          params.m_txPosY = m_rxPacketInfo[i].m_txPosition.y;
           //NS_LOG_DEBUG("Receive Time = " << params.m_timestamp << ", from TxId = " << params.m_rnti + 3);
 
           double deltaX = params.m_rxPosX - params.m_txPosX;
@@ -2305,38 +2275,41 @@ LteSpectrumPhy::EndRxSlData ()
 
           params.m_rxType = notReceptType;
 
+          // the neighbors are identified by their node, the RNTIs of out
+          // of coverage UEs need not be unique nor start at 1
+          uint32_t txNodeId = m_rxPacketInfo[i].m_txNodeId;
           if (distRxTx < 150.0)
             {
               params.m_neighbor = 1;
-              params.m_consecutiveMiss = m_consecutiveMiss[params.m_rnti-1];
-              params.m_msgInterval = params.m_timestamp - m_msgLastReception[params.m_rnti-1];
+              params.m_consecutiveMiss = m_consecutiveMiss[txNodeId];
+              params.m_msgInterval = params.m_timestamp - m_msgLastReception[txNodeId];
 
-              if (m_msgLastReception[params.m_rnti-1] == 0)
+              if (m_msgLastReception[txNodeId] == 0)
                 {
                   params.m_msgInterval = 0;
                 }
               if (params.m_correctness)
                 {
-                  m_consecutiveMiss[params.m_rnti-1] = 0;
-                  m_msgLastReception[params.m_rnti-1] = params.m_timestamp;;
-                  //NS_LOG_DEBUG("[In 150m] TxID = " << params.m_rnti + 3 << ", m_msgLastReception[params.m_rnti-1] = " << m_msgLastReception[params.m_rnti-1]);
+                  m_consecutiveMiss[txNodeId] = 0;
+                  m_msgLastReception[txNodeId] = params.m_timestamp;;
+                  //NS_LOG_DEBUG("[In 150m] TxID = " << params.m_rnti + 3 << ", m_msgLastReception[txNodeId] = " << m_msgLastReception[txNodeId]);
                 }
               else
                 {
-                  m_consecutiveMiss[params.m_rnti-1]++;
-                  //m_msgLastReception[params.m_rnti-1]++;
+                  m_consecutiveMiss[txNodeId]++;
+                  //m_msgLastReception[txNodeId]++;
                 }
-              /*if (m_msgLastReception[params.m_rnti-1] == 0)
+              /*if (m_msgLastReception[txNodeId] == 0)
                 {
                   params.m_msgInterval = 0;
-                  m_msgLastReception[params.m_rnti-1] = params.m_timestamp;
+                  m_msgLastReception[txNodeId] = params.m_timestamp;
                 }
               else
                 {
-                  params.m_msgInterval = params.m_timestamp - m_msgLastReception[params.m_rnti-1];
+                  params.m_msgInterval = params.m_timestamp - m_msgLastReception[txNodeId];
                   if (params.m_correctness)
                     {
-                      m_msgLastReception[params.m_rnti-1] = params.m_timestamp;
+                      m_msgLastReception[txNodeId] = params.m_timestamp;
                     }
                 }*/
               
@@ -2348,15 +2321,15 @@ LteSpectrumPhy::EndRxSlData ()
                 }
               else
                 {
-                  m_msgLastReception[params.m_rnti-1] = 0;
-                  m_consecutiveMiss[params.m_rnti-1] = 0;
+                  m_msgLastReception.erase (txNodeId);
+                  m_consecutiveMiss.erase (txNodeId);
                 }
             }
           else
             {
-              m_msgLastReception[params.m_rnti-1] = 0;
-              //NS_LOG_DEBUG("[Out 150m] TxID = " << params.m_rnti + 3 << ", m_msgLastReception[params.m_rnti-1] = " << m_msgLastReception[params.m_rnti-1]);
-              m_consecutiveMiss[params.m_rnti-1] = 0;
+              m_msgLastReception.erase (txNodeId);
+              //NS_LOG_DEBUG("[Out 150m] TxID = " << params.m_rnti + 3 << ", m_msgLastReception[txNodeId] = " << m_msgLastReception[txNodeId]);
+              m_consecutiveMiss.erase (txNodeId);
               params.m_neighbor = 0;
             }
                   
@@ -2584,6 +2557,45 @@ LteSpectrumPhy::SetTxModeGain (uint8_t txMode, double gain)
   }
 }
 
+void
+LteSpectrumPhy::UpdateSlCollidedRbs (const SlRbBitmap_t& rbBitmap, SlRbBitmap_t& usedRbBitmap, SlRbBitmap_t& collidedRbBitmap)
+{
+  //collision, update the bitmap
+  collidedRbBitmap |= usedRbBitmap & rbBitmap;
+  //store resources used by the packet to detect collision
+  usedRbBitmap |= rbBitmap;
+}
+
+void
+LteSpectrumPhy::UpdateSlCtrlCollidedRbs (const SlRbBitmap_t& rbBitmap, SlRbBitmap_t& usedRbBitmap, SlRbBitmap_t& collidedRbBitmap)
+{
+  SlRbBitmap_t overlap = usedRbBitmap & rbBitmap;
+  if (overlap.any ())
+    {
+      //collision, update the bitmap with the first collided RB and
+      //store the resources of the packet up to that RB
+      uint32_t rb = GetFirstRb (overlap);
+      collidedRbBitmap.set (rb);
+      usedRbBitmap |= rbBitmap & (~SlRbBitmap_t () >> (overlap.size () - rb));
+    }
+  else
+    {
+      //store resources used by the packet to detect collision
+      usedRbBitmap |= rbBitmap;
+    }
+}
+
+LteSpectrumPhy::SlCtrlRbStatus_t
+LteSpectrumPhy::GetSlCtrlRbStatus (const SlRbBitmap_t& rbBitmap, const SlRbBitmap_t& collidedRbBitmap, const SlRbBitmap_t& rbDecodedBitmap)
+{
+  SlRbBitmap_t used = rbBitmap & (collidedRbBitmap | rbDecodedBitmap);
+  if (used.none ())
+    {
+      return SL_CTRL_RB_FREE;
+    }
+  return collidedRbBitmap.test (GetFirstRb (used)) ? SL_CTRL_RB_COLLIDED : SL_CTRL_RB_DECODED;
+}
+
 std::vector<uint32_t>
 LteSpectrumPhy::GetFeedbackProvidedResources(uint32_t subChannel, uint32_t subFrame, uint32_t nFeedback, uint32_t totalRU)
 {
@@ -2598,45 +2610,19 @@ LteSpectrumPhy::GetFeedbackProvidedResources(uint32_t subChannel, uint32_t subFr
   return feedback_RUs;
 }
 
-std::vector<std::vector<bool>>
-LteSpectrumPhy::GetDecodingMap()
-{
-  NS_LOG_FUNCTION (this);
-  return m_decodingMap;
-}
-
-std::vector<std::vector<double>>
-LteSpectrumPhy::GetRssiMap ()
+const LteSlSensingWindow&
+LteSpectrumPhy::GetSensingWindow () const
 {
   NS_LOG_FUNCTION (this);
-  return m_rssiMap;
-}
-
-std::vector<std::vector<double>>
-LteSpectrumPhy::GetRsrpMap ()
-{
-  NS_LOG_FUNCTION (this);
-  return m_rsrpMap;
+  return m_sensingWindow;
 }
 
 void
-LteSpectrumPhy::MoveSensingWindow(uint32_t sIdx, uint32_t scPeriod)
+LteSpectrumPhy::MoveSensingWindow (int64_t timeMs, uint32_t scPeriod)
 {
-  NS_LOG_FUNCTION (this);
-  uint32_t nSubChannel = std::ceil(50 / m_RbPerSubChannel);
-
-  for (uint32_t idx_sc = 0; idx_sc < nSubChannel; idx_sc++)
-  {
-    /*for (uint32_t idx_sf = sIdx; idx_sf < sIdx + scPeriod; idx_sf++)
-      {
-        m_rssiMap[idx_sc][idx_sf%1000] = 0;
-        m_rsrpMap[idx_sc][idx_sf%1000] = 0;
-        m_decodingMap[idx_sc][idx_sf%1000] = false;
-      }*/
-    m_rssiMap[idx_sc][sIdx] = -1000;
-    m_rsrpMap[idx_sc][sIdx] = -1000;
-    m_decodingMap[idx_sc][sIdx] = false;
-  }
+  NS_LOG_FUNCTION (this << timeMs << scPeriod);
+  m_sensingWindow.AddAveragingPeriod (scPeriod);
+  m_sensingWindow.ExpireUntil (timeMs);
 }
 
 void
@@ -2657,16 +2643,7 @@ LteSpectrumPhy::UpdateRssiRsrpMap (int sigIndex)
   double rsrp_dBm = -1000.0;
   if (Simulator::Now ().GetMilliSeconds () >= 50016 && !m_50ms)
     {
-      uint32_t nSubChannel = std::ceil(50 / m_RbPerSubChannel);
-      for (uint32_t subChannel =0; subChannel < nSubChannel; subChannel++)
-        {
-          for (int subFrame = 0; subFrame < 1000; subFrame++)
-            {
-              m_rssiMap[subChannel][subFrame] = -1000;
-              m_rsrpMap[subChannel][subFrame] = -1000;
-              m_decodingMap[subChannel][subFrame] = false;
-            }
-        }
+      m_sensingWindow.Clear ();
       m_50ms = true;
     }
       
@@ -2684,23 +2661,23 @@ LteSpectrumPhy::UpdateRssiRsrpMap (int sigIndex)
     }
          
   int subChannel = std::ceil(m_slRxRbStartIdx / m_RbPerSubChannel);
-  int64_t subFrame = Simulator::Now ().GetMilliSeconds () % 1000;
+  // the MAC of an idle UE does not move the window every subframe
+  m_sensingWindow.ExpireUntil (Simulator::Now ().GetMilliSeconds ());
+  uint32_t subFrame = m_sensingWindow.GetSlot (Simulator::Now ().GetMilliSeconds ());
 
   rssi_dBm = 10 * log10 (1000 * (rssiSum / static_cast<double> (rbNum)));
-  if (rssi_dBm < -1000)
+  if (rssi_dBm < LteSlSensingWindow::EMPTY_POWER_DBM)
     {
-      rssi_dBm = -1000;
+      rssi_dBm = LteSlSensingWindow::EMPTY_POWER_DBM;
     }
-  m_rssiMap[subChannel][subFrame] = rssi_dBm;
 
   rsrp_dBm = 10 * log10 (1000 * (rsrpSum / static_cast<double> (rbNum)));
-  if (rsrp_dBm < -1000)
+  if (rsrp_dBm < LteSlSensingWindow::EMPTY_POWER_DBM)
     {
-      rsrp_dBm = -1000;
+      rsrp_dBm = LteSlSensingWindow::EMPTY_POWER_DBM;
     }
-  m_rsrpMap[subChannel][subFrame] = rsrp_dBm;
 
-  m_decodingMap[subChannel][subFrame] = m_isDecoded;
+  m_sensingWindow.Record (subChannel, subFrame, rssi_dBm, rsrp_dBm, m_isDecoded);
 }
 
 /*void
@@ -2726,6 +2703,22 @@ LteSpectrumPhy::GetMeanSinr (const SpectrumValue& sinr, const std::vector<int>&
   return sinrLin / map.size();
 }
 
+double
+LteSpectrumPhy::GetMeanSinr (const SpectrumValue& sinr, const SlRbBitmap_t& rbBitmap)
+{
+  NS_LOG_FUNCTION (this << sinr);
+  double sinrLin = 0;
+  int i = 0;
+  for (Values::const_iterator it = sinr.ConstValuesBegin (); it != sinr.ConstValuesEnd (); it++, i++)
+    {
+      if (rbBitmap.test (i))
+        {
+          sinrLin += *it;
+        }
+    }
+  return sinrLin / rbBitmap.count ();
+}
+
 LteSpectrumPhy::State
 LteSpectrumPhy::GetState ()
 {
@@ -2848,7 +2841,7 @@ LteSpectrumPhy::RxDiscovery ()
                               NS_LOG_LOGIC (this << " Checking PSDCH RB " << i);
                               rbMap.push_back (i);
                             }
-                          if (m_rxPacketInfo [i].rbBitmap == rbMap)
+                          if (m_rxPacketInfo [i].rbBitmap == GetRbBitmap (rbMap))
                             {
                               //Here, it may happen that the first transmission and the retransmission is
                               //on the identical RBs but different subframes. If this happens, this while
@@ -2908,9 +2901,9 @@ LteSpectrumPhy::RxDiscovery ()
     }
 
   //container to store the RB indices of the collided TBs
-  std::set<int> collidedRbBitmap;
+  SlRbBitmap_t collidedRbBitmap;
   //container to store the RB indices of the decoded TBs
-  std::set<int> rbDecodedBitmap;
+  SlRbBitmap_t rbDecodedBitmap;
   std::set<SlCtrlPacketInfo_t> sortedDiscMessages;
   std::map<SlDiscTbId_t, uint32_t>::iterator itSinrDisc;
 
@@ -2928,24 +2921,12 @@ LteSpectrumPhy::RxDiscovery ()
   if (m_dropRbOnCollisionEnabled)
     {
       NS_LOG_DEBUG (this << " PSDCH DropOnCollisionEnabled: Identifying RB Collisions");
-      std::set<int> collidedRbBitmapTemp;
+      SlRbBitmap_t collidedRbBitmapTemp;
       for (expectedDiscTbs_t::iterator itDiscTb = m_expectedDiscTbs.begin (); itDiscTb != m_expectedDiscTbs.end (); itDiscTb++)
         {
-          for (std::vector<int>::iterator rbIt = (*itDiscTb).second.rbBitmap.begin (); rbIt != (*itDiscTb).second.rbBitmap.end (); rbIt++)
-            {
-              if (collidedRbBitmapTemp.find (*rbIt) != collidedRbBitmapTemp.end ())
-                {
-                  //collision, update the bitmap
-                  NS_LOG_DEBUG ("Collided RB " << (*rbIt));
-                  collidedRbBitmap.insert (*rbIt);
-                }
-              else
-                {
-                  //store resources used by the packet to detect collision
-                  collidedRbBitmapTemp.insert (*rbIt);
-                }
-            }
+          UpdateSlCollidedRbs ((*itDiscTb).second.rbBitmap, collidedRbBitmapTemp, collidedRbBitmap);
         }
+      NS_LOG_DEBUG ("Collided RBs " << collidedRbBitmap);
     }
 
   std::list<Ptr<LteControlMessage> > rxDiscMessageOkList;
@@ -2978,24 +2959,17 @@ LteSpectrumPhy::RxDiscovery ()
             }
 
               //Check if any of the RBs in this TB have been collided
-              for (std::vector<int>::iterator rbIt =  (*itTbDisc).second.rbBitmap.begin (); rbIt != (*itTbDisc).second.rbBitmap.end (); rbIt++)
+              //if m_dropRbOnCollisionEnabled == false, collidedRbBitmap will remain empty
+              //and we only check if the TB with similar RBs has already been decoded
+              if (((*itTbDisc).second.rbBitmap & collidedRbBitmap).any ())
                 {
-                  //if m_dropRbOnCollisionEnabled == false, collidedRbBitmap will remain empty
-                  //and we move to the second "if" to check if the TB with similar RBs has already
-                  //been decoded. If m_dropRbOnCollisionEnabled == true, all the collided TBs
-                  //are marked corrupt and this for loop will break in the first "if" condition
-                  if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                    {
-                      NS_LOG_DEBUG (*rbIt << " TB collided, labeled as corrupted!");
-                      (*itTbDisc).second.corrupt = true;
-                      break;
-                    }
-                  if (rbDecodedBitmap.find (*rbIt) != rbDecodedBitmap.end ())
-                    {
-                      NS_LOG_DEBUG (*rbIt << " TB with the similar RB has already been decoded. Avoid to decode it again!");
-                      (*itTbDisc).second.corrupt = true;
-                      break;
-                    }
+                  NS_LOG_DEBUG ("TB collided, labeled as corrupted!");
+                  (*itTbDisc).second.corrupt = true;
+                }
+              else if (((*itTbDisc).second.rbBitmap & rbDecodedBitmap).any ())
+                {
+                  NS_LOG_DEBUG ("TB with the similar RB has already been decoded. Avoid to decode it again!");
+                  (*itTbDisc).second.corrupt = true;
                 }
 
           TbErrorStats_t tbStats = LteNistErrorModel::GetPsdchBler (m_fadingModel,LteNistErrorModel::SISO, GetMeanSinr (m_slSinrPerceived[(*itSinrDisc).second] * m_slRxGain, (*itTbDisc).second.rbBitmap),  harqInfoList);
@@ -3025,7 +2999,7 @@ LteSpectrumPhy::RxDiscovery ()
           //We logged it to discard overlapping retransmissions.
           if (!(*itTbDisc).second.corrupt && m_slHarqPhyModule->IsDiscTbPrevDecoded ((*itTbDisc).first.m_rnti, (*itTbDisc).first.m_resPsdch))
             {
-              rbDecodedBitmap.insert((*itTbDisc).second.rbBitmap.begin (), (*itTbDisc).second.rbBitmap.end ());
+              rbDecodedBitmap |= (*itTbDisc).second.rbBitmap;
             }
 
           //If the TB is not corrupt and has not been decoded before, we indicate it decoded and consider its reception
@@ -3041,7 +3015,7 @@ LteSpectrumPhy::RxDiscovery ()
               Ptr<LteControlMessage> rxCtrlMsg = m_rxPacketInfo[(*itSinrDisc).second].m_rxControlMessage;
               rxDiscMessageOkList.push_back (rxCtrlMsg);
               //Store the indices of the decoded RBs
-              rbDecodedBitmap.insert((*itTbDisc).second.rbBitmap.begin (), (*itTbDisc).second.rbBitmap.end ());
+              rbDecodedBitmap |= (*itTbDisc).second.rbBitmap;
             }
           //Store the HARQ information
           m_slHarqPhyModule->UpdateDiscHarqProcessStatus ((*itTbDisc).first.m_rnti, (*itTbDisc).first.m_resPsdch, (*itTbDisc).second.sinr);
@@ -3055,21 +3029,15 @@ LteSpectrumPhy::RxDiscovery ()
             {
               NS_LOG_DEBUG (this << " PSDCH DropOnCollisionEnabled: Labeling Corrupted TB");
               //Check if any of the RBs in this TB have been collided
-              for (std::vector<int>::iterator rbIt =  (*itTbDisc).second.rbBitmap.begin (); rbIt != (*itTbDisc).second.rbBitmap.end (); rbIt++)
+              if (((*itTbDisc).second.rbBitmap & collidedRbBitmap).any ())
                 {
-                  if (collidedRbBitmap.find (*rbIt) != collidedRbBitmap.end ())
-                    {
-                      NS_LOG_DEBUG (*rbIt << " TB collided, labeled as corrupted!");
-                      (*itTbDisc).second.corrupt = true;
-                      break;
-                    }
-                  else
-                    {
-                      //We will check all the RBs and label the TB as not corrupted for every non-collided RBs.
-                      //if any of the RB would collide, the above "if" will label the TB as corrupt and break.
-                      NS_LOG_DEBUG (*rbIt << " RB not collided");
-                      (*itTbDisc).second.corrupt = false;
-                    }
+                  NS_LOG_DEBUG ("TB collided, labeled as corrupted!");
+                  (*itTbDisc).second.corrupt = true;
+                }
+              else if ((*itTbDisc).second.rbBitmap.any ())
+                {
+                  NS_LOG_DEBUG ("RBs not collided");
+                  (*itTbDisc).second.corrupt = false;
                 }
             }
           else
@@ -38,7 +38,9 @@
 #include <ns3/packet-burst.h>
 #include <ns3/lte-interference.h>
 #include <ns3/lte-sl-interference.h>
+#include <ns3/lte-sl-sensing-window.h>
 #include <ns3/lte-nist-error-model.h>
+#include <ns3/lte-spectrum-signal-parameters.h>
 #include "ns3/random-variable-stream.h"
 #include <map>
 #include <ns3/ff-mac-common.h>
@@ -115,7 +117,7 @@ struct SltbInfo_t
   uint8_t ndi; ///< ndi
   uint16_t size; ///< TB size
   uint8_t mcs; ///< mcs
-  std::vector<int> rbBitmap; ///< RB bitmap
+  SlRbBitmap_t rbBitmap; ///< RB bitmap
   uint8_t rv; ///< rv
   double mi; ///< mi
   bool corrupt; ///< whether is corrupt
@@ -151,7 +153,7 @@ struct SlDisctbInfo_t
 {
   uint8_t ndi; ///< ndi
   uint8_t resPsdch; ///< PSDCH resource number
-  std::vector<int> rbBitmap; ///< RB bitmap
+  SlRbBitmap_t rbBitmap; ///< RB bitmap
   uint8_t rv; ///< rv
   double mi; ///< mi
   bool corrupt; ///< whether is corrupt
@@ -177,9 +179,11 @@ struct LteSpectrumSignalParametersSlFrame;
  */
 struct SlRxPacketInfo_t
 {
-  std::vector<int> rbBitmap;  ///< RB bitmap
+  SlRbBitmap_t rbBitmap;  ///< RB bitmap
   Ptr<PacketBurst> m_rxPacketBurst;  ///< Rx packet burst
   Ptr<LteControlMessage> m_rxControlMessage; ///< Rx control message
+  uint32_t m_txNodeId; ///< node id of the transmitter
+  Vector m_txPosition; ///< position of the transmitter when the transmission started
 };
 
 /// SlCtrlPacketInfo_t structure
@@ -283,7 +287,6 @@ public:
   void SetTJAlgo (bool TJAlgo);
   void InitRssiRsrpMap ();
   void SetChannel (Ptr<SpectrumChannel> c);
-  void SetNodeList (NodeContainer c);
   void SetMobility (Ptr<MobilityModel> m);
   void SetDevice (Ptr<NetDevice> d);
   Ptr<MobilityModel> GetMobility ();
@@ -707,13 +710,64 @@ public:
    */
   void SetDiscNumRetx (uint8_t retx);
   
-  std::vector<std::vector<double>> GetRssiMap ();
-  std::vector<std::vector<double>> GetRsrpMap ();
-  std::vector<std::vector<bool>> GetDecodingMap ();
-  void MoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod);
+  /**
+   * \brief Get the Mode-4 sensing window of this PHY
+   *
+   * \return A read-only view of the S-RSSI/PSSCH-RSRP/decoding history
+   */
+  const LteSlSensingWindow& GetSensingWindow () const;
+  /**
+   * \brief Expire the sensing window up to the current subframe and keep
+   * the sums of its samples for the averaging period
+   *
+   * \param timeMs The absolute time in milliseconds of the current subframe
+   * \param scPeriod The averaging period (SC period) in subframes
+   */
+  void MoveSensingWindow (int64_t timeMs, uint32_t scPeriod);
   void SetNextTxTime (uint32_t txTime);
   std::vector<uint32_t> GetFeedbackProvidedResources(uint32_t subChannel, uint32_t subFrame, uint32_t nFeedback, uint32_t totalRU);
 
+  /**
+   * Status of the first RB of a PSCCH message already taken by another one
+   */
+  enum SlCtrlRbStatus_t
+  {
+    SL_CTRL_RB_FREE,      ///< no RB of the message is collided or decoded
+    SL_CTRL_RB_COLLIDED,  ///< the first such RB has collided
+    SL_CTRL_RB_DECODED    ///< the first such RB carried a decoded message
+  };
+
+  /**
+   * \brief Add the RBs of a PSSCH or PSDCH TB to the collision detection
+   *
+   * \param rbBitmap The RBs of the TB
+   * \param usedRbBitmap The RBs of the TBs already added, updated
+   * \param collidedRbBitmap The RBs used by more than one TB, updated
+   */
+  static void UpdateSlCollidedRbs (const SlRbBitmap_t& rbBitmap, SlRbBitmap_t& usedRbBitmap, SlRbBitmap_t& collidedRbBitmap);
+  /**
+   * \brief Add the RBs of a PSCCH message to the collision detection
+   *
+   * The messages are added from the strongest one. Only the first collided
+   * RB of a message is recorded, and only its RBs before that one are
+   * marked as used.
+   *
+   * \param rbBitmap The RBs of the message
+   * \param usedRbBitmap The RBs of the messages already added, updated
+   * \param collidedRbBitmap The collided RBs, updated
+   */
+  static void UpdateSlCtrlCollidedRbs (const SlRbBitmap_t& rbBitmap, SlRbBitmap_t& usedRbBitmap, SlRbBitmap_t& collidedRbBitmap);
+  /**
+   * \brief Get the status of the first RB of a PSCCH message that has
+   * collided or carried an already decoded message
+   *
+   * \param rbBitmap The RBs of the message
+   * \param collidedRbBitmap The collided RBs
+   * \param rbDecodedBitmap The RBs of the decoded messages
+   * \return The status of that RB, SL_CTRL_RB_FREE if there is none
+   */
+  static SlCtrlRbStatus_t GetSlCtrlRbStatus (const SlRbBitmap_t& rbBitmap, const SlRbBitmap_t& collidedRbBitmap, const SlRbBitmap_t& rbDecodedBitmap);
+
   /**
   * TracedCallback signature for TB drop.
   *
@@ -778,6 +832,15 @@ private:
    */
   double GetMeanSinr (const SpectrumValue& sinr, const std::vector<int>& rbBitMap);
 
+  /**
+   * \brief Get mean SINR function
+   *
+   * \param sinr The SINR values
+   * \param rbBitmap The RBs of the signal
+   * \return The average SINR per RB in linear scale
+   */
+  double GetMeanSinr (const SpectrumValue& sinr, const SlRbBitmap_t& rbBitmap);
+
   /**
    * \brief Filter Rx applications function
    *
@@ -795,7 +858,6 @@ private:
   void RxDiscovery ();
 
   Ptr<MobilityModel> m_mobility; ///< the mobility model
-  NodeContainer m_nodeList;
   Ptr<AntennaModel> m_antenna; ///< the antenna model
   Ptr<NetDevice> m_device; ///< the device
 
@@ -835,13 +897,13 @@ private:
   Ptr<LteInterference> m_interferenceData; ///< the data interference
   Ptr<LteInterference> m_interferenceCtrl; ///< the control interference
 
-  std::vector<std::vector<bool>> m_decodingMap;
-  std::vector<std::vector<double>> m_rssiMap; // rssi map
-  std::vector<std::vector<double>> m_rsrpMap; // rsrp map
+  LteSlSensingWindow m_sensingWindow; ///< Mode-4 sensing history
+  uint32_t m_sensingWindowLength; ///< length of the sensing window in subframes
+  uint32_t m_slBandwidth; ///< sidelink bandwidth in RBs used to derive the number of subchannels
   std::vector<std::vector<uint32_t>> m_txFeedbackMap; // map for feedback information to transmit.
   std::vector<std::vector<uint32_t>> m_rxFeedbackMap; // map for received feedback information
-  std::vector<uint32_t> m_msgLastReception;
-  std::vector<uint32_t> m_consecutiveMiss;
+  std::map<uint32_t, uint32_t> m_msgLastReception; ///< time of the last PSCCH received from each neighbor node, 0 if none
+  std::map<uint32_t, uint32_t> m_consecutiveMiss; ///< PSCCH missed from each neighbor node since the last one received
   uint32_t m_nextTxTime;
   bool m_isDecoded;
   uint32_t m_txID;
@@ -23,6 +23,7 @@
 #include <ns3/log.h>
 #include <ns3/packet-burst.h>
 #include <ns3/ptr.h>
+#include <ns3/simulator.h>
 #include <ns3/lte-spectrum-signal-parameters.h>
 #include <ns3/lte-control-messages.h>
 
@@ -148,6 +149,22 @@ LteSpectrumSignalParametersUlSrsFrame::Copy ()
 }
 
 
+/// Bytes of packet bursts shared by the copies of Sidelink signal parameters
+static uint64_t g_slSharedPayloadBytes = 0;
+/// True if the reset of g_slSharedPayloadBytes is scheduled at Simulator::Destroy
+static bool g_slSharedPayloadResetScheduled = false;
+
+/**
+ * Reset the bytes shared by the copies of Sidelink signal parameters,
+ * so that each simulation of the program reports its own count
+ */
+static void
+ResetSlSharedPayloadBytes (void)
+{
+  g_slSharedPayloadBytes = 0;
+  g_slSharedPayloadResetScheduled = false;
+}
+
 LteSpectrumSignalParametersSlFrame::LteSpectrumSignalParametersSlFrame ()
 {
   NS_LOG_FUNCTION (this);
@@ -159,14 +176,27 @@ LteSpectrumSignalParametersSlFrame::LteSpectrumSignalParametersSlFrame (const Lt
   NS_LOG_FUNCTION (this << &p);
   nodeId = p.nodeId;
   groupId = p.groupId;
+  txPosition = p.txPosition;
   slssId = p.slssId;
-  ctrlMsgList = p.ctrlMsgList;
-  if (p.packetBurst)
+  payload = p.payload;
+  rbBitmap = p.rbBitmap;
+  if (payload && payload->packetBurst)
     {
-      packetBurst = p.packetBurst->Copy ();
+      if (!g_slSharedPayloadResetScheduled)
+        {
+          Simulator::ScheduleDestroy (&ResetSlSharedPayloadBytes);
+          g_slSharedPayloadResetScheduled = true;
+        }
+      g_slSharedPayloadBytes += payload->packetBurst->GetSize ();
     }
 }
 
+uint64_t
+LteSpectrumSignalParametersSlFrame::GetSharedPayloadBytes (void)
+{
+  return g_slSharedPayloadBytes;
+}
+
 Ptr<SpectrumSignalParameters>
 LteSpectrumSignalParametersSlFrame::Copy ()
 {
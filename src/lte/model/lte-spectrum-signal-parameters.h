@@ -25,6 +25,10 @@
 
 
 #include <ns3/spectrum-signal-parameters.h>
+#include <ns3/simple-ref-count.h>
+#include <ns3/vector.h>
+#include <list>
+#include <bitset>
 
 namespace ns3 {
 
@@ -152,16 +156,54 @@ struct LteSpectrumSignalParametersUlSrsFrame : public SpectrumSignalParameters
   uint16_t cellId; ///< cell ID
 };
 
+/**
+* \ingroup lte
+*
+* RBs of a Sidelink signal, bit i being set if the signal uses RB i.
+* 128 bits cover the 100 RBs of the largest LTE bandwidth.
+*/
+typedef std::bitset<128> SlRbBitmap_t;
+
+/**
+* \ingroup lte
+*
+* Payload of a Sidelink signal. It is built by the transmitter and then
+* shared, read-only, by all the receivers of the signal: a receiver
+* copies a packet only when it delivers it to the upper layers.
+*/
+struct LteSlSignalPayload : public SimpleRefCount<LteSlSignalPayload>
+{
+  /**
+  * The packet burst being transmitted with this signal
+  */
+  Ptr<PacketBurst> packetBurst;
+
+  /**
+   * The control messages being sent (for sidelink, there should only be 1)
+   */
+  std::list<Ptr<LteControlMessage> > ctrlMsgList;
+};
+
 /**
 * \ingroup lte
 *
 * Signal parameters for Lte SL Frame (PSCCH and PSSCH)
+*
+* The copies made by the channel for each receiver share the payload of
+* the signal, only the power spectral density is per receiver.
 */
 struct LteSpectrumSignalParametersSlFrame : public SpectrumSignalParameters
 {
   
   // inherited from SpectrumSignalParameters
   virtual Ptr<SpectrumSignalParameters> Copy ();
+
+  /**
+  * \return the number of bytes of packet bursts shared by the copies of
+  * Sidelink signal parameters instead of being copied, since the start
+  * of the simulation. The count is reset by Simulator::Destroy
+  */
+  static uint64_t GetSharedPayloadBytes (void);
   
   /**
   * default constructor
@@ -176,18 +218,24 @@ struct LteSpectrumSignalParametersSlFrame : public SpectrumSignalParameters
 
 
   /**
-  * The packet burst being transmitted with this signal
+  * The packet burst and control messages, shared by all the copies
   */
-  Ptr<PacketBurst> packetBurst;
+  Ptr<const LteSlSignalPayload> payload;
 
   /**
-   * The control messages being sent (for sidelink, there should only be 1)
-   */
-  std::list<Ptr<LteControlMessage> > ctrlMsgList;
+  * The RBs used by the signal, computed once from the transmitted PSD
+  */
+  SlRbBitmap_t rbBitmap;
   
   uint32_t nodeId; ///< Node id
   uint8_t groupId; ///< Sidelink group id
 
+  /**
+   * Position of the transmitting UE when the transmission started, so that
+   * the receivers do not need to look up the mobility model of the transmitter
+   */
+  Vector txPosition;
+
   /**
    * The Sidelink synchronization signal identifier of the transmitting UE
    */
@@ -38,6 +38,7 @@
 #include <ns3/lte-control-messages.h>
 #include <ns3/simulator.h>
 #include <ns3/lte-common.h>
+#include <ns3/lte-sl-resource-selector.h>
 
 #include<bitset>
 #include<algorithm>
@@ -352,6 +353,19 @@ LteUeMac::GetTypeId (void)
                    UintegerValue (2),
                    MakeUintegerAccessor (&LteUeMac::m_slGrantSize),
                    MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("SlResourceSelector",
+                   "The Mode-4 resource selection policy. If not set, the 3GPP or the TJ "
+                   "policy is used depending on the TJ algorithm flag.",
+                   PointerValue (),
+                   MakePointerAccessor (&LteUeMac::m_resourceSelector),
+                   MakePointerChecker<LteSlResourceSelector> ())
+    .AddAttribute ("SlIdleFastPath",
+                   "If true, the Sidelink Tx pools are not processed in the subframes "
+                   "without SC period start or transmission (sidelink-idle state). "
+                   "The sensing window and the not sensed subframes are expired lazily.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&LteUeMac::m_slIdleFastPath),
+                   MakeBooleanChecker ())
     .AddTraceSource ("SlPscchScheduling",
                      "Information regarding SL UE scheduling",
                      MakeTraceSourceAccessor (&LteUeMac::m_slPscchScheduling),
@@ -409,11 +423,9 @@ LteUeMac::LteUeMac ()
   m_v2v = true;
   m_first = true;
   m_TJAlgo = false;
-  
-  for (uint32_t idx_sf = 0; idx_sf < 1000; idx_sf++)
-    {
-      m_not_sensed_subframe.push_back(false);
-    }
+  m_notSensedWindowLength = 0;
+  m_slLastSubframe = -1;
+  m_slIdle = false;
 }
 
 LteUeMac::~LteUeMac ()
@@ -441,6 +453,7 @@ LteUeMac::DoDispose ()
   delete m_macSapProvider;
   delete m_cmacSapProvider;
   delete m_uePhySapUser;
+  m_resourceSelector = 0;
   Object::DoDispose ();
 }
 
@@ -983,8 +996,6 @@ LteUeMac::DoAddSlCommTxPool (uint32_t dstL2Id, Ptr<SidelinkTxCommResourcePool> p
   NS_ABORT_MSG_IF (info.m_nextScPeriod.frameNo > 1024 || info.m_nextScPeriod.subframeNo > 10,
                    "Invalid frame or subframe number");
   info.m_grantReceived = false;
-  info.m_reserveCount = (uint32_t) 0;
-  NS_LOG_DEBUG(this << " set m_reserveCount = " << (uint32_t) info.m_reserveCount);
   m_sidelinkTxPoolsMap.insert (std::pair<uint32_t, PoolInfo > (dstL2Id, info));
 
   NS_LOG_DEBUG ("scPeriod = " << info.m_pool->GetScPeriod ());
@@ -1453,11 +1464,37 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
           m_freshSlBsr = false;
         }
     
+      const LteSlSensingWindow& sensingWindow = m_uePhySapProvider->GetSensingWindow ();
+      uint32_t windowLength = sensingWindow.GetLength ();
+      if (m_notSensedWindowLength != windowLength)
+        {
+          m_not_sensed_subframe.clear ();
+          m_notSensedWindowLength = windowLength;
+        }
+
+      //The pools are not walked until the next SC period or transmission;
+      //the not sensed marks and the sensing window of the PHY catch up
+      if (m_slIdleFastPath && IsSidelinkIdle (frameNo, subframeNo))
+        {
+          if (!m_slIdle)
+            {
+              NS_LOG_LOGIC ("RNTI " << m_rnti << " enters the sidelink-idle state");
+              m_slIdle = true;
+            }
+          return;
+        }
+      if (m_slIdle)
+        {
+          NS_LOG_LOGIC ("RNTI " << m_rnti << " leaves the sidelink-idle state");
+          m_slIdle = false;
+        }
+      ExpireNotSensedSubframes (frameNo, subframeNo);
+
       std::map <uint32_t, PoolInfo>::iterator poolIt;
-      for (poolIt = m_sidelinkTxPoolsMap.begin (); poolIt != m_sidelinkTxPoolsMap.end (); poolIt++)
+      for (poolIt = m_sidelinkTxPoolsMap.begin (); poolIt != m_sidelinkTxPoolsMap.end () && windowLength > 0; poolIt++)
         {
-          m_not_sensed_subframe[((frameNo-1)*10 + (subframeNo-1) + poolIt->second.m_pool->GetScPeriod())%1000] = false;
-          m_uePhySapProvider->MoveSensingWindow(Simulator::Now().GetMilliSeconds()%1000, poolIt->second.m_pool->GetScPeriod());
+          m_not_sensed_subframe.erase (((frameNo-1)*10 + (subframeNo-1) + poolIt->second.m_pool->GetScPeriod())%windowLength);
+          m_uePhySapProvider->MoveSensingWindow(Simulator::Now().GetMilliSeconds(), poolIt->second.m_pool->GetScPeriod());
           //m_uePhySapProvider->MoveSensingWindow(((frameNo-1)*10 + (subframeNo-1) + poolIt->second.m_pool->GetScPeriod())%1000, poolIt->second.m_pool->GetScPeriod());
           //Check if this is a new SC period
           if (frameNo == poolIt->second.m_nextScPeriod.frameNo && subframeNo == poolIt->second.m_nextScPeriod.subframeNo)
@@ -1518,238 +1555,78 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                       {
                         NS_LOG_INFO ("SL BSR size =" << m_slBsrReceived.size ());
                         SidelinkGrantV2V grantV2V;
-                        //NS_LOG_DEBUG (this << " m_reserveCount = " << (uint32_t) poolIt->second.m_reserveCount);
+                        LteSlSpsReservation &sps = poolIt->second.m_sps;
                         uint32_t changeProb = m_ueSelectedUniformVariable->GetInteger(1, 100);
                         //NS_LOG_DEBUG("m_changeProb = " << m_changeProb);
-                        if (m_first || (poolIt->second.m_reserveCount==0 && changeProb >= (101-m_changeProb)))
+                        if (m_first || (sps.GetCounter () == 0 && changeProb >= (101-m_changeProb)))
                           {
                             m_first = false;
                             // Semi-Persistent Scheduling (SPS)
-                            poolIt->second.m_reserveCount = (uint32_t) m_ueSelectedUniformVariable->GetInteger(25, 75);
-                            poolIt->second.m_reserveCount--; // decrement by 1
-                            std::vector<std::vector<double>> rssiMap = m_uePhySapProvider->GetRssiMap();
-                            std::vector<std::vector<double>> rsrpMap = m_uePhySapProvider->GetRsrpMap();
-                            std::vector<std::vector<bool>> decodingMap = m_uePhySapProvider->GetDecodingMap();
+                            uint32_t reselectionCounter = (uint32_t) m_ueSelectedUniformVariable->GetInteger(25, 75);
                             uint32_t scPeriod = poolIt->second.m_pool->GetScPeriod ();
 
                             NS_LOG_INFO ("Succeed getting RSSI Map");
-                            // TODO: candidate and avrg_rsrp create with std::vector
-                            std::vector<std::vector<bool>> candidates;
-                            std::vector<std::vector<double>> avrg_rsrp;
-                            std::vector<std::vector<double>> avrg_rssi;
-                            for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
+                            // sensing results per resource of the selection window, index = idx_sc * scPeriod + idx_sf
+                            uint32_t nSubChannels = poolIt->second.m_pool->GetNSubChannel ();
+                            std::vector<bool> candidates (nSubChannels * scPeriod, true);
+                            std::vector<double> avrg_rsrp (nSubChannels * scPeriod, 0.0);
+                            std::vector<double> avrg_rssi (nSubChannels * scPeriod, 0.0);
+
+                            // the sums of the window per resource are kept up to date by the PHY
+                            for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
                               {
-                                std::vector<bool> boolTemp;
-                                std::vector<double> doubleTemp;
-                                std::vector<double> doubleTemp2;
                                 for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
                                   {
-                                    boolTemp.push_back(true);
-                                    doubleTemp.push_back(0.0);
-                                    doubleTemp2.push_back(0.0);
+                                    avrg_rsrp[idx_sc * scPeriod + idx_sf] = sensingWindow.GetRsrpSum (idx_sc, idx_sf, scPeriod);
+                                    avrg_rssi[idx_sc * scPeriod + idx_sf] = sensingWindow.GetRssiSum (idx_sc, idx_sf, scPeriod);
                                   }
-                                candidates.push_back(boolTemp);
-                                avrg_rsrp.push_back(doubleTemp);
-                                avrg_rssi.push_back(doubleTemp2);
                               }
 
-                            // monitor check
-                            for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
+                            // monitor check: the window is walked from the slot before the current one backwards
+                            uint32_t lastSlot = (sensingWindow.GetSlot (Simulator::Now ().GetMilliSeconds ()) + windowLength - 1) % windowLength;
+                            for (std::set<uint32_t>::const_iterator itNs = m_not_sensed_subframe.begin (); itNs != m_not_sensed_subframe.end () && !m_TJAlgo; itNs++)
                               {
-                                int tempMod = scPeriod-1;
-                                int sIdx = Simulator::Now().GetMilliSeconds () % 1000 -1;
-                                //int sIdx = (frameNo -1 ) *10 + (subframeNo-1) - UL_PUSCH_TTIS_DELAY - 1;
-                                for (int rel = 0; rel < 1000; rel++)
+                                uint32_t rel = (lastSlot + windowLength - *itNs) % windowLength;
+                                uint32_t tempMod = scPeriod - 1 - rel % scPeriod;
+                                for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
                                   {
-                                    if (sIdx - rel < 0)
-                                      {
-                                        sIdx += 1000;
-                                      }
-                                    uint32_t idx_sf = sIdx - rel;
-                                    avrg_rsrp[idx_sc][tempMod] += rsrpMap[idx_sc][idx_sf%1000];
-                                    avrg_rssi[idx_sc][tempMod] += rssiMap[idx_sc][idx_sf%1000];
-                                    //NS_LOG_DEBUG("avrg_rsrp[idx_sc][idx_sf] = "<<avrg_rsrp[idx_sc][idx_sf%scPeriod] << ", idx_sc = "<<idx_sc<<", idx_sf = "<<idx_sf%scPeriod);
-                                    if (m_not_sensed_subframe[idx_sf%1000])
-                                      {
-                                        if (!m_TJAlgo)
-                                          {  
-                                            candidates[idx_sc][tempMod] = false;
-                                          }
-                                      }
-                                    
-                                    //NS_LOG_DEBUG ("Not Sensed Subframe = " << tempMod << ", Ultimate = " << idx_sf%1000);
-                                    tempMod--;
-                                    if (tempMod < 0)
-                                      {
-                                        tempMod = scPeriod-1;
-                                      }
+                                    candidates[idx_sc * scPeriod + tempMod] = false;
                                   }
                               }
 
-                            double refcnt = std::ceil(1000/scPeriod);
-                            std::vector<double> avrg_rsrp_list;
-                            for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
+                            double refcnt = std::ceil(windowLength/scPeriod);
+                            for (uint32_t idx = 0; idx < avrg_rsrp.size (); idx++)
                               {
-                                for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                  {
-                                    avrg_rsrp[idx_sc][idx_sf] /= refcnt;
-                                    avrg_rssi[idx_sc][idx_sf] /= refcnt;
-                                    if (candidates[idx_sc][idx_sf])
-                                      {
-                                        avrg_rsrp_list.push_back(avrg_rsrp[idx_sc][idx_sf]);
-                                      }
-                                  }
+                                avrg_rsrp[idx] /= refcnt;
+                                avrg_rssi[idx] /= refcnt;
                               }
-                            std::sort(avrg_rsrp_list.begin(), avrg_rsrp_list.end());
-                            NS_LOG_DEBUG("[RSRP] lowest= " << avrg_rsrp_list[0] << ", 2-lowest= " << avrg_rsrp_list[1] << ", 3-lowest= " << avrg_rsrp_list[2]);
-                            NS_LOG_DEBUG("[RSRP] highest= " << avrg_rsrp_list[avrg_rsrp_list.size()-1] << ", 2-highest= " << avrg_rsrp_list[avrg_rsrp_list.size()-2] << ", 3-highest= " << avrg_rsrp_list[avrg_rsrp_list.size()-3]);
 
-                            // signal power (rsrp) check;
-                            double rsrp_threshold = -1000.0;
-                            uint32_t total_ru = poolIt->second.m_pool->GetNSubChannel() * scPeriod;
-                            
-                            while (true)
-                              { 
-                                uint32_t candidate_count = 0;
-                                for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
-                                  {
-                                    for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                      {
-                                        if (avrg_rsrp[idx_sc][idx_sf] < rsrp_threshold && candidates[idx_sc][idx_sf])
-                                          {
-                                            candidate_count++;
-                                          }
-                                      }
-                                  }
-
-                                if (candidate_count > (uint32_t)(total_ru * 0.2))
-                                  {
-                                    break;
-                                  }
-                                rsrp_threshold += 30;
-                                //NS_LOG_DEBUG("rsrp_threshold = "<<rsrp_threshold<<", candidate_count = "<<candidate_count);
-                              }
-                            
-                            std::vector<uint32_t> subFrameCandidateCount;
-                            uint32_t maxCandidateCount = 0;
-                            std::vector<double> candidate_avrg_rsrp_list;
-                            for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                              {
-                                subFrameCandidateCount.push_back(0);
-                              }
-
-                            for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
-                              {
-                                for (unsigned int idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                  {
-                                    if (avrg_rsrp[idx_sc][idx_sf] < rsrp_threshold && candidates[idx_sc][idx_sf])
-                                      {
-                                        candidate_avrg_rsrp_list.push_back(avrg_rsrp[idx_sc][idx_sf]);
-                                        subFrameCandidateCount[idx_sf]++;
-                                      }
-                                    else
-                                      {
-                                        candidates[idx_sc][idx_sf] = false;
-                                      }
-                                  }
-                              }
-                            std::sort(candidate_avrg_rsrp_list.begin(), candidate_avrg_rsrp_list.end());
-                            NS_LOG_DEBUG("[CANDIDATE_RSRP] lowest= " << candidate_avrg_rsrp_list[0] << ", 2-lowest= " << candidate_avrg_rsrp_list[1] << ", 3-lowest= " << candidate_avrg_rsrp_list[2]);
-                            NS_LOG_DEBUG("[CANDIDATE_RSRP] highest= " << candidate_avrg_rsrp_list[candidate_avrg_rsrp_list.size()-1] << ", 2-highest= " << candidate_avrg_rsrp_list[candidate_avrg_rsrp_list.size()-2] << ", 3-higest= " << candidate_avrg_rsrp_list[candidate_avrg_rsrp_list.size()-3]);
-                            
-                            for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
+                            if (m_resourceSelector == 0)
                               {
-                                if (subFrameCandidateCount[idx_sf] > maxCandidateCount)
+                                if (m_TJAlgo)
                                   {
-                                    maxCandidateCount = subFrameCandidateCount[idx_sf];
-                                  }
-                              }
-
-                            //NS_LOG_DEBUG ("maxCandidateCount = "<<maxCandidateCount);
-
-                            // serialize the candidate resources in one dimension vector for random choice.
-                            std::vector<unsigned int> second_candidates_sc;
-                            std::vector<unsigned int> second_candidates_sf;
-                            std::vector<double> second_candidates_avrg_rssi;
-                            for (unsigned int idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
-                              {
-                                for (unsigned int idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                  {
-                                    if (m_TJAlgo && candidates[idx_sc][idx_sf] && subFrameCandidateCount[idx_sf]==maxCandidateCount)
-                                      {
-                                        second_candidates_sc.push_back(idx_sc);
-                                        second_candidates_sf.push_back(idx_sf);
-                                      }
-                                    else if (!m_TJAlgo && candidates[idx_sc][idx_sf])
-                                      {
-                                        second_candidates_sc.push_back(idx_sc);
-                                        second_candidates_sf.push_back(idx_sf);
-                                        second_candidates_avrg_rssi.push_back(avrg_rssi[idx_sc][idx_sf]);
-                                        //NS_LOG_DEBUG ("[CANDIDATE] SubFrame: "<<idx_sf<<", SubChannel: "<<idx_sc<<", Avg_RSRP: "<<avrg_rsrp[idx_sc][idx_sf]/10);
-                                      }
+                                    m_resourceSelector = CreateObject<LteSlTjResourceSelector> ();
                                   }
-                              }
-
-                            if (!m_TJAlgo)
-                              {
-
-                                for (uint32_t i = 0; i < second_candidates_sc.size()-1; i++)
+                                else
                                   {
-                                    for (uint32_t j = i+1; j < second_candidates_sc.size(); j++)
-                                      {
-                                        uint32_t uintTemp;
-                                        double doubleTemp;
-                                        if (second_candidates_avrg_rssi[i] > second_candidates_avrg_rssi[j])
-                                          {
-                                            uintTemp = second_candidates_sc[i];
-                                            second_candidates_sc[i] = second_candidates_sc[j];
-                                            second_candidates_sc[j] = uintTemp;
-                                            uintTemp = second_candidates_sf[i];
-                                            second_candidates_sf[i] = second_candidates_sf[j];
-                                            second_candidates_sf[j] = uintTemp;
-                                            doubleTemp = second_candidates_avrg_rssi[i];
-                                            second_candidates_avrg_rssi[i] = second_candidates_avrg_rssi[j];
-                                            second_candidates_avrg_rssi[j] = doubleTemp;
-                                          }
-                                      }
+                                    m_resourceSelector = CreateObject<LteSl3gppResourceSelector> ();
                                   }
                               }
-                            NS_LOG_INFO("second candidate size = "<<second_candidates_sc.size());
-                            // choice a random resource in candidate pool.
-                            uint32_t randChosenResource = 0;
-                            if (!m_TJAlgo)
-                              {
-                                uint32_t candidate_pool_size = (uint32_t)(total_ru * 0.2);
-                                randChosenResource = m_ueSelectedUniformVariable->GetInteger(0, candidate_pool_size-1);
-                              }
-                            else
-                              {
-                                randChosenResource = m_ueSelectedUniformVariable->GetInteger(0, second_candidates_sc.size()-1);
-                              }
-                            uint32_t subframe = second_candidates_sf[randChosenResource];
-                            poolIt->second.m_chosenSubframe = subframe;
-                            NS_LOG_INFO ("[New Chosen Resource] SubFrame: "<<poolIt->second.m_chosenSubframe<<", SubChannel: "<<second_candidates_sc[randChosenResource]);
-
-                            //uint32_t subframe = m_ueSelectedUniformVariable->GetInteger(0, poolIt->second.m_pool->GetScPeriod()-1);
-                            SidelinkCommResourcePool::SubframeInfo relativeSubframe;
-                            SidelinkCommResourcePool::SubframeInfo ultimateSubframe;
-                            relativeSubframe.frameNo = subframe / 10;
-                            relativeSubframe.subframeNo = subframe % 10;
-                            ultimateSubframe.frameNo = poolIt->second.m_currentScPeriod.frameNo + relativeSubframe.frameNo;
-                            ultimateSubframe.subframeNo = poolIt->second.m_currentScPeriod.subframeNo + relativeSubframe.subframeNo;
-                
-                            if (ultimateSubframe.subframeNo >= 11)
-                              {
-                                ultimateSubframe.frameNo++;
-                                ultimateSubframe.subframeNo -= 10;
-                              }
-
-                            grantV2V.m_grantedSubframe = ultimateSubframe;
+                            m_resourceSelector->SetRandomVariable (m_ueSelectedUniformVariable);
+                            SlCandidateResource chosenResource;
+                            bool selected = m_resourceSelector->SelectResource (nSubChannels, scPeriod, avrg_rsrp, avrg_rssi, candidates, chosenResource);
+                            NS_ABORT_MSG_IF (!selected, "No candidate resource left for the Mode-4 selection");
+                            uint32_t subframe = chosenResource.subframe;
+                            NS_LOG_INFO ("[New Chosen Resource] SubFrame: "<<subframe<<", SubChannel: "<<chosenResource.subChannel);
+
+                            // the transmissions of all the SC periods until the reselection counter expires
+                            sps.Reserve (subframe, chosenResource.subChannel, reselectionCounter);
+                            grantV2V.m_grantedSubframe = sps.Pop (poolIt->second.m_currentScPeriod).subframe;
                             //NS_LOG_DEBUG("Assigned frameNo: " << grantV2V.m_grantedSubframe.frameNo << " subframeNo: " << grantV2V.m_grantedSubframe.subframeNo);
-                            grantV2V.m_subChannelIndex = second_candidates_sc[randChosenResource];
+                            grantV2V.m_subChannelIndex = chosenResource.subChannel;
                             
-                            m_phase1_selected_sc = second_candidates_sc[randChosenResource];
-                            m_phase1_selected_sf = second_candidates_sf[randChosenResource];
+                            m_phase1_selected_sc = chosenResource.subChannel;
+                            m_phase1_selected_sf = chosenResource.subframe;
                             m_onmove = false;
                             //grantV2V.m_subChannelIndex = m_ueSelectedUniformVariable->GetInteger (0, poolIt->second.m_pool->GetNSubChannel()-1);
                             
@@ -1766,61 +1643,49 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                           }
                         else
                           {
-                            if (poolIt->second.m_reserveCount==0)
+                            if (sps.GetCounter () == 0)
                               {
-                                poolIt->second.m_reserveCount = (uint32_t) m_ueSelectedUniformVariable->GetInteger(25, 75);
+                                // the resource is kept for a new reselection counter
+                                sps.Reserve (sps.GetOffset (), sps.GetSubChannel (), (uint32_t) m_ueSelectedUniformVariable->GetInteger(25, 75));
                               }
-                            poolIt->second.m_reserveCount--; // decrement by 1
                             grantV2V = poolIt->second.m_prevGrantV2V;
                             uint32_t scPeriod = poolIt->second.m_pool->GetScPeriod ();
                             
                             if (m_TJAlgo)
                               {
-                                std::vector<std::vector<bool>> decodingMap = m_uePhySapProvider->GetDecodingMap();
                                 std::vector<uint32_t> decodedSubframe;
                                 //uint32_t selfLocation = 0;
                                 int sIdx;
 
                                 /*
-                                if ((grantV2V.m_grantedSubframe.frameNo-1) *10 + (grantV2V.m_grantedSubframe.subframeNo-1) > poolIt->second.m_chosenSubframe)
+                                if ((grantV2V.m_grantedSubframe.frameNo-1) *10 + (grantV2V.m_grantedSubframe.subframeNo-1) > sps.GetOffset ())
                                   {
-                                    sIdx = ((grantV2V.m_grantedSubframe.frameNo-1) *10 + (grantV2V.m_grantedSubframe.subframeNo-1)) - poolIt->second.m_chosenSubframe;
+                                    sIdx = ((grantV2V.m_grantedSubframe.frameNo-1) *10 + (grantV2V.m_grantedSubframe.subframeNo-1)) - sps.GetOffset ();
                                   }
                                 else
                                   {
-                                    sIdx = poolIt->second.m_chosenSubframe - ((grantV2V.m_grantedSubframe.frameNo-1) * 10 + (grantV2V.m_grantedSubframe.subframeNo-1));
+                                    sIdx = sps.GetOffset () - ((grantV2V.m_grantedSubframe.frameNo-1) * 10 + (grantV2V.m_grantedSubframe.subframeNo-1));
                                   }*/
 
                                 NS_LOG_DEBUG("MAC time = "<<(frameNo-1) * 10 + (subframeNo-1) << ", current time = " << Simulator::Now().GetMilliSeconds());
-                                std::vector<unsigned int> rand_jump_candidates_sc;
-                                std::vector<unsigned int> rand_jump_candidates_sf;
                                 bool phase1_selected_resource_check = false;
-                                std::vector<std::vector<double>> avrg_decoding;
-                                for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
-                                  {
-                                    std::vector<double> doubleTemp;
-                                    for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                      {
-                                        doubleTemp.push_back(0.0);
-                                      }
-                                    avrg_decoding.push_back(doubleTemp);
-                                  }
+                                uint32_t nSubChannels = poolIt->second.m_pool->GetNSubChannel ();
+                                std::vector<double> avrg_decoding (nSubChannels * scPeriod, 0.0);
 
-
-                                for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool->GetNSubChannel(); idx_sc++)
+                                for (uint32_t idx_sc = 0; idx_sc < nSubChannels; idx_sc++)
                                   {
                                     int tempMod = scPeriod - 1;
-                                    sIdx = Simulator::Now ().GetMilliSeconds () % 1000 -1;
+                                    sIdx = (int) sensingWindow.GetSlot (Simulator::Now ().GetMilliSeconds ()) -1;
                                     for (int rel = 0; rel < (int)scPeriod; rel++)
                                       {
                                         if (sIdx - rel < 0)
                                           {
-                                            sIdx += 1000;
+                                            sIdx += windowLength;
                                           }
-                                        uint32_t idx_sf = sIdx - rel;
-                                        if (decodingMap[idx_sc][idx_sf%1000])
+                                        uint32_t idx_sf = (sIdx - rel) % windowLength;
+                                        if (sensingWindow.IsDecoded (idx_sc, idx_sf))
                                           {
-                                            avrg_decoding[idx_sc][tempMod] += 1.0;
+                                            avrg_decoding[idx_sc * scPeriod + tempMod] += 1.0;
                                             if (idx_sc==m_phase1_selected_sc && tempMod == (int)m_phase1_selected_sf)
                                               {
                                                 phase1_selected_resource_check = true;
@@ -1834,49 +1699,19 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                                       }
                                   }
 
-                                double refcnt = std::ceil(1000/scPeriod);
-                                std::vector<double> rand_jump_candidates_avrg_decoding;
-                                for (uint32_t idx_sc = 0; idx_sc < poolIt->second.m_pool ->GetNSubChannel(); idx_sc++)
+                                double refcnt = std::ceil(windowLength/scPeriod);
+                                for (uint32_t idx = 0; idx < avrg_decoding.size (); idx++)
                                   {
-                                    for (uint32_t idx_sf = 0; idx_sf < scPeriod; idx_sf++)
-                                      {
-                                        avrg_decoding[idx_sc][idx_sf] /= refcnt;
-                                        rand_jump_candidates_avrg_decoding.push_back(avrg_decoding[idx_sc][idx_sf]);
-                                        rand_jump_candidates_sc.push_back(idx_sc);
-                                        rand_jump_candidates_sf.push_back(idx_sf);
-                                      }
-                                  }
-                                for (uint32_t i = 0; i < rand_jump_candidates_sc.size() - 1; i++)
-                                  {
-                                    for (uint32_t j = i + 1; j < rand_jump_candidates_sf.size(); j++)
-                                      {
-                                        uint32_t uintTemp;
-                                        double doubleTemp;
-                                        if (rand_jump_candidates_avrg_decoding[i] < rand_jump_candidates_avrg_decoding[j])
-                                          {
-                                            uintTemp = rand_jump_candidates_sc[i];
-                                            rand_jump_candidates_sc[i] = rand_jump_candidates_sc[j];
-                                            rand_jump_candidates_sc[j] = uintTemp;
-                                            uintTemp = rand_jump_candidates_sf[i];
-                                            rand_jump_candidates_sf[i] = rand_jump_candidates_sf[j];
-                                            rand_jump_candidates_sf[j] = uintTemp;
-                                            doubleTemp = rand_jump_candidates_avrg_decoding[i];
-                                            rand_jump_candidates_avrg_decoding[i] = rand_jump_candidates_avrg_decoding[j];
-                                            rand_jump_candidates_avrg_decoding[j] = doubleTemp;
-                                          }
-                                      }
+                                    avrg_decoding[idx] /= refcnt;
                                   }
-                                int eIdx = (int)((double)rand_jump_candidates_sc.size() * 0.8);
-                                //NS_LOG_DEBUG ("rand jump candidate size = " << rand_jump_candidates_sc.size());
-                                uint32_t randChosenResource = m_ueSelectedUniformVariable->GetInteger(0, eIdx);
-                                if (rand_jump_candidates_sc.size()==0)
-                                  {
-                                    rand_jump_candidates_sc.push_back(m_phase1_selected_sc);
-                                    rand_jump_candidates_sf.push_back(m_phase1_selected_sf);
-                                    randChosenResource = 0;
-                                  }
-                                uint32_t nextSubframe = rand_jump_candidates_sf[randChosenResource];
-                                /*decodedSubframe.push_back(poolIt->second.m_chosenSubframe);
+
+                                SlCandidateResource jumpResource;
+                                jumpResource.subChannel = m_phase1_selected_sc;
+                                jumpResource.subframe = m_phase1_selected_sf;
+                                m_resourceSelector->SetRandomVariable (m_ueSelectedUniformVariable);
+                                m_resourceSelector->SelectJumpResource (nSubChannels, scPeriod, avrg_decoding, jumpResource);
+                                uint32_t nextSubframe = jumpResource.subframe;
+                                /*decodedSubframe.push_back(sps.GetOffset ());
                                 for (uint32_t idx_sf = sIdx; idx_sf < sIdx+scPeriod; idx_sf++)
                                   {
                                     if (decodingMap[grantV2V.m_subChannelIndex][idx_sf%1000])
@@ -1885,7 +1720,7 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                                       }
                                   }
                                
-                                uint32_t nextSubframe = poolIt->second.m_chosenSubframe;
+                                uint32_t nextSubframe = sps.GetOffset ();
                                 while (decodedSubframe.size() <= grantV2V.m_subChannelIndex)
                                   {
                                     unsigned int randSubframe = m_ueSelectedUniformVariable->GetInteger(0, scPeriod-1);
@@ -1898,7 +1733,7 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                                 std::sort(decodedSubframe.begin(), decodedSubframe.end());
                                 for (uint32_t idx = 0; idx < decodedSubframe.size(); idx++)
                                   {
-                                    if (decodedSubframe[idx] == poolIt->second.m_chosenSubframe)
+                                    if (decodedSubframe[idx] == sps.GetOffset ())
                                       {
                                         selfLocation = idx;
                                       }
@@ -1906,7 +1741,7 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                                 
                                 nextSubframe = decodedSubframe[(selfLocation + (int)grantV2V.m_subChannelIndex) % decodedSubframe.size()];
                                 */
-                                grantV2V.m_subChannelIndex = rand_jump_candidates_sc[randChosenResource];
+                                grantV2V.m_subChannelIndex = jumpResource.subChannel;
                                 if (!phase1_selected_resource_check && m_onmove) 
                                   {
                                     nextSubframe = m_phase1_selected_sf;
@@ -1918,39 +1753,17 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                                     m_onmove = true;
                                   }
  
-                                poolIt->second.m_chosenSubframe = nextSubframe;
-                                SidelinkCommResourcePool::SubframeInfo relativeSubframe;
-                                SidelinkCommResourcePool::SubframeInfo ultimateSubframe;
-                                relativeSubframe.frameNo = nextSubframe / 10;
-                                relativeSubframe.subframeNo = nextSubframe % 10;
-                                ultimateSubframe.frameNo = poolIt->second.m_currentScPeriod.frameNo + relativeSubframe.frameNo;
-                                ultimateSubframe.subframeNo = poolIt->second.m_currentScPeriod.subframeNo + relativeSubframe.subframeNo;
-                                if (ultimateSubframe.subframeNo >= 11)
-                                  {
-                                    ultimateSubframe.frameNo++;
-                                    ultimateSubframe.subframeNo -= 10;
-                                  }
-                                grantV2V.m_grantedSubframe = ultimateSubframe;
+                                // the jump moves the reserved resource, keeping the reselection counter
+                                sps.Reserve (nextSubframe, grantV2V.m_subChannelIndex, sps.GetCounter ());
+                                grantV2V.m_grantedSubframe = sps.Pop (poolIt->second.m_currentScPeriod).subframe;
                                 NS_LOG_DEBUG ("[Re Chosen Resource] SubFrame: "<<nextSubframe<<", SubChannel: "<< (uint32_t)grantV2V.m_subChannelIndex);
                                 m_uePhySapProvider->SetNextTxTime(Simulator::Now ().GetMilliSeconds () + nextSubframe);
                               }
                             else
                               {
-                                SidelinkCommResourcePool::SubframeInfo relativeSubframe;
-                                SidelinkCommResourcePool::SubframeInfo ultimateSubframe;
-                                relativeSubframe.frameNo = poolIt->second.m_chosenSubframe / 10;
-                                relativeSubframe.subframeNo = poolIt->second.m_chosenSubframe % 10;
-                                ultimateSubframe.frameNo = poolIt->second.m_currentScPeriod.frameNo + relativeSubframe.frameNo;
-                                ultimateSubframe.subframeNo = poolIt->second.m_currentScPeriod.subframeNo + relativeSubframe.subframeNo;
-                
-                                if (ultimateSubframe.subframeNo >= 11)
-                                  {
-                                    ultimateSubframe.frameNo++;
-                                    ultimateSubframe.subframeNo -= 10;
-                                  }
-                                grantV2V.m_grantedSubframe = ultimateSubframe;
-                                NS_LOG_INFO ("[Re Chosen Resource] SubFrame: "<<poolIt->second.m_chosenSubframe<<", SubChannel: "<< (uint32_t)grantV2V.m_subChannelIndex);
-                                m_uePhySapProvider->SetNextTxTime(Simulator::Now ().GetMilliSeconds () + poolIt->second.m_chosenSubframe);
+                                grantV2V.m_grantedSubframe = sps.Pop (poolIt->second.m_currentScPeriod).subframe;
+                                NS_LOG_INFO ("[Re Chosen Resource] SubFrame: "<<sps.GetOffset ()<<", SubChannel: "<< (uint32_t)grantV2V.m_subChannelIndex);
+                                m_uePhySapProvider->SetNextTxTime(Simulator::Now ().GetMilliSeconds () + sps.GetOffset ());
                               }
                             
                             //NS_LOG_DEBUG("Assigned frameNo: " << grantV2V.m_grantedSubframe.frameNo << " subframeNo: " << grantV2V.m_grantedSubframe.subframeNo);
@@ -1958,8 +1771,8 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
                           }
  
                         uint32_t reservedSubframe = (grantV2V.m_grantedSubframe.frameNo-1) * 10 + (grantV2V.m_grantedSubframe.subframeNo-1);
-                        NS_LOG_INFO ("Tx subChannel = " << (uint32_t) grantV2V.m_subChannelIndex << ", subFrame = " << reservedSubframe % 1000);
-                        m_not_sensed_subframe[reservedSubframe % 1000] = true;
+                        NS_LOG_INFO ("Tx subChannel = " << (uint32_t) grantV2V.m_subChannelIndex << ", subFrame = " << reservedSubframe % windowLength);
+                        m_not_sensed_subframe.insert (reservedSubframe % windowLength);
 
                         poolIt->second.m_nextGrantV2V = grantV2V;
                         poolIt->second.m_grantReceived = true;
@@ -2417,6 +2230,52 @@ LteUeMac::DoSubframeIndication (uint32_t frameNo, uint32_t subframeNo)
     }
 }
 
+bool
+LteUeMac::IsSidelinkIdle (uint32_t frameNo, uint32_t subframeNo) const
+{
+  std::map <uint32_t, PoolInfo>::const_iterator poolIt;
+  for (poolIt = m_sidelinkTxPoolsMap.begin (); poolIt != m_sidelinkTxPoolsMap.end (); poolIt++)
+    {
+      if (frameNo == poolIt->second.m_nextScPeriod.frameNo && subframeNo == poolIt->second.m_nextScPeriod.subframeNo)
+        {
+          return false;
+        }
+      std::list<SidelinkCommResourcePool::SidelinkTransmissionInfo>::const_iterator allocIt = poolIt->second.m_pscchTx.begin ();
+      if (allocIt != poolIt->second.m_pscchTx.end () && (*allocIt).subframe.frameNo == frameNo && (*allocIt).subframe.subframeNo == subframeNo)
+        {
+          return false;
+        }
+      allocIt = poolIt->second.m_psschTx.begin ();
+      if (allocIt != poolIt->second.m_psschTx.end () && (*allocIt).subframe.frameNo == frameNo && (*allocIt).subframe.subframeNo == subframeNo)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+LteUeMac::ExpireNotSensedSubframes (uint32_t frameNo, uint32_t subframeNo)
+{
+  int32_t now = (frameNo - 1) * 10 + (subframeNo - 1);
+  if (m_slLastSubframe >= 0 && !m_not_sensed_subframe.empty ())
+    {
+      // the marks are cleared one SC period ahead of the subframe, as in DoSubframeIndication
+      uint32_t windowLength = m_notSensedWindowLength;
+      int32_t nSkipped = (now - m_slLastSubframe - 1 + 10240) % 10240;
+      std::map <uint32_t, PoolInfo>::const_iterator poolIt;
+      for (poolIt = m_sidelinkTxPoolsMap.begin (); poolIt != m_sidelinkTxPoolsMap.end (); poolIt++)
+        {
+          uint32_t scPeriod = poolIt->second.m_pool->GetScPeriod ();
+          for (int32_t i = 1; i <= nSkipped && !m_not_sensed_subframe.empty (); i++)
+            {
+              m_not_sensed_subframe.erase (((m_slLastSubframe + i) % 10240 + scPeriod) % windowLength);
+            }
+        }
+    }
+  m_slLastSubframe = now;
+}
+
 void
 LteUeMac::DoAddSlDestination (uint32_t destination)
 {
@@ -26,6 +26,7 @@
 
 
 #include <map>
+#include <set>
 
 #include <ns3/lte-mac-sap.h>
 #include <ns3/lte-ue-cmac-sap.h>
@@ -36,6 +37,7 @@
 #include <vector>
 #include <ns3/packet.h>
 #include <ns3/packet-burst.h>
+#include <ns3/lte-sl-sps-reservation.h>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 
@@ -43,6 +45,7 @@
 namespace ns3 {
 
 class UniformRandomVariable;
+class LteSlResourceSelector;
 
 class LteUeMac :   public Object
 {
@@ -360,6 +363,23 @@ private:
    * Refresh HARQ processes packet buffer function
    */
   void RefreshHarqProcessesPacketBuffer (void);
+  /**
+   * Check if the Sidelink Tx pools have nothing to do in a subframe: no
+   * SC period starts and no PSCCH or PSSCH transmission is due
+   *
+   * \param frameNo The frame number, adjusted for the PUSCH delay
+   * \param subframeNo The subframe number, adjusted for the PUSCH delay
+   * \return true if the UE can stay in the sidelink-idle state
+   */
+  bool IsSidelinkIdle (uint32_t frameNo, uint32_t subframeNo) const;
+  /**
+   * Clear the not sensed marks of the subframes skipped in the
+   * sidelink-idle state, as if the pools had been walked every subframe
+   *
+   * \param frameNo The frame number, adjusted for the PUSCH delay
+   * \param subframeNo The subframe number, adjusted for the PUSCH delay
+   */
+  void ExpireNotSensedSubframes (uint32_t frameNo, uint32_t subframeNo);
 
   /// component carrier Id --> used to address sap
   uint8_t m_componentCarrierId;
@@ -368,7 +388,11 @@ private:
   bool m_first;
   bool m_TJAlgo;
   uint32_t m_changeProb;
-  std::vector<bool> m_not_sensed_subframe;
+  std::set<uint32_t> m_not_sensed_subframe; ///< slots of the sensing window in which the UE transmitted
+  uint32_t m_notSensedWindowLength; ///< length of the sensing window of m_not_sensed_subframe
+  int32_t m_slLastSubframe; ///< last subframe (0 to 10239) for which the pools were walked, -1 if none
+  bool m_slIdleFastPath; ///< skip the Sidelink pools while the UE is idle
+  bool m_slIdle; ///< true while the UE is in the sidelink-idle state
 
 private:
 
@@ -483,8 +507,7 @@ private:
     SidelinkGrantV2V m_nextGrantV2V;
     SidelinkGrantV2V m_prevGrantV2V;
 
-    uint32_t m_reserveCount;
-    uint32_t m_chosenSubframe;
+    LteSlSpsReservation m_sps; ///< Mode-4 semi-persistent reservation, holding the reselection counter
 
     std::list<SidelinkCommResourcePool::SidelinkTransmissionInfo> m_pscchTx; ///< List of PSCCH transmissions within the pool
     std::list<SidelinkCommResourcePool::SidelinkTransmissionInfo> m_psschTx; ///< List of PSSCH transmissions within the pool
@@ -505,6 +528,7 @@ private:
   Ptr<LteAmc> m_amc; ///< Pointer to LteAmc class; needed now since UE is doing scheduling
   Ptr<UniformRandomVariable> m_ueSelectedUniformVariable;  ///<  A uniform random variable used to choose random resources, RB start
                                                            ///<  and iTrp values in UE selected mode
+  Ptr<LteSlResourceSelector> m_resourceSelector; ///< Mode-4 resource selection policy
   //fields for fixed UE_SELECTED pools
   uint8_t m_slKtrp; ///< Number of active resource blocks in the TRP used.
   uint8_t m_setTrpIndex; ///< TRP index to be used
@@ -34,29 +34,15 @@ LteUePhySapUser::~LteUePhySapUser ()
 {
 }
 
-std::vector<std::vector<double>>
-LteUePhySapProvider::GetRssiMap ()
+const LteSlSensingWindow&
+LteUePhySapProvider::GetSensingWindow ()
 {
-  std::vector<std::vector<double>> temp;
-  return temp;
-}
-
-std::vector<std::vector<double>>
-LteUePhySapProvider::GetRsrpMap ()
-{
-  std::vector<std::vector<double>> temp;
-  return temp;
-}
-
-std::vector<std::vector<bool>>
-LteUePhySapProvider::GetDecodingMap ()
-{
-  std::vector<std::vector<bool>> temp;
-  return temp;
+  static LteSlSensingWindow emptyWindow;
+  return emptyWindow;
 }
 
 void
-LteUePhySapProvider::MoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod)
+LteUePhySapProvider::MoveSensingWindow (int64_t timeMs, uint32_t scPeriod)
 {
 }
 
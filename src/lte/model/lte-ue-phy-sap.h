@@ -25,6 +25,7 @@
 #define LTE_UE_PHY_SAP_H
 
 #include <ns3/packet.h>
+#include <ns3/lte-sl-sensing-window.h>
 
 namespace ns3 {
 
@@ -41,10 +42,18 @@ class LteUePhySapProvider
 public:
   virtual ~LteUePhySapProvider ();
 
-  virtual std::vector<std::vector<double>> GetRssiMap ();
-  virtual std::vector<std::vector<double>> GetRsrpMap ();
-  virtual std::vector<std::vector<bool>> GetDecodingMap ();
-  virtual void MoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod);
+  /**
+   * \brief Get the Mode-4 sensing window of the sidelink PHY
+   * \return A read-only view of the sensing window (no copy is made)
+   */
+  virtual const LteSlSensingWindow& GetSensingWindow ();
+  /**
+   * \brief Expire the sensing window up to the current subframe, including
+   * the subframes skipped while the MAC was idle
+   * \param timeMs The absolute time in milliseconds of the current subframe
+   * \param scPeriod The averaging period (SC period) in subframes
+   */
+  virtual void MoveSensingWindow (int64_t timeMs, uint32_t scPeriod);
   virtual std::vector<uint32_t> GetFeedbackProvidedResources (uint32_t subChannel, uint32_t subFrame, uint32_t nFeedback, uint32_t totalRU);
   virtual void SetNextTxTime (uint32_t txTime);
 
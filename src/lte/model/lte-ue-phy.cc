@@ -82,10 +82,8 @@ public:
    * \param phy the LTE UE Phy
    */
   UeMemberLteUePhySapProvider (LteUePhy* phy);
-  virtual std::vector<std::vector<double>> GetRssiMap ();
-  virtual std::vector<std::vector<double>> GetRsrpMap ();
-  virtual std::vector<std::vector<bool>> GetDecodingMap ();
-  virtual void MoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod);
+  virtual const LteSlSensingWindow& GetSensingWindow ();
+  virtual void MoveSensingWindow (int64_t timeMs, uint32_t scPeriod);
   virtual void SetNextTxTime (uint32_t txTime);
   virtual std::vector<uint32_t> GetFeedbackProvidedResources (uint32_t subChannel, uint32_t subFrame, uint32_t nFeedback, uint32_t totalRU);
 
@@ -106,22 +104,10 @@ UeMemberLteUePhySapProvider::UeMemberLteUePhySapProvider (LteUePhy* phy) : m_phy
 
 }
 
-std::vector<std::vector<double>>
-UeMemberLteUePhySapProvider::GetRssiMap ()
+const LteSlSensingWindow&
+UeMemberLteUePhySapProvider::GetSensingWindow ()
 {
-  return m_phy->DoGetRssiMap ();
-}
-
-std::vector<std::vector<double>>
-UeMemberLteUePhySapProvider::GetRsrpMap ()
-{
-  return m_phy->DoGetRsrpMap ();
-}
-
-std::vector<std::vector<bool>>
-UeMemberLteUePhySapProvider::GetDecodingMap ()
-{
-  return m_phy->DoGetDecodingMap ();
+  return m_phy->DoGetSensingWindow ();
 }
 
 
@@ -132,9 +118,9 @@ UeMemberLteUePhySapProvider::GetFeedbackProvidedResources (uint32_t subChannel,
 }
 
 void
-UeMemberLteUePhySapProvider::MoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod)
+UeMemberLteUePhySapProvider::MoveSensingWindow (int64_t timeMs, uint32_t scPeriod)
 {
-  m_phy->DoMoveSensingWindow (removeIdx, scPeriod);
+  m_phy->DoMoveSensingWindow (timeMs, scPeriod);
 }
 
 void
@@ -225,6 +211,8 @@ LteUePhy::LteUePhy (Ptr<LteSpectrumPhy> dlPhy, Ptr<LteSpectrumPhy> ulPhy)
     m_ueMeasurementsFilterPeriod (MilliSeconds (200)),
     m_ueMeasurementsFilterLast (MilliSeconds (0)),
     m_rsrpSinrSampleCounter (0),
+    m_nextFrameNo (0),
+    m_nextSubframeNo (0),
     m_tFirstScanning(MilliSeconds (0)),
     m_ueSlssScanningInProgress(false),
     m_ueSlssMeasurementInProgress(false),
@@ -277,6 +265,11 @@ LteUePhy::DoDispose ()
   NS_LOG_FUNCTION (this);
   delete m_uePhySapProvider;
   delete m_ueCphySapProvider;
+  if (m_subframeClock)
+    {
+      m_subframeClock->Unregister (this);
+      m_subframeClock = 0;
+    }
   if (m_sidelinkSpectrumPhy)
     {
       m_sidelinkSpectrumPhy->Dispose ();
@@ -447,6 +440,14 @@ LteUePhy::GetTypeId (void)
                   BooleanValue(false),
                   MakeBooleanAccessor(&LteUePhy::m_chooseFrameAndSubframeRandomly),
                   MakeBooleanChecker())
+    .AddAttribute ("SubframeClock",
+                   "Shared clock triggering the subframe indications of several UE PHYs "
+                   "from a single event per TTI. If null, each UE PHY schedules its own "
+                   "subframe indications. The subframe indications triggered by the clock "
+                   "run in the context of the clock event, not of the node of the UE.",
+                   PointerValue (),
+                   MakePointerAccessor (&LteUePhy::m_subframeClock),
+                   MakePointerChecker<LteUeSubframeClock> ())
     .AddAttribute ("MinSrsrp",
                    "The minimum S-RSRP required to consider a SyncRef detectable",
                    DoubleValue(-125),
@@ -492,7 +493,13 @@ LteUePhy::DoInitialize ()
           haveNodeId = true;
         }
     }
-  if (haveNodeId)
+  if (m_subframeClock)
+    {
+      m_nextFrameNo = frameNo;
+      m_nextSubframeNo = subframeNo;
+      m_subframeClock->Register (this);
+    }
+  else if (haveNodeId)
     {
       Simulator::ScheduleWithContext (nodeId, Seconds (0), &LteUePhy::SubframeIndication, this, frameNo, subframeNo);
     }
@@ -611,25 +618,11 @@ LteUePhy::GetSlSpectrumPhy () const
   return m_sidelinkSpectrumPhy;
 }
 
-std::vector<std::vector<double>>
-LteUePhy::DoGetRssiMap ()
-{
-  NS_LOG_FUNCTION (this);
-  return m_sidelinkSpectrumPhy->GetRssiMap();
-}
-
-std::vector<std::vector<double>>
-LteUePhy::DoGetRsrpMap ()
+const LteSlSensingWindow&
+LteUePhy::DoGetSensingWindow ()
 {
   NS_LOG_FUNCTION (this);
-  return m_sidelinkSpectrumPhy->GetRsrpMap();
-}
-
-std::vector<std::vector<bool>>
-LteUePhy::DoGetDecodingMap ()
-{
-  NS_LOG_FUNCTION (this);
-  return m_sidelinkSpectrumPhy->GetDecodingMap();
+  return m_sidelinkSpectrumPhy->GetSensingWindow ();
 }
 
 std::vector<uint32_t>
@@ -640,9 +633,9 @@ LteUePhy::DoGetFeedbackProvidedResources (uint32_t subChannel, uint32_t subFrame
 }
 
 void
-LteUePhy::DoMoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod)
+LteUePhy::DoMoveSensingWindow (int64_t timeMs, uint32_t scPeriod)
 {
-  m_sidelinkSpectrumPhy->MoveSensingWindow (removeIdx, scPeriod);
+  m_sidelinkSpectrumPhy->MoveSensingWindow (timeMs, scPeriod);
 }
 
 void
@@ -2168,7 +2161,21 @@ LteUePhy::SubframeIndication (uint32_t frameNo, uint32_t subframeNo)
     }
 
   // schedule next subframe indication
-  Simulator::Schedule (Seconds (GetTti ()), &LteUePhy::SubframeIndication, this, frameNo, subframeNo);
+  if (m_subframeClock)
+    {
+      m_nextFrameNo = frameNo;
+      m_nextSubframeNo = subframeNo;
+    }
+  else
+    {
+      Simulator::Schedule (Seconds (GetTti ()), &LteUePhy::SubframeIndication, this, frameNo, subframeNo);
+    }
+}
+
+void
+LteUePhy::TriggerSubframeIndication ()
+{
+  SubframeIndication (m_nextFrameNo, m_nextSubframeNo);
 }
 
 
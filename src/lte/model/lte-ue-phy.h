@@ -35,6 +35,7 @@
 #include <ns3/lte-amc.h>
 #include <set>
 #include <ns3/lte-ue-power-control.h>
+#include <ns3/lte-ue-subframe-clock.h>
 
 
 namespace ns3 {
@@ -254,6 +255,12 @@ public:
   */
   void SubframeIndication (uint32_t frameNo, uint32_t subframeNo);
 
+  /**
+   * \brief Trigger the next subframe indication, when the subframes are
+   * driven by a shared LteUeSubframeClock
+   */
+  void TriggerSubframeIndication ();
+
 
   /**
    * \brief Send the SRS signal in the last symbols of the frame
@@ -578,10 +585,8 @@ private:
     void DoRemoveSlDestination (uint32_t destination);
 
   // UE PHY SAP methods 
-  virtual std::vector<std::vector<double>> DoGetRssiMap ();
-  virtual std::vector<std::vector<double>> DoGetRsrpMap ();
-  virtual std::vector<std::vector<bool>> DoGetDecodingMap ();
-  virtual void DoMoveSensingWindow (uint32_t removeIdx, uint32_t scPeriod);
+  virtual const LteSlSensingWindow& DoGetSensingWindow ();
+  virtual void DoMoveSensingWindow (int64_t timeMs, uint32_t scPeriod);
   virtual void DoSetNextTxTime (uint32_t txTime);
   virtual std::vector<uint32_t> DoGetFeedbackProvidedResources (uint32_t subChannel, uint32_t subFrame, uint32_t nFeedback, uint32_t totalRU);
   virtual void DoSendMacPdu (Ptr<Packet> p);
@@ -777,6 +782,14 @@ private:
    */
   bool m_chooseFrameAndSubframeRandomly;
 
+  /**
+   * Shared clock triggering the subframe indications, if any; otherwise
+   * the PHY schedules its own subframe indication every TTI
+   */
+  Ptr<LteUeSubframeClock> m_subframeClock;
+  uint32_t m_nextFrameNo; ///< frame number of the next subframe indication triggered by the clock
+  uint32_t m_nextSubframeNo; ///< subframe number of the next subframe indication triggered by the clock
+
 struct SidelinkGrantV2V
 {
   uint16_t m_rnti;
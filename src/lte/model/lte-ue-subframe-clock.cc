@@ -0,0 +1,126 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "lte-ue-subframe-clock.h"
+#include "lte-ue-phy.h"
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LteUeSubframeClock");
+
+NS_OBJECT_ENSURE_REGISTERED (LteUeSubframeClock);
+
+TypeId
+LteUeSubframeClock::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LteUeSubframeClock")
+    .SetParent<Object> ()
+    .SetGroupName ("Lte")
+    .AddConstructor<LteUeSubframeClock> ()
+    .AddAttribute ("Period",
+                   "Time between two subframe indications (TTI).",
+                   TimeValue (MilliSeconds (1)),
+                   MakeTimeAccessor (&LteUeSubframeClock::m_period),
+                   MakeTimeChecker (NanoSeconds (1)))
+  ;
+  return tid;
+}
+
+LteUeSubframeClock::LteUeSubframeClock ()
+  : m_ticking (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LteUeSubframeClock::~LteUeSubframeClock ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LteUeSubframeClock::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_tickEvent.Cancel ();
+  m_phys.clear ();
+  Object::DoDispose ();
+}
+
+void
+LteUeSubframeClock::Register (LteUePhy *phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  NS_ASSERT (std::find (m_phys.begin (), m_phys.end (), phy) == m_phys.end ());
+  m_phys.push_back (phy);
+  if (!m_tickEvent.IsRunning () && !m_ticking)
+    {
+      m_tickEvent = Simulator::ScheduleNow (&LteUeSubframeClock::Tick, this);
+    }
+}
+
+void
+LteUeSubframeClock::Unregister (LteUePhy *phy)
+{
+  NS_LOG_FUNCTION (this << phy);
+  std::vector<LteUePhy*>::iterator it = std::find (m_phys.begin (), m_phys.end (), phy);
+  if (it == m_phys.end ())
+    {
+      return;
+    }
+  if (m_ticking)
+    {
+      // removed at the end of the tick, so that the indices stay valid
+      *it = 0;
+    }
+  else
+    {
+      m_phys.erase (it);
+    }
+}
+
+uint32_t
+LteUeSubframeClock::GetNPhys (void) const
+{
+  return m_phys.size () - std::count (m_phys.begin (), m_phys.end (), (LteUePhy*) 0);
+}
+
+void
+LteUeSubframeClock::Tick (void)
+{
+  NS_LOG_FUNCTION (this << m_phys.size ());
+  m_ticking = true;
+  // PHYs registered during the tick are at the end and triggered too;
+  // all of them run in the context of this event (see class doc)
+  for (uint32_t i = 0; i < m_phys.size (); i++)
+    {
+      if (m_phys[i] != 0)
+        {
+          m_phys[i]->TriggerSubframeIndication ();
+        }
+    }
+  m_ticking = false;
+  m_phys.erase (std::remove (m_phys.begin (), m_phys.end (), (LteUePhy*) 0), m_phys.end ());
+
+  if (!m_phys.empty ())
+    {
+      m_tickEvent = Simulator::Schedule (m_period, &LteUeSubframeClock::Tick, this);
+    }
+}
+
+} // namespace ns3
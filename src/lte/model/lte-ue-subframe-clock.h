@@ -0,0 +1,98 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LTE_UE_SUBFRAME_CLOCK_H
+#define LTE_UE_SUBFRAME_CLOCK_H
+
+#include <ns3/object.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <vector>
+
+namespace ns3 {
+
+class LteUePhy;
+
+/**
+ * \ingroup lte
+ *
+ * Subframe clock shared by several UE PHYs. Instead of each LteUePhy
+ * scheduling its own subframe indication every TTI, the PHYs configured
+ * with a clock (LteUePhy::SubframeClock attribute) register with it and
+ * the clock triggers the subframe indication of all of them, in
+ * registration order, from a single event per TTI.
+ *
+ * Each PHY keeps its own frame and subframe numbers, so random initial
+ * numbers and SLSS (re)synchronization behave as with separate events.
+ * A PHY registered after the tick of the current time has been processed
+ * receives its first subframe indication at the next tick.
+ *
+ * The subframe indications are processed in the context of the clock
+ * event, not in the context of the node of each PHY: Simulator::GetContext
+ * and the node id prefix of the log messages are those of the clock
+ * during the subframe processing of the PHY, MAC and RRC, and the events
+ * they schedule inherit that context. Scheduling one event per PHY with
+ * Simulator::ScheduleWithContext would restore the contexts at the cost
+ * of the events the clock saves, so the clock should not be used when
+ * the context matters, e.g., with the distributed simulator.
+ */
+class LteUeSubframeClock : public Object
+{
+public:
+  LteUeSubframeClock ();
+  virtual ~LteUeSubframeClock ();
+
+  /**
+   * \brief Get the type ID.
+   * \return The object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Add a PHY to the PHYs triggered by the clock. The first tick is
+   * scheduled now if the clock is not running yet.
+   * \param phy The PHY
+   */
+  void Register (LteUePhy *phy);
+
+  /**
+   * Remove a PHY from the PHYs triggered by the clock
+   * \param phy The PHY
+   */
+  void Unregister (LteUePhy *phy);
+
+  /// \return The number of PHYs triggered by the clock
+  uint32_t GetNPhys (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Trigger the subframe indication of every registered PHY and
+   * schedule the next tick
+   */
+  void Tick (void);
+
+  Time m_period; ///< time between two ticks
+  std::vector<LteUePhy*> m_phys; ///< registered PHYs; null while unregistered during a tick
+  bool m_ticking; ///< true while the PHYs are being triggered
+  EventId m_tickEvent; ///< next tick
+};
+
+} // namespace ns3
+
+#endif /* LTE_UE_SUBFRAME_CLOCK_H */
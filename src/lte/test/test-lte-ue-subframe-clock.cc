@@ -0,0 +1,230 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/pointer.h>
+#include <ns3/lte-ue-phy.h>
+#include <ns3/lte-ue-phy-sap.h>
+#include <ns3/lte-spectrum-phy.h>
+#include <ns3/lte-ue-subframe-clock.h>
+#include <vector>
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE ("TestLteUeSubframeClock");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief MAC side of the UE PHY SAP recording the subframe indications
+ */
+class LteUeSubframeClockTestMac : public LteUePhySapUser
+{
+public:
+  /// Subframe indication received by a MAC
+  struct Indication
+  {
+    int64_t time; ///< time of the indication (ns)
+    uint32_t mac; ///< index of the MAC
+    uint32_t frameNo; ///< frame number
+    uint32_t subframeNo; ///< subframe number
+
+    /**
+     * \param other The other indication
+     * \return True if both indications are the same
+     */
+    bool operator== (const Indication &other) const
+    {
+      return time == other.time && mac == other.mac
+             && frameNo == other.frameNo && subframeNo == other.subframeNo;
+    }
+  };
+
+  /**
+   * Constructor
+   * \param index The index of the MAC
+   * \param indications The list where the indications are recorded
+   */
+  LteUeSubframeClockTestMac (uint32_t index, std::vector<Indication> *indications);
+
+  // inherited from LteUePhySapUser
+  virtual void ReceivePhyPdu (Ptr<Packet> p);
+  virtual void SubframeIndication (uint32_t frameNo, uint32_t subframeNo);
+  virtual void ReceiveLteControlMessage (Ptr<LteControlMessage> msg);
+  virtual void NotifyChangeOfTiming (uint32_t frameNo, uint32_t subframeNo);
+  virtual void NotifySidelinkEnabled ();
+
+private:
+  uint32_t m_index; ///< index of the MAC
+  std::vector<Indication> *m_indications; ///< recorded indications
+};
+
+LteUeSubframeClockTestMac::LteUeSubframeClockTestMac (uint32_t index, std::vector<Indication> *indications)
+  : m_index (index),
+    m_indications (indications)
+{
+}
+
+void
+LteUeSubframeClockTestMac::ReceivePhyPdu (Ptr<Packet> p)
+{
+}
+
+void
+LteUeSubframeClockTestMac::SubframeIndication (uint32_t frameNo, uint32_t subframeNo)
+{
+  Indication indication;
+  indication.time = Simulator::Now ().GetNanoSeconds ();
+  indication.mac = m_index;
+  indication.frameNo = frameNo;
+  indication.subframeNo = subframeNo;
+  m_indications->push_back (indication);
+}
+
+void
+LteUeSubframeClockTestMac::ReceiveLteControlMessage (Ptr<LteControlMessage> msg)
+{
+}
+
+void
+LteUeSubframeClockTestMac::NotifyChangeOfTiming (uint32_t frameNo, uint32_t subframeNo)
+{
+}
+
+void
+LteUeSubframeClockTestMac::NotifySidelinkEnabled ()
+{
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that UE PHYs driven by a shared LteUeSubframeClock deliver
+ * the same subframe indications, at the same times and with the same
+ * frame and subframe numbers, as UE PHYs scheduling their own.
+ */
+class LteUeSubframeClockTestCase : public TestCase
+{
+public:
+  LteUeSubframeClockTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Run a few UE PHYs started at different times
+   * \param useClock True to drive the PHYs with a shared clock
+   * \return The subframe indications received by the MACs, sorted by
+   *         time and MAC
+   */
+  std::vector<LteUeSubframeClockTestMac::Indication> Run (bool useClock);
+};
+
+LteUeSubframeClockTestCase::LteUeSubframeClockTestCase ()
+  : TestCase ("Subframe indications of the shared clock and of the per-UE events")
+{
+}
+
+/**
+ * \param a An indication
+ * \param b Another indication
+ * \return True if a is before b in time, then in MAC index
+ */
+static bool
+IndicationBefore (const LteUeSubframeClockTestMac::Indication &a, const LteUeSubframeClockTestMac::Indication &b)
+{
+  return a.time < b.time || (a.time == b.time && a.mac < b.mac);
+}
+
+std::vector<LteUeSubframeClockTestMac::Indication>
+LteUeSubframeClockTestCase::Run (bool useClock)
+{
+  const uint32_t nPhys = 4;
+  std::vector<LteUeSubframeClockTestMac::Indication> indications;
+  std::vector<LteUeSubframeClockTestMac *> macs;
+  std::vector<Ptr<LteUePhy> > phys;
+  Ptr<LteUeSubframeClock> clock = CreateObject<LteUeSubframeClock> ();
+  for (uint32_t i = 0; i < nPhys; i++)
+    {
+      Ptr<LteUePhy> phy = CreateObject<LteUePhy> (CreateObject<LteSpectrumPhy> (), CreateObject<LteSpectrumPhy> ());
+      if (useClock)
+        {
+          phy->SetAttribute ("SubframeClock", PointerValue (clock));
+        }
+      macs.push_back (new LteUeSubframeClockTestMac (i, &indications));
+      phy->SetLteUePhySapUser (macs.back ());
+      // the PHYs started later register with a running clock
+      Simulator::Schedule (MilliSeconds (3 * i), &LteUePhy::Initialize, phy);
+      phys.push_back (phy);
+    }
+
+  // stop before the first UE measurement report, that needs an RRC
+  Simulator::Stop (MilliSeconds (50));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < nPhys; i++)
+    {
+      phys[i]->Dispose ();
+      delete macs[i];
+    }
+  clock->Dispose ();
+  Simulator::Destroy ();
+
+  std::stable_sort (indications.begin (), indications.end (), IndicationBefore);
+  return indications;
+}
+
+void
+LteUeSubframeClockTestCase::DoRun (void)
+{
+  std::vector<LteUeSubframeClockTestMac::Indication> perUe = Run (false);
+  std::vector<LteUeSubframeClockTestMac::Indication> shared = Run (true);
+
+  NS_TEST_ASSERT_MSG_EQ (perUe.size (), 50 + 47 + 44 + 41, "Wrong number of per-UE indications");
+  NS_TEST_ASSERT_MSG_EQ (shared.size (), perUe.size (), "Different number of indications");
+  for (uint32_t i = 0; i < perUe.size () && i < shared.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((shared[i] == perUe[i]), true,
+                             "Indication " << i << " differs: " << shared[i].time << " " << shared[i].mac
+                             << " " << shared[i].frameNo << "/" << shared[i].subframeNo << " instead of "
+                             << perUe[i].time << " " << perUe[i].mac << " "
+                             << perUe[i].frameNo << "/" << perUe[i].subframeNo);
+    }
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Shared UE subframe clock test suite
+ */
+class LteUeSubframeClockTestSuite : public TestSuite
+{
+public:
+  LteUeSubframeClockTestSuite ();
+};
+
+LteUeSubframeClockTestSuite::LteUeSubframeClockTestSuite ()
+  : TestSuite ("lte-ue-subframe-clock", UNIT)
+{
+  AddTestCase (new LteUeSubframeClockTestCase (), TestCase::QUICK);
+}
+
+static LteUeSubframeClockTestSuite staticLteUeSubframeClockTestSuite;
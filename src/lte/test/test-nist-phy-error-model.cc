@@ -171,6 +171,76 @@ LteNistPhyErrorModelTestCase::DoRun ()
 }
 
 
+/**
+ * Test the BLER of the dense tables against the interpolation of the
+ * BLER curves in the linear SINR, and the batch lookup against the
+ * lookup of each TB.
+ */
+class LteNistBlerTableTestCase : public TestCase
+{
+public:
+  LteNistBlerTableTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LteNistBlerTableTestCase::LteNistBlerTableTestCase ()
+  : TestCase ("Dense BLER tables and batch lookup")
+{
+}
+
+void
+LteNistBlerTableTestCase::DoRun ()
+{
+  //first points of the PSCCH curve, from -6.2 dB every 0.2 dB
+  const double pscchBler[] = {1, 0.9883, 0.9784, 0.9721, 0.9631, 0.9517};
+  std::vector<double> sinr;
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      double sinr1 = std::pow (10, (-6.2 + i * 0.2) / 10);
+      double sinr2 = std::pow (10, (-6.2 + (i + 1) * 0.2) / 10);
+      for (uint32_t j = 0; j < 20; j++)
+        {
+          double sinrDb = -6.2 + i * 0.2 + j * 0.01 + 0.003;
+          double s = std::pow (10, sinrDb / 10);
+          double expected = pscchBler[i] + (pscchBler[i + 1] - pscchBler[i]) * (s - sinr1) / (sinr2 - sinr1);
+          double bler = LteNistErrorModel::GetPscchBler (LteNistErrorModel::AWGN, LteNistErrorModel::SISO, s).tbler;
+          NS_TEST_EXPECT_MSG_EQ_TOL (bler, expected, 1e-4, "wrong PSCCH BLER at " << sinrDb << " dB");
+          sinr.push_back (s);
+        }
+    }
+  sinr.push_back (std::pow (10, -7.0 / 10));
+  sinr.push_back (std::pow (10, 2.0 / 10));
+
+  std::vector<double> bler;
+  LteNistErrorModel::GetPscchBler (LteNistErrorModel::AWGN, LteNistErrorModel::SISO, sinr, bler);
+  NS_TEST_ASSERT_MSG_EQ (bler.size (), sinr.size (), "wrong number of PSCCH BLER values");
+  for (uint32_t i = 0; i < sinr.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (bler[i], LteNistErrorModel::GetPscchBler (LteNistErrorModel::AWGN, LteNistErrorModel::SISO, sinr[i]).tbler, "wrong batch PSCCH BLER " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (bler[bler.size () - 2], 1, "wrong PSCCH BLER below the curve");
+  NS_TEST_EXPECT_MSG_EQ (bler[bler.size () - 1], 0, "wrong PSCCH BLER above the curve");
+
+  HarqProcessInfoList_t harqInfoList;
+  std::vector<uint16_t> mcs;
+  sinr.clear ();
+  for (uint16_t m = 0; m <= 20; m++)
+    {
+      for (double sinrDb = -15; sinrDb < 25; sinrDb += 0.37)
+        {
+          mcs.push_back (m);
+          sinr.push_back (std::pow (10, sinrDb / 10));
+        }
+    }
+  LteNistErrorModel::GetPsschBler (LteNistErrorModel::AWGN, LteNistErrorModel::SISO, mcs, sinr, bler);
+  NS_TEST_ASSERT_MSG_EQ (bler.size (), sinr.size (), "wrong number of PSSCH BLER values");
+  for (uint32_t i = 0; i < sinr.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (bler[i], LteNistErrorModel::GetPsschBler (LteNistErrorModel::AWGN, LteNistErrorModel::SISO, mcs[i], sinr[i], harqInfoList).tbler, "wrong batch PSSCH BLER " << i);
+    }
+}
 
 
 class LteNistPhyErrorModelTestSuite : public TestSuite
@@ -223,6 +293,8 @@ LteNistPhyErrorModelTestSuite::LteNistPhyErrorModelTestSuite ()
 
   AddTestCase (new LteNistPhyErrorModelTestCase (LteNistErrorModel::PSCCH, LteNistErrorModel::AWGN, LteNistErrorModel::SISO, 0, std::pow (10, (2 / 10.0)),  harqInfoList, 0,    EQUAL), TestCase::QUICK);
 
+  AddTestCase (new LteNistBlerTableTestCase (), TestCase::QUICK);
+
 }
 
 static LteNistPhyErrorModelTestSuite staticLteNistPhyErrorModelTestSuiteInstance;
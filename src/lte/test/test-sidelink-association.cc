@@ -0,0 +1,223 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/double.h>
+#include <ns3/node-container.h>
+#include <ns3/net-device-container.h>
+#include <ns3/mobility-helper.h>
+#include <ns3/position-allocator.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/lte-helper.h>
+#include <ns3/lte-sidelink-helper.h>
+#include <map>
+#include <set>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkAssociation");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the association methods of LteSidelinkHelper select
+ * the same receivers as a brute force search over all the pairs, with and
+ * without the MaxAssociationDistance limit. The UEs are a random layout
+ * plus UEs on the boundaries of the grid cells of the association index,
+ * some of them exactly at the maximum distance of each other.
+ */
+class SidelinkAssociationTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param maxDistance The maximum association distance, 0 to disable it
+   */
+  SidelinkAssociationTestCase (double maxDistance);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Build the name of the test case
+   * \param maxDistance The maximum association distance
+   * \return The name
+   */
+  static std::string BuildNameString (double maxDistance);
+
+  /**
+   * Check the groups created by an association method
+   * \param method The name of the association method
+   * \param groups The groups, each one starting with its transmitter
+   * \param txCanReceive True if the transmitters may be receivers of the other groups
+   */
+  void CheckGroups (std::string method, const std::vector<NetDeviceContainer> &groups, bool txCanReceive);
+
+  double m_maxDistance; ///< maximum association distance
+  std::vector<Vector> m_positions; ///< position of each UE
+  std::map<Ptr<NetDevice>, uint32_t> m_ueIndex; ///< index of each UE device
+};
+
+SidelinkAssociationTestCase::SidelinkAssociationTestCase (double maxDistance)
+  : TestCase (BuildNameString (maxDistance)),
+    m_maxDistance (maxDistance)
+{
+}
+
+std::string
+SidelinkAssociationTestCase::BuildNameString (double maxDistance)
+{
+  std::ostringstream oss;
+  oss << "Sidelink association with MaxAssociationDistance " << maxDistance;
+  return oss.str ();
+}
+
+void
+SidelinkAssociationTestCase::CheckGroups (std::string method, const std::vector<NetDeviceContainer> &groups, bool txCanReceive)
+{
+  std::set<uint32_t> transmitters;
+  for (uint32_t g = 0; g < groups.size (); g++)
+    {
+      transmitters.insert (m_ueIndex[groups[g].Get (0)]);
+    }
+  for (uint32_t g = 0; g < groups.size (); g++)
+    {
+      uint32_t tx = m_ueIndex[groups[g].Get (0)];
+      std::set<uint32_t> receivers;
+      for (uint32_t i = 1; i < groups[g].GetN (); i++)
+        {
+          receivers.insert (m_ueIndex[groups[g].Get (i)]);
+        }
+      NS_TEST_ASSERT_MSG_EQ (receivers.size (), groups[g].GetN () - 1, method << ": duplicate receivers in group " << g);
+
+      std::set<uint32_t> expected;
+      for (uint32_t rx = 0; rx < m_positions.size (); rx++)
+        {
+          if (rx == tx || (!txCanReceive && transmitters.count (rx) > 0))
+            {
+              continue;
+            }
+          if (m_maxDistance <= 0 || CalculateDistance (m_positions[tx], m_positions[rx]) <= m_maxDistance)
+            {
+              expected.insert (rx);
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ ((receivers == expected), true,
+                             method << ": group of UE " << tx << " has " << receivers.size ()
+                             << " receivers instead of " << expected.size ());
+    }
+}
+
+void
+SidelinkAssociationTestCase::DoRun (void)
+{
+  // UEs on the boundaries of the grid cells, and at exactly the maximum
+  // distance from each other across a boundary
+  double d = m_maxDistance > 0 ? m_maxDistance : 50.0;
+  m_positions.clear ();
+  m_positions.push_back (Vector (0, 0, 1.5));
+  m_positions.push_back (Vector (d, 0, 1.5));
+  m_positions.push_back (Vector (2 * d, 0, 1.5));
+  m_positions.push_back (Vector (-d, 0, 1.5));
+  m_positions.push_back (Vector (0, d, 1.5));
+  m_positions.push_back (Vector (0, -d, 1.5));
+  m_positions.push_back (Vector (d, d, 1.5));
+  m_positions.push_back (Vector (-d, -d, 1.5));
+  m_positions.push_back (Vector (d - 1e-6, d - 1e-6, 1.5));
+  m_positions.push_back (Vector (2 * d, -d, 1.5));
+  m_positions.push_back (Vector (3 * d, 0, 1.5));
+  m_positions.push_back (Vector (-1e-6, 0, 1.5));
+
+  // random layout over several cells, including negative coordinates
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  const uint32_t nRandomUes = 200;
+  for (uint32_t i = 0; i < nRandomUes; i++)
+    {
+      m_positions.push_back (Vector (random->GetValue (-6 * d, 6 * d), random->GetValue (-6 * d, 6 * d), 1.5));
+    }
+
+  NodeContainer ueNodes;
+  ueNodes.Create (m_positions.size ());
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  for (uint32_t i = 0; i < m_positions.size (); i++)
+    {
+      positionAlloc->Add (m_positions[i]);
+    }
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.Install (ueNodes);
+
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetAttribute ("UseSidelink", BooleanValue (true));
+  lteHelper->SetV2VMode (true);
+  lteHelper->SetRbPerSubChannel (10);
+  lteHelper->Initialize ();
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  m_ueIndex.clear ();
+  for (uint32_t i = 0; i < ueDevs.GetN (); i++)
+    {
+      m_ueIndex[ueDevs.Get (i)] = i;
+    }
+
+  Ptr<LteSidelinkHelper> proseHelper = CreateObject<LteSidelinkHelper> ();
+  proseHelper->SetLteHelper (lteHelper);
+  proseHelper->SetAttribute ("MaxAssociationDistance", DoubleValue (m_maxDistance));
+  proseHelper->AssignStreams (1);
+
+  double txPower = 23.0;
+  double ulEarfcn = 18100;
+  double ulBandwidth = 50;
+  // every UE is a transmitter, so that every grid cell is searched
+  std::vector<NetDeviceContainer> groups = proseHelper->AssociateForBroadcastWithTxEnabledToReceive (txPower, ulEarfcn, ulBandwidth, ueDevs, -1e9, ueDevs.GetN (), LteSidelinkHelper::SLRSRP_TX_PW);
+  NS_TEST_ASSERT_MSG_EQ (groups.size (), ueDevs.GetN (), "Wrong number of groups");
+  CheckGroups ("AssociateForBroadcastWithTxEnabledToReceive", groups, true);
+
+  // with a threshold below any RSRP, the receivers are the UEs in range
+  groups = proseHelper->AssociateForBroadcast (txPower, ulEarfcn, ulBandwidth, ueDevs, -1e9, 20, LteSidelinkHelper::SLRSRP_TX_PW);
+  NS_TEST_ASSERT_MSG_EQ (groups.size (), 20, "Wrong number of groups");
+  CheckGroups ("AssociateForBroadcast", groups, false);
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink association test suite
+ */
+class SidelinkAssociationTestSuite : public TestSuite
+{
+public:
+  SidelinkAssociationTestSuite ();
+};
+
+SidelinkAssociationTestSuite::SidelinkAssociationTestSuite ()
+  : TestSuite ("sidelink-association", UNIT)
+{
+  AddTestCase (new SidelinkAssociationTestCase (0), TestCase::QUICK);
+  AddTestCase (new SidelinkAssociationTestCase (50), TestCase::QUICK);
+  AddTestCase (new SidelinkAssociationTestCase (120), TestCase::QUICK);
+}
+
+static SidelinkAssociationTestSuite staticSidelinkAssociationTestSuite;
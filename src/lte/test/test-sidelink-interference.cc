@@ -0,0 +1,168 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lte-sl-interference.h"
+#include "ns3/lte-sl-chunk-processor.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/spectrum-value.h>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkInterference");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test the SINR, SNR and interference computed by LteSlInterference
+ * for two simultaneous signals, over two chunks, against the
+ * SpectrumValue arithmetic.
+ */
+class SidelinkInterferenceTestCase : public TestCase
+{
+public:
+  SidelinkInterferenceTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Store the values reported by a chunk processor
+   * \param result Where to store the values
+   * \param values The values reported
+   */
+  static void Report (std::vector<SpectrumValue> *result, std::vector<SpectrumValue> values);
+
+  /**
+   * Check that two values are equal
+   * \param actual The actual value
+   * \param expected The expected value
+   * \param msg The message of the failure
+   */
+  void CheckValue (const SpectrumValue &actual, const SpectrumValue &expected, std::string msg);
+};
+
+SidelinkInterferenceTestCase::SidelinkInterferenceTestCase ()
+  : TestCase ("Sidelink SINR chunk evaluation")
+{
+}
+
+void
+SidelinkInterferenceTestCase::Report (std::vector<SpectrumValue> *result, std::vector<SpectrumValue> values)
+{
+  *result = values;
+}
+
+void
+SidelinkInterferenceTestCase::CheckValue (const SpectrumValue &actual, const SpectrumValue &expected, std::string msg)
+{
+  Values::const_iterator a = actual.ConstValuesBegin ();
+  for (Values::const_iterator e = expected.ConstValuesBegin (); e != expected.ConstValuesEnd (); ++e, ++a)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (*a, *e, std::abs (*e) * 1e-12, msg);
+    }
+}
+
+void
+SidelinkInterferenceTestCase::DoRun (void)
+{
+  std::vector<double> freqs;
+  for (uint32_t rb = 0; rb < 6; rb++)
+    {
+      freqs.push_back (2e9 + rb * 180e3);
+    }
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+
+  Ptr<SpectrumValue> noise = Create<SpectrumValue> (model);
+  Ptr<SpectrumValue> signal1 = Create<SpectrumValue> (model);
+  Ptr<SpectrumValue> signal2 = Create<SpectrumValue> (model);
+  Ptr<SpectrumValue> interferer = Create<SpectrumValue> (model);
+  for (uint32_t rb = 0; rb < 6; rb++)
+    {
+      (*noise)[rb] = 1e-20 * (rb + 1);
+      (*signal1)[rb] = rb < 3 ? 1e-17 * (rb + 1) : 0.0;
+      (*signal2)[rb] = rb >= 2 ? 3e-18 * (rb + 1) : 0.0;
+      (*interferer)[rb] = 5e-19;
+    }
+
+  Ptr<LteSlInterference> interference = CreateObject<LteSlInterference> ();
+  interference->SetNoisePowerSpectralDensity (noise);
+  std::vector<SpectrumValue> sinr, snr, interf, power;
+  Ptr<LteSlChunkProcessor> sinrProcessor = Create<LteSlChunkProcessor> ();
+  sinrProcessor->AddCallback (MakeBoundCallback (&SidelinkInterferenceTestCase::Report, &sinr));
+  interference->AddSinrChunkProcessor (sinrProcessor);
+  Ptr<LteSlChunkProcessor> snrProcessor = Create<LteSlChunkProcessor> ();
+  snrProcessor->AddCallback (MakeBoundCallback (&SidelinkInterferenceTestCase::Report, &snr));
+  interference->AddSnrChunkProcessor (snrProcessor);
+  Ptr<LteSlChunkProcessor> interfProcessor = Create<LteSlChunkProcessor> ();
+  interfProcessor->AddCallback (MakeBoundCallback (&SidelinkInterferenceTestCase::Report, &interf));
+  interference->AddInterferenceChunkProcessor (interfProcessor);
+  Ptr<LteSlChunkProcessor> powerProcessor = Create<LteSlChunkProcessor> ();
+  powerProcessor->AddCallback (MakeBoundCallback (&SidelinkInterferenceTestCase::Report, &power));
+  interference->AddRsPowerChunkProcessor (powerProcessor);
+
+  // two receptions, the interferer is only present during the first quarter
+  Time duration = MilliSeconds (1);
+  interference->AddSignal (signal1, duration);
+  interference->AddSignal (signal2, duration);
+  interference->AddSignal (interferer, duration / 4);
+  interference->StartRx (signal1);
+  interference->StartRx (signal2);
+  Simulator::Schedule (duration, &LteSlInterference::EndRx, interference);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (sinr.size (), 2, "Wrong number of SINR values");
+  NS_TEST_ASSERT_MSG_EQ (snr.size (), 2, "Wrong number of SNR values");
+  NS_TEST_ASSERT_MSG_EQ (interf.size (), 2, "Wrong number of interference values");
+  NS_TEST_ASSERT_MSG_EQ (power.size (), 2, "Wrong number of power values");
+
+  Ptr<SpectrumValue> signals[2] = {signal1, signal2};
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      SpectrumValue interfWith = (*signal1) + (*signal2) + (*interferer) - (*signals[i]) + (*noise);
+      SpectrumValue interfWithout = (*signal1) + (*signal2) - (*signals[i]) + (*noise);
+      SpectrumValue expectedSinr = ((*signals[i]) / interfWith * 0.25) + ((*signals[i]) / interfWithout * 0.75);
+      SpectrumValue expectedInterf = (interfWith * 0.25) + (interfWithout * 0.75);
+      CheckValue (sinr[i], expectedSinr, "Wrong SINR");
+      CheckValue (snr[i], (*signals[i]) / (*noise), "Wrong SNR");
+      CheckValue (interf[i], expectedInterf, "Wrong interference");
+      CheckValue (power[i], *signals[i], "Wrong signal power");
+    }
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink interference test suite
+ */
+class SidelinkInterferenceTestSuite : public TestSuite
+{
+public:
+  SidelinkInterferenceTestSuite ();
+};
+
+SidelinkInterferenceTestSuite::SidelinkInterferenceTestSuite ()
+  : TestSuite ("sidelink-interference", UNIT)
+{
+  AddTestCase (new SidelinkInterferenceTestCase (), TestCase::QUICK);
+}
+
+static SidelinkInterferenceTestSuite staticSidelinkInterferenceTestSuite;
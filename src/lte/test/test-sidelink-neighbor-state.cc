@@ -0,0 +1,276 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/config.h>
+#include <ns3/node-container.h>
+#include <ns3/net-device-container.h>
+#include <ns3/mobility-helper.h>
+#include <ns3/position-allocator.h>
+#include <ns3/internet-stack-helper.h>
+#include <ns3/ipv4-static-routing-helper.h>
+#include <ns3/ipv4.h>
+#include <ns3/point-to-point-epc-helper.h>
+#include <ns3/udp-client-server-helper.h>
+#include <ns3/application-container.h>
+#include <ns3/lte-helper.h>
+#include <ns3/lte-sidelink-helper.h>
+#include <ns3/lte-sl-tft.h>
+#include <ns3/lte-sl-ue-rrc.h>
+#include <ns3/lte-sl-preconfig-pool-factory.h>
+#include <ns3/lte-ue-net-device.h>
+#include <ns3/lte-ue-phy.h>
+#include <ns3/lte-spectrum-phy.h>
+#include <map>
+#include <utility>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkNeighborState");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the PSCCH reception metrics (message interval and
+ * consecutive misses) are kept per transmitter, even when transmitters
+ * share their RNTI: several out of coverage V2V UEs, installed in two
+ * groups, broadcast to each other, and each receiver recomputes the
+ * metrics of every transmitter, identified by its position, from the
+ * sequence of receptions reported by the SlPscchReception trace.
+ */
+class SidelinkNeighborStateTestCase : public TestCase
+{
+public:
+  SidelinkNeighborStateTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// The position of a transmitter
+  typedef std::pair<int32_t, int32_t> TxPosition_t;
+
+  /// The metrics expected for a transmitter
+  struct NeighborState
+  {
+    uint32_t lastReception; ///< time of the last PSCCH received without error, 0 if none
+    uint32_t consecutiveMiss; ///< PSCCH missed since the last one received
+    uint32_t nReceived; ///< number of PSCCH received without error
+  };
+
+  /// The metrics expected by a receiver
+  struct ReceiverState
+  {
+    std::map<TxPosition_t, NeighborState> neighbors; ///< the metrics expected for each transmitter
+    uint32_t nWrongInterval; ///< number of receptions with a wrong message interval
+    uint32_t nWrongMiss; ///< number of receptions with wrong consecutive misses
+  };
+
+  /**
+   * Check the metrics of a PSCCH reception and update the expected ones
+   * \param receiver The state of the receiver
+   * \param params The reception parameters
+   */
+  static void SlPscchReception (ReceiverState *receiver, SlPhyReceptionStatParameters params);
+};
+
+SidelinkNeighborStateTestCase::SidelinkNeighborStateTestCase ()
+  : TestCase ("PSCCH reception metrics kept per transmitter")
+{
+}
+
+void
+SidelinkNeighborStateTestCase::SlPscchReception (ReceiverState *receiver, SlPhyReceptionStatParameters params)
+{
+  TxPosition_t position (params.m_txPosX, params.m_txPosY);
+  std::map<TxPosition_t, NeighborState>::iterator it = receiver->neighbors.find (position);
+  if (it == receiver->neighbors.end ())
+    {
+      NeighborState state = {0, 0, 0};
+      it = receiver->neighbors.insert (std::make_pair (position, state)).first;
+    }
+  NeighborState &state = it->second;
+
+  uint32_t expectedInterval = state.lastReception == 0 ? 0 : params.m_timestamp - state.lastReception;
+  if (params.m_msgInterval != expectedInterval)
+    {
+      NS_LOG_DEBUG ("Message interval " << params.m_msgInterval << " from (" << position.first << "," << position.second
+                    << ") at " << params.m_timestamp << ", expected " << expectedInterval);
+      receiver->nWrongInterval++;
+    }
+  if (params.m_consecutiveMiss != state.consecutiveMiss)
+    {
+      NS_LOG_DEBUG ("Consecutive misses " << params.m_consecutiveMiss << " from (" << position.first << "," << position.second
+                    << ") at " << params.m_timestamp << ", expected " << state.consecutiveMiss);
+      receiver->nWrongMiss++;
+    }
+  if (params.m_correctness)
+    {
+      state.lastReception = params.m_timestamp;
+      state.consecutiveMiss = 0;
+      state.nReceived++;
+    }
+  else
+    {
+      state.consecutiveMiss++;
+    }
+}
+
+void
+SidelinkNeighborStateTestCase::DoRun (void)
+{
+  uint32_t nUes = 4;
+
+  Config::SetDefault ("ns3::LteUeMac::SlGrantSize", UintegerValue (5));
+  Config::SetDefault ("ns3::LteUeMac::SlGrantMcs", UintegerValue (10));
+  Config::SetDefault ("ns3::LteUeMac::Ktrp", UintegerValue (1));
+  Config::SetDefault ("ns3::LteEnbNetDevice::UlEarfcn", UintegerValue (23330));
+  Config::SetDefault ("ns3::LteEnbNetDevice::UlBandwidth", UintegerValue (50));
+
+  Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetEpcHelper (epcHelper);
+  lteHelper->DisableEnbPhy (true);
+  lteHelper->SetV2VMode (true);
+  lteHelper->SetRbPerSubChannel (10);
+  lteHelper->SetAttribute ("UseSidelink", BooleanValue (true));
+  lteHelper->Initialize ();
+  Ptr<LteSidelinkHelper> proseHelper = CreateObject<LteSidelinkHelper> ();
+  proseHelper->SetLteHelper (lteHelper);
+
+  NodeContainer ueNodes;
+  ueNodes.Create (nUes);
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  positionAlloc->Add (Vector (0.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (-20.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (30.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (0.0, 60.0, 1.5));
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.Install (ueNodes);
+
+  // in V2V mode, the RNTI of a UE is its index in the install: the UEs
+  // installed in two groups share their RNTIs
+  NetDeviceContainer ueDevs;
+  for (uint32_t u = 0; u < nUes; u += nUes / 2)
+    {
+      NodeContainer groupNodes;
+      for (uint32_t v = u; v < u + nUes / 2; v++)
+        {
+          groupNodes.Add (ueNodes.Get (v));
+        }
+      ueDevs.Add (lteHelper->InstallUeDevice (groupNodes));
+    }
+  lteHelper->AssignStreams (ueDevs, 1000);
+
+  InternetStackHelper internet;
+  internet.Install (ueNodes);
+  epcHelper->AssignUeIpv4Address (ueDevs);
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  for (uint32_t u = 0; u < ueNodes.GetN (); ++u)
+    {
+      Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting (ueNodes.Get (u)->GetObject<Ipv4> ());
+      ueStaticRouting->SetDefaultRoute (epcHelper->GetUeDefaultGatewayAddress (), 1);
+    }
+
+  // every UE broadcasts to the others
+  Ipv4Address groupAddress ("225.0.0.1");
+  uint32_t groupL2Address = 0;
+  Ptr<LteSlTft> tft = Create<LteSlTft> (LteSlTft::BIDIRECTIONAL, groupAddress, groupL2Address);
+  proseHelper->ActivateSidelinkBearer (Seconds (1.0), ueDevs, tft);
+
+  UdpClientHelper udpClient (groupAddress, 8000);
+  udpClient.SetAttribute ("MaxPackets", UintegerValue (20));
+  udpClient.SetAttribute ("Interval", TimeValue (MilliSeconds (100)));
+  udpClient.SetAttribute ("PacketSize", UintegerValue (200));
+  ApplicationContainer clientApps = udpClient.Install (ueNodes);
+  clientApps.Start (Seconds (2.0));
+  clientApps.Stop (Seconds (4.0));
+
+  Ptr<LteSlUeRrc> ueSidelinkConfiguration = CreateObject<LteSlUeRrc> ();
+  ueSidelinkConfiguration->SetSlEnabled (true);
+  LteRrcSap::SlPreconfiguration preconfiguration;
+  preconfiguration.preconfigGeneral.carrierFreq = 23330;
+  preconfiguration.preconfigGeneral.slBandwidth = 50;
+  preconfiguration.preconfigComm.nbPools = 1;
+  LteSlPreconfigPoolFactory pfactory;
+  pfactory.SetControlBitmap (0x00000000FF);
+  pfactory.SetControlPeriod ("sf50");
+  pfactory.SetControlPrbNum (22);
+  pfactory.SetDataOffset (8);
+  pfactory.SetRbPerSubChannel (10);
+  preconfiguration.preconfigComm.pools[0] = pfactory.CreatePool ();
+  ueSidelinkConfiguration->SetSlPreconfiguration (preconfiguration);
+  lteHelper->InstallSidelinkConfiguration (ueDevs, ueSidelinkConfiguration);
+
+  std::vector<ReceiverState> receivers (nUes);
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      receivers[i].nWrongInterval = 0;
+      receivers[i].nWrongMiss = 0;
+      Ptr<LteSpectrumPhy> slPhy = ueDevs.Get (i)->GetObject<LteUeNetDevice> ()->GetPhy ()->GetSlSpectrumPhy ();
+      slPhy->TraceConnectWithoutContext ("SlPscchReception",
+                                         MakeBoundCallback (&SidelinkNeighborStateTestCase::SlPscchReception, &receivers[i]));
+    }
+
+  Simulator::Stop (Seconds (5.0));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (receivers[i].nWrongInterval, 0, "Receiver " << i << " reported wrong message intervals");
+      NS_TEST_EXPECT_MSG_EQ (receivers[i].nWrongMiss, 0, "Receiver " << i << " reported wrong consecutive misses");
+      uint32_t nActiveNeighbors = 0;
+      for (std::map<TxPosition_t, NeighborState>::const_iterator it = receivers[i].neighbors.begin ();
+           it != receivers[i].neighbors.end (); ++it)
+        {
+          if (it->second.nReceived > 1)
+            {
+              nActiveNeighbors++;
+            }
+        }
+      NS_TEST_EXPECT_MSG_EQ (nActiveNeighbors, nUes - 1,
+                             "Receiver " << i << " did not receive several PSCCH from each of the other UEs");
+    }
+}
+
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink neighbor state test suite
+ */
+class SidelinkNeighborStateTestSuite : public TestSuite
+{
+public:
+  SidelinkNeighborStateTestSuite ();
+};
+
+SidelinkNeighborStateTestSuite::SidelinkNeighborStateTestSuite ()
+  : TestSuite ("sidelink-neighbor-state", SYSTEM)
+{
+  AddTestCase (new SidelinkNeighborStateTestCase (), TestCase::QUICK);
+}
+
+static SidelinkNeighborStateTestSuite staticSidelinkNeighborStateTestSuite;
@@ -0,0 +1,316 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lte-spectrum-phy.h"
+#include <ns3/random-variable-stream.h>
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <set>
+#include <sstream>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkRbBitmap");
+
+using namespace ns3;
+
+/// RBs of a message, in increasing order as scanned from its PSD
+typedef std::vector<int> RbMap_t;
+
+/**
+ * \param map The RBs of a message
+ * \return The RB bitmap of the message
+ */
+static SlRbBitmap_t
+ToBitmap (const RbMap_t& map)
+{
+  SlRbBitmap_t rbBitmap;
+  for (RbMap_t::const_iterator it = map.begin (); it != map.end (); it++)
+    {
+      rbBitmap.set (*it);
+    }
+  return rbBitmap;
+}
+
+/**
+ * \param rbs A set of RBs
+ * \return The RB bitmap with these RBs
+ */
+static SlRbBitmap_t
+ToBitmap (const std::set<int>& rbs)
+{
+  return ToBitmap (RbMap_t (rbs.begin (), rbs.end ()));
+}
+
+/**
+ * \param first The first RB
+ * \param n The number of RBs
+ * \return The RB map of n contiguous RBs
+ */
+static RbMap_t
+MakeRbMap (int first, int n)
+{
+  RbMap_t map;
+  for (int rb = first; rb < first + n; rb++)
+    {
+      map.push_back (rb);
+    }
+  return map;
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Base of the tests that the collided and decoded RBs of the
+ * Sidelink messages computed on RB bitmaps are the ones of the std::set
+ * based computation that the bitmaps replaced, for the PSSCH/PSDCH TBs and
+ * for the PSCCH messages sorted by SINR.
+ */
+class SidelinkRbBitmapTestBase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param name The name of the case
+   */
+  SidelinkRbBitmapTestBase (std::string name);
+
+protected:
+  /**
+   * Check the bitmap computation against the std::set one
+   *
+   * \param messages The RBs of each message, strongest first
+   * \return The RBs collided by the PSSCH TBs
+   */
+  SlRbBitmap_t Check (const std::vector<RbMap_t>& messages);
+};
+
+SidelinkRbBitmapTestBase::SidelinkRbBitmapTestBase (std::string name)
+  : TestCase (name)
+{
+}
+
+SlRbBitmap_t
+SidelinkRbBitmapTestBase::Check (const std::vector<RbMap_t>& messages)
+{
+  // PSSCH and PSDCH: every RB used by more than one TB
+  std::set<int> refCollided;
+  std::set<int> refCollidedTemp;
+  SlRbBitmap_t collided;
+  SlRbBitmap_t collidedTemp;
+  for (std::vector<RbMap_t>::const_iterator it = messages.begin (); it != messages.end (); it++)
+    {
+      for (RbMap_t::const_iterator rbIt = it->begin (); rbIt != it->end (); rbIt++)
+        {
+          if (refCollidedTemp.find (*rbIt) != refCollidedTemp.end ())
+            {
+              refCollided.insert (*rbIt);
+            }
+          else
+            {
+              refCollidedTemp.insert (*rbIt);
+            }
+        }
+      LteSpectrumPhy::UpdateSlCollidedRbs (ToBitmap (*it), collidedTemp, collided);
+    }
+  NS_TEST_EXPECT_MSG_EQ (collided, ToBitmap (refCollided), "Wrong PSSCH collided RBs");
+
+  // PSCCH: the first collided RB of each message
+  std::set<int> refCtrlCollided;
+  std::set<int> refCtrlCollidedTemp;
+  SlRbBitmap_t ctrlCollided;
+  SlRbBitmap_t ctrlCollidedTemp;
+  for (std::vector<RbMap_t>::const_iterator it = messages.begin (); it != messages.end (); it++)
+    {
+      for (RbMap_t::const_iterator rbIt = it->begin (); rbIt != it->end (); rbIt++)
+        {
+          if (refCtrlCollidedTemp.find (*rbIt) != refCtrlCollidedTemp.end ())
+            {
+              refCtrlCollided.insert (*rbIt);
+              break;
+            }
+          else
+            {
+              refCtrlCollidedTemp.insert (*rbIt);
+            }
+        }
+      LteSpectrumPhy::UpdateSlCtrlCollidedRbs (ToBitmap (*it), ctrlCollidedTemp, ctrlCollided);
+      NS_TEST_EXPECT_MSG_EQ (ctrlCollidedTemp, ToBitmap (refCtrlCollidedTemp), "Wrong PSCCH used RBs");
+    }
+  NS_TEST_EXPECT_MSG_EQ (ctrlCollided, ToBitmap (refCtrlCollided), "Wrong PSCCH collided RBs");
+
+  // PSCCH decoding, each message without collided or decoded RB being decoded
+  std::set<int> refDecoded;
+  SlRbBitmap_t decoded;
+  for (std::vector<RbMap_t>::const_iterator it = messages.begin (); it != messages.end (); it++)
+    {
+      LteSpectrumPhy::SlCtrlRbStatus_t refStatus = LteSpectrumPhy::SL_CTRL_RB_FREE;
+      for (RbMap_t::const_iterator rbIt = it->begin (); rbIt != it->end (); rbIt++)
+        {
+          if (refCtrlCollided.find (*rbIt) != refCtrlCollided.end ())
+            {
+              refStatus = LteSpectrumPhy::SL_CTRL_RB_COLLIDED;
+              break;
+            }
+          if (refDecoded.find (*rbIt) != refDecoded.end ())
+            {
+              refStatus = LteSpectrumPhy::SL_CTRL_RB_DECODED;
+              break;
+            }
+        }
+      if (refStatus == LteSpectrumPhy::SL_CTRL_RB_FREE)
+        {
+          refDecoded.insert (it->begin (), it->end ());
+        }
+      LteSpectrumPhy::SlCtrlRbStatus_t status = LteSpectrumPhy::GetSlCtrlRbStatus (ToBitmap (*it), ctrlCollided, decoded);
+      NS_TEST_EXPECT_MSG_EQ (status, refStatus, "Wrong PSCCH RB status of message " << it - messages.begin ());
+      if (status == LteSpectrumPhy::SL_CTRL_RB_FREE)
+        {
+          decoded |= ToBitmap (*it);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (decoded, ToBitmap (refDecoded), "Wrong PSCCH decoded RBs");
+
+  return collided;
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test the bitmap computation against the std::set one on given
+ * messages, and the PSSCH collided RBs against the expected ones.
+ */
+class SidelinkRbBitmapTestCase : public SidelinkRbBitmapTestBase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param name The name of the case
+   * \param messages The RBs of each message, strongest first
+   * \param collided The expected collided RBs of the PSSCH TBs
+   */
+  SidelinkRbBitmapTestCase (std::string name, std::vector<RbMap_t> messages, RbMap_t collided);
+
+private:
+  virtual void DoRun (void);
+
+  std::vector<RbMap_t> m_messages; ///< the RBs of each message
+  RbMap_t m_collided; ///< the expected collided RBs of the PSSCH TBs
+};
+
+SidelinkRbBitmapTestCase::SidelinkRbBitmapTestCase (std::string name, std::vector<RbMap_t> messages, RbMap_t collided)
+  : SidelinkRbBitmapTestBase (name),
+    m_messages (messages),
+    m_collided (collided)
+{
+}
+
+void
+SidelinkRbBitmapTestCase::DoRun (void)
+{
+  SlRbBitmap_t collided = Check (m_messages);
+  NS_TEST_EXPECT_MSG_EQ (collided, ToBitmap (m_collided), "Unexpected PSSCH collided RBs");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test the bitmap computation against the std::set one on random
+ * messages of contiguous RBs, up to the 100 RBs of the largest bandwidth.
+ */
+class SidelinkRbBitmapRandomTestCase : public SidelinkRbBitmapTestBase
+{
+public:
+  SidelinkRbBitmapRandomTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkRbBitmapRandomTestCase::SidelinkRbBitmapRandomTestCase ()
+  : SidelinkRbBitmapTestBase ("random messages")
+{
+}
+
+void
+SidelinkRbBitmapRandomTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable> ();
+  random->SetStream (1);
+  for (uint32_t run = 0; run < 1000; run++)
+    {
+      std::vector<RbMap_t> messages;
+      uint32_t nMessages = random->GetInteger (1, 6);
+      for (uint32_t i = 0; i < nMessages; i++)
+        {
+          int n = random->GetInteger (1, 20);
+          messages.push_back (MakeRbMap (random->GetInteger (0, 100 - n), n));
+        }
+      Check (messages);
+      if (IsStatusFailure ())
+        {
+          std::ostringstream oss;
+          for (std::vector<RbMap_t>::const_iterator it = messages.begin (); it != messages.end (); it++)
+            {
+              oss << " [" << it->front () << "," << it->back () << "]";
+            }
+          NS_LOG_ERROR ("Mismatch on the messages" << oss.str ());
+          return;
+        }
+    }
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test suite of the Sidelink RB bitmaps.
+ */
+class SidelinkRbBitmapTestSuite : public TestSuite
+{
+public:
+  SidelinkRbBitmapTestSuite ();
+};
+
+SidelinkRbBitmapTestSuite::SidelinkRbBitmapTestSuite ()
+  : TestSuite ("sidelink-rb-bitmap", UNIT)
+{
+  std::vector<RbMap_t> messages;
+
+  messages.push_back (MakeRbMap (10, 10));
+  messages.push_back (MakeRbMap (10, 10));
+  AddTestCase (new SidelinkRbBitmapTestCase ("overlapping messages", messages, MakeRbMap (10, 10)), TestCase::QUICK);
+
+  messages.clear ();
+  messages.push_back (MakeRbMap (10, 10));
+  messages.push_back (MakeRbMap (15, 10));
+  messages.push_back (MakeRbMap (5, 10));
+  AddTestCase (new SidelinkRbBitmapTestCase ("partially overlapping messages", messages, MakeRbMap (10, 10)), TestCase::QUICK);
+
+  messages.clear ();
+  messages.push_back (MakeRbMap (0, 10));
+  messages.push_back (MakeRbMap (10, 10));
+  messages.push_back (MakeRbMap (90, 10));
+  AddTestCase (new SidelinkRbBitmapTestCase ("disjoint messages", messages, RbMap_t ()), TestCase::QUICK);
+
+  AddTestCase (new SidelinkRbBitmapRandomTestCase, TestCase::QUICK);
+}
+
+static SidelinkRbBitmapTestSuite sidelinkRbBitmapTestSuite; ///< the test suite
@@ -0,0 +1,278 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lte-sl-resource-selector.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/double.h>
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkResourceSelector");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the 3GPP resource selection only returns sensed
+ * resources below the RSRP threshold and among the candidate ratio of
+ * the resources with the lowest S-RSSI.
+ */
+class SidelinkResourceSelector3gppTestCase : public TestCase
+{
+public:
+  SidelinkResourceSelector3gppTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkResourceSelector3gppTestCase::SidelinkResourceSelector3gppTestCase ()
+  : TestCase ("3GPP resource selection")
+{
+}
+
+void
+SidelinkResourceSelector3gppTestCase::DoRun (void)
+{
+  const uint32_t nSubChannels = 5;
+  const uint32_t scPeriod = 100;
+  const uint32_t nResources = nSubChannels * scPeriod;
+
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+  Ptr<LteSl3gppResourceSelector> selector = CreateObject<LteSl3gppResourceSelector> ();
+  selector->SetRandomVariable (rv);
+
+  for (uint32_t run = 0; run < 100; run++)
+    {
+      std::vector<double> rsrp (nResources);
+      std::vector<double> rssi (nResources);
+      std::vector<bool> sensed (nResources);
+      for (uint32_t idx = 0; idx < nResources; idx++)
+        {
+          // about half of the resources are free, i.e., nothing was sensed on them
+          rsrp[idx] = rv->GetValue () < 0.5 ? -1000.0 : rv->GetValue (-120.0, -60.0);
+          rssi[idx] = rv->GetValue (-110.0, -40.0);
+          sensed[idx] = rv->GetValue () < 0.9;
+        }
+
+      SlCandidateResource chosen;
+      bool selected = selector->SelectResource (nSubChannels, scPeriod, rsrp, rssi, sensed, chosen);
+      NS_TEST_ASSERT_MSG_EQ (selected, true, "No resource selected");
+      uint32_t idx = chosen.subChannel * scPeriod + chosen.subframe;
+      NS_TEST_ASSERT_MSG_EQ (sensed[idx], true, "Selected a resource that was not sensed");
+      // more than 20% of the resources are free, so the threshold is raised only once
+      NS_TEST_ASSERT_MSG_LT (rsrp[idx], -970.0, "Selected a busy resource");
+
+      // rank of the chosen resource among the free, sensed resources
+      uint32_t rank = 0;
+      for (uint32_t other = 0; other < nResources; other++)
+        {
+          if (sensed[other] && rsrp[other] < -970.0 && rssi[other] < rssi[idx])
+            {
+              rank++;
+            }
+        }
+      NS_TEST_ASSERT_MSG_LT (rank, (uint32_t)(nResources * 0.2), "Selected resource not among the lowest S-RSSI");
+    }
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the 3GPP resource selection picks, draw for draw, the
+ * same resource as a full sort of the candidates by S-RSSI, subchannel
+ * and subframe, with and without ties in the S-RSSI.
+ */
+class SidelinkResourceSelectorDrawTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param ties True to round the S-RSSI to 1 dB, so that many candidates tie
+   */
+  SidelinkResourceSelectorDrawTestCase (bool ties);
+
+private:
+  virtual void DoRun (void);
+
+  bool m_ties; ///< whether the S-RSSI values tie
+};
+
+SidelinkResourceSelectorDrawTestCase::SidelinkResourceSelectorDrawTestCase (bool ties)
+  : TestCase (ties ? "3GPP resource selection draws, with ties" : "3GPP resource selection draws"),
+    m_ties (ties)
+{
+}
+
+/**
+ * Order of the candidates of the reference selection
+ *
+ * \param a The first candidate
+ * \param b The second candidate
+ * \return True if a is better than b
+ */
+static bool
+ReferenceOrder (const SlCandidateResource &a, const SlCandidateResource &b)
+{
+  if (a.metric != b.metric)
+    {
+      return a.metric < b.metric;
+    }
+  return a.subChannel < b.subChannel || (a.subChannel == b.subChannel && a.subframe < b.subframe);
+}
+
+void
+SidelinkResourceSelectorDrawTestCase::DoRun (void)
+{
+  const uint32_t nSubChannels = 5;
+  const uint32_t scPeriod = 100;
+  const uint32_t nResources = nSubChannels * scPeriod;
+
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+  // the selector and the reference draw from two copies of the same stream
+  Ptr<UniformRandomVariable> selectorRv = CreateObject<UniformRandomVariable> ();
+  selectorRv->SetStream (2);
+  Ptr<UniformRandomVariable> referenceRv = CreateObject<UniformRandomVariable> ();
+  referenceRv->SetStream (2);
+  Ptr<LteSl3gppResourceSelector> selector = CreateObject<LteSl3gppResourceSelector> ();
+  selector->SetRandomVariable (selectorRv);
+
+  for (uint32_t run = 0; run < 100; run++)
+    {
+      std::vector<double> rsrp (nResources);
+      std::vector<double> rssi (nResources);
+      std::vector<bool> sensed (nResources);
+      for (uint32_t idx = 0; idx < nResources; idx++)
+        {
+          rsrp[idx] = rv->GetValue () < 0.5 ? -1000.0 : rv->GetValue (-120.0, -60.0);
+          rssi[idx] = rv->GetValue (-110.0, -40.0);
+          if (m_ties)
+            {
+              rssi[idx] = std::floor (rssi[idx] / 10.0) * 10.0;
+            }
+          sensed[idx] = rv->GetValue () < 0.9;
+        }
+
+      SlCandidateResource chosen;
+      bool selected = selector->SelectResource (nSubChannels, scPeriod, rsrp, rssi, sensed, chosen);
+      NS_TEST_ASSERT_MSG_EQ (selected, true, "No resource selected");
+
+      // the free, sensed resources are the candidates, see the 3GPP test
+      std::vector<SlCandidateResource> reference;
+      for (uint32_t idx = 0; idx < nResources; idx++)
+        {
+          if (sensed[idx] && rsrp[idx] < -970.0)
+            {
+              SlCandidateResource resource;
+              resource.subChannel = idx / scPeriod;
+              resource.subframe = idx % scPeriod;
+              resource.metric = rssi[idx];
+              reference.push_back (resource);
+            }
+        }
+      std::sort (reference.begin (), reference.end (), ReferenceOrder);
+      uint32_t k = std::min<uint32_t> (nResources * 0.2, reference.size ());
+      SlCandidateResource expected = reference[referenceRv->GetInteger (0, k - 1)];
+      NS_TEST_ASSERT_MSG_EQ (chosen.subChannel, expected.subChannel, "Different subchannel in run " << run);
+      NS_TEST_ASSERT_MSG_EQ (chosen.subframe, expected.subframe, "Different subframe in run " << run);
+    }
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the TJ jump, called through the selector interface as
+ * the MAC does, selects one of the resources with the highest decoding
+ * ratio, and that the 3GPP policy keeps the current resource.
+ */
+class SidelinkResourceSelectorTjJumpTestCase : public TestCase
+{
+public:
+  SidelinkResourceSelectorTjJumpTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkResourceSelectorTjJumpTestCase::SidelinkResourceSelectorTjJumpTestCase ()
+  : TestCase ("TJ jump resource selection")
+{
+}
+
+void
+SidelinkResourceSelectorTjJumpTestCase::DoRun (void)
+{
+  const uint32_t nSubChannels = 2;
+  const uint32_t scPeriod = 10;
+
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+  Ptr<LteSlResourceSelector> selector = CreateObject<LteSlTjResourceSelector> ();
+  selector->SetAttribute ("JumpRatio", DoubleValue (0.0));
+  selector->SetRandomVariable (rv);
+
+  std::vector<double> decodingRatio (nSubChannels * scPeriod, 0.1);
+  decodingRatio[1 * scPeriod + 7] = 0.9;
+
+  SlCandidateResource chosen;
+  chosen.subChannel = 0;
+  chosen.subframe = 2;
+  bool selected = selector->SelectJumpResource (nSubChannels, scPeriod, decodingRatio, chosen);
+  NS_TEST_ASSERT_MSG_EQ (selected, true, "No resource selected");
+  NS_TEST_ASSERT_MSG_EQ (chosen.subChannel, 1, "Wrong subchannel");
+  NS_TEST_ASSERT_MSG_EQ (chosen.subframe, 7, "Wrong subframe");
+
+  Ptr<LteSlResourceSelector> noJumpSelector = CreateObject<LteSl3gppResourceSelector> ();
+  noJumpSelector->SetRandomVariable (rv);
+  chosen.subChannel = 0;
+  chosen.subframe = 2;
+  selected = noJumpSelector->SelectJumpResource (nSubChannels, scPeriod, decodingRatio, chosen);
+  NS_TEST_ASSERT_MSG_EQ (selected, false, "The 3GPP policy must not jump");
+  NS_TEST_ASSERT_MSG_EQ (chosen.subChannel, 0, "The subchannel must be kept");
+  NS_TEST_ASSERT_MSG_EQ (chosen.subframe, 2, "The subframe must be kept");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink resource selector test suite
+ */
+class SidelinkResourceSelectorTestSuite : public TestSuite
+{
+public:
+  SidelinkResourceSelectorTestSuite ();
+};
+
+SidelinkResourceSelectorTestSuite::SidelinkResourceSelectorTestSuite ()
+  : TestSuite ("sidelink-resource-selector", UNIT)
+{
+  AddTestCase (new SidelinkResourceSelector3gppTestCase (), TestCase::QUICK);
+  AddTestCase (new SidelinkResourceSelectorDrawTestCase (false), TestCase::QUICK);
+  AddTestCase (new SidelinkResourceSelectorDrawTestCase (true), TestCase::QUICK);
+  AddTestCase (new SidelinkResourceSelectorTjJumpTestCase (), TestCase::QUICK);
+}
+
+static SidelinkResourceSelectorTestSuite staticSidelinkResourceSelectorTestSuite;
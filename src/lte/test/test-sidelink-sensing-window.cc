@@ -0,0 +1,287 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lte-sl-sensing-window.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/random-variable-stream.h>
+#include <ns3/double.h>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkSensingWindow");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the sums kept by the sensing window are exactly equal
+ * to the sums recomputed by walking the whole window the way the MAC did,
+ * while random samples are recorded and expired, subframes are skipped
+ * and the window is cleared. A second averaging period is added midway.
+ */
+class SidelinkSensingWindowSumTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param nSubChannels The number of subchannels
+   * \param length The window length in subframes
+   * \param period The averaging period in subframes
+   */
+  SidelinkSensingWindowSumTestCase (uint32_t nSubChannels, uint32_t length, uint32_t period);
+
+private:
+  virtual void DoRun (void);
+  /**
+   * Compute the per-resource sums of a reference map by walking the
+   * window backwards from the slot before the current time
+   *
+   * \param map The reference map indexed by [subchannel][slot]
+   * \param timeMs The current time in milliseconds
+   * \param period The averaging period
+   * \return The sums in units of the sample grid, indexed by subchannel * period + subframe
+   */
+  std::vector<int64_t> SumMap (const std::vector<std::vector<double> > &map, int64_t timeMs, uint32_t period);
+  /**
+   * Check the sums of the window against the sums of the reference maps
+   *
+   * \param window The sensing window
+   * \param rssiMap The reference S-RSSI map
+   * \param rsrpMap The reference PSSCH-RSRP map
+   * \param timeMs The current time in milliseconds
+   * \param period The averaging period
+   */
+  void CheckSums (const LteSlSensingWindow &window, const std::vector<std::vector<double> > &rssiMap,
+                  const std::vector<std::vector<double> > &rsrpMap, int64_t timeMs, uint32_t period);
+
+  uint32_t m_nSubChannels; ///< number of subchannels
+  uint32_t m_length; ///< window length
+  uint32_t m_period; ///< averaging period
+};
+
+static std::string
+BuildNameString (uint32_t nSubChannels, uint32_t length, uint32_t period)
+{
+  std::ostringstream oss;
+  oss << "nSubChannels=" << nSubChannels << ", length=" << length << ", period=" << period;
+  return oss.str ();
+}
+
+SidelinkSensingWindowSumTestCase::SidelinkSensingWindowSumTestCase (uint32_t nSubChannels, uint32_t length, uint32_t period)
+  : TestCase (BuildNameString (nSubChannels, length, period)),
+    m_nSubChannels (nSubChannels),
+    m_length (length),
+    m_period (period)
+{
+}
+
+std::vector<int64_t>
+SidelinkSensingWindowSumTestCase::SumMap (const std::vector<std::vector<double> > &map, int64_t timeMs, uint32_t period)
+{
+  std::vector<int64_t> sums (m_nSubChannels * period, 0);
+  for (uint32_t sc = 0; sc < m_nSubChannels; sc++)
+    {
+      int64_t t = timeMs - 1;
+      for (int32_t sf = period - 1, rel = 0; rel < (int32_t) m_length; rel++, t--)
+        {
+          sums[sc * period + sf] += LteSlSensingWindow::Quantize (map[sc][(t + m_length) % m_length]);
+          sf = (sf == 0) ? period - 1 : sf - 1;
+        }
+    }
+  return sums;
+}
+
+void
+SidelinkSensingWindowSumTestCase::CheckSums (const LteSlSensingWindow &window, const std::vector<std::vector<double> > &rssiMap,
+                                             const std::vector<std::vector<double> > &rsrpMap, int64_t timeMs, uint32_t period)
+{
+  std::vector<int64_t> rssiSums = SumMap (rssiMap, timeMs, period);
+  std::vector<int64_t> rsrpSums = SumMap (rsrpMap, timeMs, period);
+  for (uint32_t sc = 0; sc < m_nSubChannels; sc++)
+    {
+      for (uint32_t sf = 0; sf < period; sf++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (window.GetRssiSum (sc, sf, period), LteSlSensingWindow::Dequantize (rssiSums[sc * period + sf]),
+                                 "S-RSSI sum differs at time " << timeMs << ", period " << period << ", resource " << sc << "/" << sf);
+          NS_TEST_ASSERT_MSG_EQ (window.GetRsrpSum (sc, sf, period), LteSlSensingWindow::Dequantize (rsrpSums[sc * period + sf]),
+                                 "PSSCH-RSRP sum differs at time " << timeMs << ", period " << period << ", resource " << sc << "/" << sf);
+        }
+    }
+}
+
+void
+SidelinkSensingWindowSumTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+
+  LteSlSensingWindow window;
+  window.Resize (m_nSubChannels, m_length);
+  window.AddAveragingPeriod (m_period);
+  uint32_t otherPeriod = m_period + 7;
+  std::vector<std::vector<double> > rssiMap (m_nSubChannels, std::vector<double> (m_length, LteSlSensingWindow::EMPTY_POWER_DBM));
+  std::vector<std::vector<double> > rsrpMap (m_nSubChannels, std::vector<double> (m_length, LteSlSensingWindow::EMPTY_POWER_DBM));
+
+  bool otherPeriodAdded = false;
+  int64_t lastTime = -1;
+  for (int64_t t = 0; t < 4 * m_length; t++)
+    {
+      // a UE idle for some subframes catches up at once
+      if (rv->GetValue () < 0.02)
+        {
+          t += rv->GetInteger (1, 3 * m_length / 2);
+        }
+      uint32_t slot = window.GetSlot (t);
+      window.ExpireUntil (t);
+      for (int64_t x = std::max (lastTime + 1, t - (int64_t) m_length + 1); x <= t; x++)
+        {
+          for (uint32_t sc = 0; sc < m_nSubChannels; sc++)
+            {
+              rssiMap[sc][x % m_length] = LteSlSensingWindow::EMPTY_POWER_DBM;
+              rsrpMap[sc][x % m_length] = LteSlSensingWindow::EMPTY_POWER_DBM;
+            }
+        }
+      lastTime = t;
+      if (rv->GetValue () < 0.002)
+        {
+          window.Clear ();
+          for (uint32_t sc = 0; sc < m_nSubChannels; sc++)
+            {
+              std::fill (rssiMap[sc].begin (), rssiMap[sc].end (), LteSlSensingWindow::EMPTY_POWER_DBM);
+              std::fill (rsrpMap[sc].begin (), rsrpMap[sc].end (), LteSlSensingWindow::EMPTY_POWER_DBM);
+            }
+        }
+      if (t >= m_length)
+        {
+          // adding the period again keeps its sums
+          window.AddAveragingPeriod (otherPeriod);
+          otherPeriodAdded = true;
+        }
+      uint32_t nRx = rv->GetInteger (0, m_nSubChannels);
+      for (uint32_t i = 0; i < nRx; i++)
+        {
+          uint32_t sc = rv->GetInteger (0, m_nSubChannels - 1);
+          double rssi = rv->GetValue (-110.0, -40.0);
+          double rsrp = rv->GetValue (-130.0, -50.0);
+          window.Record (sc, slot, rssi, rsrp, rv->GetValue () < 0.5);
+          rssiMap[sc][slot] = rssi;
+          rsrpMap[sc][slot] = rsrp;
+        }
+      if (t % 7 == 0)
+        {
+          CheckSums (window, rssiMap, rsrpMap, t, m_period);
+          if (otherPeriodAdded)
+            {
+              CheckSums (window, rssiMap, rsrpMap, t, otherPeriod);
+            }
+        }
+    }
+  for (uint32_t sc = 0; sc < m_nSubChannels; sc++)
+    {
+      for (uint32_t slot = 0; slot < m_length; slot++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (window.GetRssi (sc, slot), LteSlSensingWindow::Dequantize (LteSlSensingWindow::Quantize (rssiMap[sc][slot])),
+                                 "Wrong S-RSSI at " << sc << "/" << slot);
+          NS_TEST_ASSERT_MSG_EQ (window.GetRsrp (sc, slot), LteSlSensingWindow::Dequantize (LteSlSensingWindow::Quantize (rsrpMap[sc][slot])),
+                                 "Wrong PSSCH-RSRP at " << sc << "/" << slot);
+        }
+    }
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test the ring buffer bookkeeping of the sensing window
+ */
+class SidelinkSensingWindowRingTestCase : public TestCase
+{
+public:
+  SidelinkSensingWindowRingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkSensingWindowRingTestCase::SidelinkSensingWindowRingTestCase ()
+  : TestCase ("Sensing window ring buffer")
+{
+}
+
+void
+SidelinkSensingWindowRingTestCase::DoRun (void)
+{
+  LteSlSensingWindow window;
+  window.Resize (5, 1000);
+  NS_TEST_ASSERT_MSG_EQ (window.GetNSubChannels (), 5, "Wrong number of subchannels");
+  NS_TEST_ASSERT_MSG_EQ (window.GetSlot (1234), 234, "Wrong slot");
+
+  window.Record (2, 234, -60.0, -80.0, true);
+  NS_TEST_ASSERT_MSG_EQ (window.GetRssi (2, 234), -60.0, "Wrong S-RSSI");
+  NS_TEST_ASSERT_MSG_EQ (window.GetRsrp (2, 234), -80.0, "Wrong PSSCH-RSRP");
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (2, 234), true, "Wrong decoding flag");
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, 234), false, "Wrong decoding flag");
+
+  // one window later the slot is reused
+  window.ExpireUntil (2234);
+  NS_TEST_ASSERT_MSG_EQ (window.GetRsrp (2, 234), LteSlSensingWindow::EMPTY_POWER_DBM, "Slot not expired");
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (2, 234), false, "Slot not expired");
+
+  // an idle UE catches up with all the subframes it skipped at once
+  window.ExpireUntil (3000);
+  window.Record (1, window.GetSlot (3010), -70.0, -90.0, true);
+  window.Record (1, window.GetSlot (3020), -70.0, -90.0, true);
+  window.ExpireUntil (3015);
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, window.GetSlot (3010)), false, "Skipped slot not expired");
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, window.GetSlot (3020)), true, "Slot expired too early");
+  window.ExpireUntil (3015);
+  window.Record (1, window.GetSlot (3015), -70.0, -90.0, true);
+  window.ExpireUntil (3015);
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, window.GetSlot (3015)), true, "Slot expired twice");
+  window.ExpireUntil (9000);
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, window.GetSlot (3015)), false, "Window not expired");
+  NS_TEST_ASSERT_MSG_EQ (window.IsDecoded (1, window.GetSlot (3020)), false, "Window not expired");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink sensing window test suite
+ */
+class SidelinkSensingWindowTestSuite : public TestSuite
+{
+public:
+  SidelinkSensingWindowTestSuite ();
+};
+
+SidelinkSensingWindowTestSuite::SidelinkSensingWindowTestSuite ()
+  : TestSuite ("sidelink-sensing-window", UNIT)
+{
+  AddTestCase (new SidelinkSensingWindowRingTestCase (), TestCase::QUICK);
+  AddTestCase (new SidelinkSensingWindowSumTestCase (5, 1000, 100), TestCase::QUICK);
+  AddTestCase (new SidelinkSensingWindowSumTestCase (3, 1000, 20), TestCase::QUICK);
+  AddTestCase (new SidelinkSensingWindowSumTestCase (10, 100, 50), TestCase::QUICK);
+  AddTestCase (new SidelinkSensingWindowSumTestCase (5, 1000, 60), TestCase::QUICK);
+  AddTestCase (new SidelinkSensingWindowSumTestCase (4, 100, 30), TestCase::QUICK);
+}
+
+static SidelinkSensingWindowTestSuite staticSidelinkSensingWindowTestSuite;
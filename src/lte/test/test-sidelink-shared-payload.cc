@@ -0,0 +1,225 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/pointer.h>
+#include <ns3/node.h>
+#include <ns3/simple-net-device.h>
+#include <ns3/packet-burst.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/isotropic-antenna-model.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/lte-spectrum-phy.h>
+#include <ns3/lte-spectrum-value-helper.h>
+#include <ns3/lte-spectrum-signal-parameters.h>
+#include <ns3/lte-control-messages.h>
+#include <ns3/lte-sl-chunk-processor.h>
+#include <ns3/lte-sl-harq-phy.h>
+#include <ns3/lte-radio-bearer-tag.h>
+#include <ns3/lte-pdcp-header.h>
+#include <vector>
+#include <sstream>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkSharedPayload");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the receivers of a Sidelink signal, which share its
+ * payload, each deliver their own copy of the packets: removing a header
+ * from the packet delivered by one receiver changes neither the packet
+ * delivered by the other receiver nor the packet transmitted. Also check
+ * that the count of the shared bytes covers the receivers of the signal
+ * and is reset by Simulator::Destroy, the test case being run twice.
+ */
+class SidelinkSharedPayloadTestCase : public TestCase
+{
+public:
+  /**
+   * Constructor
+   * \param packetSize The size of the packet transmitted, without its header
+   */
+  SidelinkSharedPayloadTestCase (uint32_t packetSize);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Build the name of the test case
+   * \param packetSize The size of the packet transmitted
+   * \return The name
+   */
+  static std::string BuildNameString (uint32_t packetSize);
+
+  /**
+   * Create a Sidelink PHY on its own node
+   * \param channel The channel
+   * \param position The position of the node
+   * \return The PHY
+   */
+  static Ptr<LteSpectrumPhy> CreatePhy (Ptr<SpectrumChannel> channel, Vector position);
+
+  /**
+   * Store a packet delivered by a receiver
+   * \param received The packets delivered by the receiver
+   * \param p The packet
+   */
+  static void RxDataEndOk (std::vector<Ptr<Packet> > *received, Ptr<Packet> p);
+
+  uint32_t m_packetSize; ///< size of the packet transmitted, without its header
+};
+
+SidelinkSharedPayloadTestCase::SidelinkSharedPayloadTestCase (uint32_t packetSize)
+  : TestCase (BuildNameString (packetSize)),
+    m_packetSize (packetSize)
+{
+}
+
+std::string
+SidelinkSharedPayloadTestCase::BuildNameString (uint32_t packetSize)
+{
+  std::ostringstream oss;
+  oss << "Sidelink payload shared by two receivers, packet size " << packetSize;
+  return oss.str ();
+}
+
+Ptr<LteSpectrumPhy>
+SidelinkSharedPayloadTestCase::CreatePhy (Ptr<SpectrumChannel> channel, Vector position)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  node->AddDevice (device);
+  Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+  mobility->SetPosition (position);
+  node->AggregateObject (mobility);
+
+  Ptr<LteSpectrumPhy> phy = CreateObject<LteSpectrumPhy> ();
+  phy->SetDevice (device);
+  phy->SetMobility (mobility);
+  phy->SetAntenna (CreateObject<IsotropicAntennaModel> ());
+  phy->SetAttribute ("SlDataErrorModelEnabled", BooleanValue (false));
+  phy->SetAttribute ("HalfDuplexPhy", PointerValue (phy));
+  phy->SetNoisePowerSpectralDensity (LteSpectrumValueHelper::CreateNoisePowerSpectralDensity (23330, 50, 9.0));
+  phy->SetSlHarqPhyModule (Create<LteSlHarqPhy> ());
+  Ptr<LteSlChunkProcessor> pSlSinr = Create<LteSlChunkProcessor> ();
+  pSlSinr->AddCallback (MakeCallback (&LteSpectrumPhy::UpdateSlSinrPerceived, phy));
+  phy->AddSlSinrChunkProcessor (pSlSinr);
+  phy->SetChannel (channel);
+  channel->AddRx (phy);
+  return phy;
+}
+
+void
+SidelinkSharedPayloadTestCase::RxDataEndOk (std::vector<Ptr<Packet> > *received, Ptr<Packet> p)
+{
+  received->push_back (p);
+}
+
+void
+SidelinkSharedPayloadTestCase::DoRun (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (LteSpectrumSignalParametersSlFrame::GetSharedPayloadBytes (), 0,
+                         "The count of the shared bytes was not reset by the previous simulation");
+
+  Ptr<MultiModelSpectrumChannel> channel = CreateObject<MultiModelSpectrumChannel> ();
+  Ptr<LteSpectrumPhy> txPhy = CreatePhy (channel, Vector (0.0, 0.0, 1.5));
+  Ptr<LteSpectrumPhy> rxPhys[2] = {CreatePhy (channel, Vector (20.0, 0.0, 1.5)),
+                                   CreatePhy (channel, Vector (-30.0, 0.0, 1.5))};
+
+  std::vector<int> rbs;
+  for (int rb = 2; rb < 10; rb++)
+    {
+      rbs.push_back (rb);
+    }
+  txPhy->SetTxPowerSpectralDensity (LteSpectrumValueHelper::CreateTxPowerSpectralDensity (23330, 50, 23.0, rbs));
+
+  // data only (no SCI) from RNTI 1 to the group 5
+  uint16_t rnti = 1;
+  uint32_t dstL2Id = 5;
+  Ptr<Packet> packet = Create<Packet> (m_packetSize);
+  LtePdcpHeader pdcpHeader;
+  pdcpHeader.SetDcBit (LtePdcpHeader::DATA_PDU);
+  packet->AddHeader (pdcpHeader);
+  packet->AddPacketTag (LteRadioBearerTag (rnti, 1, 2, dstL2Id));
+  uint32_t txSize = packet->GetSize ();
+  Ptr<PacketBurst> pb = CreateObject<PacketBurst> ();
+  pb->AddPacket (packet);
+
+  std::vector<Ptr<Packet> > received[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      rxPhys[i]->SetLtePhyRxDataEndOkCallback (MakeBoundCallback (&SidelinkSharedPayloadTestCase::RxDataEndOk, &received[i]));
+      rxPhys[i]->AddExpectedTb (rnti, dstL2Id & 0xFF, 1, txSize, 10, rbs, 0);
+    }
+
+  Simulator::Schedule (MilliSeconds (1), &LteSpectrumPhy::StartTxSlDataFrame, txPhy,
+                       pb, std::list<Ptr<LteControlMessage> > (), MicroSeconds (500), 0);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_GT_OR_EQ (LteSpectrumSignalParametersSlFrame::GetSharedPayloadBytes (), 2 * pb->GetSize (),
+                               "The payload was not shared by the receivers");
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (received[i].size (), 1, "Wrong number of packets delivered by receiver " << i);
+    }
+  NS_TEST_ASSERT_MSG_NE (received[0][0], received[1][0], "The receivers delivered the same packet");
+  NS_TEST_ASSERT_MSG_NE (received[0][0], packet, "A receiver delivered the packet transmitted");
+  NS_TEST_ASSERT_MSG_NE (received[1][0], packet, "A receiver delivered the packet transmitted");
+
+  // the upper layers of the first receiver remove the header and the tag
+  LtePdcpHeader header;
+  received[0][0]->RemoveHeader (header);
+  LteRadioBearerTag tag;
+  received[0][0]->RemovePacketTag (tag);
+  NS_TEST_ASSERT_MSG_EQ (received[0][0]->GetSize (), m_packetSize, "Wrong size after removing the header");
+
+  NS_TEST_ASSERT_MSG_EQ (received[1][0]->GetSize (), txSize, "The packet of the other receiver was modified");
+  NS_TEST_ASSERT_MSG_EQ (received[1][0]->PeekPacketTag (tag), true, "The tag of the other receiver was removed");
+  NS_TEST_ASSERT_MSG_EQ (packet->GetSize (), txSize, "The packet transmitted was modified");
+  NS_TEST_ASSERT_MSG_EQ (packet->PeekPacketTag (tag), true, "The tag of the packet transmitted was removed");
+
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (LteSpectrumSignalParametersSlFrame::GetSharedPayloadBytes (), 0,
+                         "The count of the shared bytes was not reset by Simulator::Destroy");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink shared payload test suite
+ */
+class SidelinkSharedPayloadTestSuite : public TestSuite
+{
+public:
+  SidelinkSharedPayloadTestSuite ();
+};
+
+SidelinkSharedPayloadTestSuite::SidelinkSharedPayloadTestSuite ()
+  : TestSuite ("sidelink-shared-payload", UNIT)
+{
+  AddTestCase (new SidelinkSharedPayloadTestCase (100), TestCase::QUICK);
+  AddTestCase (new SidelinkSharedPayloadTestCase (1000), TestCase::QUICK);
+}
+
+static SidelinkSharedPayloadTestSuite staticSidelinkSharedPayloadTestSuite;
@@ -0,0 +1,183 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/lte-sl-sps-reservation.h"
+#include "ns3/lte-sl-preconfig-pool-factory.h"
+#include "ns3/lte-sl-pool.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkSpsReservation");
+
+using namespace ns3;
+
+/**
+ * \param pool The sidelink pool
+ * \param scPeriod The start of an SC period, numbered from frame/subframe 1 as in the MAC
+ * \return The start of the next SC period, as computed by the MAC
+ */
+static SidelinkCommResourcePool::SubframeInfo
+NextScPeriod (Ptr<SidelinkCommResourcePool> pool, SidelinkCommResourcePool::SubframeInfo scPeriod)
+{
+  SidelinkCommResourcePool::SubframeInfo next = pool->GetNextScPeriod (scPeriod.frameNo, scPeriod.subframeNo);
+  next.frameNo++;
+  next.subframeNo++;
+  return next;
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the transmissions of an SPS reservation are at the
+ * reserved offset of each SC period, SC period after SC period, across
+ * the end of the 1024 frames where the last SC period is longer.
+ */
+class SidelinkSpsReservationScheduleTestCase : public TestCase
+{
+public:
+  SidelinkSpsReservationScheduleTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkSpsReservationScheduleTestCase::SidelinkSpsReservationScheduleTestCase ()
+  : TestCase ("SPS reservation schedule")
+{
+}
+
+void
+SidelinkSpsReservationScheduleTestCase::DoRun (void)
+{
+  LteSlPreconfigPoolFactory pfactory;
+  Ptr<SidelinkTxCommResourcePool> pool = CreateObject<SidelinkTxCommResourcePool> ();
+  pool->SetPool (pfactory.CreatePool ());
+  NS_TEST_ASSERT_MSG_EQ (pool->GetScPeriod (), 100, "Unexpected SC period");
+
+  // the SC period starting at 10000 ms
+  SidelinkCommResourcePool::SubframeInfo scPeriod;
+  scPeriod.frameNo = 1001;
+  scPeriod.subframeNo = 1;
+  const uint32_t offset = 37;
+  const uint32_t counter = 75;
+
+  LteSlSpsReservation sps;
+  sps.Reserve (offset, 3, counter);
+  NS_TEST_ASSERT_MSG_EQ (sps.GetCounter (), counter, "Wrong reselection counter");
+  NS_TEST_ASSERT_MSG_EQ (sps.GetOffset (), offset, "Wrong offset");
+  NS_TEST_ASSERT_MSG_EQ ((uint16_t) sps.GetSubChannel (), 3, "Wrong subchannel");
+
+  bool wrapped = false;
+  for (uint32_t i = 0; i < counter; i++)
+    {
+      LteSlSpsReservation::Transmission tx = sps.Pop (scPeriod);
+      NS_TEST_ASSERT_MSG_EQ ((tx.scPeriod == scPeriod), true, "Wrong SC period of transmission " << i);
+      SidelinkCommResourcePool::SubframeInfo expected = LteSlSpsReservation::GetSubframe (scPeriod, offset);
+      NS_TEST_ASSERT_MSG_EQ (tx.subframe.frameNo, expected.frameNo, "Wrong frame of transmission " << i);
+      NS_TEST_ASSERT_MSG_EQ (tx.subframe.subframeNo, expected.subframeNo, "Wrong subframe of transmission " << i);
+      NS_TEST_ASSERT_MSG_EQ (sps.GetCounter (), counter - i - 1, "Wrong reselection counter after transmission " << i);
+
+      SidelinkCommResourcePool::SubframeInfo next = NextScPeriod (pool, scPeriod);
+      if (next.frameNo < scPeriod.frameNo)
+        {
+          // the last SC period of the 1024 frames starts at 10100 ms and lasts 140 ms
+          NS_TEST_ASSERT_MSG_EQ (scPeriod.frameNo, 1011, "Wrong last SC period");
+          NS_TEST_ASSERT_MSG_EQ (next.frameNo, 1, "Wrong first SC period");
+          wrapped = true;
+        }
+      scPeriod = next;
+    }
+  NS_TEST_ASSERT_MSG_EQ (wrapped, true, "The reservation did not cross the end of the frames");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the SC periods without transmission do not consume an
+ * SPS reservation: the next transmission is in the current SC period.
+ */
+class SidelinkSpsReservationShiftTestCase : public TestCase
+{
+public:
+  SidelinkSpsReservationShiftTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SidelinkSpsReservationShiftTestCase::SidelinkSpsReservationShiftTestCase ()
+  : TestCase ("SPS reservation shifted by SC periods without data")
+{
+}
+
+void
+SidelinkSpsReservationShiftTestCase::DoRun (void)
+{
+  LteSlPreconfigPoolFactory pfactory;
+  Ptr<SidelinkTxCommResourcePool> pool = CreateObject<SidelinkTxCommResourcePool> ();
+  pool->SetPool (pfactory.CreatePool ());
+
+  std::vector<SidelinkCommResourcePool::SubframeInfo> scPeriods (1);
+  scPeriods[0].frameNo = 1;
+  scPeriods[0].subframeNo = 1;
+  for (uint32_t i = 1; i < 8; i++)
+    {
+      scPeriods.push_back (NextScPeriod (pool, scPeriods.back ()));
+    }
+
+  LteSlSpsReservation sps;
+  sps.Reserve (95, 0, 5);
+  LteSlSpsReservation::Transmission tx = sps.Pop (scPeriods[0]);
+  NS_TEST_ASSERT_MSG_EQ (tx.subframe.frameNo, 10, "Wrong frame of the first transmission");
+  NS_TEST_ASSERT_MSG_EQ (tx.subframe.subframeNo, 6, "Wrong subframe of the first transmission");
+
+  // no data in the two following SC periods
+  tx = sps.Pop (scPeriods[3]);
+  NS_TEST_ASSERT_MSG_EQ ((tx.scPeriod == scPeriods[3]), true, "Transmission not shifted");
+  NS_TEST_ASSERT_MSG_EQ (tx.subframe.frameNo, 40, "Wrong frame of the shifted transmission");
+  NS_TEST_ASSERT_MSG_EQ (tx.subframe.subframeNo, 6, "Wrong subframe of the shifted transmission");
+  NS_TEST_ASSERT_MSG_EQ (sps.GetCounter (), 3, "SC periods without data consumed the reservation");
+
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      tx = sps.Pop (scPeriods[4 + i]);
+      NS_TEST_ASSERT_MSG_EQ ((tx.scPeriod == scPeriods[4 + i]), true, "Wrong SC period of transmission " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (sps.GetCounter (), 0, "Reservation not consumed");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink SPS reservation test suite
+ */
+class SidelinkSpsReservationTestSuite : public TestSuite
+{
+public:
+  SidelinkSpsReservationTestSuite ();
+};
+
+SidelinkSpsReservationTestSuite::SidelinkSpsReservationTestSuite ()
+  : TestSuite ("sidelink-sps-reservation", UNIT)
+{
+  AddTestCase (new SidelinkSpsReservationScheduleTestCase (), TestCase::QUICK);
+  AddTestCase (new SidelinkSpsReservationShiftTestCase (), TestCase::QUICK);
+}
+
+static SidelinkSpsReservationTestSuite staticSidelinkSpsReservationTestSuite;
@@ -0,0 +1,228 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/config.h>
+#include <ns3/node-container.h>
+#include <ns3/net-device-container.h>
+#include <ns3/mobility-helper.h>
+#include <ns3/position-allocator.h>
+#include <ns3/internet-stack-helper.h>
+#include <ns3/ipv4-static-routing-helper.h>
+#include <ns3/ipv4.h>
+#include <ns3/point-to-point-epc-helper.h>
+#include <ns3/udp-client-server-helper.h>
+#include <ns3/application-container.h>
+#include <ns3/lte-helper.h>
+#include <ns3/lte-sidelink-helper.h>
+#include <ns3/lte-sl-ue-rrc.h>
+#include <ns3/lte-sl-preconfig-pool-factory.h>
+#include <ns3/lte-ue-net-device.h>
+#include <ns3/lte-ue-phy.h>
+#include <ns3/lte-spectrum-phy.h>
+#include <map>
+#include <utility>
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("TestSidelinkV2xBroadcast");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the single V2X broadcast bearer activated by
+ * LteSidelinkHelper::ActivateV2xBroadcastBearer on all the UEs reaches all
+ * the receivers: some of the out of coverage V2V UEs transmit, and every
+ * UE, transmitting or not, must receive the PSCCH of every transmitter but
+ * itself. The transmitters are identified by their position.
+ */
+class SidelinkV2xBroadcastTestCase : public TestCase
+{
+public:
+  SidelinkV2xBroadcastTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// The position of a transmitter
+  typedef std::pair<int32_t, int32_t> TxPosition_t;
+
+  /**
+   * Count a PSCCH received without error
+   * \param counts The counts of the receiver, per transmitter
+   * \param params The reception parameters
+   */
+  static void SlPscchReception (std::map<TxPosition_t, uint32_t> *counts, SlPhyReceptionStatParameters params);
+};
+
+SidelinkV2xBroadcastTestCase::SidelinkV2xBroadcastTestCase ()
+  : TestCase ("V2X broadcast bearer reaching all the receivers")
+{
+}
+
+void
+SidelinkV2xBroadcastTestCase::SlPscchReception (std::map<TxPosition_t, uint32_t> *counts, SlPhyReceptionStatParameters params)
+{
+  if (params.m_correctness)
+    {
+      (*counts)[TxPosition_t (params.m_txPosX, params.m_txPosY)]++;
+    }
+}
+
+void
+SidelinkV2xBroadcastTestCase::DoRun (void)
+{
+  uint32_t nUes = 5;
+  uint32_t nTxUes = 3;
+
+  Config::SetDefault ("ns3::LteUeMac::SlGrantSize", UintegerValue (5));
+  Config::SetDefault ("ns3::LteUeMac::SlGrantMcs", UintegerValue (10));
+  Config::SetDefault ("ns3::LteUeMac::Ktrp", UintegerValue (1));
+  Config::SetDefault ("ns3::LteEnbNetDevice::UlEarfcn", UintegerValue (23330));
+  Config::SetDefault ("ns3::LteEnbNetDevice::UlBandwidth", UintegerValue (50));
+
+  Ptr<PointToPointEpcHelper> epcHelper = CreateObject<PointToPointEpcHelper> ();
+  Ptr<LteHelper> lteHelper = CreateObject<LteHelper> ();
+  lteHelper->SetEpcHelper (epcHelper);
+  lteHelper->DisableEnbPhy (true);
+  lteHelper->SetV2VMode (true);
+  lteHelper->SetRbPerSubChannel (10);
+  lteHelper->SetAttribute ("UseSidelink", BooleanValue (true));
+  lteHelper->Initialize ();
+  Ptr<LteSidelinkHelper> proseHelper = CreateObject<LteSidelinkHelper> ();
+  proseHelper->SetLteHelper (lteHelper);
+
+  NodeContainer ueNodes;
+  ueNodes.Create (nUes);
+  Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator> ();
+  positionAlloc->Add (Vector (0.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (-20.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (30.0, 0.0, 1.5));
+  positionAlloc->Add (Vector (0.0, 60.0, 1.5));
+  positionAlloc->Add (Vector (-40.0, -50.0, 1.5));
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  mobility.SetPositionAllocator (positionAlloc);
+  mobility.Install (ueNodes);
+
+  NetDeviceContainer ueDevs = lteHelper->InstallUeDevice (ueNodes);
+  lteHelper->AssignStreams (ueDevs, 1000);
+
+  InternetStackHelper internet;
+  internet.Install (ueNodes);
+  epcHelper->AssignUeIpv4Address (ueDevs);
+  Ipv4StaticRoutingHelper ipv4RoutingHelper;
+  for (uint32_t u = 0; u < ueNodes.GetN (); ++u)
+    {
+      Ptr<Ipv4StaticRouting> ueStaticRouting = ipv4RoutingHelper.GetStaticRouting (ueNodes.Get (u)->GetObject<Ipv4> ());
+      ueStaticRouting->SetDefaultRoute (epcHelper->GetUeDefaultGatewayAddress (), 1);
+    }
+
+  // one bearer per UE towards the shared destination, whether it transmits or not
+  Ipv4Address groupAddress ("225.0.0.1");
+  uint32_t groupL2Address = 0;
+  proseHelper->ActivateV2xBroadcastBearer (Seconds (1.0), ueDevs, groupAddress, groupL2Address);
+
+  NodeContainer txNodes;
+  for (uint32_t u = 0; u < nTxUes; u++)
+    {
+      txNodes.Add (ueNodes.Get (u));
+    }
+  UdpClientHelper udpClient (groupAddress, 8000);
+  udpClient.SetAttribute ("MaxPackets", UintegerValue (10));
+  udpClient.SetAttribute ("Interval", TimeValue (MilliSeconds (100)));
+  udpClient.SetAttribute ("PacketSize", UintegerValue (200));
+  ApplicationContainer clientApps = udpClient.Install (txNodes);
+  clientApps.Start (Seconds (2.0));
+  clientApps.Stop (Seconds (3.5));
+
+  Ptr<LteSlUeRrc> ueSidelinkConfiguration = CreateObject<LteSlUeRrc> ();
+  ueSidelinkConfiguration->SetSlEnabled (true);
+  LteRrcSap::SlPreconfiguration preconfiguration;
+  preconfiguration.preconfigGeneral.carrierFreq = 23330;
+  preconfiguration.preconfigGeneral.slBandwidth = 50;
+  preconfiguration.preconfigComm.nbPools = 1;
+  LteSlPreconfigPoolFactory pfactory;
+  pfactory.SetControlBitmap (0x00000000FF);
+  pfactory.SetControlPeriod ("sf50");
+  pfactory.SetControlPrbNum (22);
+  pfactory.SetDataOffset (8);
+  pfactory.SetRbPerSubChannel (10);
+  preconfiguration.preconfigComm.pools[0] = pfactory.CreatePool ();
+  ueSidelinkConfiguration->SetSlPreconfiguration (preconfiguration);
+  lteHelper->InstallSidelinkConfiguration (ueDevs, ueSidelinkConfiguration);
+
+  std::vector<std::map<TxPosition_t, uint32_t> > counts (nUes);
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      Ptr<LteSpectrumPhy> slPhy = ueDevs.Get (i)->GetObject<LteUeNetDevice> ()->GetPhy ()->GetSlSpectrumPhy ();
+      slPhy->TraceConnectWithoutContext ("SlPscchReception",
+                                         MakeBoundCallback (&SidelinkV2xBroadcastTestCase::SlPscchReception, &counts[i]));
+    }
+
+  Simulator::Stop (Seconds (4.0));
+  Simulator::Run ();
+
+  std::vector<TxPosition_t> txPositions;
+  for (uint32_t u = 0; u < nTxUes; u++)
+    {
+      Vector position = ueNodes.Get (u)->GetObject<MobilityModel> ()->GetPosition ();
+      txPositions.push_back (TxPosition_t (position.x, position.y));
+    }
+  Simulator::Destroy ();
+
+  for (uint32_t i = 0; i < nUes; i++)
+    {
+      uint32_t nHeardTxUes = (i < nTxUes) ? nTxUes - 1 : nTxUes;
+      NS_TEST_EXPECT_MSG_EQ (counts[i].size (), nHeardTxUes,
+                             "Receiver " << i << " did not hear the expected number of transmitters");
+      for (uint32_t u = 0; u < nTxUes; u++)
+        {
+          if (u != i)
+            {
+              NS_TEST_EXPECT_MSG_GT (counts[i][txPositions[u]], 0,
+                                     "Receiver " << i << " received no PSCCH from transmitter " << u);
+            }
+        }
+    }
+}
+
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Sidelink V2X broadcast test suite
+ */
+class SidelinkV2xBroadcastTestSuite : public TestSuite
+{
+public:
+  SidelinkV2xBroadcastTestSuite ();
+};
+
+SidelinkV2xBroadcastTestSuite::SidelinkV2xBroadcastTestSuite ()
+  : TestSuite ("sidelink-v2x-broadcast", SYSTEM)
+{
+  AddTestCase (new SidelinkV2xBroadcastTestCase (), TestCase::QUICK);
+}
+
+static SidelinkV2xBroadcastTestSuite staticSidelinkV2xBroadcastTestSuite;
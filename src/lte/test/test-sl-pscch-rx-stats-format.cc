@@ -0,0 +1,155 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/sl-pscch-rx-stats-format.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE ("TestSlPscchRxStatsFormat");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test that the binary PSCCH statistics are read back and
+ * converted to the same text as written by the text format, also for
+ * the values stored in extension records, and that they are smaller
+ * than the text format.
+ */
+class SlPscchRxStatsFormatTestCase : public TestCase
+{
+public:
+  SlPscchRxStatsFormatTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+SlPscchRxStatsFormatTestCase::SlPscchRxStatsFormatTestCase ()
+  : TestCase ("Binary PSCCH reception statistics round trip")
+{
+}
+
+void
+SlPscchRxStatsFormatTestCase::DoRun (void)
+{
+  std::string binaryFilename = CreateTempDirFilename ("SlPscchRxPhyStats.bin");
+  std::string textFilename = CreateTempDirFilename ("SlPscchRxPhyStats.txt");
+
+  std::ofstream binaryFile (binaryFilename.c_str (), std::ios_base::out | std::ios_base::binary);
+  std::ostringstream expectedText;
+  SlPscchRxStatsFormat::WriteBinaryHeader (binaryFile);
+  int64_t lastTimestamp = 0;
+  int64_t timestamp = 100000;
+  const uint32_t nRecords = 1000;
+  for (uint32_t i = 0; i < nRecords; i++)
+    {
+      // a few receptions per subframe, a long silence and a step back
+      // in time, that both need a time record
+      timestamp += (i % 3 == 0) ? 1 : 0;
+      if (i == 500)
+        {
+          timestamp += 100000;
+        }
+      if (i == 700)
+        {
+          timestamp -= 50;
+        }
+      SlPhyReceptionStatParameters params;
+      std::memset (&params, 0, sizeof (params));
+      params.m_timestamp = timestamp;
+      params.m_frl = i % 5;
+      params.m_TJAlgo = (i / 100) % 2;
+      params.m_rnti = 1 + i % 200;
+      params.m_imsi = 1 + (i * 7) % 200;
+      params.m_weakSignal = (i % 11 == 0);
+      params.m_conflict = (i % 13 == 0);
+      params.m_msgInterval = 100 * (1 + i % 3);
+      params.m_consecutiveMiss = i % 4;
+      params.m_isTx = (i % 17 == 0);
+      params.m_rxType = i % 5;
+      SlPscchRxStatsFormat::WriteBinaryRecord (binaryFile, params, lastTimestamp);
+      SlPscchRxStatsFormat::WriteTextRecord (expectedText, params);
+    }
+  // the values that do not fit in the record go to an extension record
+  SlPhyReceptionStatParameters params;
+  std::memset (&params, 0, sizeof (params));
+  params.m_timestamp = timestamp;
+  params.m_imsi = 4294967295u;
+  params.m_rnti = 65535;
+  params.m_msgInterval = 200000;
+  params.m_consecutiveMiss = 65535;
+  SlPscchRxStatsFormat::WriteBinaryRecord (binaryFile, params, lastTimestamp);
+  SlPscchRxStatsFormat::WriteTextRecord (expectedText, params);
+  params.m_imsi = 70000;
+  params.m_msgInterval = 100;
+  params.m_consecutiveMiss = 4294967295u;
+  SlPscchRxStatsFormat::WriteBinaryRecord (binaryFile, params, lastTimestamp);
+  SlPscchRxStatsFormat::WriteTextRecord (expectedText, params);
+  params.m_imsi = 65534;
+  params.m_consecutiveMiss = 0;
+  SlPscchRxStatsFormat::WriteBinaryRecord (binaryFile, params, lastTimestamp);
+  SlPscchRxStatsFormat::WriteTextRecord (expectedText, params);
+  binaryFile.close ();
+
+  std::ifstream binarySize (binaryFilename.c_str (), std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  double ratio = expectedText.str ().size () / (double) binarySize.tellg ();
+  NS_LOG_INFO ("Text size " << expectedText.str ().size () << " binary size " << binarySize.tellg ()
+               << " record size " << SlPscchRxStatsFormat::GetRecordSize ());
+  NS_TEST_ASSERT_MSG_GT (ratio, 2.5, "Binary format not enough smaller than the text format");
+
+  SlPscchRxStatsReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (binaryFilename), true, "Can't read the binary file");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetNRecords (), nRecords + 3, "Wrong number of records");
+  SlPhyReceptionStatParameters first;
+  NS_TEST_ASSERT_MSG_EQ (reader.ReadNext (first), true, "Can't read the first record");
+  NS_TEST_ASSERT_MSG_EQ (first.m_timestamp, 100001, "Wrong first timestamp");
+  NS_TEST_ASSERT_MSG_EQ (first.m_rnti, 1, "Wrong first RNTI");
+
+  NS_TEST_ASSERT_MSG_EQ (SlPscchRxStatsReader::ConvertToText (binaryFilename, textFilename), true, "Conversion failed");
+  std::ifstream textFile (textFilename.c_str ());
+  std::ostringstream text;
+  text << textFile.rdbuf ();
+  NS_TEST_ASSERT_MSG_EQ (text.str (), expectedText.str (), "Converted text differs from the text format");
+
+  // a text file is not accepted by the reader
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (textFilename), false, "Text file accepted as binary");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Binary PSCCH reception statistics test suite
+ */
+class SlPscchRxStatsFormatTestSuite : public TestSuite
+{
+public:
+  SlPscchRxStatsFormatTestSuite ();
+};
+
+SlPscchRxStatsFormatTestSuite::SlPscchRxStatsFormatTestSuite ()
+  : TestSuite ("sl-pscch-rx-stats-format", UNIT)
+{
+  AddTestCase (new SlPscchRxStatsFormatTestCase (), TestCase::QUICK);
+}
+
+static SlPscchRxStatsFormatTestSuite staticSlPscchRxStatsFormatTestSuite;
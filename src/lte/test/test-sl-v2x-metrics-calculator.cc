@@ -0,0 +1,169 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/sl-v2x-metrics-calculator.h"
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/string.h>
+#include <ns3/double.h>
+#include <ns3/nstime.h>
+#include <fstream>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE ("TestSlV2xMetricsCalculator");
+
+using namespace ns3;
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief Test the PRR, inter-packet gap and failure cause aggregates
+ * written by the SlV2xMetricsCalculator for a few receptions.
+ */
+class SlV2xMetricsCalculatorTestCase : public TestCase
+{
+public:
+  SlV2xMetricsCalculatorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Build a reception
+   * \param timestamp The time of the reception (ms)
+   * \param distance The distance between the transmitter and the receiver (m)
+   * \param correct True if the reception is successful
+   * \param rxType The reception type
+   * \param msgInterval The interval since the last successful reception (ms)
+   * \return The reception
+   */
+  static SlPhyReceptionStatParameters MakeReception (int64_t timestamp, int32_t distance, bool correct,
+                                                      uint32_t rxType, uint32_t msgInterval);
+
+  /**
+   * Read the lines of a file, without the column description
+   * \param filename The name of the file
+   * \return The lines
+   */
+  static std::vector<std::string> ReadLines (std::string filename);
+};
+
+SlV2xMetricsCalculatorTestCase::SlV2xMetricsCalculatorTestCase ()
+  : TestCase ("V2X metrics aggregation")
+{
+}
+
+SlPhyReceptionStatParameters
+SlV2xMetricsCalculatorTestCase::MakeReception (int64_t timestamp, int32_t distance, bool correct,
+                                               uint32_t rxType, uint32_t msgInterval)
+{
+  SlPhyReceptionStatParameters params;
+  std::memset (&params, 0, sizeof (params));
+  params.m_timestamp = timestamp;
+  params.m_rnti = 1;
+  params.m_txPosX = 10;
+  params.m_rxPosX = 10 + distance;
+  params.m_correctness = correct;
+  params.m_rxType = rxType;
+  params.m_msgInterval = msgInterval;
+  return params;
+}
+
+std::vector<std::string>
+SlV2xMetricsCalculatorTestCase::ReadLines (std::string filename)
+{
+  std::vector<std::string> lines;
+  std::ifstream file (filename.c_str ());
+  std::string line;
+  while (std::getline (file, line))
+    {
+      if (!line.empty () && line[0] != '%')
+        {
+          lines.push_back (line);
+        }
+    }
+  return lines;
+}
+
+void
+SlV2xMetricsCalculatorTestCase::DoRun (void)
+{
+  std::string prrFilename = CreateTempDirFilename ("SlV2xPrrStats.txt");
+  std::string ipgFilename = CreateTempDirFilename ("SlV2xIpgStats.txt");
+  std::string failureFilename = CreateTempDirFilename ("SlV2xFailureStats.txt");
+
+  Ptr<SlV2xMetricsCalculator> metrics = CreateObject<SlV2xMetricsCalculator> ();
+  metrics->SetAttribute ("PrrOutputFilename", StringValue (prrFilename));
+  metrics->SetAttribute ("InterPacketGapOutputFilename", StringValue (ipgFilename));
+  metrics->SetAttribute ("FailureOutputFilename", StringValue (failureFilename));
+  metrics->SetAttribute ("WindowDuration", TimeValue (MilliSeconds (100)));
+  metrics->SetAttribute ("DistanceBinWidth", DoubleValue (50.0));
+  metrics->SetAttribute ("MaxDistance", DoubleValue (150.0));
+  metrics->SetAttribute ("InterPacketGapBinWidth", TimeValue (MilliSeconds (100)));
+  metrics->SetAttribute ("MaxInterPacketGap", TimeValue (MilliSeconds (300)));
+
+  // first window
+  metrics->SlPscchReception (MakeReception (10, 30, true, 0, 0));
+  metrics->SlPscchReception (MakeReception (20, 60, false, 1, 0));
+  metrics->SlPscchReception (MakeReception (50, 120, false, 2, 0));
+  metrics->SlPscchReception (MakeReception (60, 200, true, 0, 250));
+  // second window
+  metrics->SlPscchReception (MakeReception (150, 10, false, 4, 0));
+  metrics->SlPscchReception (MakeReception (160, 10, true, 0, 500));
+  metrics->SlPscchReception (MakeReception (170, 10, false, 3, 0));
+
+  // writes the last window and closes the files
+  Simulator::Destroy ();
+
+  std::vector<std::string> failures = ReadLines (failureFilename);
+  NS_TEST_ASSERT_MSG_EQ (failures.size (), 2, "Wrong number of windows");
+  NS_TEST_ASSERT_MSG_EQ (failures[0], "0\t100\t4\t2\t1\t1\t0\t0\t0", "Wrong failure causes in the first window");
+  NS_TEST_ASSERT_MSG_EQ (failures[1], "100\t200\t3\t1\t0\t0\t1\t1\t0", "Wrong failure causes in the second window");
+
+  std::vector<std::string> prr = ReadLines (prrFilename);
+  NS_TEST_ASSERT_MSG_EQ (prr.size (), 6, "Wrong number of distance bins");
+  NS_TEST_ASSERT_MSG_EQ (prr[0], "0\t100\t0\t50\t1\t1\t1", "Wrong PRR in the first bin");
+  NS_TEST_ASSERT_MSG_EQ (prr[1], "0\t100\t50\t100\t1\t0\t0", "Wrong PRR in the second bin");
+  NS_TEST_ASSERT_MSG_EQ (prr[2], "0\t100\t100\t150\t2\t1\t0.5", "Wrong PRR in the last bin");
+  NS_TEST_ASSERT_MSG_EQ (prr[3], "100\t200\t0\t50\t3\t1\t0.333333", "Wrong PRR in the second window");
+
+  std::vector<std::string> ipg = ReadLines (ipgFilename);
+  NS_TEST_ASSERT_MSG_EQ (ipg.size (), 8, "Wrong number of inter-packet gap bins");
+  NS_TEST_ASSERT_MSG_EQ (ipg[2], "0\t100\t200\t300\t1", "Wrong inter-packet gap in the first window");
+  NS_TEST_ASSERT_MSG_EQ (ipg[7], "100\t200\t300\tinf\t1", "Wrong inter-packet gap above the maximum");
+}
+
+/**
+ * \ingroup lte-test
+ * \ingroup tests
+ *
+ * \brief V2X metrics aggregation test suite
+ */
+class SlV2xMetricsCalculatorTestSuite : public TestSuite
+{
+public:
+  SlV2xMetricsCalculatorTestSuite ();
+};
+
+SlV2xMetricsCalculatorTestSuite::SlV2xMetricsCalculatorTestSuite ()
+  : TestSuite ("sl-v2x-metrics-calculator", UNIT)
+{
+  AddTestCase (new SlV2xMetricsCalculatorTestCase (), TestCase::QUICK);
+}
+
+static SlV2xMetricsCalculatorTestSuite staticSlV2xMetricsCalculatorTestSuite;
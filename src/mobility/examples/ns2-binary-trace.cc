@@ -0,0 +1,63 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * This example converts a ns-2 movement trace to a binary mobility trace,
+ * which Ns2BinaryMobilityHelper loads without parsing the ns-2 trace again.
+ *
+ * Usage of ns2-binary-trace:
+ *
+ *  ./waf --run "ns2-binary-trace \
+ *        --traceFile=src/mobility/examples/default.ns_movements
+ *        --binaryFile=default.ns_movements.bin"
+ *
+ *  Then, in the simulation scripts, replace
+ *
+ *    Ns2MobilityHelper mobility (traceFile);
+ *
+ *  with
+ *
+ *    Ns2BinaryMobilityHelper mobility (binaryFile);
+ */
+
+#include <iostream>
+#include "ns3/core-module.h"
+#include "ns3/ns2-mobility-helper.h"
+
+using namespace ns3;
+
+int main (int argc, char *argv[])
+{
+  std::string traceFile;
+  std::string binaryFile;
+
+  CommandLine cmd;
+  cmd.AddValue ("traceFile", "Ns2 movement trace file", traceFile);
+  cmd.AddValue ("binaryFile", "Binary mobility trace file to write", binaryFile);
+  cmd.Parse (argc, argv);
+
+  if (traceFile.empty () || binaryFile.empty ())
+    {
+      std::cout << "Usage of " << argv[0] << " :\n\n"
+      "./waf --run \"ns2-binary-trace"
+      " --traceFile=src/mobility/examples/default.ns_movements"
+      " --binaryFile=default.ns_movements.bin\"\n";
+      return 0;
+    }
+
+  Ns2MobilityHelper (traceFile).WriteBinaryTrace (binaryFile);
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns2-binary-mobility-helper.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ns2BinaryMobilityHelper");
+
+const uint32_t Ns2BinaryTraceHeader::FORMAT_VERSION;
+const uint32_t Ns2BinaryTraceHeader::BYTE_ORDER_MARK;
+
+/**
+ * Binary mobility trace mapped in memory, unmapped when the last
+ * movement has been done
+ */
+class Ns2BinaryTrace : public SimpleRefCount<Ns2BinaryTrace>
+{
+public:
+  /**
+   * Map the trace in memory and check its layout
+   * \param filename filename of the binary mobility trace
+   */
+  Ns2BinaryTrace (std::string filename);
+  ~Ns2BinaryTrace ();
+
+  /// \return the number of node entries
+  uint32_t GetNNodes (void) const;
+  /// \return the number of movement entries
+  uint64_t GetNMovements (void) const;
+  /**
+   * \param id the node ID
+   * \return the entry of the node
+   */
+  const Ns2BinaryTraceNode & GetNode (uint32_t id) const;
+  /**
+   * Schedule a movement of a node
+   * \param model the mobility model of the node
+   * \param movement the index of the movement
+   * \param end the index after the last movement of the node
+   */
+  void ScheduleMovement (Ptr<ConstantVelocityMobilityModel> model, uint64_t movement, uint64_t end);
+
+private:
+  /**
+   * Do a movement of a node and schedule its next one
+   * \param model the mobility model of the node
+   * \param movement the index of the movement
+   * \param end the index after the last movement of the node
+   */
+  void Move (Ptr<ConstantVelocityMobilityModel> model, uint64_t movement, uint64_t end);
+
+  void *m_data;      //!< mapped file
+  size_t m_size;     //!< size of the mapped file
+  Time m_start;      //!< time of the installation, the origin of the movement times
+  const Ns2BinaryTraceHeader *m_header;     //!< header of the trace
+  const Ns2BinaryTraceNode *m_nodes;        //!< node entries
+  const Ns2BinaryTraceMovement *m_movements; //!< movement entries
+};
+
+Ns2BinaryTrace::Ns2BinaryTrace (std::string filename)
+  : m_data (MAP_FAILED),
+    m_size (0),
+    m_start (Simulator::Now ())
+{
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_FATAL_ERROR ("Could not open binary trace file " << filename << " for reading");
+    }
+  struct stat st;
+  if (fstat (fd, &st) == 0 && st.st_size >= (off_t) sizeof (Ns2BinaryTraceHeader))
+    {
+      m_size = st.st_size;
+      m_data = mmap (0, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+  close (fd);
+  if (m_data == MAP_FAILED)
+    {
+      NS_FATAL_ERROR ("Could not map binary trace file " << filename);
+    }
+
+  m_header = static_cast<const Ns2BinaryTraceHeader *> (m_data);
+  if (std::memcmp (m_header->m_magic, "NS2BMOB", 8) != 0 || m_header->m_version != Ns2BinaryTraceHeader::FORMAT_VERSION)
+    {
+      NS_FATAL_ERROR ("File " << filename << " is not a binary mobility trace (version "
+                              << Ns2BinaryTraceHeader::FORMAT_VERSION << ")");
+    }
+  if (m_header->m_byteOrder != Ns2BinaryTraceHeader::BYTE_ORDER_MARK)
+    {
+      NS_FATAL_ERROR ("Binary trace file " << filename << " was written on a machine with another byte order");
+    }
+  // check the counts against the file size before computing any entry
+  // address, without overflowing whatever the counts
+  size_t remaining = m_size - sizeof (Ns2BinaryTraceHeader);
+  if (m_header->m_nNodes > remaining / sizeof (Ns2BinaryTraceNode))
+    {
+      NS_FATAL_ERROR ("Binary trace file " << filename << " is truncated");
+    }
+  remaining -= m_header->m_nNodes * sizeof (Ns2BinaryTraceNode);
+  if (m_header->m_nMovements > remaining / sizeof (Ns2BinaryTraceMovement)
+      || remaining != m_header->m_nMovements * sizeof (Ns2BinaryTraceMovement))
+    {
+      NS_FATAL_ERROR ("Binary trace file " << filename << " is truncated");
+    }
+  m_nodes = reinterpret_cast<const Ns2BinaryTraceNode *> (m_header + 1);
+  m_movements = reinterpret_cast<const Ns2BinaryTraceMovement *> (m_nodes + m_header->m_nNodes);
+  NS_LOG_INFO ("Mapped " << filename << ": " << m_header->m_nNodes << " nodes, "
+                         << m_header->m_nMovements << " movements");
+}
+
+Ns2BinaryTrace::~Ns2BinaryTrace ()
+{
+  munmap (m_data, m_size);
+}
+
+uint32_t
+Ns2BinaryTrace::GetNNodes (void) const
+{
+  return m_header->m_nNodes;
+}
+
+uint64_t
+Ns2BinaryTrace::GetNMovements (void) const
+{
+  return m_header->m_nMovements;
+}
+
+const Ns2BinaryTraceNode &
+Ns2BinaryTrace::GetNode (uint32_t id) const
+{
+  return m_nodes[id];
+}
+
+void
+Ns2BinaryTrace::ScheduleMovement (Ptr<ConstantVelocityMobilityModel> model, uint64_t movement, uint64_t end)
+{
+  Time delay = Seconds (m_movements[movement].m_time) - (Simulator::Now () - m_start);
+  Simulator::Schedule (delay, &Ns2BinaryTrace::Move, Ptr<Ns2BinaryTrace> (this), model, movement, end);
+}
+
+void
+Ns2BinaryTrace::Move (Ptr<ConstantVelocityMobilityModel> model, uint64_t movement, uint64_t end)
+{
+  const Ns2BinaryTraceMovement &m = m_movements[movement];
+  Vector value (m.m_value[0], m.m_value[1], m.m_value[2]);
+  if (m.m_type == Ns2BinaryTraceMovement::SET_POSITION)
+    {
+      model->SetPosition (value);
+    }
+  else
+    {
+      model->SetVelocity (value);
+    }
+  if (movement + 1 < end)
+    {
+      ScheduleMovement (model, movement + 1, end);
+    }
+}
+
+
+Ns2BinaryMobilityHelper::Ns2BinaryMobilityHelper (std::string filename)
+  : m_filename (filename)
+{
+}
+
+void
+Ns2BinaryMobilityHelper::ConfigNodesMovements (const ObjectStore &store) const
+{
+  Ptr<Ns2BinaryTrace> trace = Create<Ns2BinaryTrace> (m_filename);
+  for (uint32_t id = 0; id < trace->GetNNodes (); id++)
+    {
+      const Ns2BinaryTraceNode &node = trace->GetNode (id);
+      if (!node.m_inTrace)
+        {
+          continue;
+        }
+      if (node.m_firstMovement > trace->GetNMovements ()
+          || node.m_nMovements > trace->GetNMovements () - node.m_firstMovement)
+        {
+          NS_FATAL_ERROR ("Movements of node " << id << " out of the binary trace file " << m_filename << " (corrupted file?)");
+        }
+      Ptr<Object> object = store.Get (id);
+      if (object == 0)
+        {
+          NS_LOG_ERROR ("Unknown node ID (corrupted file?): " << id << "\n");
+          continue;
+        }
+      Ptr<ConstantVelocityMobilityModel> model = object->GetObject<ConstantVelocityMobilityModel> ();
+      if (model == 0)
+        {
+          model = CreateObject<ConstantVelocityMobilityModel> ();
+          object->AggregateObject (model);
+        }
+      model->SetPosition (Vector (node.m_position[0], node.m_position[1], node.m_position[2]));
+      if (node.m_nMovements > 0)
+        {
+          trace->ScheduleMovement (model, node.m_firstMovement, node.m_firstMovement + node.m_nMovements);
+        }
+    }
+}
+
+void
+Ns2BinaryMobilityHelper::Install (void) const
+{
+  Install (NodeList::Begin (), NodeList::End ());
+}
+
+} // namespace ns3
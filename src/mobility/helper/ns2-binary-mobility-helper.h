@@ -0,0 +1,180 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef NS2_BINARY_MOBILITY_HELPER_H
+#define NS2_BINARY_MOBILITY_HELPER_H
+
+#include <string>
+#include <stdint.h>
+#include "ns3/ptr.h"
+#include "ns3/object.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup mobility
+ * \brief Header of a binary mobility trace.
+ *
+ * A binary mobility trace, written by Ns2MobilityHelper::WriteBinaryTrace,
+ * holds the movements resulting from the parsing of a ns-2 trace. The
+ * file is made of the header, one Ns2BinaryTraceNode entry per node ID
+ * from 0 to the largest node ID of the trace, and the
+ * Ns2BinaryTraceMovement entries of all the nodes. The movements of a
+ * node are contiguous and sorted by time, in the order the simulator
+ * does them; the node entry gives the index and number of the movements
+ * of the node. The values are stored in the byte order of the machine
+ * which wrote the file, given by m_byteOrder; a file written on a machine
+ * with another byte order is rejected.
+ */
+struct Ns2BinaryTraceHeader
+{
+  static const uint32_t FORMAT_VERSION = 2;           //!< version of the format
+  static const uint32_t BYTE_ORDER_MARK = 0x01020304; //!< byte order marker
+
+  char m_magic[8];        //!< "NS2BMOB" and a null character
+  uint32_t m_version;     //!< version of the format
+  uint32_t m_byteOrder;   //!< BYTE_ORDER_MARK in the byte order of the writer
+  uint32_t m_nNodes;      //!< number of node entries
+  uint32_t m_reserved;    //!< unused, zero
+  uint64_t m_nMovements;  //!< number of movement entries
+};
+
+/**
+ * \ingroup mobility
+ * \brief Node entry of a binary mobility trace
+ */
+struct Ns2BinaryTraceNode
+{
+  uint64_t m_firstMovement; //!< index of the first movement of the node
+  uint32_t m_nMovements;    //!< number of movements of the node
+  uint32_t m_inTrace;       //!< 1 if the node appears in the trace, 0 otherwise
+  double m_position[3];     //!< position of the node at install time
+};
+
+/**
+ * \ingroup mobility
+ * \brief Movement entry of a binary mobility trace
+ */
+struct Ns2BinaryTraceMovement
+{
+  /// Type of movement
+  enum Type
+  {
+    SET_VELOCITY = 0, //!< the node changes its velocity
+    SET_POSITION = 1  //!< the node jumps to a position
+  };
+  double m_time;        //!< time of the movement, in seconds from the installation
+  uint32_t m_type;      //!< type of movement
+  uint32_t m_reserved;  //!< unused, zero
+  double m_value[3];    //!< new velocity or position
+};
+
+/**
+ * \ingroup mobility
+ * \brief Helper class which configures the mobility of the nodes from a
+ * binary mobility trace.
+ *
+ * The binary trace is written once from a ns-2 trace with
+ * Ns2MobilityHelper::WriteBinaryTrace. Loading it does not involve any
+ * parsing: the file is mapped in memory, so several simulations running
+ * the same scenario share its pages. The nodes move as with
+ * Ns2MobilityHelper, with ConstantVelocityMobilityModel models, and
+ * only the next movement of each node is scheduled.
+ */
+class Ns2BinaryMobilityHelper
+{
+public:
+  /**
+   * \param filename filename of the binary mobility trace
+   */
+  Ns2BinaryMobilityHelper (std::string filename);
+
+  /**
+   * Configure the movement patterns of all nodes contained in the
+   * global ns3::NodeList whose nodeId matches the nodeId of the nodes
+   * in the trace file.
+   */
+  void Install (void) const;
+
+  /**
+   * \param begin an iterator which points to the start of the input
+   *        object array.
+   * \param end an iterator which points to the end of the input
+   *        object array.
+   *
+   * Configure the movement patterns of all input objects. Each input
+   * object is identified by a unique node id which reflects the index
+   * of the object in the input array.
+   */
+  template <typename T>
+  void Install (T begin, T end) const;
+private:
+  /**
+   * \brief a class to hold input objects internally
+   */
+  class ObjectStore
+  {
+public:
+    virtual ~ObjectStore () {}
+    /**
+     * Return ith object in store
+     * \param i index
+     * \return pointer to object
+     */
+    virtual Ptr<Object> Get (uint32_t i) const = 0;
+  };
+  /**
+   * Sets the initial positions and schedules the first movement of
+   * each node of the binary trace
+   * \param store Object store containing ns-3 mobility models
+   */
+  void ConfigNodesMovements (const ObjectStore &store) const;
+  std::string m_filename; //!< filename of file containing the binary mobility trace
+};
+
+} // namespace ns3
+
+namespace ns3 {
+
+template <typename T>
+void
+Ns2BinaryMobilityHelper::Install (T begin, T end) const
+{
+  class MyObjectStore : public ObjectStore
+  {
+public:
+    MyObjectStore (T begin, T end)
+      : m_begin (begin),
+        m_end (end)
+    {}
+    virtual Ptr<Object> Get (uint32_t i) const {
+      T iterator = m_begin;
+      iterator += i;
+      if (iterator >= m_end)
+        {
+          return 0;
+        }
+      return *iterator;
+    }
+private:
+    T m_begin;
+    T m_end;
+  };
+  ConfigNodesMovements (MyObjectStore (begin, end));
+}
+
+} // namespace ns3
+
+#endif /* NS2_BINARY_MOBILITY_HELPER_H */
@@ -41,13 +41,17 @@
 #include <fstream>
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <cstring>
 #include "ns3/log.h"
 #include "ns3/unused.h"
 #include "ns3/simulator.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/node-list.h"
 #include "ns3/node.h"
 #include "ns3/constant-velocity-mobility-model.h"
 #include "ns2-mobility-helper.h"
+#include "ns2-binary-mobility-helper.h"
 
 namespace ns3 {
 
@@ -76,6 +80,20 @@ struct ParseResult
   std::vector<bool> has_dval; //!< points if a tokens has a double value
   std::vector<std::string> svals;  //!< string value for each token
 };
+/**
+ * Identifier of a velocity change scheduled by a Ns2MovementScheduler,
+ * to cancel it: the simulator event of the change, or the index of the
+ * change in the movements recorded for a binary trace
+ */
+struct Ns2MovementHandle
+{
+  EventId m_event;  //!< Event of the change, when scheduled in the simulator
+  uint32_t m_index; //!< Index plus one of the change, when recorded; 0 for none
+  Ns2MovementHandle () :
+    m_index (0)
+  {};
+};
+
 /**
  * Keeps last movement schedule. If new movement occurs during
  * a current one, node stopping must be cancels (stored in a proper
@@ -88,7 +106,7 @@ struct DestinationPoint
   Vector m_startPosition;     //!< Start position of last movement
   Vector m_speed;             //!< Speed of the last movement (needed to derive reached destination at next schedule = start + velocity * actuallyTravelled)
   Vector m_finalPosition;     //!< Final destination to be reached before next schedule. Replaced with actually reached if needed.
-  EventId m_stopEvent;        //!< Event scheduling node's stop. May be canceled if needed.
+  Ns2MovementHandle m_stopEvent; //!< Scheduled node's stop. May be canceled if needed.
   double m_travelStartTime;   //!< Travel start time is needed to calculate actually traveled time
   double m_targetArrivalTime; //!< When a station arrives to a destination
   DestinationPoint () :
@@ -100,6 +118,195 @@ struct DestinationPoint
   {};
 };
 
+/**
+ * Destination of the movements parsed from the trace: the simulator, or
+ * a binary trace being written. The times are the trace times, in seconds.
+ */
+class Ns2MovementScheduler
+{
+public:
+  virtual ~Ns2MovementScheduler () {}
+  /**
+   * \return the current time in the time base of the trace
+   */
+  virtual Time GetTraceTime (void) const = 0;
+  /**
+   * Schedule a velocity change
+   * \param model the mobility model of the node
+   * \param at the time of the change
+   * \param velocity the new velocity
+   * \return the identifier of the change, to cancel it
+   */
+  virtual Ns2MovementHandle ScheduleVelocity (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &velocity) = 0;
+  /**
+   * Schedule a position change
+   * \param model the mobility model of the node
+   * \param at the time of the change
+   * \param position the new position
+   */
+  virtual void SchedulePosition (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &position) = 0;
+  /**
+   * Cancel a velocity change
+   * \param event the identifier of the change
+   */
+  virtual void Cancel (Ns2MovementHandle &handle) = 0;
+};
+
+/**
+ * Schedules the movements in the simulator, the trace times starting
+ * when the scheduler is created
+ */
+class Ns2SimulatorScheduler : public Ns2MovementScheduler
+{
+public:
+  Ns2SimulatorScheduler () :
+    m_start (Simulator::Now ())
+  {};
+  virtual Time GetTraceTime (void) const
+  {
+    return Simulator::Now () - m_start;
+  }
+  virtual Ns2MovementHandle ScheduleVelocity (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &velocity)
+  {
+    Ns2MovementHandle handle;
+    handle.m_event = Simulator::Schedule (Seconds (at) - GetTraceTime (), &ConstantVelocityMobilityModel::SetVelocity, model, velocity);
+    return handle;
+  }
+  virtual void SchedulePosition (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &position)
+  {
+    Simulator::Schedule (Seconds (at) - GetTraceTime (), &ConstantVelocityMobilityModel::SetPosition, model, position);
+  }
+  virtual void Cancel (Ns2MovementHandle &handle)
+  {
+    handle.m_event.Cancel ();
+  }
+private:
+  Time m_start; //!< time of the installation, the origin of the trace times
+};
+
+/**
+ * Records the movements parsed from the trace, to write a binary trace.
+ * The identifier of a recorded movement is its index plus one.
+ */
+class Ns2BinaryTraceRecorder : public Ns2MovementScheduler
+{
+public:
+  virtual Time GetTraceTime (void) const
+  {
+    return Seconds (0);
+  }
+  virtual Ns2MovementHandle ScheduleVelocity (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &velocity)
+  {
+    Record (model, at, Ns2BinaryTraceMovement::SET_VELOCITY, velocity);
+    Ns2MovementHandle handle;
+    handle.m_index = m_movements.size ();
+    return handle;
+  }
+  virtual void SchedulePosition (Ptr<ConstantVelocityMobilityModel> model, double at, const Vector &position)
+  {
+    Record (model, at, Ns2BinaryTraceMovement::SET_POSITION, position);
+  }
+  virtual void Cancel (Ns2MovementHandle &handle)
+  {
+    if (handle.m_index > 0)
+      {
+        m_movements[handle.m_index - 1].m_cancelled = true;
+        handle.m_index = 0;
+      }
+  }
+  /**
+   * Write the binary trace
+   * \param filename filename of the binary trace
+   * \param objects the objects of the nodes of the trace, by node ID
+   */
+  void Write (std::string filename, const std::map<uint32_t, Ptr<Object> > &objects) const;
+private:
+  /// A recorded movement
+  struct Movement
+  {
+    Ptr<ConstantVelocityMobilityModel> m_model; //!< mobility model of the node
+    Ns2BinaryTraceMovement m_movement;          //!< the movement
+    bool m_cancelled;                           //!< true if the movement was canceled
+  };
+  /**
+   * Record a movement
+   * \param model the mobility model of the node
+   * \param at the time of the movement
+   * \param type the type of movement
+   * \param value the new velocity or position
+   */
+  void Record (Ptr<ConstantVelocityMobilityModel> model, double at, uint32_t type, const Vector &value)
+  {
+    Movement m;
+    m.m_model = model;
+    m.m_movement.m_time = at;
+    m.m_movement.m_type = type;
+    m.m_movement.m_reserved = 0;
+    m.m_movement.m_value[0] = value.x;
+    m.m_movement.m_value[1] = value.y;
+    m.m_movement.m_value[2] = value.z;
+    m.m_cancelled = false;
+    m_movements.push_back (m);
+  }
+  /**
+   * \param a a movement
+   * \param b another movement
+   * \return true if a is done before b by the simulator
+   */
+  static bool IsBefore (const Ns2BinaryTraceMovement &a, const Ns2BinaryTraceMovement &b)
+  {
+    return Seconds (a.m_time) < Seconds (b.m_time);
+  }
+  std::vector<Movement> m_movements; //!< movements in parsing order
+};
+
+/**
+ * Movements parsed so far, needed to parse the next lines
+ */
+struct MovementParseState
+{
+  std::map<int, DestinationPoint> lastPos; //!< Stores previous movement scheduled for each node
+  std::map<int, Vector> position; //!< Position of each node after the lines parsed so far, when streaming
+  Ns2MovementScheduler *scheduler; //!< Where the movements go
+  bool streaming; //!< True if the trace is parsed while the simulation runs
+  bool flag;      //!< True if the last line set an initial position
+  MovementParseState () :
+    scheduler (0),
+    streaming (false),
+    flag (false)
+  {};
+};
+
+/**
+ * ns-2 mobility trace parsed while the simulation runs, see
+ * Ns2MobilityHelper::SetStreamingWindow
+ */
+class Ns2MobilityStream : public SimpleRefCount<Ns2MobilityStream>
+{
+public:
+  /**
+   * \param filename filename of the ns-2 mobility trace
+   * \param window how far ahead of the current time the trace is parsed
+   * \param models mobility model of each node of the trace
+   * \param state the state after the initial positions were set
+   */
+  Ns2MobilityStream (std::string filename, Time window,
+                     const std::map<int, Ptr<ConstantVelocityMobilityModel> > &models,
+                     const MovementParseState &state);
+  /**
+   * Schedule the movements starting within the window, and the next
+   * parsing when the window reaches the following movement
+   */
+  void Advance (void);
+private:
+  std::ifstream m_file; //!< trace being parsed
+  Time m_window;        //!< how far ahead of the current time the trace is parsed
+  Ns2SimulatorScheduler m_scheduler; //!< schedules the movements, from the time of the installation
+  std::map<int, Ptr<ConstantVelocityMobilityModel> > m_models; //!< mobility model of each node of the trace
+  MovementParseState m_state; //!< movements parsed so far
+  std::string m_line;   //!< line read but beyond the window, if not empty
+};
+
 
 /**
  * Parses a line of ns2 mobility
@@ -169,7 +376,7 @@ static bool IsSchedMobilityPos (ParseResult pr);
  * Set waypoints and speed for movement.
  */
 static DestinationPoint SetMovement (Ptr<ConstantVelocityMobilityModel> model, Vector lastPos, double at,
-                                     double xFinalPosition, double yFinalPosition, double speed);
+                                     double xFinalPosition, double yFinalPosition, double speed, Ns2MovementScheduler &scheduler);
 
 /**
  * Set initial position for a node
@@ -177,18 +384,32 @@ static DestinationPoint SetMovement (Ptr<ConstantVelocityMobilityModel> model, V
 static Vector SetInitialPosition (Ptr<ConstantVelocityMobilityModel> model, std::string coord, double coordVal);
 
 /** 
- * Schedule a set of position for a node
+ * Schedule a set of position for a node, from its position after the
+ * previous lines
  */
-static Vector SetSchedPosition (Ptr<ConstantVelocityMobilityModel> model, double at, std::string coord, double coordVal);
+static Vector SetSchedPosition (Ptr<ConstantVelocityMobilityModel> model, Vector position, double at, std::string coord, double coordVal, Ns2MovementScheduler &scheduler);
+
+/**
+ * Schedule the movement of a line which is not an initial position
+ */
+static void ParseMovement (const ParseResult &pr, const std::string &line, int iNodeId,
+                           Ptr<ConstantVelocityMobilityModel> model, MovementParseState &state);
 
 
 Ns2MobilityHelper::Ns2MobilityHelper (std::string filename)
-  : m_filename (filename)
+  : m_filename (filename),
+    m_streamingWindow (Seconds (0))
 {
   std::ifstream file (m_filename.c_str (), std::ios::in);
   if (!(file.is_open ())) NS_FATAL_ERROR("Could not open trace file " << m_filename.c_str() << " for reading, aborting here \n"); 
 }
 
+void
+Ns2MobilityHelper::SetStreamingWindow (Time window)
+{
+  m_streamingWindow = window;
+}
+
 Ptr<ConstantVelocityMobilityModel>
 Ns2MobilityHelper::GetMobilityModel (std::string idString, const ObjectStore &store) const
 {
@@ -213,6 +434,13 @@ Ns2MobilityHelper::GetMobilityModel (std::string idString, const ObjectStore &st
 
 void
 Ns2MobilityHelper::ConfigNodesMovements (const ObjectStore &store) const
+{
+  Ns2SimulatorScheduler scheduler;
+  ConfigNodesMovements (store, scheduler);
+}
+
+void
+Ns2MobilityHelper::ConfigNodesMovements (const ObjectStore &store, Ns2MovementScheduler &scheduler) const
 {
   std::map<int, DestinationPoint> last_pos;    // Stores previous movement scheduled for each node
 
@@ -296,7 +524,9 @@ Ns2MobilityHelper::ConfigNodesMovements (const ObjectStore &store) const
   // The reason the file is parsed again is to make this helper robust
   // to handle trace files with the initial node positions at the end.
   file.open (m_filename.c_str (), std::ios::in);
-  bool flag = false;
+  MovementParseState state;
+  state.lastPos.swap (last_pos);
+  state.scheduler = &scheduler;
   if (file.is_open ())
     {
       while (!file.eof () )
@@ -341,108 +571,368 @@ Ns2MobilityHelper::ConfigNodesMovements (const ObjectStore &store) const
               continue;
             }
 
+          ParseMovement (pr, line, iNodeId, model, state);
+        }
+      file.close ();
+    }
+}
 
-          /*
-           * In this case a initial position is being seted
-           * line like $node_(0) set X_ 151.05190721688197
-           */
-          if (IsSetInitialPos (pr))
+
+void
+Ns2MobilityHelper::WriteBinaryTrace (std::string filename) const
+{
+  // Gives a new object to each node ID of the trace
+  class RecordingObjectStore : public ObjectStore
+  {
+public:
+    virtual Ptr<Object> Get (uint32_t i) const {
+      std::map<uint32_t, Ptr<Object> >::iterator it = m_objects.find (i);
+      if (it == m_objects.end ())
+        {
+          it = m_objects.insert (std::make_pair (i, CreateObject<Object> ())).first;
+        }
+      return it->second;
+    }
+    mutable std::map<uint32_t, Ptr<Object> > m_objects; //!< object of each node ID
+  };
+
+  RecordingObjectStore store;
+  Ns2BinaryTraceRecorder recorder;
+  ConfigNodesMovements (store, recorder);
+  recorder.Write (filename, store.m_objects);
+}
+
+
+void
+Ns2BinaryTraceRecorder::Write (std::string filename, const std::map<uint32_t, Ptr<Object> > &objects) const
+{
+  std::map<ConstantVelocityMobilityModel *, std::vector<Ns2BinaryTraceMovement> > movements;
+  for (std::vector<Movement>::const_iterator it = m_movements.begin (); it != m_movements.end (); it++)
+    {
+      if (!it->m_cancelled)
+        {
+          movements[PeekPointer (it->m_model)].push_back (it->m_movement);
+        }
+    }
+
+  Ns2BinaryTraceHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.m_magic, "NS2BMOB", 8);
+  header.m_version = Ns2BinaryTraceHeader::FORMAT_VERSION;
+  header.m_byteOrder = Ns2BinaryTraceHeader::BYTE_ORDER_MARK;
+  header.m_nNodes = objects.empty () ? 0 : objects.rbegin ()->first + 1;
+  header.m_nMovements = 0;
+
+  std::vector<Ns2BinaryTraceNode> nodes (header.m_nNodes);
+  if (!nodes.empty ())
+    {
+      std::memset (&nodes[0], 0, nodes.size () * sizeof (Ns2BinaryTraceNode));
+    }
+  std::vector<Ns2BinaryTraceMovement> sorted;
+  for (std::map<uint32_t, Ptr<Object> >::const_iterator it = objects.begin (); it != objects.end (); it++)
+    {
+      Ns2BinaryTraceNode &node = nodes[it->first];
+      Ptr<ConstantVelocityMobilityModel> model = it->second->GetObject<ConstantVelocityMobilityModel> ();
+      Vector position = model->GetPosition ();
+      node.m_inTrace = 1;
+      node.m_position[0] = position.x;
+      node.m_position[1] = position.y;
+      node.m_position[2] = position.z;
+      node.m_firstMovement = sorted.size ();
+      std::vector<Ns2BinaryTraceMovement> &nodeMovements = movements[PeekPointer (model)];
+      // the simulator does the movements scheduled at the same time in scheduling order
+      std::stable_sort (nodeMovements.begin (), nodeMovements.end (), &Ns2BinaryTraceRecorder::IsBefore);
+      node.m_nMovements = nodeMovements.size ();
+      sorted.insert (sorted.end (), nodeMovements.begin (), nodeMovements.end ());
+    }
+  header.m_nMovements = sorted.size ();
+
+  std::ofstream file (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open ())
+    {
+      NS_FATAL_ERROR ("Could not open binary trace file " << filename << " for writing");
+    }
+  file.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  if (!nodes.empty ())
+    {
+      file.write (reinterpret_cast<const char *> (&nodes[0]), nodes.size () * sizeof (Ns2BinaryTraceNode));
+    }
+  if (!sorted.empty ())
+    {
+      file.write (reinterpret_cast<const char *> (&sorted[0]), sorted.size () * sizeof (Ns2BinaryTraceMovement));
+    }
+  file.close ();
+  NS_LOG_INFO ("Wrote " << filename << ": " << header.m_nNodes << " nodes, " << header.m_nMovements << " movements");
+}
+
+
+void
+Ns2MobilityHelper::StreamNodesMovements (const ObjectStore &store) const
+{
+  MovementParseState state;
+  state.streaming = true;
+  std::map<int, Ptr<ConstantVelocityMobilityModel> > models;
+
+  // Look through the whole file for the initial node positions, as in
+  // ConfigNodesMovements, and for the nodes of the scheduled statements.
+  // Only the lines setting an initial position are tokenized.
+  std::ifstream file (m_filename.c_str (), std::ios::in);
+  if (file.is_open ())
+    {
+      while (!file.eof ())
+        {
+          std::string line;
+
+          getline (file, line);
+
+          std::string::size_type nodePos = line.find (NS2_NODEID);
+          if (nodePos == std::string::npos)
+            {
+              continue;
+            }
+          std::string nodeId = GetNodeIdFromToken (line.substr (nodePos));
+          if (nodeId.empty ())
             {
-              // This is the second time this file has been parsed,
-              // and the initial node positions were already set the
-              // first time.  So, do nothing this time with this line.
-              flag = true;
               continue;
             }
+          int iNodeId = 0;
+          std::istringstream iss (nodeId);
+          iss >> iNodeId;
+
+          std::map<int, Ptr<ConstantVelocityMobilityModel> >::iterator it = models.find (iNodeId);
+          if (it == models.end ())
+            {
+              it = models.insert (std::make_pair (iNodeId, GetMobilityModel (nodeId, store))).first;
+            }
 
-          else // NOW EVENTS TO BE SCHEDULED
+          // scheduled statements start with $ns_
+          if (line.find_first_not_of (" \t") != nodePos)
             {
+              continue;
+            }
 
-              // This is a scheduled event, so time at should be present
-              double at;
-
-              if (!IsNumber (pr.tokens[2]))
-                {
-                  NS_LOG_WARN ("Time is not a number: " << pr.tokens[2]);
-                  continue;
-                }
-
-              at = pr.dvals[2]; // set time at
-
-              if ( at < 0 )
-                {
-                  NS_LOG_WARN ("Time is less than cero: " << at);
-                  continue;
-                }
-
-
-
-              /*
-               * In this case a new waypoint is added
-               * line like $ns_ at 1 "$node_(0) setdest 2 3 4"
-               */
-              if (IsSchedMobilityPos (pr))
-                {
-                  if (last_pos[iNodeId].m_targetArrivalTime > at)
-                    {
-                      NS_LOG_LOGIC ("Did not reach a destination! stoptime = " << last_pos[iNodeId].m_targetArrivalTime << ", at = "<<  at);
-                      double actuallytraveled = at - last_pos[iNodeId].m_travelStartTime;
-                      Vector reached = Vector (
-                          last_pos[iNodeId].m_startPosition.x + last_pos[iNodeId].m_speed.x * actuallytraveled,
-                          last_pos[iNodeId].m_startPosition.y + last_pos[iNodeId].m_speed.y * actuallytraveled,
-                          0
-                          );
-                      NS_LOG_LOGIC ("Final point = " << last_pos[iNodeId].m_finalPosition << ", actually reached = " << reached);
-                      last_pos[iNodeId].m_stopEvent.Cancel ();
-                      last_pos[iNodeId].m_finalPosition = reached;
-                    }
-
-                  if (!flag)
-                    {
-                      //                                     last position     time  X coord     Y coord      velocity
-                      last_pos[iNodeId] = SetMovement (model, last_pos[iNodeId].m_finalPosition, at, pr.dvals[5], pr.dvals[6], pr.dvals[7]);
-                    }
-                  else
-                    {
-                      flag = false;
-                      Vector position;
-                      position.x = pr.dvals[5];
-                      position.y = pr.dvals[6];
-                      position.z = 0.0;
-                      Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetPosition, model,position);
-                    }
-
-                  // Log new position
-                  NS_LOG_DEBUG ("Positions after parse for node " << iNodeId << " " << nodeId << " position =" << last_pos[iNodeId].m_finalPosition);
-                }
-
-
-              /*
-               * Scheduled set position
-               * line like $ns_ at 4.634906291962 "$node_(0) set X_ 28.675920486450"
-               */
-              else if (IsSchedSetPos (pr))
-                {
-                  //                                         time  coordinate   coord value
-                  last_pos[iNodeId].m_finalPosition = SetSchedPosition (model, at, pr.tokens[5], pr.dvals[6]);
-                  if (last_pos[iNodeId].m_targetArrivalTime > at)
-                    {
-                      last_pos[iNodeId].m_stopEvent.Cancel ();
-                    }
-                  last_pos[iNodeId].m_targetArrivalTime = at;
-                  last_pos[iNodeId].m_travelStartTime = at;
-                  // Log new position
-                  NS_LOG_DEBUG ("Positions after parse for node " << iNodeId << " " << nodeId <<
-                                " position =" << last_pos[iNodeId].m_finalPosition);
-                }
-              else
-                {
-                  NS_LOG_WARN ("Format Line is not correct: " << line << "\n");
-                }
+          ParseResult pr = ParseNs2Line (line);
+          if (pr.tokens.size () != 4 || !IsSetInitialPos (pr))
+            {
+              continue;
             }
+          if (it->second == 0)
+            {
+              NS_LOG_ERROR ("Unknown node ID (corrupted file?): " << nodeId << "\n");
+              continue;
+            }
+          DestinationPoint point;
+          point.m_finalPosition = SetInitialPosition (it->second, pr.tokens[2], 999999.0);
+          state.lastPos[iNodeId] = point;
+
+          // Log new position
+          NS_LOG_DEBUG ("Positions after parse for node " << iNodeId << " " << nodeId <<
+                        " position = " << point.m_finalPosition);
         }
       file.close ();
     }
+
+  for (std::map<int, Ptr<ConstantVelocityMobilityModel> >::const_iterator it = models.begin (); it != models.end (); it++)
+    {
+      if (it->second != 0)
+        {
+          state.position[it->first] = it->second->GetPosition ();
+        }
+    }
+
+  Ptr<Ns2MobilityStream> stream = Create<Ns2MobilityStream> (m_filename, m_streamingWindow, models, state);
+  stream->Advance ();
+}
+
+
+Ns2MobilityStream::Ns2MobilityStream (std::string filename, Time window,
+                                      const std::map<int, Ptr<ConstantVelocityMobilityModel> > &models,
+                                      const MovementParseState &state)
+  : m_file (filename.c_str (), std::ios::in),
+    m_window (window),
+    m_models (models),
+    m_state (state)
+{
+  m_state.scheduler = &m_scheduler;
+}
+
+void
+Ns2MobilityStream::Advance (void)
+{
+  Time offset = m_scheduler.GetTraceTime ();
+  while (!m_line.empty () || (m_file.is_open () && !m_file.eof ()))
+    {
+      std::string line;
+      if (m_line.empty ())
+        {
+          getline (m_file, line);
+        }
+      else
+        {
+          line.swap (m_line);
+        }
+
+      // ignore empty lines
+      if (line.empty ())
+        {
+          continue;
+        }
+
+      ParseResult pr = ParseNs2Line (line); // Parse line and obtain tokens
+
+      // Check if the line corresponds with one of the three types of line
+      if (pr.tokens.size () != 4 && pr.tokens.size () != 7 && pr.tokens.size () != 8)
+        {
+          NS_LOG_ERROR ("Line has not correct number of parameters (corrupted file?): " << line << "\n");
+          continue;
+        }
+
+      // Stop at the first statement scheduled beyond the window, until
+      // the window reaches it
+      if (pr.tokens.size () != 4 && pr.has_dval[2] && Seconds (pr.dvals[2]) > offset + m_window)
+        {
+          m_line.swap (line);
+          Simulator::Schedule (Seconds (pr.dvals[2]) - m_window - offset, &Ns2MobilityStream::Advance, Ptr<Ns2MobilityStream> (this));
+          return;
+        }
+
+      int iNodeId = GetNodeIdInt (pr);
+      if (iNodeId == -1)
+        {
+          NS_LOG_ERROR ("Node number couldn't be obtained (corrupted file?): " << line << "\n");
+          continue;
+        }
+
+      std::map<int, Ptr<ConstantVelocityMobilityModel> >::const_iterator it = m_models.find (iNodeId);
+      if (it == m_models.end () || it->second == 0)
+        {
+          NS_LOG_ERROR ("Unknown node ID (corrupted file?): " << GetNodeIdString (pr) << "\n");
+          continue;
+        }
+
+      ParseMovement (pr, line, iNodeId, it->second, m_state);
+    }
+  NS_LOG_LOGIC ("End of the trace reached");
+  m_file.close ();
+}
+
+
+void
+ParseMovement (const ParseResult &pr, const std::string &line, int iNodeId,
+               Ptr<ConstantVelocityMobilityModel> model, MovementParseState &state)
+{
+  std::map<int, DestinationPoint> &last_pos = state.lastPos;
+
+  /*
+   * In this case a initial position is being seted
+   * line like $node_(0) set X_ 151.05190721688197
+   */
+  if (IsSetInitialPos (pr))
+    {
+      // This is the second time this file has been parsed,
+      // and the initial node positions were already set the
+      // first time.  So, do nothing this time with this line.
+      state.flag = true;
+      return;
+    }
+
+  // NOW EVENTS TO BE SCHEDULED
+
+  // This is a scheduled event, so time at should be present
+  double at;
+
+  if (!IsNumber (pr.tokens[2]))
+    {
+      NS_LOG_WARN ("Time is not a number: " << pr.tokens[2]);
+      return;
+    }
+
+  at = pr.dvals[2]; // set time at
+
+  if ( at < 0 )
+    {
+      NS_LOG_WARN ("Time is less than cero: " << at);
+      return;
+    }
+
+  if (Seconds (at) < state.scheduler->GetTraceTime ())
+    {
+      NS_LOG_WARN ("Time is in the past (trace not in time order?): " << at);
+      return;
+    }
+
+  /*
+   * In this case a new waypoint is added
+   * line like $ns_ at 1 "$node_(0) setdest 2 3 4"
+   */
+  if (IsSchedMobilityPos (pr))
+    {
+      if (last_pos[iNodeId].m_targetArrivalTime > at)
+        {
+          NS_LOG_LOGIC ("Did not reach a destination! stoptime = " << last_pos[iNodeId].m_targetArrivalTime << ", at = "<<  at);
+          double actuallytraveled = at - last_pos[iNodeId].m_travelStartTime;
+          Vector reached = Vector (
+              last_pos[iNodeId].m_startPosition.x + last_pos[iNodeId].m_speed.x * actuallytraveled,
+              last_pos[iNodeId].m_startPosition.y + last_pos[iNodeId].m_speed.y * actuallytraveled,
+              0
+              );
+          NS_LOG_LOGIC ("Final point = " << last_pos[iNodeId].m_finalPosition << ", actually reached = " << reached);
+          state.scheduler->Cancel (last_pos[iNodeId].m_stopEvent);
+          last_pos[iNodeId].m_finalPosition = reached;
+        }
+
+      if (!state.flag)
+        {
+          //                                     last position     time  X coord     Y coord      velocity
+          last_pos[iNodeId] = SetMovement (model, last_pos[iNodeId].m_finalPosition, at, pr.dvals[5], pr.dvals[6], pr.dvals[7], *state.scheduler);
+        }
+      else
+        {
+          state.flag = false;
+          Vector position;
+          position.x = pr.dvals[5];
+          position.y = pr.dvals[6];
+          position.z = 0.0;
+          state.scheduler->SchedulePosition (model, at, position);
+        }
+
+      // Log new position
+      NS_LOG_DEBUG ("Positions after parse for node " << iNodeId << " position =" << last_pos[iNodeId].m_finalPosition);
+    }
+
+
+  /*
+   * Scheduled set position
+   * line like $ns_ at 4.634906291962 "$node_(0) set X_ 28.675920486450"
+   */
+  else if (IsSchedSetPos (pr))
+    {
+      if (state.streaming)
+        {
+          // the model may already be moving, so the parsed position is kept aside
+          //                                                                         time  coordinate   coord value
+          state.position[iNodeId] = SetSchedPosition (model, state.position[iNodeId], at, pr.tokens[5], pr.dvals[6], *state.scheduler);
+          last_pos[iNodeId].m_finalPosition = state.position[iNodeId];
+        }
+      else
+        {
+          //                                                                               time  coordinate   coord value
+          last_pos[iNodeId].m_finalPosition = SetSchedPosition (model, model->GetPosition (), at, pr.tokens[5], pr.dvals[6], *state.scheduler);
+          model->SetPosition (last_pos[iNodeId].m_finalPosition);
+        }
+      if (last_pos[iNodeId].m_targetArrivalTime > at)
+        {
+          state.scheduler->Cancel (last_pos[iNodeId].m_stopEvent);
+        }
+      last_pos[iNodeId].m_targetArrivalTime = at;
+      last_pos[iNodeId].m_travelStartTime = at;
+      // Log new position
+      NS_LOG_DEBUG ("Positions after parse for node " << iNodeId << " position =" << last_pos[iNodeId].m_finalPosition);
+    }
+  else
+    {
+      NS_LOG_WARN ("Format Line is not correct: " << line << "\n");
+    }
 }
 
 
@@ -747,7 +1237,7 @@ IsSchedMobilityPos (ParseResult pr)
 
 DestinationPoint
 SetMovement (Ptr<ConstantVelocityMobilityModel> model, Vector last_pos, double at,
-             double xFinalPosition, double yFinalPosition, double speed)
+             double xFinalPosition, double yFinalPosition, double speed, Ns2MovementScheduler &scheduler)
 {
   DestinationPoint retval;
   retval.m_startPosition = last_pos;
@@ -758,8 +1248,7 @@ SetMovement (Ptr<ConstantVelocityMobilityModel> model, Vector last_pos, double a
   if (speed == 0)
     {
       // We have to maintain last position, and stop the movement
-      retval.m_stopEvent = Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetVelocity, model,
-                                                Vector (0, 0, 0));
+      retval.m_stopEvent = scheduler.ScheduleVelocity (model, at, Vector (0, 0, 0));
       return retval;
     }
   if (speed > 0)
@@ -782,8 +1271,8 @@ SetMovement (Ptr<ConstantVelocityMobilityModel> model, Vector last_pos, double a
       NS_LOG_DEBUG ("Calculated Speed: X=" << xSpeed << " Y=" << ySpeed << " Z=" << zSpeed);
 
       // Set the Values
-      Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetVelocity, model, Vector (xSpeed, ySpeed, zSpeed));
-      retval.m_stopEvent = Simulator::Schedule (Seconds (at + time), &ConstantVelocityMobilityModel::SetVelocity, model, Vector (0, 0, 0));
+      scheduler.ScheduleVelocity (model, at, Vector (xSpeed, ySpeed, zSpeed));
+      retval.m_stopEvent = scheduler.ScheduleVelocity (model, at + time, Vector (0, 0, 0));
       retval.m_finalPosition.x += xSpeed * time;
       retval.m_finalPosition.y += ySpeed * time;
       retval.m_targetArrivalTime += time;
@@ -807,18 +1296,13 @@ SetInitialPosition (Ptr<ConstantVelocityMobilityModel> model, std::string coord,
 
 // Schedule a set of position for a node
 Vector
-SetSchedPosition (Ptr<ConstantVelocityMobilityModel> model, double at, std::string coord, double coordVal)
+SetSchedPosition (Ptr<ConstantVelocityMobilityModel> model, Vector position, double at, std::string coord, double coordVal, Ns2MovementScheduler &scheduler)
 {
   // update position
-  model->SetPosition (SetOneInitialCoord (model->GetPosition (), coord, coordVal));
-
-  Vector position;
-  position.x = model->GetPosition ().x;
-  position.y = model->GetPosition ().y;
-  position.z = model->GetPosition ().z;
+  position = SetOneInitialCoord (position, coord, coordVal);
 
   // Chedule next positions
-  Simulator::Schedule (Seconds (at), &ConstantVelocityMobilityModel::SetPosition, model,position);
+  scheduler.SchedulePosition (model, at, position);
 
   return position;
 }
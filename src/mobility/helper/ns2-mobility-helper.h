@@ -27,10 +27,12 @@
 #include <stdint.h>
 #include "ns3/ptr.h"
 #include "ns3/object.h"
+#include "ns3/nstime.h"
 
 namespace ns3 {
 
 class ConstantVelocityMobilityModel;
+class Ns2MovementScheduler;
 
 /**
  * \ingroup mobility
@@ -69,6 +71,15 @@ class ConstantVelocityMobilityModel;
  *
  *  See usage example in examples/mobility/ns2-mobility-trace.cc
  *
+ * By default the whole trace is parsed at install time and all its
+ * movements are scheduled at once, so the size of the event queue grows
+ * with the length of the trace. SetStreamingWindow () makes the helper
+ * parse the trace while the simulation runs instead: only the movements
+ * starting within the window ahead of the current time are scheduled,
+ * and the event queue grows with the number of nodes. This requires
+ * the scheduled statements of the trace to be in time order, as in the
+ * traces exported by SUMO.
+ *
  * \bug Rounding errors may cause movement to diverge from the mobility
  * pattern in ns-2 (using the same trace).
  * See https://www.nsnam.org/bugzilla/show_bug.cgi?id=1316
@@ -103,6 +114,27 @@ public:
    */
   template <typename T>
   void Install (T begin, T end) const;
+
+  /**
+   * \param window how far ahead of the current simulation time the trace
+   *        is parsed and its movements are scheduled. Zero, the default,
+   *        parses the whole trace at install time.
+   *
+   * Parse the trace incrementally while the simulation runs. The initial
+   * positions are still all set at install time, with a first pass which
+   * only parses the initial position statements.
+   */
+  void SetStreamingWindow (Time window);
+
+  /**
+   * \param filename filename of the binary trace to write
+   *
+   * Parse the ns2 trace file and write the resulting movements of
+   * its nodes to a binary trace, which Ns2BinaryMobilityHelper loads
+   * without parsing. The movements are the ones Install () would
+   * schedule, ordered by node and by time.
+   */
+  void WriteBinaryTrace (std::string filename) const;
 private:
   /**
    * \brief a class to hold input objects internally
@@ -123,6 +155,18 @@ public:
    * \param store Object store containing ns-3 mobility models
    */
   void ConfigNodesMovements (const ObjectStore &store) const;
+  /**
+   * Parses ns-2 mobility file and passes the movements to a scheduler
+   * \param store Object store containing ns-3 mobility models
+   * \param scheduler where the movements go
+   */
+  void ConfigNodesMovements (const ObjectStore &store, Ns2MovementScheduler &scheduler) const;
+  /**
+   * Sets the initial node positions and prepares the incremental parsing
+   * of the ns-2 mobility file
+   * \param store Object store containing ns-3 mobility models
+   */
+  void StreamNodesMovements (const ObjectStore &store) const;
   /**
    * Get or create a ConstantVelocityMobilityModel corresponding to idString
    * \param idString string name for a node
@@ -131,6 +175,7 @@ public:
    */
   Ptr<ConstantVelocityMobilityModel> GetMobilityModel (std::string idString, const ObjectStore &store) const;
   std::string m_filename; //!< filename of file containing ns-2 mobility trace 
+  Time m_streamingWindow; //!< how far ahead the trace is parsed, zero to parse it at install time
 };
 
 } // namespace ns3
@@ -161,7 +206,14 @@ private:
     T m_begin;
     T m_end;
   };
-  ConfigNodesMovements (MyObjectStore (begin, end));
+  if (m_streamingWindow.IsStrictlyPositive ())
+    {
+      StreamNodesMovements (MyObjectStore (begin, end));
+    }
+  else
+    {
+      ConfigNodesMovements (MyObjectStore (begin, end));
+    }
 }
 
 
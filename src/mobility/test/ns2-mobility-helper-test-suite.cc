@@ -38,6 +38,16 @@
  */
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include "ns3/node-list.h"
@@ -48,6 +58,7 @@
 #include "ns3/names.h"
 #include "ns3/config.h"
 #include "ns3/ns2-mobility-helper.h"
+#include "ns3/ns2-binary-mobility-helper.h"
 
 using namespace ns3;
 
@@ -266,6 +277,291 @@ private:
   }
 };
 
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check that parsing the trace while the simulation runs
+ * (Ns2MobilityHelper::SetStreamingWindow), or loading the binary trace
+ * written from it (Ns2BinaryMobilityHelper), produces the same course
+ * changes as parsing it at install time
+ */
+class Ns2MobilityHelperStreamingTest : public TestCase
+{
+public:
+  /**
+   * \param name short description
+   * \param window the streaming window
+   * \param binary true to load the binary trace instead of streaming
+   */
+  Ns2MobilityHelperStreamingTest (std::string const & name, Time window, bool binary = false)
+    : TestCase (name),
+      m_window (window),
+      m_binary (binary),
+      m_firstNodeId (0)
+  {
+  }
+
+private:
+  /// Trace file name
+  std::string m_traceFile;
+  /// Streaming window
+  Time m_window;
+  /// True to load the binary trace
+  bool m_binary;
+  /// ID of the first node of the current run
+  uint32_t m_firstNodeId;
+  /// Course change: node index and description
+  typedef std::pair<uint32_t, std::string> Change;
+  /// Course changes of the current run
+  std::vector<Change> m_changes;
+
+  /// Record a course change
+  void CourseChange (Ptr<const MobilityModel> mobility)
+  {
+    std::ostringstream os;
+    os.precision (9);
+    os << Simulator::Now ().GetSeconds () << " " << mobility->GetPosition () << " " << mobility->GetVelocity ();
+    m_changes.push_back (Change (mobility->GetObject<Node> ()->GetId () - m_firstNodeId, os.str ()));
+  }
+
+  /// Order the course changes by node
+  static bool IsLowerNode (Change const & a, Change const & b)
+  {
+    return a.first < b.first;
+  }
+
+  /**
+   * Install the trace and run the simulation
+   * \param window the streaming window, zero to parse the trace at install time
+   * \param binary true to load the binary trace
+   * \return the course changes
+   */
+  std::vector<Change> RunTrace (Time window, bool binary)
+  {
+    NodeContainer nodes;
+    nodes.Create (3);
+    m_firstNodeId = nodes.Get (0)->GetId ();
+    if (binary)
+      {
+        std::string binaryFile = CreateTempDirFilename ("Ns2MobilityHelperStreamingTest.bin");
+        Ns2MobilityHelper (m_traceFile).WriteBinaryTrace (binaryFile);
+        Ns2BinaryMobilityHelper mobility (binaryFile);
+        mobility.Install (nodes.Begin (), nodes.End ());
+      }
+    else
+      {
+        Ns2MobilityHelper mobility (m_traceFile);
+        mobility.SetStreamingWindow (window);
+        mobility.Install (nodes.Begin (), nodes.End ());
+      }
+    for (uint32_t i = 0; i < nodes.GetN (); ++i)
+      {
+        nodes.Get (i)->GetObject<MobilityModel> ()->TraceConnectWithoutContext ("CourseChange",
+          MakeCallback (&Ns2MobilityHelperStreamingTest::CourseChange, this));
+      }
+    m_changes.clear ();
+    Simulator::Stop (Seconds (20));
+    Simulator::Run ();
+    Simulator::Destroy ();
+    return m_changes;
+  }
+
+  void DoRun ()
+  {
+    m_traceFile = CreateTempDirFilename ("Ns2MobilityHelperStreamingTest.tcl");
+    std::ofstream of (m_traceFile.c_str ());
+    NS_TEST_ASSERT_MSG_EQ (of.is_open (), true, "Need to write tmp. file");
+    of << "$node_(0) set X_ 0.0\n"
+          "$node_(0) set Y_ 0.0\n"
+          "$ns_ at 0.0 \"$node_(0) setdest 0 0 0\"\n"
+          "$ns_ at 1.0 \"$node_(0) setdest 10 0 2\"\n"
+          "$ns_ at 1.0 \"$node_(1) setdest 25 0 5\"\n"
+          "$ns_ at 3.0 \"$node_(0) setdest 10 10 2\"\n"
+          "$ns_ at 4.5 \"$node_(0) set Y_ 7\"\n"
+          "$ns_ at 5.0 \"$node_(1) setdest 0 0 1\"\n"
+          "$node_(2) set X_ 3.0\n"
+          "$node_(2) set Y_ 4.0\n"
+          "$ns_ at 8.0 \"$node_(2) setdest 3 4 0\"\n"
+          "$ns_ at 9.0 \"$node_(2) setdest 13 4 5\"\n"
+          "$ns_ at 9.5 \"$node_(0) setdest 0 0 4\"\n"
+          "$ns_ at 15.0 \"$node_(2) set X_ 1\"\n"
+          "$ns_ at 15.0 \"$node_(2) setdest 1 10 3\"\n";
+    of.close ();
+
+    std::vector<Change> reference = RunTrace (Seconds (0), false);
+    std::vector<Change> streamed = RunTrace (m_window, m_binary);
+    if (m_binary)
+      {
+        // the binary trace only schedules the next movement of each node,
+        // so the nodes moving at the same time may move in another order
+        std::stable_sort (reference.begin (), reference.end (), &IsLowerNode);
+        std::stable_sort (streamed.begin (), streamed.end (), &IsLowerNode);
+      }
+    NS_TEST_ASSERT_MSG_EQ (streamed.size (), reference.size (), "Wrong number of course changes");
+    for (uint32_t i = 0; i < reference.size (); ++i)
+      {
+        NS_TEST_EXPECT_MSG_EQ (streamed[i].first, reference[i].first, "Course change " << i << " of another node");
+        NS_TEST_EXPECT_MSG_EQ (streamed[i].second, reference[i].second, "Course change " << i << " mismatch");
+      }
+  }
+};
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check that a trace without nodes is written as a binary trace
+ * made of the header only, and that this binary trace can be loaded
+ */
+class Ns2BinaryTraceEmptyTest : public TestCase
+{
+public:
+  Ns2BinaryTraceEmptyTest ()
+    : TestCase ("empty binary trace")
+  {
+  }
+
+private:
+  void DoRun (void)
+  {
+    std::string traceFile = CreateTempDirFilename ("Ns2BinaryTraceEmptyTest.tcl");
+    std::ofstream of (traceFile.c_str ());
+    NS_TEST_ASSERT_MSG_EQ (of.is_open (), true, "Need to write tmp. file");
+    of << "# no node in this trace\n";
+    of.close ();
+
+    std::string binaryFile = CreateTempDirFilename ("Ns2BinaryTraceEmptyTest.bin");
+    Ns2MobilityHelper (traceFile).WriteBinaryTrace (binaryFile);
+    std::ifstream binary (binaryFile.c_str (), std::ios::in | std::ios::binary | std::ios::ate);
+    NS_TEST_ASSERT_MSG_EQ (binary.tellg (), (std::streamoff) sizeof (Ns2BinaryTraceHeader), "Binary trace is not the header only");
+
+    NodeContainer nodes;
+    nodes.Create (1);
+    Ns2BinaryMobilityHelper mobility (binaryFile);
+    mobility.Install (nodes.Begin (), nodes.End ());
+    NS_TEST_ASSERT_MSG_EQ (nodes.Get (0)->GetObject<ConstantVelocityMobilityModel> (), 0, "Node not in the trace got a mobility model");
+    Simulator::Run ();
+    Simulator::Destroy ();
+  }
+};
+
+/**
+ * \ingroup mobility-test
+ * \ingroup tests
+ *
+ * \brief Check that loading a corrupted binary trace aborts before any
+ * access out of the file: wrong byte order, movement count wrapping the
+ * expected file size, truncated file, node movements out of the file
+ */
+class Ns2BinaryTraceCorruptedTest : public TestCase
+{
+public:
+  Ns2BinaryTraceCorruptedTest ()
+    : TestCase ("corrupted binary trace")
+  {
+  }
+
+private:
+  /// Valid binary trace
+  std::string m_binary;
+
+  /**
+   * Load a binary trace and run the simulation in a child process
+   * \param binaryFile the binary trace
+   * \return true if the child process was aborted
+   */
+  static bool LoadAborts (std::string binaryFile)
+  {
+    std::fflush (0);
+    pid_t pid = fork ();
+    if (pid == 0)
+      {
+        // silence the abort message of the child
+        int devNull = open ("/dev/null", O_WRONLY);
+        dup2 (devNull, STDERR_FILENO);
+        NodeContainer nodes;
+        nodes.Create (2);
+        Ns2BinaryMobilityHelper mobility (binaryFile);
+        mobility.Install (nodes.Begin (), nodes.End ());
+        Simulator::Run ();
+        Simulator::Destroy ();
+        _exit (0);
+      }
+    int status = 0;
+    if (pid < 0 || waitpid (pid, &status, 0) != pid)
+      {
+        return false;
+      }
+    return WIFSIGNALED (status) && WTERMSIG (status) == SIGABRT;
+  }
+
+  /**
+   * Write a copy of the valid binary trace with a field of the header or
+   * of a node entry replaced
+   * \param name the name of the copy
+   * \param offset the offset of the field in the file
+   * \param value the new value of the field
+   * \param size the size of the copy, 0 for the size of the valid trace
+   * \return the filename of the copy
+   */
+  template <typename T>
+  std::string WriteCorrupted (std::string name, size_t offset, T value, size_t size = 0)
+  {
+    std::ifstream in (m_binary.c_str (), std::ios::in | std::ios::binary);
+    std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+    std::memcpy (&data[offset], &value, sizeof (value));
+    if (size != 0)
+      {
+        data.resize (size);
+      }
+    std::string filename = CreateTempDirFilename ("Ns2BinaryTraceCorruptedTest-" + name + ".bin");
+    std::ofstream out (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write (data.data (), data.size ());
+    return filename;
+  }
+
+  void DoRun (void)
+  {
+    std::string traceFile = CreateTempDirFilename ("Ns2BinaryTraceCorruptedTest.tcl");
+    std::ofstream of (traceFile.c_str ());
+    NS_TEST_ASSERT_MSG_EQ (of.is_open (), true, "Need to write tmp. file");
+    of << "$node_(0) set X_ 0.0\n"
+          "$ns_ at 1.0 \"$node_(0) setdest 10 0 2\"\n"
+          "$ns_ at 3.0 \"$node_(0) setdest 10 10 2\"\n"
+          "$node_(1) set X_ 3.0\n"
+          "$ns_ at 2.0 \"$node_(1) setdest 3 4 1\"\n";
+    of.close ();
+    m_binary = CreateTempDirFilename ("Ns2BinaryTraceCorruptedTest.bin");
+    Ns2MobilityHelper (traceFile).WriteBinaryTrace (m_binary);
+
+    Ns2BinaryTraceHeader header;
+    std::ifstream binary (m_binary.c_str (), std::ios::in | std::ios::binary);
+    binary.read (reinterpret_cast<char *> (&header), sizeof (header));
+    NS_TEST_ASSERT_MSG_EQ (header.m_nNodes, 2, "Wrong number of nodes");
+    NS_TEST_ASSERT_MSG_GT (header.m_nMovements, 1, "Too few movements");
+    size_t size = sizeof (header) + header.m_nNodes * sizeof (Ns2BinaryTraceNode)
+      + header.m_nMovements * sizeof (Ns2BinaryTraceMovement);
+    size_t nodeOffset = sizeof (header);
+
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (m_binary), false, "Loading the valid binary trace aborted");
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (WriteCorrupted ("byte-order", offsetof (Ns2BinaryTraceHeader, m_byteOrder), (uint32_t) 0x04030201)),
+                           true, "Binary trace of another byte order loaded");
+    // 2^61 movements of 40 bytes wrap to 5 * 2^64 bytes, nothing on 64 bits
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (WriteCorrupted ("wrapping-count", offsetof (Ns2BinaryTraceHeader, m_nMovements),
+                                                       header.m_nMovements + (((uint64_t) 1) << 61))),
+                           true, "Binary trace with a wrapping movement count loaded");
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (WriteCorrupted ("truncated", 0, header, size - 1)),
+                           true, "Truncated binary trace loaded");
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (WriteCorrupted ("first-movement", nodeOffset + offsetof (Ns2BinaryTraceNode, m_firstMovement),
+                                                       header.m_nMovements)),
+                           true, "Binary trace with node movements after the last one loaded");
+    NS_TEST_EXPECT_MSG_EQ (LoadAborts (WriteCorrupted ("wrapping-movements", nodeOffset + offsetof (Ns2BinaryTraceNode, m_firstMovement),
+                                                       ~((uint64_t) 0))),
+                           true, "Binary trace with node movements wrapping the movement index loaded");
+  }
+};
+
 /**
  * \ingroup mobility-test
  * \ingroup tests
@@ -532,5 +828,10 @@ public:
     t->AddReferencePoint ("0", 920.000, Vector (300.000,  650.000, 0.000), Vector (0.000, 0.000, 0.000));
     AddTestCase (t, TestCase::QUICK);
 
+    AddTestCase (new Ns2MobilityHelperStreamingTest ("streaming, 1 s window", Seconds (1)), TestCase::QUICK);
+    AddTestCase (new Ns2MobilityHelperStreamingTest ("streaming, 0.3 s window", Seconds (0.3)), TestCase::QUICK);
+    AddTestCase (new Ns2MobilityHelperStreamingTest ("binary trace", Seconds (0), true), TestCase::QUICK);
+    AddTestCase (new Ns2BinaryTraceEmptyTest, TestCase::QUICK);
+    AddTestCase (new Ns2BinaryTraceCorruptedTest, TestCase::QUICK);
   }
 } g_ns2TransmobilityHelperTestSuite; ///< the test suite
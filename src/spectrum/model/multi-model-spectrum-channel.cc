@@ -27,6 +27,8 @@
 #include <ns3/net-device.h>
 #include <ns3/node.h>
 #include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
 #include <ns3/mobility-model.h>
 #include <ns3/spectrum-phy.h>
 #include <ns3/propagation-loss-model.h>
@@ -34,6 +36,8 @@
 #include <ns3/angles.h>
 #include <iostream>
 #include <utility>
+#include <cmath>
+#include <limits>
 #include "ns3/pointer.h"
 
 #include "multi-model-spectrum-channel.h"
@@ -82,6 +86,10 @@ RxSpectrumModelInfo::RxSpectrumModelInfo (Ptr<const SpectrumModel> rxSpectrumMod
 
 
 MultiModelSpectrumChannel::MultiModelSpectrumChannel ()
+  : m_numDevices (0),
+    m_spatialIndexValid (false),
+    m_pathLossCacheHits (0),
+    m_pathLossCacheMisses (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -92,6 +100,17 @@ MultiModelSpectrumChannel::DoDispose ()
   NS_LOG_FUNCTION (this);
   m_txSpectrumModelInfoMap.clear ();
   m_rxSpectrumModelInfoMap.clear ();
+  m_spatialIndex.clear ();
+  m_unlocatedRx.clear ();
+  for (std::set<Ptr<MobilityModel> >::const_iterator it = m_observedMobility.begin ();
+       it != m_observedMobility.end ();
+       ++it)
+    {
+      (*it)->TraceDisconnectWithoutContext ("CourseChange", MakeCallback (&MultiModelSpectrumChannel::NotifyCourseChange, this));
+    }
+  m_observedMobility.clear ();
+  m_pathLossCache.clear ();
+  m_mobilityEpochs.clear ();
   SpectrumChannel::DoDispose ();
 }
 
@@ -102,7 +121,56 @@ MultiModelSpectrumChannel::GetTypeId (void)
     .SetParent<SpectrumChannel> ()
     .SetGroupName ("Spectrum")
     .AddConstructor<MultiModelSpectrumChannel> ()
-
+    .AddAttribute ("SpatialIndexEnabled",
+                   "If true, the receivers are indexed on a grid of their positions "
+                   "and a transmission only visits the receivers which could be "
+                   "within MaxRange of the transmitter. The index is rebuilt "
+                   "lazily when the simulation time advances or a receiver "
+                   "changes course.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultiModelSpectrumChannel::m_spatialIndexEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("MaxRange",
+                   "The distance in meters beyond which receivers are culled when "
+                   "the spatial index is enabled, 0 to disable culling. It must be a "
+                   "deterministic bound: the loss to any receiver beyond it must "
+                   "always exceed MaxLossDb, including shadowing and fading. The "
+                   "culled receivers are not visited at all, so the PathLoss and "
+                   "Gain traces are not fired for them and the PropagationLossModel "
+                   "is not evaluated: with a loss model drawing random variables, "
+                   "the subsequent draws differ from a run without culling.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&MultiModelSpectrumChannel::m_maxRange),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("PathLossCacheEnabled",
+                   "If true, the gains of the antennas and of the PropagationLossModel "
+                   "are cached per (transmitter, receiver) path and reused until one of "
+                   "the two nodes moves or uses another antenna. The random components "
+                   "of the loss model (e.g., shadowing) are only drawn again when a node "
+                   "moves, and the antennas must not be reoriented while cached.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&MultiModelSpectrumChannel::m_pathLossCacheEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PathLossCacheMaxSize",
+                   "The maximum number of paths in the path loss cache. "
+                   "When it is reached, the gains of the paths with an end which "
+                   "moved are dropped, and the whole cache if more than half of it "
+                   "is still valid.",
+                   UintegerValue (1000000),
+                   MakeUintegerAccessor (&MultiModelSpectrumChannel::m_pathLossCacheMaxSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PathLossCacheHits",
+                   "The number of path gains found in the path loss cache.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultiModelSpectrumChannel::m_pathLossCacheHits),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("PathLossCacheMisses",
+                   "The number of path gains computed with the path loss cache enabled.",
+                   TypeId::ATTR_GET,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultiModelSpectrumChannel::m_pathLossCacheMisses),
+                   MakeUintegerChecker<uint64_t> ())
   ;
   return tid;
 }
@@ -138,6 +206,7 @@ MultiModelSpectrumChannel::AddRx (Ptr<SpectrumPhy> phy)
     }
 
   ++m_numDevices;
+  m_spatialIndexValid = false;
 
   RxSpectrumModelInfoMap_t::iterator rxInfoIterator = m_rxSpectrumModelInfoMap.find (rxSpectrumModelUid);
 
@@ -245,6 +314,13 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
   NS_LOG_LOGIC ("converter map size: " << txInfoIteratorerator->second.m_spectrumConverterMap.size ());
   NS_LOG_LOGIC ("converter map first element: " << txInfoIteratorerator->second.m_spectrumConverterMap.begin ()->first);
 
+  bool cullReceivers = false;
+  if (m_spatialIndexEnabled && txMobility && !std::isinf (GetCullingRange ()))
+    {
+      RefreshSpatialIndex ();
+      cullReceivers = true;
+    }
+
   for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
        rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
        ++rxInfoIterator)
@@ -271,97 +347,341 @@ MultiModelSpectrumChannel::StartTx (Ptr<SpectrumSignalParameters> txParams)
         }
 
 
+      if (cullReceivers)
+        {
+          std::vector<Ptr<SpectrumPhy> > receivers;
+          GetReceiversInRange (txMobility->GetPosition (), rxSpectrumModelUid, receivers);
+          NS_LOG_LOGIC ("visiting " << receivers.size () << " of " << rxInfoIterator->second.m_rxPhySet.size () << " receivers");
+          for (std::vector<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = receivers.begin ();
+               rxPhyIterator != receivers.end ();
+               ++rxPhyIterator)
+            {
+              StartTxToReceiver (txParams, convertedTxPowerSpectrum, *rxPhyIterator);
+            }
+          continue;
+        }
+
       for (std::set<Ptr<SpectrumPhy> >::const_iterator rxPhyIterator = rxInfoIterator->second.m_rxPhySet.begin ();
            rxPhyIterator != rxInfoIterator->second.m_rxPhySet.end ();
            ++rxPhyIterator)
         {
           NS_ASSERT_MSG ((*rxPhyIterator)->GetRxSpectrumModel ()->GetUid () == rxSpectrumModelUid,
                          "SpectrumModel change was not notified to MultiModelSpectrumChannel (i.e., AddRx should be called again after model is changed)");
+          StartTxToReceiver (txParams, convertedTxPowerSpectrum, *rxPhyIterator);
+        }
 
-          if ((*rxPhyIterator) != txParams->txPhy)
-            {
-              NS_LOG_LOGIC (" copying signal parameters " << txParams);
-              Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
-              rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
-              Time delay = MicroSeconds (0);
+    }
 
-              Ptr<MobilityModel> receiverMobility = (*rxPhyIterator)->GetMobility ();
+}
 
-              if (txMobility && receiverMobility)
-                {
-                  double txAntennaGain = 0;
-                  double rxAntennaGain = 0;
-                  double propagationGainDb = 0;
-                  double pathLossDb = 0;
-
-                  if (rxParams->txAntenna != 0)
-                    {
-                      Angles txAngles (receiverMobility->GetPosition (), txMobility->GetPosition ());
-                      txAntennaGain = rxParams->txAntenna->GetGainDb (txAngles);
-                      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
-                      pathLossDb -= txAntennaGain;
-                      NS_LOG_LOGIC ("pathLossDb = " << pathLossDb << " dB");
-                    }
-                  Ptr<AntennaModel> rxAntenna = (*rxPhyIterator)->GetRxAntenna ();
-                  if (rxAntenna != 0)
-                    {
-                      Angles rxAngles (txMobility->GetPosition (), receiverMobility->GetPosition ());
-                      rxAntennaGain = rxAntenna->GetGainDb (rxAngles);
-                      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
-                      pathLossDb -= rxAntennaGain;
-                      NS_LOG_LOGIC ("pathLossDb = " << pathLossDb << " dB");
-                    }
-                  if (m_propagationLoss)
-                    {
-                      propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, receiverMobility);
-                      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
-                      pathLossDb -= propagationGainDb;
-                      NS_LOG_LOGIC ("pathLossDb = " << pathLossDb << " dB");
-                    }                    
-                  NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");    
-
-                  // Gain trace
-                  m_gainTrace (txMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
-
-                  m_pathLossTrace (txParams->txPhy, *rxPhyIterator, pathLossDb);
-                  if ( pathLossDb > m_maxLossDb)
-                    {
-                      // beyond range
-                      continue;
-                    }
-                  double pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
-                  *(rxParams->psd) *= pathGainLinear;              
-
-                  if (m_spectrumPropagationLoss)
-                    {
-                      rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
-                    }
-
-                  if (m_propagationDelay)
-                    {
-                      delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
-                    }
-                }
+void
+MultiModelSpectrumChannel::StartTxToReceiver (Ptr<SpectrumSignalParameters> txParams,
+                                              Ptr<SpectrumValue> convertedTxPowerSpectrum,
+                                              Ptr<SpectrumPhy> receiver)
+{
+  if (receiver == txParams->txPhy)
+    {
+      return;
+    }
 
-              Ptr<NetDevice> netDev = (*rxPhyIterator)->GetDevice ();
-              if (netDev)
-                {
-                  // the receiver has a NetDevice, so we expect that it is attached to a Node
-                  uint32_t dstNode =  netDev->GetNode ()->GetId ();
-                  Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
-                                                  rxParams, *rxPhyIterator);
-                }
-              else
+  Ptr<MobilityModel> txMobility = txParams->txPhy->GetMobility ();
+  Ptr<MobilityModel> receiverMobility = receiver->GetMobility ();
+  double pathGainLinear = 1.0;
+  Time delay = MicroSeconds (0);
+
+  if (txMobility && receiverMobility)
+    {
+      PathGains gains = GetPathGains (txParams->txAntenna, txMobility, receiver->GetRxAntenna (), receiverMobility);
+      double txAntennaGain = gains.txAntennaGainDb;
+      double rxAntennaGain = gains.rxAntennaGainDb;
+      double propagationGainDb = gains.propagationGainDb;
+      double pathLossDb = 0;
+
+      NS_LOG_LOGIC ("txAntennaGain = " << txAntennaGain << " dB");
+      pathLossDb -= txAntennaGain;
+      NS_LOG_LOGIC ("rxAntennaGain = " << rxAntennaGain << " dB");
+      pathLossDb -= rxAntennaGain;
+      NS_LOG_LOGIC ("propagationGainDb = " << propagationGainDb << " dB");
+      pathLossDb -= propagationGainDb;
+      NS_LOG_LOGIC ("total pathLoss = " << pathLossDb << " dB");
+
+      // Gain trace
+      m_gainTrace (txMobility, receiverMobility, txAntennaGain, rxAntennaGain, propagationGainDb, pathLossDb);
+
+      m_pathLossTrace (txParams->txPhy, receiver, pathLossDb);
+      if ( pathLossDb > m_maxLossDb)
+        {
+          // beyond range
+          return;
+        }
+      pathGainLinear = std::pow (10.0, (-pathLossDb) / 10.0);
+    }
+
+  // the signal parameters and the PSD are only copied for the receivers in range
+  NS_LOG_LOGIC (" copying signal parameters " << txParams);
+  Ptr<SpectrumSignalParameters> rxParams = txParams->Copy ();
+  rxParams->psd = Copy<SpectrumValue> (convertedTxPowerSpectrum);
+
+  if (txMobility && receiverMobility)
+    {
+      *(rxParams->psd) *= pathGainLinear;
+
+      if (m_spectrumPropagationLoss)
+        {
+          rxParams->psd = m_spectrumPropagationLoss->CalcRxPowerSpectralDensity (rxParams->psd, txMobility, receiverMobility);
+        }
+
+      if (m_propagationDelay)
+        {
+          delay = m_propagationDelay->GetDelay (txMobility, receiverMobility);
+        }
+    }
+
+  Ptr<NetDevice> netDev = receiver->GetDevice ();
+  if (netDev)
+    {
+      // the receiver has a NetDevice, so we expect that it is attached to a Node
+      uint32_t dstNode =  netDev->GetNode ()->GetId ();
+      Simulator::ScheduleWithContext (dstNode, delay, &MultiModelSpectrumChannel::StartRx, this,
+                                      rxParams, receiver);
+    }
+  else
+    {
+      // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
+      Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
+                           rxParams, receiver);
+    }
+}
+
+uint64_t
+MultiModelSpectrumChannel::GetMobilityEpoch (Ptr<MobilityModel> mobility)
+{
+  std::map<Ptr<const MobilityModel>, MobilityEpoch>::iterator it = m_mobilityEpochs.find (mobility);
+  if (it == m_mobilityEpochs.end ())
+    {
+      ObserveCourseChanges (mobility);
+      MobilityEpoch entry;
+      entry.epoch = 0;
+      entry.position = mobility->GetPosition ();
+      entry.lastCheck = Simulator::Now ();
+      m_mobilityEpochs.insert (std::make_pair (mobility, entry));
+      return 0;
+    }
+  if (it->second.lastCheck != Simulator::Now ())
+    {
+      // positions change continuously without course change notifications
+      Vector position = mobility->GetPosition ();
+      if (position.x != it->second.position.x
+          || position.y != it->second.position.y
+          || position.z != it->second.position.z)
+        {
+          it->second.epoch++;
+          it->second.position = position;
+        }
+      it->second.lastCheck = Simulator::Now ();
+    }
+  return it->second.epoch;
+}
+
+MultiModelSpectrumChannel::PathGains
+MultiModelSpectrumChannel::ComputePathGains (Ptr<AntennaModel> txAntenna, Ptr<MobilityModel> txMobility,
+                                             Ptr<AntennaModel> rxAntenna, Ptr<MobilityModel> rxMobility) const
+{
+  PathGains gains;
+  gains.txAntennaGainDb = 0;
+  gains.rxAntennaGainDb = 0;
+  gains.propagationGainDb = 0;
+  if (txAntenna != 0)
+    {
+      Angles txAngles (rxMobility->GetPosition (), txMobility->GetPosition ());
+      gains.txAntennaGainDb = txAntenna->GetGainDb (txAngles);
+    }
+  if (rxAntenna != 0)
+    {
+      Angles rxAngles (txMobility->GetPosition (), rxMobility->GetPosition ());
+      gains.rxAntennaGainDb = rxAntenna->GetGainDb (rxAngles);
+    }
+  if (m_propagationLoss)
+    {
+      gains.propagationGainDb = m_propagationLoss->CalcRxPower (0, txMobility, rxMobility);
+    }
+  return gains;
+}
+
+MultiModelSpectrumChannel::PathGains
+MultiModelSpectrumChannel::GetPathGains (Ptr<AntennaModel> txAntenna, Ptr<MobilityModel> txMobility,
+                                         Ptr<AntennaModel> rxAntenna, Ptr<MobilityModel> rxMobility)
+{
+  if (!m_pathLossCacheEnabled)
+    {
+      return ComputePathGains (txAntenna, txMobility, rxAntenna, rxMobility);
+    }
+
+  // the paths are directed, the loss model and the antennas need not be reciprocal
+  uint64_t txEpoch = GetMobilityEpoch (txMobility);
+  uint64_t rxEpoch = GetMobilityEpoch (rxMobility);
+  PathLossCacheKey_t key (txMobility, rxMobility);
+  std::map<PathLossCacheKey_t, PathLossCacheEntry>::iterator it = m_pathLossCache.find (key);
+  if (it != m_pathLossCache.end ()
+      && it->second.txEpoch == txEpoch && it->second.rxEpoch == rxEpoch
+      && it->second.txAntenna == txAntenna && it->second.rxAntenna == rxAntenna)
+    {
+      m_pathLossCacheHits++;
+      return it->second.gains;
+    }
+
+  m_pathLossCacheMisses++;
+  if (it == m_pathLossCache.end ())
+    {
+      if (m_pathLossCache.size () >= m_pathLossCacheMaxSize)
+        {
+          EvictPathLossCache ();
+        }
+      it = m_pathLossCache.insert (std::make_pair (key, PathLossCacheEntry ())).first;
+    }
+  it->second.txEpoch = txEpoch;
+  it->second.rxEpoch = rxEpoch;
+  it->second.txAntenna = txAntenna;
+  it->second.rxAntenna = rxAntenna;
+  it->second.gains = ComputePathGains (txAntenna, txMobility, rxAntenna, rxMobility);
+  return it->second.gains;
+}
+
+void
+MultiModelSpectrumChannel::EvictPathLossCache (void)
+{
+  NS_LOG_FUNCTION (this << m_pathLossCache.size ());
+  std::map<PathLossCacheKey_t, PathLossCacheEntry>::iterator it = m_pathLossCache.begin ();
+  while (it != m_pathLossCache.end ())
+    {
+      // the epochs are not polled here, a path is stale if an end moved since it was last used
+      if (it->second.txEpoch != m_mobilityEpochs[it->first.first].epoch
+          || it->second.rxEpoch != m_mobilityEpochs[it->first.second].epoch)
+        {
+          m_pathLossCache.erase (it++);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+  if (m_pathLossCache.size () > m_pathLossCacheMaxSize / 2)
+    {
+      m_pathLossCache.clear ();
+    }
+  NS_LOG_LOGIC ("path loss cache size after eviction: " << m_pathLossCache.size ());
+}
+
+std::size_t
+MultiModelSpectrumChannel::GetPathLossCacheSize (void) const
+{
+  return m_pathLossCache.size ();
+}
+
+double
+MultiModelSpectrumChannel::GetCullingRange (void) const
+{
+  return m_maxRange > 0 ? m_maxRange : std::numeric_limits<double>::infinity ();
+}
+
+void
+MultiModelSpectrumChannel::ObserveCourseChanges (Ptr<MobilityModel> mobility)
+{
+  if (m_observedMobility.insert (mobility).second)
+    {
+      mobility->TraceConnectWithoutContext ("CourseChange", MakeCallback (&MultiModelSpectrumChannel::NotifyCourseChange, this));
+    }
+}
+
+void
+MultiModelSpectrumChannel::NotifyCourseChange (Ptr<const MobilityModel> mobility)
+{
+  NS_LOG_FUNCTION (this << mobility);
+  m_spatialIndexValid = false;
+  std::map<Ptr<const MobilityModel>, MobilityEpoch>::iterator it = m_mobilityEpochs.find (mobility);
+  if (it != m_mobilityEpochs.end ())
+    {
+      // e.g., a position set within the current time step
+      it->second.epoch++;
+      it->second.position = mobility->GetPosition ();
+      it->second.lastCheck = Simulator::Now ();
+    }
+}
+
+void
+MultiModelSpectrumChannel::RefreshSpatialIndex (void)
+{
+  if (m_spatialIndexValid && m_spatialIndexTime == Simulator::Now ())
+    {
+      return;
+    }
+  NS_LOG_FUNCTION (this);
+  double cellSize = GetCullingRange ();
+  m_spatialIndex.clear ();
+  m_unlocatedRx.clear ();
+  for (RxSpectrumModelInfoMap_t::const_iterator rxInfoIterator = m_rxSpectrumModelInfoMap.begin ();
+       rxInfoIterator != m_rxSpectrumModelInfoMap.end ();
+       ++rxInfoIterator)
+    {
+      for (std::set<Ptr<SpectrumPhy> >::const_iterator phyIt = rxInfoIterator->second.m_rxPhySet.begin ();
+           phyIt != rxInfoIterator->second.m_rxPhySet.end ();
+           ++phyIt)
+        {
+          IndexedRx entry;
+          entry.phy = *phyIt;
+          entry.modelUid = rxInfoIterator->first;
+          Ptr<MobilityModel> mobility = (*phyIt)->GetMobility ();
+          if (mobility == 0)
+            {
+              m_unlocatedRx.push_back (entry);
+              continue;
+            }
+          // a receiver moved by SetPosition within this time step must be indexed again
+          ObserveCourseChanges (mobility);
+          Vector position = mobility->GetPosition ();
+          GridCell_t cell (static_cast<int64_t> (std::floor (position.x / cellSize)),
+                           static_cast<int64_t> (std::floor (position.y / cellSize)));
+          m_spatialIndex[cell].push_back (entry);
+        }
+    }
+  m_spatialIndexValid = true;
+  m_spatialIndexTime = Simulator::Now ();
+}
+
+void
+MultiModelSpectrumChannel::GetReceiversInRange (Vector txPosition, SpectrumModelUid_t rxSpectrumModelUid,
+                                                std::vector<Ptr<SpectrumPhy> > &receivers) const
+{
+  // the cells are as large as the culling range, so all the receivers
+  // within range are in the cell of the transmitter or in its 8 neighbors
+  double cellSize = m_maxRange;
+  int64_t txCellX = static_cast<int64_t> (std::floor (txPosition.x / cellSize));
+  int64_t txCellY = static_cast<int64_t> (std::floor (txPosition.y / cellSize));
+  for (int64_t x = txCellX - 1; x <= txCellX + 1; x++)
+    {
+      for (int64_t y = txCellY - 1; y <= txCellY + 1; y++)
+        {
+          std::map<GridCell_t, std::vector<IndexedRx> >::const_iterator cellIt = m_spatialIndex.find (GridCell_t (x, y));
+          if (cellIt == m_spatialIndex.end ())
+            {
+              continue;
+            }
+          for (std::vector<IndexedRx>::const_iterator rxIt = cellIt->second.begin (); rxIt != cellIt->second.end (); ++rxIt)
+            {
+              if (rxIt->modelUid == rxSpectrumModelUid)
                 {
-                  // the receiver is not attached to a NetDevice, so we cannot assume that it is attached to a node
-                  Simulator::Schedule (delay, &MultiModelSpectrumChannel::StartRx, this,
-                                       rxParams, *rxPhyIterator);
+                  receivers.push_back (rxIt->phy);
                 }
             }
         }
-
     }
-
+  for (std::vector<IndexedRx>::const_iterator rxIt = m_unlocatedRx.begin (); rxIt != m_unlocatedRx.end (); ++rxIt)
+    {
+      if (rxIt->modelUid == rxSpectrumModelUid)
+        {
+          receivers.push_back (rxIt->phy);
+        }
+    }
 }
 
 void
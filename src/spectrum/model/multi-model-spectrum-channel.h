@@ -27,11 +27,16 @@
 #include <ns3/spectrum-channel.h>
 #include <ns3/spectrum-propagation-loss-model.h>
 #include <ns3/propagation-delay-model.h>
+#include <ns3/assert.h>
+#include <ns3/nstime.h>
+#include <ns3/vector.h>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace ns3 {
 
+class AntennaModel;
 
 /**
  * \ingroup spectrum
@@ -124,11 +129,159 @@ public:
   virtual std::size_t GetNDevices (void) const;
   virtual Ptr<NetDevice> GetDevice (std::size_t i) const;
 
+  /**
+   * \brief Get the range beyond which receivers are culled
+   *
+   * \return The MaxRange attribute in meters, or infinity if it is not
+   *         set, in which case no receiver is culled
+   */
+  double GetCullingRange (void) const;
+
+  /**
+   * \return The number of paths held in the path loss cache
+   */
+  std::size_t GetPathLossCacheSize (void) const;
+
 
 protected:
   void DoDispose ();
 
 private:
+  /// Receiver entry of the spatial index
+  struct IndexedRx
+  {
+    Ptr<SpectrumPhy> phy;          //!< The receiver
+    SpectrumModelUid_t modelUid;   //!< The Rx SpectrumModel of the receiver
+  };
+
+  /// Grid cell coordinates
+  typedef std::pair<int64_t, int64_t> GridCell_t;
+
+  /**
+   * Rebuild the spatial index of the receivers from their current
+   * positions, unless it was built at the current time and no receiver
+   * changed course since.
+   */
+  void RefreshSpatialIndex (void);
+
+  /**
+   * Collect the receivers of a given Rx SpectrumModel which could be
+   * within the culling range of the transmitter, plus the receivers
+   * without a mobility model.
+   *
+   * \param txPosition The position of the transmitter
+   * \param rxSpectrumModelUid The Rx SpectrumModel
+   * \param receivers The receivers found
+   */
+  void GetReceiversInRange (Vector txPosition, SpectrumModelUid_t rxSpectrumModelUid,
+                            std::vector<Ptr<SpectrumPhy> > &receivers) const;
+
+  /**
+   * Connect to the CourseChange trace of a MobilityModel, once.
+   *
+   * \param mobility The MobilityModel
+   */
+  void ObserveCourseChanges (Ptr<MobilityModel> mobility);
+
+  /**
+   * Invalidate the spatial index and the cached propagation gains of a
+   * node when it changes course, e.g., when its position is set within
+   * the current time step.
+   *
+   * \param mobility The MobilityModel of the node
+   */
+  void NotifyCourseChange (Ptr<const MobilityModel> mobility);
+
+  /**
+   * Gains of a path from a transmitter to a receiver
+   */
+  struct PathGains
+  {
+    double txAntennaGainDb;    //!< Gain of the transmit antenna in dB
+    double rxAntennaGainDb;    //!< Gain of the receive antenna in dB
+    double propagationGainDb;  //!< Gain of the propagation loss model in dB
+  };
+
+  /**
+   * Gains of a path, valid as long as neither end moved and the
+   * antennas are the same
+   */
+  struct PathLossCacheEntry
+  {
+    uint64_t txEpoch;          //!< Position epoch of the transmitter
+    uint64_t rxEpoch;          //!< Position epoch of the receiver
+    Ptr<AntennaModel> txAntenna; //!< Transmit antenna of the gains
+    Ptr<AntennaModel> rxAntenna; //!< Receive antenna of the gains
+    PathGains gains;           //!< Gains of the path
+  };
+
+  /// Path of the cache, the MobilityModels of the transmitter and of the receiver
+  typedef std::pair<Ptr<const MobilityModel>, Ptr<const MobilityModel> > PathLossCacheKey_t;
+
+  /**
+   * Make room in the path loss cache: drop the gains of the paths with
+   * an end which moved since, and the whole cache if more than half of
+   * it is still valid.
+   */
+  void EvictPathLossCache (void);
+
+  /// Position epoch of a MobilityModel
+  struct MobilityEpoch
+  {
+    uint64_t epoch;     //!< Incremented every time the position changes
+    Vector position;    //!< Last position seen
+    Time lastCheck;     //!< Time at which the position was last checked
+  };
+
+  /**
+   * Get the position epoch of a MobilityModel. The epoch is incremented
+   * when the node changes course, and when the simulation time advanced
+   * and the position differs from the last position seen.
+   *
+   * \param mobility The MobilityModel
+   * \return The position epoch
+   */
+  uint64_t GetMobilityEpoch (Ptr<MobilityModel> mobility);
+
+  /**
+   * Compute the antenna and propagation gains from a transmitter to a
+   * receiver. A missing antenna or propagation loss model has no gain.
+   *
+   * \param txAntenna The antenna of the transmitter, may be null
+   * \param txMobility The MobilityModel of the transmitter
+   * \param rxAntenna The antenna of the receiver, may be null
+   * \param rxMobility The MobilityModel of the receiver
+   * \return The gains of the path
+   */
+  PathGains ComputePathGains (Ptr<AntennaModel> txAntenna, Ptr<MobilityModel> txMobility,
+                              Ptr<AntennaModel> rxAntenna, Ptr<MobilityModel> rxMobility) const;
+
+  /**
+   * Get the antenna and propagation gains from a transmitter to a
+   * receiver, from the path loss cache if enabled, neither node moved
+   * and the antennas are the same as when the gains were computed.
+   *
+   * \param txAntenna The antenna of the transmitter, may be null
+   * \param txMobility The MobilityModel of the transmitter
+   * \param rxAntenna The antenna of the receiver, may be null
+   * \param rxMobility The MobilityModel of the receiver
+   * \return The gains of the path
+   */
+  PathGains GetPathGains (Ptr<AntennaModel> txAntenna, Ptr<MobilityModel> txMobility,
+                          Ptr<AntennaModel> rxAntenna, Ptr<MobilityModel> rxMobility);
+
+  /**
+   * Compute the losses between the transmitter and one receiver and
+   * schedule the reception if the receiver is within range.
+   *
+   * \param txParams The signal parameters of the transmitter
+   * \param convertedTxPowerSpectrum The Tx PSD in the Rx SpectrumModel
+   * \param receiver The receiver
+   */
+  void StartTxToReceiver (Ptr<SpectrumSignalParameters> txParams,
+                          Ptr<SpectrumValue> convertedTxPowerSpectrum,
+                          Ptr<SpectrumPhy> receiver);
+
   /**
    * This method checks if m_rxSpectrumModelInfoMap contains an entry
    * for the given TX SpectrumModel. If such entry exists, it returns
@@ -169,6 +322,21 @@ private:
    */
   std::size_t m_numDevices;
 
+  bool m_spatialIndexEnabled;     //!< True if receivers out of range are culled with the spatial index
+  double m_maxRange;              //!< Culling range in meters, 0 to disable culling
+  bool m_spatialIndexValid;       //!< True if the spatial index is up to date
+  Time m_spatialIndexTime;        //!< Time at which the spatial index was built
+  std::map<GridCell_t, std::vector<IndexedRx> > m_spatialIndex; //!< Receivers per grid cell (cell size = MaxRange)
+  std::vector<IndexedRx> m_unlocatedRx; //!< Receivers without a mobility model, never culled
+  std::set<Ptr<MobilityModel> > m_observedMobility; //!< MobilityModels whose course changes are observed
+
+  bool m_pathLossCacheEnabled;    //!< True if the gains are cached per path
+  uint32_t m_pathLossCacheMaxSize; //!< Maximum number of cached paths
+  std::map<PathLossCacheKey_t, PathLossCacheEntry> m_pathLossCache; //!< Gains per (transmitter, receiver) path
+  std::map<Ptr<const MobilityModel>, MobilityEpoch> m_mobilityEpochs; //!< Position epoch per MobilityModel
+  uint64_t m_pathLossCacheHits;   //!< Number of path gains found in the cache
+  uint64_t m_pathLossCacheMisses; //!< Number of path gains computed
+
 };
 
 
@@ -0,0 +1,499 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/log.h>
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/double.h>
+#include <ns3/boolean.h>
+#include <ns3/uinteger.h>
+#include <ns3/spectrum-phy.h>
+#include <ns3/net-device.h>
+#include <ns3/antenna-model.h>
+#include <ns3/cosine-antenna-model.h>
+#include <ns3/spectrum-value.h>
+#include <ns3/spectrum-signal-parameters.h>
+#include <ns3/multi-model-spectrum-channel.h>
+#include <ns3/propagation-loss-model.h>
+#include <ns3/constant-position-mobility-model.h>
+#include <ns3/random-variable-stream.h>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("MultiModelSpectrumChannelTest");
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * Minimal SpectrumPhy recording the total power of every signal it receives
+ */
+class MultiModelSpectrumChannelTestPhy : public SpectrumPhy
+{
+public:
+  /**
+   * Constructor
+   *
+   * \param id The identifier of the PHY
+   * \param model The SpectrumModel of the PHY
+   * \param mobility The MobilityModel of the PHY
+   */
+  MultiModelSpectrumChannelTestPhy (uint32_t id, Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility);
+
+  // inherited from SpectrumPhy
+  virtual void SetDevice (Ptr<NetDevice> d);
+  virtual Ptr<NetDevice> GetDevice () const;
+  virtual void SetMobility (Ptr<MobilityModel> m);
+  virtual Ptr<MobilityModel> GetMobility ();
+  virtual void SetChannel (Ptr<SpectrumChannel> c);
+  virtual Ptr<const SpectrumModel> GetRxSpectrumModel () const;
+  virtual Ptr<AntennaModel> GetRxAntenna ();
+  virtual void StartRx (Ptr<SpectrumSignalParameters> params);
+
+  /**
+   * \param antenna The antenna used to transmit and receive
+   */
+  void SetAntenna (Ptr<AntennaModel> antenna)
+  {
+    m_antenna = antenna;
+  }
+
+  /// \return The identifier of the PHY
+  uint32_t GetId () const
+  {
+    return m_id;
+  }
+
+  /// Received power (W) per transmitter identifier, in reception order
+  std::vector<std::pair<uint32_t, double> > m_received;
+
+private:
+  uint32_t m_id; ///< identifier
+  Ptr<const SpectrumModel> m_model; ///< SpectrumModel
+  Ptr<MobilityModel> m_mobility; ///< MobilityModel
+  Ptr<AntennaModel> m_antenna; ///< antenna, none by default
+};
+
+MultiModelSpectrumChannelTestPhy::MultiModelSpectrumChannelTestPhy (uint32_t id, Ptr<const SpectrumModel> model, Ptr<MobilityModel> mobility)
+  : m_id (id),
+    m_model (model),
+    m_mobility (mobility)
+{
+}
+
+void
+MultiModelSpectrumChannelTestPhy::SetDevice (Ptr<NetDevice> d)
+{
+}
+
+Ptr<NetDevice>
+MultiModelSpectrumChannelTestPhy::GetDevice () const
+{
+  return 0;
+}
+
+void
+MultiModelSpectrumChannelTestPhy::SetMobility (Ptr<MobilityModel> m)
+{
+  m_mobility = m;
+}
+
+Ptr<MobilityModel>
+MultiModelSpectrumChannelTestPhy::GetMobility ()
+{
+  return m_mobility;
+}
+
+void
+MultiModelSpectrumChannelTestPhy::SetChannel (Ptr<SpectrumChannel> c)
+{
+}
+
+Ptr<const SpectrumModel>
+MultiModelSpectrumChannelTestPhy::GetRxSpectrumModel () const
+{
+  return m_model;
+}
+
+Ptr<AntennaModel>
+MultiModelSpectrumChannelTestPhy::GetRxAntenna ()
+{
+  return m_antenna;
+}
+
+void
+MultiModelSpectrumChannelTestPhy::StartRx (Ptr<SpectrumSignalParameters> params)
+{
+  Ptr<MultiModelSpectrumChannelTestPhy> tx = DynamicCast<MultiModelSpectrumChannelTestPhy> (params->txPhy);
+  m_received.push_back (std::make_pair (tx->GetId (), Sum (*params->psd)));
+}
+
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * Non-reciprocal propagation loss model: the loss grows with the x
+ * coordinate of the transmitter only.
+ */
+class MultiModelSpectrumChannelTestLossModel : public PropagationLossModel
+{
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    return txPowerDbm - 0.1 * a->GetPosition ().x;
+  }
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+};
+
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * Test that the receivers culled by the spatial index of the
+ * MultiModelSpectrumChannel are exactly the receivers which would have
+ * been discarded by MaxLossDb, including receivers moved within the
+ * time step of a transmission.
+ */
+class MultiModelSpectrumChannelCullingTestCase : public TestCase
+{
+public:
+  MultiModelSpectrumChannelCullingTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Start a transmission of the given PHY on both channels
+   *
+   * \param i The index of the transmitting PHY
+   */
+  void Transmit (uint32_t i);
+
+  /**
+   * Move a node
+   *
+   * \param i The index of the node
+   * \param position The new position
+   */
+  void Move (uint32_t i, Vector position);
+
+  Ptr<MultiModelSpectrumChannel> m_culled; ///< channel with the spatial index
+  Ptr<MultiModelSpectrumChannel> m_unculled; ///< reference channel
+  std::vector<Ptr<MultiModelSpectrumChannelTestPhy> > m_culledPhys; ///< PHYs on the channel with the spatial index
+  std::vector<Ptr<MultiModelSpectrumChannelTestPhy> > m_unculledPhys; ///< PHYs on the reference channel
+  std::vector<Ptr<ConstantPositionMobilityModel> > m_mobility; ///< MobilityModels shared by both PHYs of a node
+  Ptr<SpectrumValue> m_txPsd; ///< Tx PSD
+};
+
+MultiModelSpectrumChannelCullingTestCase::MultiModelSpectrumChannelCullingTestCase ()
+  : TestCase ("Spatial index culling delivers to the same receivers")
+{
+}
+
+void
+MultiModelSpectrumChannelCullingTestCase::Transmit (uint32_t i)
+{
+  Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+  params->duration = MicroSeconds (100);
+  params->psd = m_txPsd;
+  params->txPhy = m_culledPhys[i];
+  m_culled->StartTx (params);
+  params = Create<SpectrumSignalParameters> ();
+  params->duration = MicroSeconds (100);
+  params->psd = m_txPsd;
+  params->txPhy = m_unculledPhys[i];
+  m_unculled->StartTx (params);
+}
+
+void
+MultiModelSpectrumChannelCullingTestCase::Move (uint32_t i, Vector position)
+{
+  m_mobility[i]->SetPosition (position);
+}
+
+void
+MultiModelSpectrumChannelCullingTestCase::DoRun (void)
+{
+  const uint32_t nNodes = 200;
+  const double areaSize = 5000.0;
+
+  // the Friis loss exceeds MaxLossDb beyond about 400 m, within MaxRange
+  std::vector<double> freqs;
+  freqs.push_back (5.9e9);
+  freqs.push_back (5.901e9);
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+  m_txPsd = Create<SpectrumValue> (model);
+  (*m_txPsd) = 1e-3 / 2e6;
+
+  m_culled = CreateObject<MultiModelSpectrumChannel> ();
+  m_culled->SetAttribute ("MaxLossDb", DoubleValue (100.0));
+  m_culled->SetAttribute ("SpatialIndexEnabled", BooleanValue (true));
+  m_culled->SetAttribute ("MaxRange", DoubleValue (500.0));
+  m_culled->AddPropagationLossModel (CreateObject<FriisPropagationLossModel> ());
+  m_unculled = CreateObject<MultiModelSpectrumChannel> ();
+  m_unculled->SetAttribute ("MaxLossDb", DoubleValue (100.0));
+  m_unculled->AddPropagationLossModel (CreateObject<FriisPropagationLossModel> ());
+  NS_TEST_ASSERT_MSG_EQ (m_culled->GetCullingRange (), 500.0, "Wrong culling range");
+
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (1);
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (rv->GetValue (0, areaSize), rv->GetValue (0, areaSize), 1.5));
+      m_mobility.push_back (mobility);
+      m_culledPhys.push_back (CreateObject<MultiModelSpectrumChannelTestPhy> (i, model, mobility));
+      m_unculledPhys.push_back (CreateObject<MultiModelSpectrumChannelTestPhy> (i, model, mobility));
+      m_culled->AddRx (m_culledPhys[i]);
+      m_unculled->AddRx (m_unculledPhys[i]);
+    }
+
+  for (uint32_t t = 0; t < 20; t++)
+    {
+      for (uint32_t n = 0; n < 10; n++)
+        {
+          uint32_t tx = rv->GetInteger (0, nNodes - 1);
+          uint32_t moved = rv->GetInteger (0, nNodes - 1);
+          Vector position = m_mobility[tx]->GetPosition ();
+          // move a node next to the transmitter within the same time step
+          position.x += rv->GetValue (-200.0, 200.0);
+          Simulator::Schedule (MilliSeconds (t), &MultiModelSpectrumChannelCullingTestCase::Transmit, this, tx);
+          Simulator::Schedule (MilliSeconds (t), &MultiModelSpectrumChannelCullingTestCase::Move, this, moved, position);
+          Simulator::Schedule (MilliSeconds (t), &MultiModelSpectrumChannelCullingTestCase::Transmit, this, tx);
+        }
+    }
+  Simulator::Run ();
+
+  uint32_t nReceived = 0;
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      const std::vector<std::pair<uint32_t, double> > &culled = m_culledPhys[i]->m_received;
+      const std::vector<std::pair<uint32_t, double> > &unculled = m_unculledPhys[i]->m_received;
+      NS_TEST_ASSERT_MSG_EQ (culled.size (), unculled.size (), "Different number of receptions at node " << i);
+      for (uint32_t j = 0; j < culled.size () && j < unculled.size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (culled[j].first, unculled[j].first, "Different transmitter at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (culled[j].second, unculled[j].second, "Different power at node " << i);
+        }
+      nReceived += unculled.size ();
+    }
+  NS_TEST_ASSERT_MSG_GT (nReceived, 0, "Nothing received, the test is meaningless");
+
+  m_culled->Dispose ();
+  m_unculled->Dispose ();
+  m_culledPhys.clear ();
+  m_unculledPhys.clear ();
+  m_mobility.clear ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * Test the hits, misses, invalidation and eviction of the path loss
+ * cache of the MultiModelSpectrumChannel, and that the cached gains are
+ * the gains computed without the cache, with a non-reciprocal loss model
+ * and directional antennas.
+ */
+class MultiModelSpectrumChannelPathLossCacheTestCase : public TestCase
+{
+public:
+  MultiModelSpectrumChannelPathLossCacheTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Start a transmission of the given PHY on both channels
+   *
+   * \param i The index of the transmitting PHY
+   */
+  void Transmit (uint32_t i);
+
+  /**
+   * Check the hits and misses of the path loss cache since the last check
+   *
+   * \param hits The expected number of hits
+   * \param misses The expected number of misses
+   */
+  void CheckCounters (uint64_t hits, uint64_t misses);
+
+  Ptr<MultiModelSpectrumChannel> m_cached; ///< channel with the path loss cache
+  Ptr<MultiModelSpectrumChannel> m_uncached; ///< reference channel
+  std::vector<Ptr<MultiModelSpectrumChannelTestPhy> > m_cachedPhys; ///< PHYs on the channel with the cache
+  std::vector<Ptr<MultiModelSpectrumChannelTestPhy> > m_uncachedPhys; ///< PHYs on the reference channel
+  std::vector<Ptr<ConstantPositionMobilityModel> > m_mobility; ///< MobilityModels shared by both PHYs of a node
+  Ptr<SpectrumValue> m_txPsd; ///< Tx PSD
+  uint64_t m_hits; ///< hits at the last check
+  uint64_t m_misses; ///< misses at the last check
+};
+
+MultiModelSpectrumChannelPathLossCacheTestCase::MultiModelSpectrumChannelPathLossCacheTestCase ()
+  : TestCase ("Path loss cache hits, misses, invalidation and eviction"),
+    m_hits (0),
+    m_misses (0)
+{
+}
+
+void
+MultiModelSpectrumChannelPathLossCacheTestCase::Transmit (uint32_t i)
+{
+  Ptr<SpectrumSignalParameters> params = Create<SpectrumSignalParameters> ();
+  params->duration = MicroSeconds (100);
+  params->psd = m_txPsd;
+  params->txPhy = m_cachedPhys[i];
+  params->txAntenna = m_cachedPhys[i]->GetRxAntenna ();
+  m_cached->StartTx (params);
+  params = Create<SpectrumSignalParameters> ();
+  params->duration = MicroSeconds (100);
+  params->psd = m_txPsd;
+  params->txPhy = m_uncachedPhys[i];
+  params->txAntenna = m_uncachedPhys[i]->GetRxAntenna ();
+  m_uncached->StartTx (params);
+}
+
+void
+MultiModelSpectrumChannelPathLossCacheTestCase::CheckCounters (uint64_t hits, uint64_t misses)
+{
+  UintegerValue value;
+  m_cached->GetAttribute ("PathLossCacheHits", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get () - m_hits, hits, "Wrong number of hits at " << Simulator::Now ().GetSeconds ());
+  m_hits = value.Get ();
+  m_cached->GetAttribute ("PathLossCacheMisses", value);
+  NS_TEST_EXPECT_MSG_EQ (value.Get () - m_misses, misses, "Wrong number of misses at " << Simulator::Now ().GetSeconds ());
+  m_misses = value.Get ();
+}
+
+void
+MultiModelSpectrumChannelPathLossCacheTestCase::DoRun (void)
+{
+  const uint32_t nNodes = 10;
+
+  std::vector<double> freqs;
+  freqs.push_back (5.9e9);
+  freqs.push_back (5.901e9);
+  Ptr<SpectrumModel> model = Create<SpectrumModel> (freqs);
+  m_txPsd = Create<SpectrumValue> (model);
+  (*m_txPsd) = 1e-3 / 2e6;
+
+  m_cached = CreateObject<MultiModelSpectrumChannel> ();
+  m_cached->SetAttribute ("PathLossCacheEnabled", BooleanValue (true));
+  m_cached->SetAttribute ("PathLossCacheMaxSize", UintegerValue (30));
+  m_cached->AddPropagationLossModel (CreateObject<FriisPropagationLossModel> ());
+  m_cached->AddPropagationLossModel (CreateObject<MultiModelSpectrumChannelTestLossModel> ());
+  m_uncached = CreateObject<MultiModelSpectrumChannel> ();
+  m_uncached->AddPropagationLossModel (CreateObject<FriisPropagationLossModel> ());
+  m_uncached->AddPropagationLossModel (CreateObject<MultiModelSpectrumChannelTestLossModel> ());
+
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Ptr<ConstantPositionMobilityModel> mobility = CreateObject<ConstantPositionMobilityModel> ();
+      mobility->SetPosition (Vector (10.0 * i, 0.0, 1.5));
+      m_mobility.push_back (mobility);
+      Ptr<CosineAntennaModel> antenna = CreateObject<CosineAntennaModel> ();
+      antenna->SetAttribute ("Orientation", DoubleValue (36.0 * i));
+      m_cachedPhys.push_back (CreateObject<MultiModelSpectrumChannelTestPhy> (i, model, mobility));
+      m_cachedPhys[i]->SetAntenna (antenna);
+      m_uncachedPhys.push_back (CreateObject<MultiModelSpectrumChannelTestPhy> (i, model, mobility));
+      m_uncachedPhys[i]->SetAntenna (antenna);
+      m_cached->AddRx (m_cachedPhys[i]);
+      m_uncached->AddRx (m_uncachedPhys[i]);
+    }
+
+  // first transmission: one miss per receiver
+  Transmit (0);
+  CheckCounters (0, nNodes - 1);
+  NS_TEST_ASSERT_MSG_EQ (m_cached->GetPathLossCacheSize (), nNodes - 1, "Wrong cache size");
+
+  // nobody moved: one hit per receiver
+  Transmit (0);
+  CheckCounters (nNodes - 1, 0);
+  // the paths are directed: the reverse path 1 -> 0 is computed
+  Transmit (1);
+  CheckCounters (0, nNodes - 1);
+  NS_TEST_ASSERT_MSG_EQ (m_cached->GetPathLossCacheSize (), 2 * (nNodes - 1), "Wrong cache size");
+
+  // another antenna: the paths of the node are computed again
+  Ptr<CosineAntennaModel> antenna = CreateObject<CosineAntennaModel> ();
+  antenna->SetAttribute ("Orientation", DoubleValue (180.0));
+  m_cachedPhys[1]->SetAntenna (antenna);
+  m_uncachedPhys[1]->SetAntenna (antenna);
+  Transmit (0);
+  CheckCounters (nNodes - 2, 1);
+
+  // a node moved within the same time step: only its paths are computed again
+  m_mobility[2]->SetPosition (Vector (500.0, 0.0, 1.5));
+  Transmit (0);
+  CheckCounters (nNodes - 2, 1);
+
+  // the next time step, the positions are checked again
+  Simulator::Schedule (MilliSeconds (1), &MultiModelSpectrumChannelPathLossCacheTestCase::Transmit, this, 0);
+  Simulator::Schedule (MilliSeconds (1), &MultiModelSpectrumChannelPathLossCacheTestCase::CheckCounters, this, nNodes - 1, 0);
+  Simulator::Schedule (MilliSeconds (2), &ConstantPositionMobilityModel::SetPosition, m_mobility[3], Vector (30.0, 5.0, 1.5));
+  Simulator::Schedule (MilliSeconds (3), &MultiModelSpectrumChannelPathLossCacheTestCase::Transmit, this, 0);
+  Simulator::Schedule (MilliSeconds (3), &MultiModelSpectrumChannelPathLossCacheTestCase::CheckCounters, this, nNodes - 2, 1);
+  // every node transmits: the 90 paths do not fit in the cache
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      Simulator::Schedule (MilliSeconds (4), &MultiModelSpectrumChannelPathLossCacheTestCase::Transmit, this, i);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (m_cached->GetPathLossCacheSize (), 30, "The cache is not bounded");
+
+  for (uint32_t i = 0; i < nNodes; i++)
+    {
+      const std::vector<std::pair<uint32_t, double> > &cached = m_cachedPhys[i]->m_received;
+      const std::vector<std::pair<uint32_t, double> > &uncached = m_uncachedPhys[i]->m_received;
+      NS_TEST_ASSERT_MSG_EQ (cached.size (), uncached.size (), "Different number of receptions at node " << i);
+      for (uint32_t j = 0; j < cached.size () && j < uncached.size (); j++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (cached[j].first, uncached[j].first, "Different transmitter at node " << i);
+          NS_TEST_ASSERT_MSG_EQ (cached[j].second, uncached[j].second, "Different power at node " << i);
+        }
+    }
+
+  m_cached->Dispose ();
+  m_uncached->Dispose ();
+  m_cachedPhys.clear ();
+  m_uncachedPhys.clear ();
+  m_mobility.clear ();
+  Simulator::Destroy ();
+}
+
+
+/**
+ * \ingroup spectrum-tests
+ *
+ * MultiModelSpectrumChannel test suite
+ */
+class MultiModelSpectrumChannelTestSuite : public TestSuite
+{
+public:
+  MultiModelSpectrumChannelTestSuite ();
+};
+
+MultiModelSpectrumChannelTestSuite::MultiModelSpectrumChannelTestSuite ()
+  : TestSuite ("multi-model-spectrum-channel", UNIT)
+{
+  AddTestCase (new MultiModelSpectrumChannelCullingTestCase, TestCase::QUICK);
+  AddTestCase (new MultiModelSpectrumChannelPathLossCacheTestCase, TestCase::QUICK);
+}
+
+static MultiModelSpectrumChannelTestSuite g_multiModelSpectrumChannelTestSuite;
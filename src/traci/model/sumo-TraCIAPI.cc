@@ -264,6 +264,12 @@ TraCIAPI::send_commandMoveToXY(const std::string& vehicleID, const std::string&
 void
 TraCIAPI::check_resultState(tcpip::Storage& inMsg, int command, bool ignoreCommandId, std::string* acknowledgement) const {
     mySocket->receiveExact(inMsg);
+    check_receivedResultState(inMsg, command, ignoreCommandId, acknowledgement);
+}
+
+
+void
+TraCIAPI::check_receivedResultState(tcpip::Storage& inMsg, int command, bool ignoreCommandId, std::string* acknowledgement) const {
     int cmdLength;
     int cmdId;
     int resultType;
@@ -569,7 +575,14 @@ void
 TraCIAPI::simulationStep(SUMOTime time) {
     send_commandSimulationStep(time);
     tcpip::Storage inMsg;
-    check_resultState(inMsg, CMD_SIMSTEP);
+    mySocket->receiveExact(inMsg);
+    read_simulationStepResult(inMsg);
+}
+
+
+void
+TraCIAPI::read_simulationStepResult(tcpip::Storage& inMsg) {
+    check_receivedResultState(inMsg, CMD_SIMSTEP);
 
     mySubscribedValues.clear();
     mySubscribedContextValues.clear();
@@ -831,6 +831,10 @@ protected:
      */
     void send_commandSimulationStep(SUMOTime time) const;
 
+    /** @brief Reads the already received response to a SimulationStep command and its subscription results
+     */
+    void read_simulationStepResult(tcpip::Storage& inMsg);
+
 
     /** @brief Sends a Close command
      */
@@ -894,6 +898,10 @@ protected:
      */
     void check_resultState(tcpip::Storage& inMsg, int command, bool ignoreCommandId = false, std::string* acknowledgement = 0) const;
 
+    /** @brief Validates the result state of a command already received into inMsg
+     */
+    void check_receivedResultState(tcpip::Storage& inMsg, int command, bool ignoreCommandId = false, std::string* acknowledgement = 0) const;
+
     /** @brief Validates the result state of a command
      * @return The command Id
      */
@@ -27,6 +27,9 @@
 #include <fstream>
 #include <regex>
 #include <string>
+#include <limits>
+#include <cmath>
+#include <unordered_set>
 #include <sys/socket.h>
 #include <netinet/in.h>
 
@@ -67,6 +70,25 @@ namespace ns3
                   BooleanValue (false),
                   MakeBooleanAccessor (&TraciClient::m_sumoGUI),
                   MakeBooleanChecker ())
+    .AddAttribute ("SumoLaunch",
+                  "Start up SUMO; when false, connect to a TraCI server already listening on SumoPort.",
+                  BooleanValue (true),
+                  MakeBooleanAccessor (&TraciClient::m_sumoLaunch),
+                  MakeBooleanChecker ())
+    .AddAttribute ("Pipeline",
+                  "Request each SUMO simulation step one synchronization interval ahead and receive it in a "
+                  "background thread, so that SUMO computes it while ns3 runs. The steps are applied at the same "
+                  "times as without pipeline, but no other TraCI command may be sent by the simulation.",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TraciClient::m_pipeline),
+                  MakeBooleanChecker ())
+    .AddAttribute ("DeadReckoning",
+                  "Between two synchronizations, move the nodes with the speed and heading of their SUMO vehicle "
+                  "instead of leaving them at the synchronized position. The nodes must have a "
+                  "ConstantVelocityMobilityModel.",
+                  BooleanValue (false),
+                  MakeBooleanAccessor (&TraciClient::m_deadReckoning),
+                  MakeBooleanChecker ())
     .AddAttribute ("SumoAdditionalCmdOptions",
                   "Additional commandline options for SUMO start-up.",
                   StringValue (""),
@@ -117,6 +139,9 @@ namespace ns3
     m_altitude = 1.5;
     m_sumoPort = 1338;
     m_sumoGUI = false;
+    m_sumoLaunch = true;
+    m_pipeline = false;
+    m_deadReckoning = false;
     m_penetrationRate = 1.0;
     m_sumoLogFile = false;
     m_sumoStepLog = false;
@@ -126,6 +151,11 @@ namespace ns3
   TraciClient::~TraciClient(void)
   {
     NS_LOG_FUNCTION(this);
+
+    if (m_stepThread)
+      {
+        m_stepThread->Join();
+      }
   }
 
   void
@@ -135,6 +165,11 @@ namespace ns3
 
     try
       {
+        // the response to a pipelined step must be read before closing
+        if (m_stepThread)
+          {
+            WaitSimulationStep();
+          }
         this->TraCIAPI::close();
       }
     catch (std::exception& e)
@@ -228,22 +263,25 @@ namespace ns3
   {
     NS_LOG_FUNCTION(this);
 
-    m_sumoPort = GetFreePort(m_sumoPort);
-
     m_includeNode = includeNode;
     m_excludeNode = excludeNode;
-    m_sumoCommand = GetSumoCmdString();
 
-    // start up sumo
-    int startCmd = std::system(m_sumoCommand.c_str());
-    if (startCmd)
+    if (m_sumoLaunch)
       {
-        NS_LOG_INFO("Used the following command to start up sumo: " << m_sumoCommand);
-      }
+        m_sumoPort = GetFreePort(m_sumoPort);
+        m_sumoCommand = GetSumoCmdString();
 
-    // wait 1 sec (=1e6 microsec) until sumo opens socket for traci connection
-    std::cout << "Sumo: wait for socket: " << (m_sumoWaitForSocket*1e-6) << "s" << std::endl;
-    usleep(m_sumoWaitForSocket);
+        // start up sumo
+        int startCmd = std::system(m_sumoCommand.c_str());
+        if (startCmd)
+          {
+            NS_LOG_INFO("Used the following command to start up sumo: " << m_sumoCommand);
+          }
+
+        // wait 1 sec (=1e6 microsec) until sumo opens socket for traci connection
+        std::cout << "Sumo: wait for socket: " << (m_sumoWaitForSocket*1e-6) << "s" << std::endl;
+        usleep(m_sumoWaitForSocket);
+      }
 
     // connect to sumo via traci
     try
@@ -255,6 +293,9 @@ namespace ns3
         NS_FATAL_ERROR("Can not connect to sumo via traci: " << e.what());
       }
 
+    // departed and arrived vehicles are returned with every simulation step
+    SubscribeSimulation();
+
     // start sumo and simulate until the specified time
     this->TraCIAPI::simulationStep(m_startTime.GetMilliSeconds());
 
@@ -264,6 +305,12 @@ namespace ns3
     // get current positions from sumo and uptdate positions
     UpdatePositions();
 
+    // let sumo compute the step of the first synchronisation while ns3 runs until it
+    if (m_pipeline)
+      {
+        RequestSimulationStep(m_synchInterval.GetMilliSeconds() * 2 + m_startTime.GetMilliSeconds());
+      }
+
     // schedule event to command sumo the next simulation step
     Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
   }
@@ -278,8 +325,16 @@ namespace ns3
         // get current simulation time
         auto nextTime = Simulator::Now().GetMilliSeconds() + m_synchInterval.GetMilliSeconds() + m_startTime.GetMilliSeconds();
 
-        // command sumo to simulate next time step
-        this->TraCIAPI::simulationStep(nextTime);
+        if (m_pipeline)
+          {
+            // the step to the next time was requested at the previous synchronisation
+            WaitSimulationStep();
+          }
+        else
+          {
+            // command sumo to simulate next time step
+            this->TraCIAPI::simulationStep(nextTime);
+          }
 
         // include a ns3 node for every new sumo vehicle and exclude arrived vehicles
         SynchroniseVehicleNodeMap();
@@ -287,6 +342,12 @@ namespace ns3
         // ask sumo for new vehicle positions and update node positions
         UpdatePositions();
 
+        if (m_pipeline)
+          {
+            // let sumo compute the step of the next synchronisation while ns3 runs until it
+            RequestSimulationStep(nextTime + m_synchInterval.GetMilliSeconds());
+          }
+
         // schedule next event to simulate next time step in sumo
         Simulator::Schedule(m_synchInterval, &TraciClient::SumoSimulationStep, this);
       }
@@ -297,95 +358,194 @@ namespace ns3
   }
 
   void
-  TraciClient::UpdatePositions()
+  TraciClient::RequestSimulationStep(SUMOTime time)
   {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << time);
+    NS_ASSERT(!m_stepThread);
 
+    this->TraCIAPI::send_commandSimulationStep(time);
+    m_stepError.clear();
+    m_stepThread = Create<SystemThread>(MakeCallback(&TraciClient::ReceiveSimulationStep, this));
+    m_stepThread->Start();
+  }
+
+  void
+  TraciClient::ReceiveSimulationStep()
+  {
+    // runs in the step thread: only the socket and the response buffer are used here
     try
       {
-        // iterate over all sumo vehicles in map
-        for (std::map<std::string, Ptr<Node> >::iterator it = m_vehicleNodeMap.begin(); it != m_vehicleNodeMap.end(); ++it)
-          {
-            // get current sumo vehicle from map
-            std::string veh(it->first);
-
-            // get vehicle position from sumo
-            TraCIPosition pos(this->TraCIAPI::vehicle.getPosition(veh));
-
-            // get corresponding ns3 node from map
-            Ptr<MobilityModel> mob = m_vehicleNodeMap.at(veh)->GetObject<MobilityModel>();
-            // set ns3 node position with user defined altitude
-            mob->SetPosition(Vector(pos.x, pos.y, m_altitude));
-          }
+        m_stepResponse.reset();
+        this->TraCIAPI::mySocket->receiveExact(m_stepResponse);
       }
     catch (std::exception& e)
       {
-        NS_FATAL_ERROR("SUMO was closed unexpectedly while asking for vehicle positions: " << e.what());
+        m_stepError = e.what();
       }
   }
 
   void
-  TraciClient::GetSumoVehicles(std::vector<std::string>& sumoVehicles)
+  TraciClient::WaitSimulationStep()
   {
     NS_LOG_FUNCTION(this);
+    NS_ASSERT(m_stepThread);
 
-    // initialize uniform random distribution for penetration rate
-    Ptr<UniformRandomVariable> randVar = CreateObject<UniformRandomVariable>();
-    randVar->SetAttribute("Min", DoubleValue(0.0));
-    randVar->SetAttribute("Max", DoubleValue(1.0));
-    sumoVehicles.clear();
+    m_stepThread->Join();
+    m_stepThread = 0;
+    if (!m_stepError.empty())
+      {
+        throw tcpip::SocketException(m_stepError);
+      }
+    // the subscription results are updated in the main thread only
+    this->TraCIAPI::read_simulationStepResult(m_stepResponse);
+  }
+
+  void
+  TraciClient::SubscribeSimulation()
+  {
+    NS_LOG_FUNCTION(this);
+
+    try
+      {
+        std::vector<int> vars;
+        vars.push_back(VAR_DEPARTED_VEHICLES_IDS);
+        vars.push_back(VAR_ARRIVED_VEHICLES_IDS);
+        this->TraCIAPI::simulation.subscribe(CMD_SUBSCRIBE_SIM_VARIABLE, "", 0, std::numeric_limits<int>::max(), vars);
+      }
+    catch (std::exception& e)
+      {
+        NS_FATAL_ERROR("SUMO was closed unexpectedly while subscribing to departed/arrived vehicles: " << e.what());
+      }
+  }
+
+  void
+  TraciClient::SubscribeVehicle(const std::string& veh)
+  {
+    NS_LOG_FUNCTION(this << veh);
 
     try
       {
-        // ask sumo for all (new) departed vehicles SINCE last simulation step (=one synch interval)
-        std::vector<std::string> departedVehicles = this->TraCIAPI::simulation.getDepartedIDList();
+        // sumo drops the subscription when the vehicle arrives
+        std::vector<int> vars;
+        vars.push_back(VAR_POSITION);
+        vars.push_back(VAR_SPEED);
+        vars.push_back(VAR_ANGLE);
+        this->TraCIAPI::simulation.subscribe(CMD_SUBSCRIBE_VEHICLE_VARIABLE, veh, 0, std::numeric_limits<int>::max(), vars);
+      }
+    catch (std::exception& e)
+      {
+        NS_FATAL_ERROR("SUMO was closed unexpectedly while subscribing to vehicle " << veh << ": " << e.what());
+      }
+  }
 
-        // ask sumo for all (new) arrived vehicles SINCE last simulation step (=one synch interval)
-        std::vector<std::string> arrivedVehicles = this->TraCIAPI::simulation.getArrivedIDList();
+  void
+  TraciClient::UpdatePositions()
+  {
+    NS_LOG_FUNCTION(this);
+
+    // the positions of all the vehicles were returned with the last simulation step (or subscription)
+    const SubscribedValues& results = this->TraCIAPI::simulation.getSubscriptionResults();
 
-        // iterate over departed vehicles
-        for (std::vector<std::string>::iterator it = departedVehicles.begin(); it != departedVehicles.end(); ++it)
+    // iterate over all sumo vehicles in map
+    for (std::map<std::string, Ptr<Node> >::iterator it = m_vehicleNodeMap.begin(); it != m_vehicleNodeMap.end(); ++it)
+      {
+        SubscribedValues::const_iterator vehResults = results.find(it->first);
+        if (vehResults == results.end())
           {
-            // get departed vehicle
-            std::string veh(*it);
+            NS_FATAL_ERROR("SUMO did not return the subscribed position of vehicle " << it->first);
+          }
+        TraCIValues::const_iterator pos = vehResults->second.find(VAR_POSITION);
+        if (pos == vehResults->second.end())
+          {
+            NS_FATAL_ERROR("SUMO did not return the subscribed position of vehicle " << it->first);
+          }
 
-            // search for same vehicle in arrived vehicles
-            std::vector<std::string>::iterator pos = std::find(arrivedVehicles.begin(), arrivedVehicles.end(), veh);
+        // get corresponding ns3 node from map
+        Ptr<MobilityModel> mob = it->second->GetObject<MobilityModel>();
+        // set ns3 node position with user defined altitude
+        mob->SetPosition(Vector(pos->second.position.x, pos->second.position.y, m_altitude));
 
-            // if vehicle is found in both lists, ignore it; all others are considered as relevant vehicles for simulation
-            if (pos != arrivedVehicles.end())
+        if (m_deadReckoning)
+          {
+            // move the node with the speed and heading of the vehicle until the next synchronisation
+            TraCIValues::const_iterator speed = vehResults->second.find(VAR_SPEED);
+            TraCIValues::const_iterator angle = vehResults->second.find(VAR_ANGLE);
+            Ptr<ConstantVelocityMobilityModel> cvmm = DynamicCast<ConstantVelocityMobilityModel>(mob);
+            if (cvmm == 0)
               {
-                arrivedVehicles.erase(pos);
+                NS_FATAL_ERROR("DeadReckoning requires nodes with a ConstantVelocityMobilityModel");
               }
-            else
+            if (speed == vehResults->second.end() || angle == vehResults->second.end())
               {
-                // penetration rate determines number of included nodes
-                if (randVar->GetValue() <= m_penetrationRate)
-                  {
-                    sumoVehicles.push_back(veh);
-                  }
+                NS_FATAL_ERROR("SUMO did not return the subscribed speed and angle of vehicle " << it->first);
               }
+            // sumo angles are in degrees, clockwise from north (y axis)
+            double heading = angle->second.scalar * M_PI / 180.0;
+            cvmm->SetVelocity(Vector(speed->second.scalar * std::sin(heading), speed->second.scalar * std::cos(heading), 0.0));
           }
+      }
+  }
 
-        // iterate over arrived vehicles
-        for (std::vector<std::string>::iterator it = arrivedVehicles.begin(); it != arrivedVehicles.end(); ++it)
-          {
-            // get arrived vehicle
-            std::string veh(*it);
+  void
+  TraciClient::GetSumoVehicles(std::vector<std::string>& sumoVehicles)
+  {
+    NS_LOG_FUNCTION(this);
 
-            // search for arrived vehicle in vehicleNodeMap
-            std::map<std::string, Ptr<Node> >::iterator pos = m_vehicleNodeMap.find(veh);
+    // initialize uniform random distribution for penetration rate
+    Ptr<UniformRandomVariable> randVar = CreateObject<UniformRandomVariable>();
+    randVar->SetAttribute("Min", DoubleValue(0.0));
+    randVar->SetAttribute("Max", DoubleValue(1.0));
+    sumoVehicles.clear();
 
-            // if node is in map, exclude it, otherwise is was not simulated in ns3 because of the penetration rate
-            if (pos != m_vehicleNodeMap.end())
+    // (new) departed and arrived vehicles SINCE last simulation step (=one synch interval), returned with the step
+    const SubscribedValues& results = this->TraCIAPI::simulation.getSubscriptionResults();
+    SubscribedValues::const_iterator simResults = results.find("");
+    if (simResults == results.end())
+      {
+        NS_FATAL_ERROR("SUMO did not return the subscribed departed/arrived vehicles");
+      }
+    const TraCIValues& simValues = simResults->second;
+    TraCIValues::const_iterator departedValue = simValues.find(VAR_DEPARTED_VEHICLES_IDS);
+    TraCIValues::const_iterator arrivedValue = simValues.find(VAR_ARRIVED_VEHICLES_IDS);
+    if (departedValue == simValues.end() || arrivedValue == simValues.end())
+      {
+        NS_FATAL_ERROR("SUMO did not return the subscribed departed/arrived vehicles");
+      }
+    const std::vector<std::string>& departedVehicles = departedValue->second.stringList;
+    const std::vector<std::string>& arrivedList = arrivedValue->second.stringList;
+    std::unordered_set<std::string> arrivedVehicles(arrivedList.begin(), arrivedList.end());
+
+    // iterate over departed vehicles
+    for (std::vector<std::string>::const_iterator it = departedVehicles.begin(); it != departedVehicles.end(); ++it)
+      {
+        // get departed vehicle
+        const std::string& veh(*it);
+
+        // if vehicle is found in both lists, ignore it; all others are considered as relevant vehicles for simulation
+        if (arrivedVehicles.erase(veh) == 0)
+          {
+            // penetration rate determines number of included nodes
+            if (randVar->GetValue() <= m_penetrationRate)
               {
                 sumoVehicles.push_back(veh);
               }
           }
       }
-    catch (std::exception& e)
+
+    // iterate over arrived vehicles, in the order given by sumo
+    for (std::vector<std::string>::const_iterator it = arrivedList.begin(); it != arrivedList.end(); ++it)
       {
-        NS_FATAL_ERROR("SUMO was closed unexpectedly while asking for arrived/departed vehicles: " << e.what());
+        // skip the vehicles which departed in the same step
+        if (arrivedVehicles.find(*it) == arrivedVehicles.end())
+          {
+            continue;
+          }
+
+        // if node is in map, exclude it, otherwise is was not simulated in ns3 because of the penetration rate
+        if (m_vehicleNodeMap.find(*it) != m_vehicleNodeMap.end())
+          {
+            sumoVehicles.push_back(*it);
+          }
       }
   }
 
@@ -415,6 +575,16 @@ namespace ns3
                 // get corresponding ns3 node
                 Ptr<ns3::Node> exNode = m_vehicleNodeMap.at(veh);
 
+                // stop the dead reckoning of the node
+                if (m_deadReckoning)
+                  {
+                    Ptr<ConstantVelocityMobilityModel> cvmm = exNode->GetObject<ConstantVelocityMobilityModel>();
+                    if (cvmm != 0)
+                      {
+                        cvmm->SetVelocity(Vector(0.0, 0.0, 0.0));
+                      }
+                  }
+
                 // call exclude function for this node
                 m_excludeNode(exNode);
 
@@ -428,6 +598,9 @@ namespace ns3
 
                 // register in the map (link vehicle to node!)
                 m_vehicleNodeMap.insert(std::pair<std::string, Ptr<Node>>(veh, inNode));
+
+                // get its position, speed and angle with every simulation step
+                SubscribeVehicle(veh);
               }
           }
       }
@@ -34,6 +34,7 @@
 
 #include "ns3/core-module.h"
 #include "ns3/mobility-module.h"
+#include "ns3/system-thread.h"
 
 #include "sumo-TraCIAPI.h"
 #include "sumo-TraCIDefs.h"
@@ -55,6 +56,18 @@ public:
 
   void SumoStop();
 
+  // The positions, speeds and angles of the vehicles linked to ns3 nodes are subscribed: sumo returns them
+  // with the response to each simulation step, and simulation.getSubscriptionResults() gives access to them
+  // without further requests
+
+  // With the Pipeline attribute, the simulation step of the next synchronisation is requested as soon as the
+  // current one is applied, and its response is received by a background thread while ns3 runs. The TraCI
+  // connection is busy meanwhile: the simulation must not send any other command to sumo.
+
+  // With the DeadReckoning attribute, the nodes move with the speed and heading of their vehicle between two
+  // synchronisations, which keeps their positions accurate with long synchronisation intervals. The nodes given
+  // by the include function must then have a ConstantVelocityMobilityModel.
+
   // get associated sumo vehicle for ns3 node
   std::string GetVehicleId(Ptr<Node> node);
 
@@ -64,10 +77,25 @@ private:
   // perform sumo simulation for a certain time step
   void SumoSimulationStep(void);
 
-  // get current positions from sumo vehicles and update corresponding ns3 nodes positions
+  // send the command of a simulation step and receive its response in the step thread
+  void RequestSimulationStep(SUMOTime time);
+
+  // body of the step thread
+  void ReceiveSimulationStep(void);
+
+  // wait for the response to the requested simulation step and read it
+  void WaitSimulationStep(void);
+
+  // subscribe to the departed and arrived vehicles, returned by sumo with every simulation step
+  void SubscribeSimulation(void);
+
+  // subscribe to the position, speed and angle of a vehicle, returned by sumo with every simulation step
+  void SubscribeVehicle(const std::string& veh);
+
+  // update the ns3 nodes positions with the subscribed positions of the sumo vehicles
   void UpdatePositions(void);
 
-  // get new (departed) and removed (arrived) vehicles from sumo
+  // get new (departed) and removed (arrived) vehicles from the subscription results
   void GetSumoVehicles(std::vector<std::string>& sumoVehicles);
 
   // synchronise ns3 nodes with sumo vehicles
@@ -97,6 +125,14 @@ private:
   std::string m_sumoBinaryPath;
   uint16_t m_sumoPort;
   bool m_sumoGUI;
+  bool m_sumoLaunch;
+  bool m_pipeline;
+  bool m_deadReckoning;
+
+  // pipelined simulation step being received in the background
+  Ptr<SystemThread> m_stepThread;
+  tcpip::Storage m_stepResponse;
+  std::string m_stepError;
 
   double m_penetrationRate;
   ns3::Time m_synchInterval;
@@ -0,0 +1,217 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <sstream>
+#include <set>
+#include <functional>
+
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node-container.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/traci-client.h"
+
+#include "traci-mock-server.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("TraciClientTestSuite");
+
+/**
+ * \ingroup traci
+ * \ingroup tests
+ *
+ * \brief Couple TraciClient with the mock TraCI server and check that the
+ * nodes follow the vehicles of the server, with one request per
+ * synchronization step apart from the subscriptions of new vehicles.
+ */
+class TraciClientMockTestCase : public TestCase
+{
+public:
+  /**
+   * \param nVehicles the number of vehicles of the scenario
+   * \param pipeline whether the steps are pipelined
+   * \param deadReckoning whether the nodes move between synchronizations
+   */
+  TraciClientMockTestCase (uint32_t nVehicles, bool pipeline, bool deadReckoning);
+
+private:
+  virtual void DoRun (void);
+  /// \return a node of the pool for a departed vehicle
+  Ptr<Node> IncludeNode (void);
+  /**
+   * Return the node of an arrived vehicle to the pool
+   * \param node the node
+   */
+  void ExcludeNode (Ptr<Node> node);
+  /**
+   * Check the nodes against the vehicles of the server
+   * \param sumoTime the time of the last simulation step of the server in ms
+   * \param elapsed the time elapsed since the last synchronization in ms
+   */
+  void Check (int32_t sumoTime, int32_t elapsed);
+
+  uint32_t m_nVehicles; //!< number of vehicles
+  bool m_pipeline; //!< whether the steps are pipelined
+  bool m_deadReckoning; //!< whether the nodes move between synchronizations
+  TraciMockServer *m_server; //!< mock TraCI server
+  Ptr<TraciClient> m_client; //!< client under test
+  std::vector<Ptr<Node> > m_pool; //!< free nodes
+  std::set<Ptr<Node> > m_included; //!< nodes linked to a vehicle
+  uint32_t m_nIncluded; //!< number of inclusions
+};
+
+static std::string
+BuildNameString (uint32_t nVehicles, bool pipeline, bool deadReckoning)
+{
+  std::ostringstream oss;
+  oss << "TraCI coupling with a mock server, " << nVehicles << " vehicles"
+      << (pipeline ? ", pipelined" : "") << (deadReckoning ? ", dead reckoning" : "");
+  return oss.str ();
+}
+
+TraciClientMockTestCase::TraciClientMockTestCase (uint32_t nVehicles, bool pipeline, bool deadReckoning)
+  : TestCase (BuildNameString (nVehicles, pipeline, deadReckoning)),
+    m_nVehicles (nVehicles),
+    m_pipeline (pipeline),
+    m_deadReckoning (deadReckoning),
+    m_server (0),
+    m_nIncluded (0)
+{
+}
+
+Ptr<Node>
+TraciClientMockTestCase::IncludeNode (void)
+{
+  NS_ASSERT (!m_pool.empty ());
+  Ptr<Node> node = m_pool.back ();
+  m_pool.pop_back ();
+  m_included.insert (node);
+  m_nIncluded++;
+  return node;
+}
+
+void
+TraciClientMockTestCase::ExcludeNode (Ptr<Node> node)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_included.erase (node), 1, "Excluded node was not included");
+  m_pool.push_back (node);
+}
+
+void
+TraciClientMockTestCase::Check (int32_t sumoTime, int32_t elapsed)
+{
+  NS_TEST_ASSERT_MSG_EQ (m_client->GetVehicleMapSize (), m_server->GetNDriving (sumoTime),
+                         "Wrong number of vehicles at " << sumoTime << " ms");
+  NS_TEST_ASSERT_MSG_EQ (m_included.size (), m_client->GetVehicleMapSize (), "Wrong number of included nodes");
+  for (std::set<Ptr<Node> >::const_iterator it = m_included.begin (); it != m_included.end (); ++it)
+    {
+      std::string veh = m_client->GetVehicleId (*it);
+      uint32_t i = 0;
+      while (i < m_nVehicles && TraciMockServer::GetVehicleId (i) != veh)
+        {
+          i++;
+        }
+      NS_TEST_ASSERT_MSG_LT (i, m_nVehicles, "Node linked to an unknown vehicle " << veh);
+      // the vehicles of the mock server drive straight at a constant speed
+      Vector expected = TraciMockServer::GetPosition (i, sumoTime + (m_deadReckoning ? elapsed : 0));
+      Vector position = (*it)->GetObject<MobilityModel> ()->GetPosition ();
+      NS_TEST_ASSERT_MSG_EQ_TOL (position.x, expected.x, 1e-9, "Wrong x for " << veh << " at " << sumoTime << " ms");
+      NS_TEST_ASSERT_MSG_EQ_TOL (position.y, expected.y, 1e-9, "Wrong y for " << veh << " at " << sumoTime << " ms");
+      NS_TEST_ASSERT_MSG_EQ_TOL (position.z, 1.5, 1e-9, "Wrong altitude for " << veh);
+    }
+}
+
+void
+TraciClientMockTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (m_nVehicles);
+  MobilityHelper mobility;
+  mobility.SetMobilityModel ("ns3::ConstantVelocityMobilityModel");
+  mobility.Install (nodes);
+  m_pool.assign (nodes.Begin (), nodes.End ());
+
+  TraciMockServer server (m_nVehicles);
+  m_server = &server;
+  uint16_t port = server.Start (24800);
+
+  m_client = CreateObject<TraciClient> ();
+  m_client->SetAttribute ("SumoLaunch", BooleanValue (false));
+  m_client->SetAttribute ("SumoPort", UintegerValue (port));
+  m_client->SetAttribute ("SynchInterval", TimeValue (Seconds (1.0)));
+  m_client->SetAttribute ("Pipeline", BooleanValue (m_pipeline));
+  m_client->SetAttribute ("DeadReckoning", BooleanValue (m_deadReckoning));
+  m_client->SumoSetup (std::bind (&TraciClientMockTestCase::IncludeNode, this),
+                       std::bind (&TraciClientMockTestCase::ExcludeNode, this, std::placeholders::_1));
+
+  // the set-up steps SUMO to the start time, then the positions applied at
+  // each synchronization are those of the next SUMO step
+  Simulator::Schedule (MilliSeconds (500), &TraciClientMockTestCase::Check, this, 0, 500);
+  for (int32_t k = 1; k < 12; k++)
+    {
+      Simulator::Schedule (MilliSeconds (1000 * k + 300), &TraciClientMockTestCase::Check, this, 1000 * (k + 1), 300);
+      Simulator::Schedule (MilliSeconds (1000 * k + 900), &TraciClientMockTestCase::Check, this, 1000 * (k + 1), 900);
+    }
+  Simulator::Stop (Seconds (12.0));
+  Simulator::Run ();
+  m_client->SumoStop ();
+  server.Join ();
+  Simulator::Destroy ();
+
+  // the set-up step, one per synchronization before the stop and the one
+  // requested ahead by the pipeline, plus the subscriptions and the close:
+  // no request per vehicle and per step
+  NS_TEST_ASSERT_MSG_GT (m_nIncluded, 0, "No vehicle included");
+  NS_TEST_ASSERT_MSG_EQ (server.GetNSteps (), (m_pipeline ? 13u : 12u), "Wrong number of simulation steps");
+  NS_TEST_ASSERT_MSG_EQ (server.GetNGets (), 0, "Unexpected variable retrievals");
+  NS_TEST_ASSERT_MSG_EQ (server.GetNVehicleSubscriptions (), m_nIncluded, "Wrong number of vehicle subscriptions");
+  NS_TEST_ASSERT_MSG_EQ (server.GetNCommands (), server.GetNSteps () + m_nIncluded + 2, "Unexpected requests");
+
+  m_client = 0;
+  m_included.clear ();
+  m_pool.clear ();
+  m_server = 0;
+}
+
+/**
+ * \ingroup traci
+ * \ingroup tests
+ *
+ * \brief TraciClient test suite
+ */
+class TraciClientTestSuite : public TestSuite
+{
+public:
+  TraciClientTestSuite ();
+};
+
+TraciClientTestSuite::TraciClientTestSuite ()
+  : TestSuite ("traci-client", SYSTEM)
+{
+  AddTestCase (new TraciClientMockTestCase (40, false, false), TestCase::QUICK);
+  AddTestCase (new TraciClientMockTestCase (40, true, false), TestCase::QUICK);
+  AddTestCase (new TraciClientMockTestCase (40, false, true), TestCase::QUICK);
+  AddTestCase (new TraciClientMockTestCase (40, true, true), TestCase::QUICK);
+  AddTestCase (new TraciClientMockTestCase (2000, false, false), TestCase::EXTENSIVE);
+  AddTestCase (new TraciClientMockTestCase (2000, true, false), TestCase::EXTENSIVE);
+}
+
+static TraciClientTestSuite staticTraciClientTestSuite;
@@ -0,0 +1,415 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <exception>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "ns3/log.h"
+#include "ns3/callback.h"
+#include "ns3/sumo-socket.h"
+#include "ns3/sumo-storage.h"
+#include "ns3/sumo-TraCIConstants.h"
+
+#include "traci-mock-server.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraciMockServer");
+
+TraciMockServer::TraciMockServer (uint32_t nVehicles)
+  : m_nVehicles (nVehicles),
+    m_socket (0),
+    m_stepDuration (0),
+    m_time (-1),
+    m_lastTime (-1),
+    m_nCommands (0),
+    m_nSteps (0),
+    m_nVehicleSubscriptions (0),
+    m_nGets (0)
+{
+}
+
+TraciMockServer::~TraciMockServer ()
+{
+  delete m_socket;
+}
+
+uint16_t
+TraciMockServer::Start (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  while (m_socket == 0)
+    {
+      // a non-blocking accept binds and listens without waiting for the client
+      m_socket = new tcpip::Socket (port);
+      m_socket->set_blocking (false);
+      try
+        {
+          m_socket->accept ();
+        }
+      catch (tcpip::SocketException &)
+        {
+          delete m_socket;
+          m_socket = 0;
+          port++;
+        }
+    }
+  m_socket->set_blocking (true);
+  m_thread = Create<SystemThread> (MakeCallback (&TraciMockServer::Run, this));
+  m_thread->Start ();
+  return port;
+}
+
+void
+TraciMockServer::SetStepDuration (uint32_t duration)
+{
+  m_stepDuration = duration;
+}
+
+void
+TraciMockServer::Join (void)
+{
+  if (m_thread)
+    {
+      m_thread->Join ();
+      m_thread = 0;
+    }
+}
+
+uint32_t
+TraciMockServer::GetNVehicles (void) const
+{
+  return m_nVehicles;
+}
+
+std::string
+TraciMockServer::GetVehicleId (uint32_t i)
+{
+  return "veh" + std::to_string (i);
+}
+
+int32_t
+TraciMockServer::GetDepartTime (uint32_t i)
+{
+  return 1000 * (i % 7) + 100 * (i % 3);
+}
+
+int32_t
+TraciMockServer::GetArriveTime (uint32_t i)
+{
+  if (i % 11 == 10)
+    {
+      return GetDepartTime (i) + 300;
+    }
+  return GetDepartTime (i) + 3000 + 1000 * (i % 5);
+}
+
+double
+TraciMockServer::GetSpeed (uint32_t i)
+{
+  return 10.0 + i % 5;
+}
+
+Vector
+TraciMockServer::GetPosition (uint32_t i, int32_t time)
+{
+  return Vector (10.0 * i + GetSpeed (i) * (time - GetDepartTime (i)) / 1000.0, 3.5 * (i % 4), 0.0);
+}
+
+uint32_t
+TraciMockServer::GetNDriving (int32_t time) const
+{
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < m_nVehicles; i++)
+    {
+      if (GetDepartTime (i) <= time && time < GetArriveTime (i))
+        {
+          n++;
+        }
+    }
+  return n;
+}
+
+uint32_t
+TraciMockServer::GetNCommands (void) const
+{
+  return m_nCommands;
+}
+
+uint32_t
+TraciMockServer::GetNSteps (void) const
+{
+  return m_nSteps;
+}
+
+uint32_t
+TraciMockServer::GetNVehicleSubscriptions (void) const
+{
+  return m_nVehicleSubscriptions;
+}
+
+uint32_t
+TraciMockServer::GetNGets (void) const
+{
+  return m_nGets;
+}
+
+uint32_t
+TraciMockServer::GetIndex (const std::string &id) const
+{
+  if (id.compare (0, 3, "veh") != 0 || id.size () == 3)
+    {
+      return m_nVehicles;
+    }
+  uint32_t i = std::strtoul (id.c_str () + 3, 0, 10);
+  return i < m_nVehicles && GetVehicleId (i) == id ? i : m_nVehicles;
+}
+
+bool
+TraciMockServer::IsDriving (uint32_t i) const
+{
+  return GetDepartTime (i) <= m_time && m_time < GetArriveTime (i);
+}
+
+void
+TraciMockServer::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  try
+    {
+      m_socket->accept ();
+      bool open = true;
+      while (open)
+        {
+          tcpip::Storage in;
+          tcpip::Storage out;
+          if (!m_socket->receiveExact (in))
+            {
+              break;
+            }
+          while (open && in.valid_pos ())
+            {
+              int length = in.readUnsignedByte ();
+              if (length == 0)
+                {
+                  in.readInt ();
+                }
+              open = Process (in, in.readUnsignedByte (), out);
+            }
+          m_socket->sendExact (out);
+        }
+    }
+  catch (std::exception &e)
+    {
+      NS_LOG_WARN ("Connection to the TraCI client lost: " << e.what ());
+    }
+  m_socket->close ();
+}
+
+bool
+TraciMockServer::Process (tcpip::Storage &in, int cmdId, tcpip::Storage &out)
+{
+  NS_LOG_FUNCTION (this << cmdId);
+  m_nCommands++;
+  switch (cmdId)
+    {
+    case CMD_SIMSTEP:
+      {
+        m_nSteps++;
+        Step (in.readInt ());
+        WriteStatus (cmdId, RTYPE_OK, "", out);
+        out.writeInt (m_vehicleVars.size () + (m_simVars.empty () ? 0 : 1));
+        if (!m_simVars.empty ())
+          {
+            WriteSubscription (CMD_SUBSCRIBE_SIM_VARIABLE, "", m_simVars, out);
+          }
+        for (std::map<std::string, std::vector<int> >::const_iterator it = m_vehicleVars.begin (); it != m_vehicleVars.end (); ++it)
+          {
+            WriteSubscription (CMD_SUBSCRIBE_VEHICLE_VARIABLE, it->first, it->second, out);
+          }
+        return true;
+      }
+    case CMD_SUBSCRIBE_SIM_VARIABLE:
+    case CMD_SUBSCRIBE_VEHICLE_VARIABLE:
+      {
+        in.readInt (); // begin time
+        in.readInt (); // end time
+        std::string objId = in.readString ();
+        std::vector<int> vars (in.readUnsignedByte ());
+        for (uint32_t i = 0; i < vars.size (); i++)
+          {
+            vars[i] = in.readUnsignedByte ();
+          }
+        if (cmdId == CMD_SUBSCRIBE_SIM_VARIABLE)
+          {
+            m_simVars = vars;
+          }
+        else
+          {
+            m_nVehicleSubscriptions++;
+            uint32_t i = GetIndex (objId);
+            if (i == m_nVehicles || !IsDriving (i))
+              {
+                WriteStatus (cmdId, RTYPE_ERR, "Vehicle '" + objId + "' is not known", out);
+                return true;
+              }
+            m_vehicleVars[objId] = vars;
+          }
+        WriteStatus (cmdId, RTYPE_OK, "", out);
+        if (!vars.empty ())
+          {
+            WriteSubscription (cmdId, objId, vars, out);
+          }
+        return true;
+      }
+    case CMD_GET_SIM_VARIABLE:
+    case CMD_GET_VEHICLE_VARIABLE:
+      {
+        m_nGets++;
+        int var = in.readUnsignedByte ();
+        std::string objId = in.readString ();
+        uint32_t i = GetIndex (objId);
+        if (cmdId == CMD_GET_VEHICLE_VARIABLE && (i == m_nVehicles || !IsDriving (i)))
+          {
+            WriteStatus (cmdId, RTYPE_ERR, "Vehicle '" + objId + "' is not known", out);
+            return true;
+          }
+        WriteStatus (cmdId, RTYPE_OK, "", out);
+        tcpip::Storage content;
+        content.writeUnsignedByte (cmdId + 0x10);
+        content.writeUnsignedByte (var);
+        content.writeString (objId);
+        WriteValue (var, i, content);
+        out.writeUnsignedByte (0);
+        out.writeInt (1 + 4 + content.size ());
+        out.writeStorage (content);
+        return true;
+      }
+    case CMD_CLOSE:
+      WriteStatus (cmdId, RTYPE_OK, "", out);
+      return false;
+    default:
+      WriteStatus (cmdId, RTYPE_NOTIMPLEMENTED, "Not implemented by the mock server", out);
+      // the content of the command is unknown, skip the rest of the message
+      while (in.valid_pos ())
+        {
+          in.readChar ();
+        }
+      return true;
+    }
+}
+
+void
+TraciMockServer::Step (int32_t time)
+{
+  NS_LOG_FUNCTION (this << time);
+  if (m_stepDuration > 0)
+    {
+      usleep (m_stepDuration);
+    }
+  m_lastTime = m_time;
+  m_time = time > m_time ? time : m_time + 1000;
+
+  // subscriptions of arrived vehicles are dropped
+  std::map<std::string, std::vector<int> >::iterator it = m_vehicleVars.begin ();
+  while (it != m_vehicleVars.end ())
+    {
+      if (IsDriving (GetIndex (it->first)))
+        {
+          ++it;
+        }
+      else
+        {
+          m_vehicleVars.erase (it++);
+        }
+    }
+}
+
+void
+TraciMockServer::WriteSubscription (int cmdId, const std::string &objId, const std::vector<int> &vars, tcpip::Storage &out) const
+{
+  tcpip::Storage content;
+  content.writeUnsignedByte (cmdId + 0x10);
+  content.writeString (objId);
+  content.writeUnsignedByte (vars.size ());
+  uint32_t i = GetIndex (objId);
+  for (std::vector<int>::const_iterator var = vars.begin (); var != vars.end (); ++var)
+    {
+      content.writeUnsignedByte (*var);
+      content.writeUnsignedByte (RTYPE_OK);
+      WriteValue (*var, i, content);
+    }
+  out.writeUnsignedByte (0);
+  out.writeInt (1 + 4 + content.size ());
+  out.writeStorage (content);
+}
+
+void
+TraciMockServer::WriteValue (int var, uint32_t i, tcpip::Storage &out) const
+{
+  switch (var)
+    {
+    case VAR_DEPARTED_VEHICLES_IDS:
+    case VAR_ARRIVED_VEHICLES_IDS:
+      {
+        std::vector<std::string> ids;
+        for (uint32_t j = 0; j < m_nVehicles; j++)
+          {
+            int32_t t = var == VAR_DEPARTED_VEHICLES_IDS ? GetDepartTime (j) : GetArriveTime (j);
+            if (m_lastTime < t && t <= m_time)
+              {
+                ids.push_back (GetVehicleId (j));
+              }
+          }
+        out.writeUnsignedByte (TYPE_STRINGLIST);
+        out.writeStringList (ids);
+        break;
+      }
+    case VAR_POSITION:
+      {
+        Vector pos = GetPosition (i, m_time);
+        out.writeUnsignedByte (POSITION_2D);
+        out.writeDouble (pos.x);
+        out.writeDouble (pos.y);
+        break;
+      }
+    case VAR_SPEED:
+      out.writeUnsignedByte (TYPE_DOUBLE);
+      out.writeDouble (GetSpeed (i));
+      break;
+    case VAR_ANGLE:
+      // heading east, clockwise from north in degrees
+      out.writeUnsignedByte (TYPE_DOUBLE);
+      out.writeDouble (90.0);
+      break;
+    default:
+      out.writeUnsignedByte (TYPE_DOUBLE);
+      out.writeDouble (0.0);
+      break;
+    }
+}
+
+void
+TraciMockServer::WriteStatus (int cmdId, int result, const std::string &description, tcpip::Storage &out)
+{
+  out.writeUnsignedByte (1 + 1 + 1 + 4 + description.size ());
+  out.writeUnsignedByte (cmdId);
+  out.writeUnsignedByte (result);
+  out.writeString (description);
+}
+
+} // namespace ns3
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACI_MOCK_SERVER_H
+#define TRACI_MOCK_SERVER_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "ns3/ptr.h"
+#include "ns3/system-thread.h"
+#include "ns3/vector.h"
+
+namespace tcpip {
+class Socket;
+class Storage;
+}
+
+namespace ns3 {
+
+/**
+ * \ingroup traci
+ *
+ * Minimal TraCI server standing in for SUMO, so that TraciClient can be
+ * tested and benchmarked without a SUMO installation. It serves a single
+ * client, from a thread of its own, and answers the simulation step,
+ * variable retrieval and subscription, and close commands.
+ *
+ * The scenario is synthetic and deterministic: vehicle "veh<i>" departs at
+ * GetDepartTime (i), drives east on its own lane at a constant speed and
+ * arrives at GetArriveTime (i). Some vehicles depart and arrive within the
+ * same second, to exercise the departed/arrived bookkeeping of the client.
+ */
+class TraciMockServer
+{
+public:
+  /**
+   * \param nVehicles the number of vehicles of the scenario
+   */
+  TraciMockServer (uint32_t nVehicles);
+  ~TraciMockServer ();
+
+  /**
+   * Listen on the first free port from the given one and start serving
+   * the client in a new thread
+   * \param port the first port to try
+   * \return the port listened on
+   */
+  uint16_t Start (uint16_t port);
+
+  /**
+   * Make each simulation step take some wall-clock time, as SUMO does
+   * \param duration the duration of a step in microseconds
+   */
+  void SetStepDuration (uint32_t duration);
+
+  /// Wait until the client has closed the connection
+  void Join (void);
+
+  /// \return the number of vehicles of the scenario
+  uint32_t GetNVehicles (void) const;
+  /**
+   * \param i the vehicle index
+   * \return the SUMO ID of the vehicle
+   */
+  static std::string GetVehicleId (uint32_t i);
+  /**
+   * \param i the vehicle index
+   * \return the departure time of the vehicle in ms
+   */
+  static int32_t GetDepartTime (uint32_t i);
+  /**
+   * \param i the vehicle index
+   * \return the arrival time of the vehicle in ms
+   */
+  static int32_t GetArriveTime (uint32_t i);
+  /**
+   * \param i the vehicle index
+   * \return the speed of the vehicle in m/s
+   */
+  static double GetSpeed (uint32_t i);
+  /**
+   * \param i the vehicle index
+   * \param time the time in ms, between departure and arrival
+   * \return the position of the vehicle
+   */
+  static Vector GetPosition (uint32_t i, int32_t time);
+  /**
+   * \param time the time in ms
+   * \return the number of vehicles driving at this time
+   */
+  uint32_t GetNDriving (int32_t time) const;
+
+  /// \return the number of commands received, all types included
+  uint32_t GetNCommands (void) const;
+  /// \return the number of simulation step commands received
+  uint32_t GetNSteps (void) const;
+  /// \return the number of vehicle subscription commands received
+  uint32_t GetNVehicleSubscriptions (void) const;
+  /// \return the number of variable retrieval commands received
+  uint32_t GetNGets (void) const;
+
+private:
+  /// Serve the client until it closes the connection
+  void Run (void);
+  /**
+   * Process a command and write the response
+   * \param in the command, after its length
+   * \param cmdId the command ID
+   * \param out the response
+   * \return false if the connection is closed
+   */
+  bool Process (tcpip::Storage &in, int cmdId, tcpip::Storage &out);
+  /**
+   * Advance the scenario
+   * \param time the target time in ms, 0 for one step
+   */
+  void Step (int32_t time);
+  /**
+   * Write the values of a subscription
+   * \param cmdId the subscription command ID
+   * \param objId the subscribed object
+   * \param vars the subscribed variables
+   * \param out the response
+   */
+  void WriteSubscription (int cmdId, const std::string &objId, const std::vector<int> &vars, tcpip::Storage &out) const;
+  /**
+   * Write the type and value of a variable
+   * \param var the variable ID
+   * \param i the vehicle index, for vehicle variables
+   * \param out the response
+   */
+  void WriteValue (int var, uint32_t i, tcpip::Storage &out) const;
+  /**
+   * Write a status response
+   * \param cmdId the command ID
+   * \param result the result type
+   * \param description the description of the result
+   * \param out the response
+   */
+  static void WriteStatus (int cmdId, int result, const std::string &description, tcpip::Storage &out);
+  /**
+   * \param id a SUMO vehicle ID
+   * \return the vehicle index, or the number of vehicles if unknown
+   */
+  uint32_t GetIndex (const std::string &id) const;
+  /**
+   * \param i the vehicle index
+   * \return true if the vehicle drives at the current time
+   */
+  bool IsDriving (uint32_t i) const;
+
+  uint32_t m_nVehicles; //!< number of vehicles
+  tcpip::Socket *m_socket; //!< listening socket, then connection to the client
+  Ptr<SystemThread> m_thread; //!< serving thread
+
+  uint32_t m_stepDuration; //!< wall-clock duration of a step in microseconds
+  int32_t m_time; //!< current time in ms
+  int32_t m_lastTime; //!< time before the last step in ms
+  std::vector<int> m_simVars; //!< subscribed simulation variables
+  std::map<std::string, std::vector<int> > m_vehicleVars; //!< subscribed vehicle variables
+
+  uint32_t m_nCommands; //!< number of commands received
+  uint32_t m_nSteps; //!< number of simulation steps received
+  uint32_t m_nVehicleSubscriptions; //!< number of vehicle subscriptions received
+  uint32_t m_nGets; //!< number of variable retrievals received
+};
+
+} // namespace ns3
+
+#endif /* TRACI_MOCK_SERVER_H */